@@ -0,0 +1,98 @@
+/*
+ * iwinfo - Wireless Information Library - Benchmark Helpers
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef __IWINFO_BENCH_H_
+#define __IWINFO_BENCH_H_
+
+#include <time.h>
+
+#include "iwinfo.h"
+
+
+#define BENCH_SAMPLES	64
+
+/* One corpus file: hex bytes, lines starting with '#' are comments */
+struct bench_sample {
+	char name[64];
+	uint8_t data[512];
+	int len;
+};
+
+static inline uint64_t bench_nsecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int bench_load_hex(const char *path, struct bench_sample *s)
+{
+	FILE *f;
+	char line[1024], *p, *end;
+	unsigned long v;
+	const char *name = strrchr(path, '/');
+
+	if (!(f = fopen(path, "r")))
+		return -1;
+
+	memset(s, 0, sizeof(*s));
+	strncpy(s->name, name ? name + 1 : path, sizeof(s->name) - 1);
+
+	while (fgets(line, sizeof(line), f))
+	{
+		if (line[0] == '#')
+			continue;
+
+		for (p = line; s->len < sizeof(s->data); p = end)
+		{
+			v = strtoul(p, &end, 16);
+
+			if (end == p)
+				break;
+
+			s->data[s->len++] = v;
+		}
+	}
+
+	fclose(f);
+
+	return s->len ? 0 : -1;
+}
+
+/* Load every *.hex file below dir, returns the number of samples */
+static int bench_load_corpus(const char *dir, struct bench_sample *s, int max)
+{
+	int i, n = 0;
+	char pattern[PATH_MAX];
+	glob_t gl;
+
+	snprintf(pattern, sizeof(pattern), "%s/*.hex", dir);
+
+	if (glob(pattern, 0, NULL, &gl))
+		return 0;
+
+	for (i = 0; i < gl.gl_pathc && n < max; i++)
+		if (!bench_load_hex(gl.gl_pathv[i], &s[n]))
+			n++;
+
+	globfree(&gl);
+
+	return n;
+}
+
+#endif
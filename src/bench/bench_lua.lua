@@ -0,0 +1,76 @@
+--[[
+iwinfo - Wireless Information Library - Lua Binding Benchmark
+
+Time and Lua heap allocations of the list wrappers, normalized to 1000
+stations. The stations come from a snapshot written by shm_stations, so
+no radio or associated clients are needed:
+
+  ./bench/shm_stations bench0
+  LUA_CPATH="./?.so" lua bench/bench_lua.lua bench0 [rounds]
+]]--
+
+local iwinfo = require "iwinfo"
+
+local ifname = arg[1] or "bench0"
+local rounds = tonumber(arg[2]) or 500
+
+local function count(t)
+	local n = 0
+	for _ in pairs(t) do n = n + 1 end
+	return n
+end
+
+-- Allocated kilobytes of one call, with the collector stopped so nothing
+-- is reclaimed while measuring
+local function allocated(fn)
+	collectgarbage("collect")
+	collectgarbage("stop")
+
+	local before = collectgarbage("count")
+	local rv = fn()
+	local after = collectgarbage("count")
+
+	collectgarbage("restart")
+
+	return after - before, rv
+end
+
+local function bench(name, fn, stations)
+	local kb = allocated(fn)
+
+	collectgarbage("collect")
+
+	local start = os.clock()
+
+	for i = 1, rounds do
+		fn()
+	end
+
+	local secs = os.clock() - start
+	local scale = 1000 / stations
+
+	print(string.format("%-18s %8.1f us/call %8.1f us/1000 sta %8.1f KB/1000 sta",
+		name, secs / rounds * 1e6, secs / rounds * 1e6 * scale, kb * scale))
+end
+
+local stations = count(iwinfo.shm.assoclist(ifname))
+
+if stations == 0 then
+	io.stderr:write("No stations in the snapshot of " .. ifname ..
+		", run bench/shm_stations first\n")
+	os.exit(1)
+end
+
+print(string.format("%d stations x %d rounds", stations, rounds))
+
+bench("assoclist", function()
+	return iwinfo.shm.assoclist(ifname)
+end, stations)
+
+bench("assoclist+walk", function()
+	local n = 0
+	for mac, e in pairs(iwinfo.shm.assoclist(ifname)) do
+		n = n + e.signal + e.rx_packets
+	end
+	return n
+end, stations)
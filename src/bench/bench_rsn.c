@@ -0,0 +1,198 @@
+/*
+ * iwinfo - Wireless Information Library - RSN Decoder Benchmark
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * Times iwinfo_parse_rsn() over the element corpus against the previous
+ * memcmp based decoder, which is kept below for reference only.
+ *
+ *   bench_rsn [-v] [corpus dir] [rounds]
+ */
+
+#include "bench.h"
+#include "rsn.h"
+
+
+static void rsn_legacy(struct iwinfo_crypto_entry *c, uint8_t *data,
+                       uint8_t len, uint16_t defcipher, uint8_t defauth)
+{
+	uint16_t i, count;
+
+	static unsigned char ms_oui[3]        = { 0x00, 0x50, 0xf2 };
+	static unsigned char ieee80211_oui[3] = { 0x00, 0x0f, 0xac };
+
+	data += 2;
+	len -= 2;
+
+	if (!memcmp(data, ms_oui, 3))
+		c->wpa_version += 1;
+	else if (!memcmp(data, ieee80211_oui, 3))
+		c->wpa_version += 2;
+
+	if (len < 4)
+	{
+		c->group_ciphers |= defcipher;
+		c->pair_ciphers  |= defcipher;
+		c->auth_suites   |= defauth;
+		return;
+	}
+
+	if (!memcmp(data, ms_oui, 3) || !memcmp(data, ieee80211_oui, 3))
+	{
+		switch (data[3])
+		{
+			case 1: c->group_ciphers |= IWINFO_CIPHER_WEP40;  break;
+			case 2: c->group_ciphers |= IWINFO_CIPHER_TKIP;   break;
+			case 4: c->group_ciphers |= IWINFO_CIPHER_CCMP;   break;
+			case 5: c->group_ciphers |= IWINFO_CIPHER_WEP104; break;
+		}
+	}
+
+	data += 4;
+	len -= 4;
+
+	if (len < 2)
+	{
+		c->pair_ciphers |= defcipher;
+		c->auth_suites  |= defauth;
+		return;
+	}
+
+	count = data[0] | (data[1] << 8);
+	if (2 + (count * 4) > len)
+		return;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!memcmp(data + 2 + (i * 4), ms_oui, 3) ||
+			!memcmp(data + 2 + (i * 4), ieee80211_oui, 3))
+		{
+			switch (data[2 + (i * 4) + 3])
+			{
+				case 1: c->pair_ciphers |= IWINFO_CIPHER_WEP40;  break;
+				case 2: c->pair_ciphers |= IWINFO_CIPHER_TKIP;   break;
+				case 4: c->pair_ciphers |= IWINFO_CIPHER_CCMP;   break;
+				case 5: c->pair_ciphers |= IWINFO_CIPHER_WEP104; break;
+			}
+		}
+	}
+
+	data += 2 + (count * 4);
+	len -= 2 + (count * 4);
+
+	if (len < 2)
+	{
+		c->auth_suites |= defauth;
+		return;
+	}
+
+	count = data[0] | (data[1] << 8);
+	if (2 + (count * 4) > len)
+		return;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!memcmp(data + 2 + (i * 4), ms_oui, 3) ||
+			!memcmp(data + 2 + (i * 4), ieee80211_oui, 3))
+		{
+			switch (data[2 + (i * 4) + 3])
+			{
+				case 1: c->auth_suites |= IWINFO_KMGMT_8021x; break;
+				case 2: c->auth_suites |= IWINFO_KMGMT_PSK;   break;
+			}
+		}
+	}
+}
+
+static void print_names(const char *label, int mask, const char **names, int n)
+{
+	int i;
+
+	printf(" %s=", label);
+
+	for (i = 0; i < n; i++)
+		if (mask & (1 << i))
+			printf("%s%s", names[i], (mask >> (i + 1)) ? "," : "");
+
+	if (!mask)
+		printf("-");
+}
+
+static double run(struct bench_sample *s, int n, int rounds,
+                  void (*parse)(struct iwinfo_crypto_entry *, uint8_t *,
+                                uint8_t, uint16_t, uint8_t))
+{
+	int i, r;
+	uint64_t start;
+	volatile uint16_t sink = 0;
+	struct iwinfo_crypto_entry c;
+
+	start = bench_nsecs();
+
+	for (r = 0; r < rounds; r++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			memset(&c, 0, sizeof(c));
+			rsn_parse_ies(&c, s[i].data, s[i].len, parse);
+			sink += c.pair_ciphers;
+		}
+	}
+
+	return (double)(bench_nsecs() - start) / ((double)rounds * n);
+}
+
+int main(int argc, char **argv)
+{
+	int i, n, verbose = 0, rounds = 200000;
+	const char *dir = "bench/corpus/rsn";
+	static struct bench_sample s[BENCH_SAMPLES];
+	struct iwinfo_crypto_entry c;
+
+	if (argc > 1 && !strcmp(argv[1], "-v"))
+	{
+		verbose = 1;
+		argc--;
+		argv++;
+	}
+
+	if (argc > 1)
+		dir = argv[1];
+
+	if (argc > 2)
+		rounds = atoi(argv[2]);
+
+	if ((n = bench_load_corpus(dir, s, BENCH_SAMPLES)) == 0 || rounds <= 0)
+	{
+		fprintf(stderr, "No corpus samples in %s\n", dir);
+		return 1;
+	}
+
+	for (i = 0; verbose && i < n; i++)
+	{
+		memset(&c, 0, sizeof(c));
+		rsn_parse_ies(&c, s[i].data, s[i].len, iwinfo_parse_rsn);
+
+		printf("%-28s wpa=%d", s[i].name, c.wpa_version);
+		print_names("group", IWINFO_CRYPTO_CIPHERS(&c, group), IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+		print_names("pair", IWINFO_CRYPTO_CIPHERS(&c, pair), IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+		print_names("akm", c.auth_suites, IWINFO_KMGMT_NAMES, IWINFO_KMGMT_COUNT);
+		printf("\n");
+	}
+
+	printf("%d elements x %d rounds\n", n, rounds);
+	printf("  table decoder   %6.1f ns/element\n", run(s, n, rounds, iwinfo_parse_rsn));
+	printf("  memcmp decoder  %6.1f ns/element\n", run(s, n, rounds, rsn_legacy));
+
+	return 0;
+}
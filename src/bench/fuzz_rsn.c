@@ -0,0 +1,114 @@
+/*
+ * iwinfo - Wireless Information Library - RSN Decoder Fuzz Target
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * libFuzzer entry point for iwinfo_parse_rsn(), the input is treated as a
+ * stream of information elements. Built without -DIWINFO_LIBFUZZER the
+ * target runs the corpus plus seeded mutations of it, which is meant to be
+ * combined with the address and undefined behaviour sanitizers:
+ *
+ *   fuzz_rsn [corpus dir] [iterations] [seed]
+ */
+
+#include "bench.h"
+#include "rsn.h"
+
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	uint8_t *copy;
+	struct iwinfo_crypto_entry c = { 0 };
+
+	/* exact sized copy so the sanitizer sees every overread */
+	if (size == 0 || !(copy = malloc(size)))
+		return 0;
+
+	memcpy(copy, data, size);
+	rsn_parse_ies(&c, copy, size, iwinfo_parse_rsn);
+	free(copy);
+
+	return 0;
+}
+
+#ifndef IWINFO_LIBFUZZER
+static void mutate(struct bench_sample *s, unsigned int *seed)
+{
+	int i, n = 1 + rand_r(seed) % 4;
+
+	for (i = 0; i < n && s->len > 0; i++)
+	{
+		switch (rand_r(seed) % 5)
+		{
+		case 0: /* flip a bit */
+			s->data[rand_r(seed) % s->len] ^= 1 << (rand_r(seed) % 8);
+			break;
+
+		case 1: /* corrupt an element or suite count length */
+			s->data[rand_r(seed) % s->len] = rand_r(seed) % 256;
+			break;
+
+		case 2: /* truncate */
+			s->len = rand_r(seed) % s->len;
+			break;
+
+		case 3: /* claim a longer element */
+			s->data[1] = s->len + rand_r(seed) % 8;
+			break;
+
+		case 4: /* extreme suite counts */
+			if (s->len > 10)
+				s->data[8 + rand_r(seed) % 2] = 0xff;
+			break;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int i, n, iterations = 1000000;
+	unsigned int seed = 1;
+	const char *dir = "bench/corpus/rsn";
+	static struct bench_sample s[BENCH_SAMPLES];
+	struct bench_sample m;
+
+	if (argc > 1)
+		dir = argv[1];
+
+	if (argc > 2)
+		iterations = atoi(argv[2]);
+
+	if (argc > 3)
+		seed = atoi(argv[3]);
+
+	if ((n = bench_load_corpus(dir, s, BENCH_SAMPLES)) == 0)
+	{
+		fprintf(stderr, "No corpus samples in %s\n", dir);
+		return 1;
+	}
+
+	for (i = 0; i < n; i++)
+		LLVMFuzzerTestOneInput(s[i].data, s[i].len);
+
+	for (i = 0; i < iterations; i++)
+	{
+		m = s[rand_r(&seed) % n];
+		mutate(&m, &seed);
+		LLVMFuzzerTestOneInput(m.data, m.len);
+	}
+
+	printf("%d samples, %d mutations\n", n, iterations);
+
+	return 0;
+}
+#endif
@@ -0,0 +1,65 @@
+#!/bin/sh
+#
+# iwinfo - Wireless Information Library - mac80211_hwsim Bench Setup
+#
+# Loads mac80211_hwsim with a number of radios and spreads interfaces
+# across them, giving bench/metrics_scrape a real nl80211 layout without
+# hardware. Needs root, iw and ip.
+#
+#   hwsim.sh up [radios] [interfaces]
+#   hwsim.sh down
+
+RADIOS=${2:-3}
+VAPS=${3:-16}
+
+hwsim_phys() {
+	for p in /sys/class/ieee80211/*; do
+		[ "$(basename "$(readlink "$p/device/driver")")" = mac80211_hwsim ] &&
+			basename "$p"
+	done
+}
+
+hwsim_ifaces() {
+	for p in $(hwsim_phys); do
+		ls "/sys/class/ieee80211/$p/device/net"
+	done
+}
+
+case "$1" in
+up)
+	if grep -q '^mac80211_hwsim ' /proc/modules; then
+		echo "mac80211_hwsim is loaded already, run '$0 down' first" >&2
+		exit 1
+	fi
+
+	modprobe mac80211_hwsim radios="$RADIOS" || exit 1
+
+	# every radio comes with one interface, add the rest round robin
+	n=$(hwsim_ifaces | wc -l)
+	i=0
+
+	while [ "$n" -lt "$VAPS" ]; do
+		for p in $(hwsim_phys); do
+			[ "$n" -lt "$VAPS" ] || break
+			iw phy "$p" interface add "hwsim$i" type managed || exit 1
+			i=$((i + 1))
+			n=$((n + 1))
+		done
+	done
+
+	for d in $(hwsim_ifaces); do
+		ip link set "$d" up 2>/dev/null
+	done
+
+	echo "$(hwsim_phys | wc -l) radios, $n interfaces"
+	;;
+
+down)
+	modprobe -r mac80211_hwsim
+	;;
+
+*)
+	echo "Usage: $0 up [radios] [interfaces] | down" >&2
+	exit 1
+	;;
+esac
@@ -0,0 +1,118 @@
+/*
+ * iwinfo - Wireless Information Library - Metrics Scrape Benchmark
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * Times complete iwinfo_metrics() scrapes against the interfaces present,
+ * kernel round trips included. bench/hwsim.sh sets up 3 mac80211_hwsim
+ * radios with 16 interfaces for a reproducible layout. The daemon is
+ * bypassed unless -d is given, built with USE_STATS the kernel requests
+ * per scrape are broken down as well.
+ *
+ *   metrics_scrape [-d] [rounds]
+ */
+
+#include "bench.h"
+
+
+#define BENCH_ROUNDS	100
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void print_counts(int rounds)
+{
+	int i, j, len;
+	char buf[IWINFO_BUFSIZE];
+	uint64_t calls = 0, count[IWINFO_STATS_COUNTERS] = { 0 };
+	struct iwinfo_stats_entry *e = (struct iwinfo_stats_entry *)buf;
+
+	if (iwinfo_stats(buf, &len))
+		return;
+
+	for (i = 0; i < len / sizeof(*e); i++)
+	{
+		calls += e[i].calls;
+
+		for (j = 0; j < IWINFO_STATS_COUNTERS; j++)
+			count[j] += e[i].count[j];
+	}
+
+	printf("  per scrape      %6.1f calls", (double)calls / rounds);
+
+	for (j = 0; j < IWINFO_STATS_COUNTERS; j++)
+		printf("  %.1f %s", (double)count[j] / rounds, IWINFO_STATS_NAMES[j]);
+
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	int i, n = 0, fd, rounds = BENCH_ROUNDS;
+	uint64_t start, *t;
+
+	if (argc > 1 && !strcmp(argv[1], "-d"))
+	{
+		argc--;
+		argv++;
+	}
+	else
+	{
+		iwinfo_client(0);
+	}
+
+	if (argc > 1)
+		rounds = atoi(argv[1]);
+
+	if (rounds <= 0 || !(t = calloc(rounds, sizeof(*t))))
+	{
+		fprintf(stderr, "Round count must be positive\n");
+		return 1;
+	}
+
+	if ((fd = open("/dev/null", O_WRONLY | O_CLOEXEC)) < 0)
+		return 1;
+
+	/* the first scrape resolves backends and opens the sockets */
+	if (iwinfo_metrics(fd) < 0)
+	{
+		fprintf(stderr, "Unable to gather metrics\n");
+		return 1;
+	}
+
+	iwinfo_stats_reset();
+
+	for (i = 0; i < rounds; i++)
+	{
+		start = bench_nsecs();
+		n = iwinfo_metrics(fd);
+		t[i] = bench_nsecs() - start;
+	}
+
+	qsort(t, rounds, sizeof(*t), cmp_u64);
+
+	printf("%d interfaces x %d scrapes\n", n, rounds);
+	printf("  min             %8.3f ms\n", t[0] / 1e6);
+	printf("  median          %8.3f ms\n", t[rounds / 2] / 1e6);
+	printf("  p95             %8.3f ms\n", t[rounds * 95 / 100] / 1e6);
+	printf("  max             %8.3f ms\n", t[rounds - 1] / 1e6);
+
+	print_counts(rounds);
+
+	close(fd);
+	free(t);
+	iwinfo_finish();
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * iwinfo - Wireless Information Library - RSN Benchmark Helpers
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef __IWINFO_BENCH_RSN_H_
+#define __IWINFO_BENCH_RSN_H_
+
+#include "iwinfo.h"
+#include "iwinfo/utils.h"
+
+
+/* Walk an IE stream the way the nl80211 and wext scan parsers do and feed
+ * the RSN and WPA elements to the given decoder */
+static inline void rsn_parse_ies(struct iwinfo_crypto_entry *c,
+                                 uint8_t *ie, int ielen,
+                                 void (*parse)(struct iwinfo_crypto_entry *,
+                                               uint8_t *, uint8_t,
+                                               uint16_t, uint8_t))
+{
+	static const uint8_t ms_oui[3] = { 0x00, 0x50, 0xf2 };
+
+	while (ielen >= 2 && ielen >= ie[1] + 2)
+	{
+		switch (ie[0])
+		{
+		case 48:
+			parse(c, ie + 2, ie[1], IWINFO_CIPHER_CCMP, IWINFO_KMGMT_8021x);
+			break;
+
+		case 221:
+			if (ie[1] >= 4 && !memcmp(ie + 2, ms_oui, 3) && ie[5] == 1)
+				parse(c, ie + 6, ie[1] - 4, IWINFO_CIPHER_TKIP, IWINFO_KMGMT_PSK);
+			break;
+		}
+
+		ielen -= ie[1] + 2;
+		ie += ie[1] + 2;
+	}
+}
+
+#endif
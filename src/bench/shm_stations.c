@@ -0,0 +1,104 @@
+/*
+ * iwinfo - Wireless Information Library - Synthetic Station Snapshot
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * Publishes a shared memory snapshot for a made-up interface whose
+ * assoclist holds as many synthetic stations as fit, so the Lua binding
+ * can be measured through iwinfo.shm without radios or associated
+ * clients:
+ *
+ *   shm_stations [ifname] [stations]
+ */
+
+#include "bench.h"
+
+
+/* the snapshot stores extended entries, which bounds the station count */
+static int stations =
+	IWINFO_BUFSIZE / sizeof(struct iwinfo_assoclist_ext_entry);
+
+static int stub_mode(const char *ifname, int *buf)
+{
+	*buf = IWINFO_OPMODE_MASTER;
+	return 0;
+}
+
+static int stub_ssid(const char *ifname, char *buf)
+{
+	strcpy(buf, "bench");
+	return 0;
+}
+
+static int stub_assoclist(const char *ifname, char *buf, int *len)
+{
+	int i;
+	struct iwinfo_assoclist_entry *e = (struct iwinfo_assoclist_entry *)buf;
+
+	memset(buf, 0, stations * sizeof(*e));
+
+	for (i = 0; i < stations; i++, e++)
+	{
+		e->mac[0] = 0x02;
+		e->mac[4] = i >> 8;
+		e->mac[5] = i & 0xff;
+		e->signal = -40 - (i % 50);
+		e->noise = -95;
+		e->inactive = i * 10;
+		e->rx_packets = 1000 + i;
+		e->tx_packets = 2000 + i;
+		e->rx_rate.rate = 144400;
+		e->rx_rate.mcs = 15;
+		e->rx_rate.is_40mhz = 1;
+		e->tx_rate.rate = 300000;
+		e->tx_rate.mcs = 15;
+		e->tx_rate.is_short_gi = 1;
+	}
+
+	*len = stations * sizeof(*e);
+	return 0;
+}
+
+static const struct iwinfo_ops stub_ops = {
+	.mode      = stub_mode,
+	.ssid      = stub_ssid,
+	.assoclist = stub_assoclist,
+};
+
+int main(int argc, char **argv)
+{
+	const char *ifname = (argc > 1) ? argv[1] : "bench0";
+	int max = stations;
+
+	if (argc > 2)
+		stations = atoi(argv[2]);
+
+	if (stations <= 0 || stations > max)
+	{
+		fprintf(stderr, "Station count must be within 1..%d\n", max);
+		return 1;
+	}
+
+	/* an hour of validity, readers must not treat it as stale */
+	if (iwinfo_shm_publish(&stub_ops, ifname, 3600 * 1000))
+	{
+		fprintf(stderr, "Unable to publish %s/iwinfo.%s\n",
+		        IWINFO_SHM_DIR, ifname);
+		return 1;
+	}
+
+	printf("%d\n", stations);
+
+	iwinfo_finish();
+	return 0;
+}
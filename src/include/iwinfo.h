@@ -28,22 +28,81 @@
 #define IWINFO_80211_G       (1 << 2)
 #define IWINFO_80211_N       (1 << 3)
 
-#define IWINFO_CIPHER_NONE   (1 << 0)
-#define IWINFO_CIPHER_WEP40  (1 << 1)
-#define IWINFO_CIPHER_TKIP   (1 << 2)
-#define IWINFO_CIPHER_WRAP   (1 << 3)
-#define IWINFO_CIPHER_CCMP   (1 << 4)
-#define IWINFO_CIPHER_WEP104 (1 << 5)
-#define IWINFO_CIPHER_AESOCB (1 << 6)
-#define IWINFO_CIPHER_CKIP   (1 << 7)
+#define IWINFO_CIPHER_NONE    (1 << 0)
+#define IWINFO_CIPHER_WEP40   (1 << 1)
+#define IWINFO_CIPHER_TKIP    (1 << 2)
+#define IWINFO_CIPHER_WRAP    (1 << 3)
+#define IWINFO_CIPHER_CCMP    (1 << 4)
+#define IWINFO_CIPHER_WEP104  (1 << 5)
+#define IWINFO_CIPHER_AESOCB  (1 << 6)
+#define IWINFO_CIPHER_CKIP    (1 << 7)
+#define IWINFO_CIPHER_GCMP    (1 << 8)
+#define IWINFO_CIPHER_GCMP256 (1 << 9)
+#define IWINFO_CIPHER_CCMP256 (1 << 10)
+
+#define IWINFO_CIPHER_COUNT   11
 
 #define IWINFO_KMGMT_NONE    (1 << 0)
 #define IWINFO_KMGMT_8021x   (1 << 1)
 #define IWINFO_KMGMT_PSK     (1 << 2)
+#define IWINFO_KMGMT_SAE     (1 << 3)
+#define IWINFO_KMGMT_OWE     (1 << 4)
+
+#define IWINFO_KMGMT_COUNT   5
 
 #define IWINFO_AUTH_OPEN     (1 << 0)
 #define IWINFO_AUTH_SHARED   (1 << 1)
 
+#define IWINFO_BSS_ADDED     (1 << 0)
+#define IWINFO_BSS_CHANGED   (1 << 1)
+#define IWINFO_BSS_REMOVED   (1 << 2)
+
+#define IWINFO_INFO_MODE             (1 << 0)
+#define IWINFO_INFO_CHANNEL          (1 << 1)
+#define IWINFO_INFO_FREQUENCY        (1 << 2)
+#define IWINFO_INFO_FREQUENCY_OFFSET (1 << 3)
+#define IWINFO_INFO_TXPOWER          (1 << 4)
+#define IWINFO_INFO_TXPOWER_OFFSET   (1 << 5)
+#define IWINFO_INFO_BITRATE          (1 << 6)
+#define IWINFO_INFO_SIGNAL           (1 << 7)
+#define IWINFO_INFO_NOISE            (1 << 8)
+#define IWINFO_INFO_QUALITY          (1 << 9)
+#define IWINFO_INFO_QUALITY_MAX      (1 << 10)
+#define IWINFO_INFO_MBSSID_SUPPORT   (1 << 11)
+#define IWINFO_INFO_HWMODES          (1 << 12)
+#define IWINFO_INFO_SSID             (1 << 13)
+#define IWINFO_INFO_BSSID            (1 << 14)
+#define IWINFO_INFO_COUNTRY          (1 << 15)
+#define IWINFO_INFO_HARDWARE_ID      (1 << 16)
+#define IWINFO_INFO_HARDWARE_NAME    (1 << 17)
+#define IWINFO_INFO_ENCRYPTION       (1 << 18)
+
+/* Fields whose change bumps the generation, volatile link metrics like
+ * signal or bitrate are deliberately left out */
+#define IWINFO_INFO_CONFIG \
+	(IWINFO_INFO_MODE | IWINFO_INFO_CHANNEL | IWINFO_INFO_FREQUENCY | \
+	 IWINFO_INFO_FREQUENCY_OFFSET | IWINFO_INFO_TXPOWER | \
+	 IWINFO_INFO_TXPOWER_OFFSET | IWINFO_INFO_MBSSID_SUPPORT | \
+	 IWINFO_INFO_HWMODES | IWINFO_INFO_SSID | IWINFO_INFO_BSSID | \
+	 IWINFO_INFO_COUNTRY | IWINFO_INFO_ENCRYPTION)
+
+#define IWINFO_UNCHANGED	1
+#define IWINFO_GENERATION_TTL	5000	/* ms */
+#define IWINFO_GENERATION_EVENT_TTL	60000	/* ms, backends with events */
+
+#define IWINFO_FIELD_COUNTERS  (1 << 0)
+#define IWINFO_FIELD_RATES     (1 << 1)
+#define IWINFO_FIELD_CRYPTO    (1 << 2)
+
+#define IWINFO_SCAN_PENDING  0
+#define IWINFO_SCAN_READY    1
+#define IWINFO_SCAN_ABORTED  2
+
+#define IWINFO_IE_HT_OPERATION  (1 << 0)
+#define IWINFO_IE_VHT_OPERATION (1 << 1)
+#define IWINFO_IE_BSS_LOAD      (1 << 2)
+#define IWINFO_IE_COUNTRY       (1 << 3)
+
 extern const char *IWINFO_CIPHER_NAMES[];
 extern const char *IWINFO_KMGMT_NAMES[];
 extern const char *IWINFO_AUTH_NAMES[];
@@ -65,6 +124,47 @@ enum iwinfo_opmode {
 extern const char *IWINFO_OPMODE_NAMES[];
 
 
+enum iwinfo_event_type {
+	IWINFO_EVENT_NONE           = 0,
+	IWINFO_EVENT_STA_NEW        = 1,
+	IWINFO_EVENT_STA_DEL        = 2,
+	IWINFO_EVENT_SCAN_DONE      = 3,
+	IWINFO_EVENT_SCAN_ABORTED   = 4,
+	IWINFO_EVENT_CHANNEL_SWITCH = 5,
+	IWINFO_EVENT_REG_CHANGE     = 6,
+	IWINFO_EVENT_OVERRUN        = 7,
+	IWINFO_EVENT_IFACE_CHANGE   = 8,
+};
+
+extern const char *IWINFO_EVENT_NAMES[];
+
+
+#define IWINFO_STATS_BUCKETS	10
+
+enum iwinfo_stats_counter {
+	IWINFO_STATS_NL_MSGS,
+	IWINFO_STATS_NL_BYTES,
+	IWINFO_STATS_IOCTLS,
+	IWINFO_STATS_FILES,
+	IWINFO_STATS_CTRL,
+	IWINFO_STATS_COUNTERS
+};
+
+extern const char *IWINFO_STATS_NAMES[];
+
+/* Statistics of one operation of a backend, latency bucket i counts the
+ * calls faster than 16 << 2i us, the last bucket all slower ones */
+struct iwinfo_stats_entry {
+	char backend[16];
+	char op[20];
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t usecs;
+	uint64_t latency[IWINFO_STATS_BUCKETS];
+	uint64_t count[IWINFO_STATS_COUNTERS];
+};
+
+
 struct iwinfo_rate_entry {
 	uint32_t rate;
 	int8_t mcs;
@@ -83,6 +183,59 @@ struct iwinfo_assoclist_entry {
 	struct iwinfo_rate_entry tx_rate;
 };
 
+/* Station with the counters the original entry has no room for, as
+ * returned by assoclist_ext, assoclist_filter and station. The packet
+ * counters of base are the low 32 bit of the wide ones. */
+struct iwinfo_assoclist_ext_entry {
+	struct iwinfo_assoclist_entry base;
+	uint64_t rx_packets;
+	uint64_t tx_packets;
+	uint64_t rx_bytes;
+	uint64_t tx_bytes;
+	uint32_t tx_retries;
+	uint32_t tx_failed;
+	uint32_t beacon_loss;
+	uint32_t connected_time;
+};
+
+#define IWINFO_RATE_SAMPLES	8
+
+/* Per-station rates between the current and an earlier assoclist sample.
+ * Totals are widened to 64 bit across wraps of 32 bit driver counters,
+ * interval is zero until a previous sample of the station exists. */
+struct iwinfo_assoclist_rates {
+	uint8_t mac[6];
+	uint32_t interval;
+	uint64_t rx_bytes;
+	uint64_t tx_bytes;
+	uint64_t rx_packets;
+	uint64_t tx_packets;
+	uint64_t rx_byte_rate;
+	uint64_t tx_byte_rate;
+	uint32_t rx_packet_rate;
+	uint32_t tx_packet_rate;
+	uint16_t tx_retry_ratio;	/* 1/100 % of transmit attempts */
+	uint16_t tx_fail_ratio;
+};
+
+/* Channel survey with cumulative radio times in ms, the ratios cover the
+ * last interval in which the channel accrued time, in 1/100 %. */
+struct iwinfo_survey_entry {
+	uint32_t mhz;
+	uint8_t channel;
+	int8_t noise;
+	uint8_t in_use;
+	uint64_t time;
+	uint64_t time_busy;
+	uint64_t time_ext_busy;
+	uint64_t time_rx;
+	uint64_t time_tx;
+	uint32_t interval;
+	uint16_t busy_ratio;
+	uint16_t rx_ratio;
+	uint16_t tx_ratio;
+};
+
 struct iwinfo_txpwrlist_entry {
 	uint8_t  dbm;
 	uint16_t mw;
@@ -94,6 +247,10 @@ struct iwinfo_freqlist_entry {
 	uint8_t restricted;
 };
 
+/* Cipher flags above IWINFO_CIPHER_CKIP do not fit the original fields and
+ * are kept shifted down by 8 in the _ext fields appended for them. The
+ * original members keep their offsets, but the entry grew from 6 to 8 bytes:
+ * encryption op buffers must hold sizeof(struct iwinfo_crypto_entry). */
 struct iwinfo_crypto_entry {
 	uint8_t	enabled;
 	uint8_t wpa_version;
@@ -101,6 +258,64 @@ struct iwinfo_crypto_entry {
 	uint8_t pair_ciphers;
 	uint8_t auth_suites;
 	uint8_t auth_algs;
+	uint8_t group_ciphers_ext;
+	uint8_t pair_ciphers_ext;
+};
+
+/* Complete cipher set of field f (group or pair) of crypto entry c */
+#define IWINFO_CRYPTO_CIPHERS(c, f) \
+	((uint16_t)((c)->f##_ciphers | ((c)->f##_ciphers_ext << 8)))
+
+#define IWINFO_CRYPTO_ADD_CIPHERS(c, f, v)				\
+	do {												\
+		uint16_t _v = (v);								\
+		(c)->f##_ciphers     |= _v & 0xff;				\
+		(c)->f##_ciphers_ext |= _v >> 8;				\
+	} while (0)
+
+struct iwinfo_ht_operation {
+	uint8_t primary_channel;
+	uint8_t secondary_offset;
+	uint8_t chan_width;
+};
+
+struct iwinfo_vht_operation {
+	uint8_t chan_width;
+	uint8_t center_chan_1;
+	uint8_t center_chan_2;
+};
+
+struct iwinfo_bss_load {
+	uint16_t station_count;
+	uint8_t channel_utilization;
+	uint16_t admission_capacity;
+};
+
+struct iwinfo_country_ie {
+	char ccode[3];
+	char environment;
+};
+
+struct iwinfo_arena_chunk {
+	struct iwinfo_arena_chunk *next;
+	size_t size;
+	size_t used;
+	uint8_t data[];
+};
+
+struct iwinfo_arena {
+	struct iwinfo_arena_chunk *chunks;
+};
+
+struct iwinfo_ie_blob {
+	uint16_t len;
+	uint8_t decoded;
+	uint8_t present;
+	struct iwinfo_ht_operation ht;
+	struct iwinfo_vht_operation vht;
+	struct iwinfo_bss_load load;
+	struct iwinfo_country_ie country;
+	uint8_t data[];
 };
 
 struct iwinfo_scanlist_entry {
@@ -114,6 +329,78 @@ struct iwinfo_scanlist_entry {
 	struct iwinfo_crypto_entry crypto;
 };
 
+/* Scan entry with the raw IEs of the BSS, as returned by scanlist_ext.
+ * The blob is owned by the library and stays valid until the next scan
+ * of the same device in this process or iwinfo_finish(). ies is NULL if
+ * the backend does not report IEs for the BSS. */
+struct iwinfo_scanlist_ext_entry {
+	struct iwinfo_scanlist_entry base;
+	struct iwinfo_ie_blob *ies;
+};
+
+struct iwinfo_scanlist_delta_entry {
+	uint8_t change;
+	uint32_t age;
+	struct iwinfo_scanlist_entry bss;
+};
+
+/* List filter, every criterion left at zero matches anything. Fields
+ * outside a non-zero field mask may be left unset by the backend. */
+struct iwinfo_filter {
+	uint32_t fields;
+	int min_signal;
+	int max_signal;
+	uint32_t max_inactive;
+	uint32_t channels[8];
+	char ssid[IWINFO_ESSID_MAX_SIZE + 1];
+	int top;
+};
+
+#define IWINFO_SCAN_MULTI_MAX		32
+#define IWINFO_SCAN_MULTI_TIMEOUT	10000	/* ms */
+
+/* Merged scan result, bit n of radios is set if the n-th device passed
+ * to iwinfo_scan_multi() saw the BSS, bss holds the strongest sighting */
+struct iwinfo_scan_multi_entry {
+	uint32_t radios;
+	struct iwinfo_scanlist_entry bss;
+};
+
+struct iwinfo_scan {
+	char ifname[IFNAMSIZ];
+	int fd;
+	int state;
+	void *priv;
+};
+
+/* A decoded wireless event, OVERRUN reports that events were lost and
+ * the consumer should resynchronize its state by polling */
+struct iwinfo_event {
+	enum iwinfo_event_type type;
+	char ifname[IFNAMSIZ];
+	union {
+		struct {
+			uint8_t mac[6];
+		} sta;
+		struct {
+			int mhz;
+			int channel;
+		} chan;
+		struct {
+			char alpha2[3];
+			uint8_t initiator;
+		} reg;
+	} u;
+};
+
+#define IWINFO_EVENT_QUEUE	32
+
+struct iwinfo_events {
+	char ifname[IFNAMSIZ];
+	int fd;
+	void *priv;
+};
+
 struct iwinfo_country_entry {
 	uint16_t iso3166;
 	uint8_t ccode[4];
@@ -147,6 +434,29 @@ extern const struct iwinfo_iso3166_label IWINFO_ISO3166_NAMES[];
 #define IWINFO_HARDWARE_FILE	"/usr/share/libiwinfo/hardware.txt"
 
 
+struct iwinfo_info {
+	uint32_t valid;
+	int mode;
+	int channel;
+	int frequency;
+	int frequency_offset;
+	int txpower;
+	int txpower_offset;
+	int bitrate;
+	int signal;
+	int noise;
+	int quality;
+	int quality_max;
+	int mbssid_support;
+	int hwmodes;
+	char ssid[IWINFO_ESSID_MAX_SIZE + 1];
+	char bssid[18];
+	char country[4];
+	char hardware_name[128];
+	struct iwinfo_hardware_id hardware_id;
+	struct iwinfo_crypto_entry crypto;
+};
+
 struct iwinfo_ops {
 	int (*mode)(const char *, int *);
 	int (*channel)(const char *, int *);
@@ -173,13 +483,91 @@ struct iwinfo_ops {
 	int (*freqlist)(const char *, char *, int *);
 	int (*countrylist)(const char *, char *, int *);
 	void (*close)(void);
+
+	/* later additions, keep appending to preserve the layout above */
+	int (*scanlist_delta)(const char *, char *, int *);
+	int (*scan_trigger)(const char *, struct iwinfo_scan *);
+	int (*scan_ready)(struct iwinfo_scan *);
+	int (*scan_results)(struct iwinfo_scan *, char *, int *);
+	void (*scan_close)(struct iwinfo_scan *);
+	int (*phyname)(const char *, char *);
+	int (*info)(const char *, struct iwinfo_info *);
+	int (*assoclist_filter)(const char *, const struct iwinfo_filter *,
+	                        char *, int *);
+	int (*scanlist_filter)(const char *, const struct iwinfo_filter *,
+	                       char *, int *);
+	int (*station)(const char *, const uint8_t *,
+	               struct iwinfo_assoclist_ext_entry *);
+	int (*survey)(const char *, char *, int *);
+	int (*scan_schedule)(const char *, int);
+	int (*scan_age)(const char *, int *);
+	int (*events_open)(const char *, struct iwinfo_events *);
+	int (*events_read)(struct iwinfo_events *, struct iwinfo_event *);
+	void (*events_close)(struct iwinfo_events *);
+	int (*assoclist_ext)(const char *, char *, int *);
+	int (*scanlist_ext)(const char *, char *, int *);
 };
 
 const char * iwinfo_type(const char *ifname);
 const struct iwinfo_ops * iwinfo_backend(const char *ifname);
+const struct iwinfo_ops * iwinfo_backend_by_name(const char *type);
+const struct iwinfo_ops * iwinfo_backend_route(const struct iwinfo_ops *local,
+                                               const char *type,
+                                               const char *ifname);
+void iwinfo_resolved(const char *ifname, int ifindex, const char *phy);
+int iwinfo_info(const struct iwinfo_ops *ops, const char *ifname,
+                struct iwinfo_info *info);
+int iwinfo_assoclist_ext(const struct iwinfo_ops *ops, const char *ifname,
+                         char *buf, int *len);
+int iwinfo_assoclist_filter(const struct iwinfo_ops *ops, const char *ifname,
+                            const struct iwinfo_filter *f, char *buf, int *len);
+int iwinfo_station_get(const struct iwinfo_ops *ops, const char *ifname,
+                       const uint8_t *mac,
+                       struct iwinfo_assoclist_ext_entry *e);
+int iwinfo_assoclist_rates(const struct iwinfo_ops *ops, const char *ifname,
+                           int window, char *buf, int *len);
+int iwinfo_scanlist_filter(const struct iwinfo_ops *ops, const char *ifname,
+                           const struct iwinfo_filter *f, char *buf, int *len);
+int iwinfo_scanlist_ext(const struct iwinfo_ops *ops, const char *ifname,
+                        char *buf, int *len);
+int iwinfo_scan_multi(const char * const *ifnames, int count, int timeout,
+                      char *buf, int *len);
+void iwinfo_scan_coalesce(int window);
+void iwinfo_client(int enable);
+int iwinfo_shm_publish(const struct iwinfo_ops *ops, const char *ifname,
+                       int interval);
+int iwinfo_shm_read(const char *ifname, int section, int max_age,
+                    char *buf, int *len);
+uint32_t iwinfo_generation(const struct iwinfo_ops *ops, const char *ifname);
+int iwinfo_info_since(const struct iwinfo_ops *ops, const char *ifname,
+                      uint32_t *generation, struct iwinfo_info *info);
+int iwinfo_metrics(int fd);
+int iwinfo_stats(char *buf, int *len);
+void iwinfo_stats_reset(void);
 void iwinfo_finish(void);
 
+void iwinfo_filter_channel(struct iwinfo_filter *f, int channel);
+void iwinfo_filter_frequency(struct iwinfo_filter *f, int mhz);
+int iwinfo_filter_assoc(const struct iwinfo_filter *f,
+                        const struct iwinfo_assoclist_entry *e);
+int iwinfo_filter_scan(const struct iwinfo_filter *f,
+                       const struct iwinfo_scanlist_entry *e);
+
+const uint8_t * iwinfo_ie_find(const struct iwinfo_scanlist_ext_entry *e,
+                               uint8_t id, const uint8_t *prev);
+const uint8_t * iwinfo_ie_vendor(const struct iwinfo_scanlist_ext_entry *e,
+                                 const uint8_t *oui, const uint8_t *prev);
+int iwinfo_ie_ht_operation(struct iwinfo_scanlist_ext_entry *e,
+                           struct iwinfo_ht_operation *ht);
+int iwinfo_ie_vht_operation(struct iwinfo_scanlist_ext_entry *e,
+                            struct iwinfo_vht_operation *vht);
+int iwinfo_ie_bss_load(struct iwinfo_scanlist_ext_entry *e,
+                       struct iwinfo_bss_load *load);
+int iwinfo_ie_country(struct iwinfo_scanlist_ext_entry *e,
+                      struct iwinfo_country_ie *country);
+
 #include "iwinfo/wext.h"
+#include "iwinfo/shm.h"
 
 #ifdef USE_WL
 #include "iwinfo/wl.h"
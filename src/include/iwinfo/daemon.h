@@ -0,0 +1,79 @@
+/*
+ * iwinfo - Wireless Information Library - Query Daemon Protocol
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef __IWINFO_DAEMON_H_
+#define __IWINFO_DAEMON_H_
+
+#include <sys/un.h>
+
+#include "iwinfo.h"
+
+#define IWINFO_DAEMON_SOCK		"/var/run/iwinfod.sock"
+#define IWINFO_DAEMON_MAGIC		0x69774451	/* "iwDQ" */
+#define IWINFO_DAEMON_TIMEOUT	15			/* s, covers a full scan */
+
+/*
+ * A binary query is a struct iwinfo_daemon_req, the answer is a struct
+ * iwinfo_daemon_res followed by len bytes of payload laid out exactly like
+ * the buffer filled by the corresponding iwinfo_ops member. Queries
+ * starting with '{' are read as a single line of JSON instead, see
+ * iwinfod.c for the supported subset.
+ */
+enum iwinfo_daemon_op {
+	IWINFO_DAEMON_TYPE,
+	IWINFO_DAEMON_MODE,
+	IWINFO_DAEMON_CHANNEL,
+	IWINFO_DAEMON_FREQUENCY,
+	IWINFO_DAEMON_FREQUENCY_OFFSET,
+	IWINFO_DAEMON_TXPOWER,
+	IWINFO_DAEMON_TXPOWER_OFFSET,
+	IWINFO_DAEMON_BITRATE,
+	IWINFO_DAEMON_SIGNAL,
+	IWINFO_DAEMON_NOISE,
+	IWINFO_DAEMON_QUALITY,
+	IWINFO_DAEMON_QUALITY_MAX,
+	IWINFO_DAEMON_MBSSID_SUPPORT,
+	IWINFO_DAEMON_HWMODELIST,
+	IWINFO_DAEMON_SSID,
+	IWINFO_DAEMON_BSSID,
+	IWINFO_DAEMON_COUNTRY,
+	IWINFO_DAEMON_HARDWARE_ID,
+	IWINFO_DAEMON_HARDWARE_NAME,
+	IWINFO_DAEMON_PHYNAME,
+	IWINFO_DAEMON_ENCRYPTION,
+	IWINFO_DAEMON_INFO,
+	IWINFO_DAEMON_ASSOCLIST,
+	IWINFO_DAEMON_TXPWRLIST,
+	IWINFO_DAEMON_SCANLIST,
+	IWINFO_DAEMON_FREQLIST,
+	IWINFO_DAEMON_SURVEY,
+	IWINFO_DAEMON_COUNTRYLIST,
+	IWINFO_DAEMON_ASSOCLIST_EXT,
+	__IWINFO_DAEMON_OP_MAX
+};
+
+struct iwinfo_daemon_req {
+	uint32_t magic;
+	uint32_t op;
+	char ifname[IFNAMSIZ];
+};
+
+struct iwinfo_daemon_res {
+	int32_t rv;
+	uint32_t len;
+};
+
+#endif
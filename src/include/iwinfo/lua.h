@@ -22,6 +22,7 @@
 #include <lua.h>
 #include <lualib.h>
 #include <lauxlib.h>
+#include <poll.h>
 
 #include "iwinfo.h"
 #include "iwinfo/wext_scan.h"
@@ -29,6 +30,14 @@
 
 #define IWINFO_META			"iwinfo"
 #define IWINFO_WEXT_META	"iwinfo.wext"
+#define IWINFO_SHM_META		"iwinfo.shm"
+
+#define IWINFO_LIST_META	"iwinfo.list"
+#define IWINFO_ENTRY_META	"iwinfo.entry"
+#define IWINFO_CRYPTO_META	"iwinfo.crypto"
+#define IWINFO_SCAN_META	"iwinfo.scan"
+#define IWINFO_EVENTS_META	"iwinfo.events"
+#define IWINFO_DEVICE_META	"iwinfo.device"
 
 #ifdef USE_WL
 #define IWINFO_WL_META		"iwinfo.wl"
@@ -50,12 +59,21 @@
 #define LUA_REG(type,op) \
 	{ #op, iwinfo_L_##type##_##op }
 
+/* While iwinfod serves the backend of the interface the getters go through
+ * it, exactly like the ones picked by iwinfo_backend() */
+#define LUA_OPS(type,ifname)							\
+	iwinfo_backend_route(&type##_ops, #type, ifname)
+
+#define LUA_ROUTE(type,op)								\
+	LUA_OPS(type, luaL_checkstring(L, 1))->op
+
 #define LUA_WRAP_INT(type,op) 							\
 	static int iwinfo_L_##type##_##op(lua_State *L)		\
 	{													\
 		const char *ifname = luaL_checkstring(L, 1);	\
+		const struct iwinfo_ops *ops = LUA_OPS(type, ifname);	\
 		int rv;											\
-		if( !type##_get_##op(ifname, &rv) )				\
+		if( ops->op && !ops->op(ifname, &rv) )			\
 			lua_pushnumber(L, rv);						\
 		else											\
 			lua_pushnil(L);								\
@@ -66,9 +84,10 @@
 	static int iwinfo_L_##type##_##op(lua_State *L)		\
 	{													\
 		const char *ifname = luaL_checkstring(L, 1);	\
+		const struct iwinfo_ops *ops = LUA_OPS(type, ifname);	\
 		char rv[IWINFO_BUFSIZE];						\
 		memset(rv, 0, IWINFO_BUFSIZE);					\
-		if( !type##_get_##op(ifname, rv) )				\
+		if( ops->op && !ops->op(ifname, rv) )			\
 			lua_pushstring(L, rv);						\
 		else											\
 			lua_pushnil(L);								\
@@ -78,7 +97,32 @@
 #define LUA_WRAP_STRUCT(type,op)						\
 	static int iwinfo_L_##type##_##op(lua_State *L)		\
 	{													\
-		return iwinfo_L_##op(L, type##_get_##op);		\
+		return iwinfo_L_##op(L, LUA_ROUTE(type, op));	\
+	}
+
+#define LUA_WRAP_LIST(type,op)							\
+	static int iwinfo_L_##type##_##op(lua_State *L)		\
+	{													\
+		return iwinfo_L_##op(L,							\
+			LUA_OPS(type, luaL_checkstring(L, 1)));		\
+	}
+
+#define LUA_WRAP_LAZY(type,op)							\
+	static int iwinfo_L_##type##_##op##_lazy(lua_State *L)	\
+	{													\
+		return iwinfo_L_##op##_lazy(L, LUA_ROUTE(type, op));	\
+	}
+
+#define LUA_WRAP_ITER(type,name,op)						\
+	static int iwinfo_L_##type##_##name(lua_State *L)	\
+	{													\
+		return iwinfo_L_##op##_iter(L, LUA_ROUTE(type, op));	\
+	}
+
+#define LUA_WRAP_SCAN(type)								\
+	static int iwinfo_L_##type##_scan_start(lua_State *L)	\
+	{													\
+		return iwinfo_L_scan_start(L, &type##_ops);		\
 	}
 
 #endif
\ No newline at end of file
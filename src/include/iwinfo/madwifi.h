@@ -42,6 +42,8 @@ int madwifi_get_quality(const char *ifname, int *buf);
 int madwifi_get_quality_max(const char *ifname, int *buf);
 int madwifi_get_encryption(const char *ifname, char *buf);
 int madwifi_get_assoclist(const char *ifname, char *buf, int *len);
+int madwifi_get_station(const char *ifname, const uint8_t *mac,
+                        struct iwinfo_assoclist_ext_entry *e);
 int madwifi_get_txpwrlist(const char *ifname, char *buf, int *len);
 int madwifi_get_scanlist(const char *ifname, char *buf, int *len);
 int madwifi_get_freqlist(const char *ifname, char *buf, int *len);
@@ -73,6 +75,7 @@ static const struct iwinfo_ops madwifi_ops = {
 	.hardware_name    = madwifi_get_hardware_name,
 	.encryption       = madwifi_get_encryption,
 	.assoclist        = madwifi_get_assoclist,
+	.station          = madwifi_get_station,
 	.txpwrlist        = madwifi_get_txpwrlist,
 	.scanlist         = madwifi_get_scanlist,
 	.freqlist         = madwifi_get_freqlist,
@@ -26,6 +26,8 @@
 #include <dirent.h>
 #include <signal.h>
 #include <sys/un.h>
+#include <poll.h>
+#include <time.h>
 #include <netlink/netlink.h>
 #include <netlink/genl/genl.h>
 #include <netlink/genl/family.h>
@@ -37,9 +39,12 @@
 
 struct nl80211_state {
 	struct nl_sock *nl_sock;
+	struct nl_sock *nl_evsock;
 	struct nl_cache *nl_cache;
 	struct genl_family *nl80211;
 	struct genl_family *nlctrl;
+	int dump_intr;
+	int msg_err;
 };
 
 struct nl80211_msg_conveyor {
@@ -50,6 +55,7 @@ struct nl80211_msg_conveyor {
 struct nl80211_event_conveyor {
 	int wait;
 	int recv;
+	uint32_t ifidx;
 };
 
 struct nl80211_group_conveyor {
@@ -57,6 +63,28 @@ struct nl80211_group_conveyor {
 	int id;
 };
 
+struct nl80211_wpactl {
+	int sock;
+	struct sockaddr_un local;
+};
+
+struct nl80211_scan_handle {
+	struct nl_sock *sock;
+	struct nl_cb *cb;
+	struct nl80211_wpactl ctl;
+	int ifidx;
+};
+
+struct nl80211_event_handle {
+	struct nl_sock *sock;
+	struct nl_cb *cb;
+	int ifidx;
+	int phyidx;
+	int head;
+	int count;
+	struct iwinfo_event queue[IWINFO_EVENT_QUEUE];
+};
+
 struct nl80211_rssi_rate {
 	int16_t rate;
 	int8_t  rssi;
@@ -67,6 +95,65 @@ struct nl80211_array_buf {
 	int count;
 };
 
+struct nl80211_assoclist {
+	struct iwinfo_assoclist_ext_entry *e;
+	int count;
+	const struct iwinfo_filter *filter;
+};
+
+#define NL80211_ASSOCLIST_MAX \
+	(IWINFO_BUFSIZE / sizeof(struct iwinfo_assoclist_ext_entry))
+
+#define NL80211_SCHED_MAX	4
+
+struct nl80211_sched {
+	char ifname[IFNAMSIZ];
+	int ifidx;
+	int interval;
+	int kernel;
+	int pending;
+	uint64_t triggered;
+	uint64_t stamp;
+	int len;
+	char *buf;
+};
+
+#define NL80211_SURVEY_MAX	128
+
+struct nl80211_survey {
+	char ifname[IFNAMSIZ];
+	uint64_t stamp;
+	int valid;
+	int count;
+	struct iwinfo_survey_entry e[NL80211_SURVEY_MAX];
+};
+
+struct nl80211_survey_dump {
+	struct iwinfo_survey_entry *e;
+	int count;
+};
+
+struct nl80211_bss_node {
+	uint8_t  change;
+	uint8_t  known;
+	uint32_t iehash;
+	uint32_t generation;
+	uint32_t seen;
+	uint32_t age;
+	struct iwinfo_scanlist_entry e;
+};
+
+struct nl80211_bss_table {
+	char ifname[IFNAMSIZ];
+	uint32_t serial;
+	int dumped;
+	int count;
+	int size;
+	int *index;
+	struct nl80211_bss_node *nodes;
+	struct iwinfo_ie_set *ies;
+};
+
 int nl80211_probe(const char *ifname);
 int nl80211_get_mode(const char *ifname, int *buf);
 int nl80211_get_ssid(const char *ifname, char *buf);
@@ -84,14 +171,37 @@ int nl80211_get_quality(const char *ifname, int *buf);
 int nl80211_get_quality_max(const char *ifname, int *buf);
 int nl80211_get_encryption(const char *ifname, char *buf);
 int nl80211_get_assoclist(const char *ifname, char *buf, int *len);
+int nl80211_get_assoclist_ext(const char *ifname, char *buf, int *len);
+int nl80211_get_assoclist_filter(const char *ifname,
+                                 const struct iwinfo_filter *f,
+                                 char *buf, int *len);
+int nl80211_get_station(const char *ifname, const uint8_t *mac,
+                        struct iwinfo_assoclist_ext_entry *e);
 int nl80211_get_txpwrlist(const char *ifname, char *buf, int *len);
 int nl80211_get_scanlist(const char *ifname, char *buf, int *len);
+int nl80211_get_scanlist_ext(const char *ifname, char *buf, int *len);
+int nl80211_get_scanlist_delta(const char *ifname, char *buf, int *len);
+int nl80211_get_scanlist_filter(const char *ifname,
+                                const struct iwinfo_filter *f,
+                                char *buf, int *len);
+int nl80211_scan_trigger(const char *ifname, struct iwinfo_scan *s);
+int nl80211_scan_ready(struct iwinfo_scan *s);
+int nl80211_scan_results(struct iwinfo_scan *s, char *buf, int *len);
+void nl80211_scan_close(struct iwinfo_scan *s);
+int nl80211_events_open(const char *ifname, struct iwinfo_events *ev);
+int nl80211_events_read(struct iwinfo_events *ev, struct iwinfo_event *e);
+void nl80211_events_close(struct iwinfo_events *ev);
+int nl80211_scan_schedule(const char *ifname, int interval);
+int nl80211_get_scan_age(const char *ifname, int *buf);
 int nl80211_get_freqlist(const char *ifname, char *buf, int *len);
+int nl80211_get_survey(const char *ifname, char *buf, int *len);
 int nl80211_get_countrylist(const char *ifname, char *buf, int *len);
 int nl80211_get_hwmodelist(const char *ifname, int *buf);
 int nl80211_get_mbssid_support(const char *ifname, int *buf);
 int nl80211_get_hardware_id(const char *ifname, char *buf);
 int nl80211_get_hardware_name(const char *ifname, char *buf);
+int nl80211_get_phyname(const char *ifname, char *buf);
+int nl80211_get_info(const char *ifname, struct iwinfo_info *info);
 void nl80211_close(void);
 
 static const struct iwinfo_ops nl80211_ops = {
@@ -113,11 +223,29 @@ static const struct iwinfo_ops nl80211_ops = {
 	.country          = nl80211_get_country,
 	.hardware_id      = nl80211_get_hardware_id,
 	.hardware_name    = nl80211_get_hardware_name,
+	.phyname          = nl80211_get_phyname,
 	.encryption       = nl80211_get_encryption,
+	.info             = nl80211_get_info,
 	.assoclist        = nl80211_get_assoclist,
+	.assoclist_ext    = nl80211_get_assoclist_ext,
+	.scanlist_ext     = nl80211_get_scanlist_ext,
+	.assoclist_filter = nl80211_get_assoclist_filter,
+	.station          = nl80211_get_station,
 	.txpwrlist        = nl80211_get_txpwrlist,
 	.scanlist         = nl80211_get_scanlist,
+	.scanlist_delta   = nl80211_get_scanlist_delta,
+	.scanlist_filter  = nl80211_get_scanlist_filter,
+	.scan_trigger     = nl80211_scan_trigger,
+	.scan_ready       = nl80211_scan_ready,
+	.scan_results     = nl80211_scan_results,
+	.scan_close       = nl80211_scan_close,
+	.events_open      = nl80211_events_open,
+	.events_read      = nl80211_events_read,
+	.events_close     = nl80211_events_close,
+	.scan_schedule    = nl80211_scan_schedule,
+	.scan_age         = nl80211_get_scan_age,
 	.freqlist         = nl80211_get_freqlist,
+	.survey           = nl80211_get_survey,
 	.countrylist      = nl80211_get_countrylist,
 	.close            = nl80211_close
 };
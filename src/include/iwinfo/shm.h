@@ -0,0 +1,112 @@
+/*
+ * iwinfo - Wireless Information Library - Shared Memory Snapshot Headers
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef __IWINFO_SHM_H_
+#define __IWINFO_SHM_H_
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <sched.h>
+
+#include "iwinfo.h"
+
+#define IWINFO_SHM_DIR		"/dev/shm"
+#define IWINFO_SHM_MAGIC	0x69775348	/* "iwSH" */
+#define IWINFO_SHM_MAPS		8
+#define IWINFO_SHM_RETRIES	64
+#define IWINFO_SHM_SLACK	1000		/* ms */
+
+#define IWINFO_SHM_INFO		(1 << 0)
+#define IWINFO_SHM_ASSOC	(1 << 1)
+#define IWINFO_SHM_SURVEY	(1 << 2)
+
+/*
+ * Layout of IWINFO_SHM_DIR/iwinfo.<ifname>. The publisher makes seq odd
+ * while it updates the region and even again once done, readers copy the
+ * data out and retry if seq was odd or changed meanwhile. stamp is taken
+ * from CLOCK_MONOTONIC in ms, a snapshot counts as stale once it is older
+ * than twice the publishing interval. The stations in assoc are struct
+ * iwinfo_assoclist_ext_entry.
+ */
+struct iwinfo_shm_region {
+	uint32_t magic;
+	uint32_t size;
+	volatile uint32_t seq;
+	uint32_t valid;
+	uint64_t stamp;
+	int interval;
+	int assoc_len;
+	int survey_len;
+	struct iwinfo_info info;
+	char assoc[IWINFO_BUFSIZE];
+	char survey[IWINFO_BUFSIZE];
+};
+
+int shm_probe(const char *ifname, int section);
+int shm_get_mode(const char *ifname, int *buf);
+int shm_get_ssid(const char *ifname, char *buf);
+int shm_get_bssid(const char *ifname, char *buf);
+int shm_get_country(const char *ifname, char *buf);
+int shm_get_channel(const char *ifname, int *buf);
+int shm_get_frequency(const char *ifname, int *buf);
+int shm_get_frequency_offset(const char *ifname, int *buf);
+int shm_get_txpower(const char *ifname, int *buf);
+int shm_get_txpower_offset(const char *ifname, int *buf);
+int shm_get_bitrate(const char *ifname, int *buf);
+int shm_get_signal(const char *ifname, int *buf);
+int shm_get_noise(const char *ifname, int *buf);
+int shm_get_quality(const char *ifname, int *buf);
+int shm_get_quality_max(const char *ifname, int *buf);
+int shm_get_encryption(const char *ifname, char *buf);
+int shm_get_info(const char *ifname, struct iwinfo_info *info);
+int shm_get_assoclist(const char *ifname, char *buf, int *len);
+int shm_get_assoclist_ext(const char *ifname, char *buf, int *len);
+int shm_get_survey(const char *ifname, char *buf, int *len);
+int shm_get_hwmodelist(const char *ifname, int *buf);
+int shm_get_mbssid_support(const char *ifname, int *buf);
+int shm_get_hardware_id(const char *ifname, char *buf);
+int shm_get_hardware_name(const char *ifname, char *buf);
+void shm_close(void);
+
+static const struct iwinfo_ops shm_ops = {
+	.mode             = shm_get_mode,
+	.channel          = shm_get_channel,
+	.frequency        = shm_get_frequency,
+	.frequency_offset = shm_get_frequency_offset,
+	.txpower          = shm_get_txpower,
+	.txpower_offset   = shm_get_txpower_offset,
+	.bitrate          = shm_get_bitrate,
+	.signal           = shm_get_signal,
+	.noise            = shm_get_noise,
+	.quality          = shm_get_quality,
+	.quality_max      = shm_get_quality_max,
+	.mbssid_support   = shm_get_mbssid_support,
+	.hwmodelist       = shm_get_hwmodelist,
+	.ssid             = shm_get_ssid,
+	.bssid            = shm_get_bssid,
+	.country          = shm_get_country,
+	.hardware_id      = shm_get_hardware_id,
+	.hardware_name    = shm_get_hardware_name,
+	.encryption       = shm_get_encryption,
+	.info             = shm_get_info,
+	.assoclist        = shm_get_assoclist,
+	.survey           = shm_get_survey,
+	.close            = shm_close,
+	.assoclist_ext    = shm_get_assoclist_ext
+};
+
+#endif
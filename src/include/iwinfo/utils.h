@@ -20,12 +20,21 @@
 #define __IWINFO_UTILS_H_
 
 #include <sys/socket.h>
+#include <sys/file.h>
 #include <net/if.h>
+#include <time.h>
 
 #include "iwinfo.h"
 
 #define LOG10_MAGIC	1.25892541179
 
+#define IWINFO_ARENA_CHUNK	16384
+
+#define IWINFO_SCAN_CACHE_DIR		"/var/run"
+#define IWINFO_SCAN_CACHE_MAGIC		0x69775344	/* "iwSD" */
+#define IWINFO_SCAN_WINDOW			5000		/* ms */
+#define IWINFO_SCAN_LOCK_WAIT		15000		/* ms */
+
 int iwinfo_ioctl(int cmd, void *ifr);
 
 int iwinfo_dbm2mw(int in);
@@ -37,11 +46,110 @@ int iwinfo_ifmac(const char *ifname);
 
 void iwinfo_close(void);
 
+uint64_t iwinfo_msecs(void);
+
+int iwinfo_resolved_ifindex(const char *ifname);
+const char * iwinfo_resolved_phy(const char *ifname);
+
+/* Add n to a counter of the operation currently running, compiled out
+ * unless the library is built with USE_STATS */
+#ifdef USE_STATS
+void iwinfo_stats_count(int counter, uint64_t n);
+#define IWINFO_STATS_COUNT(counter, n) \
+	iwinfo_stats_count(IWINFO_STATS_##counter, n)
+#else
+#define IWINFO_STATS_COUNT(counter, n) do { } while (0)
+#endif
+
 struct iwinfo_hardware_entry * iwinfo_hardware(struct iwinfo_hardware_id *id);
 
 int iwinfo_hardware_id_from_mtd(struct iwinfo_hardware_id *id);
 
+void * iwinfo_arena_alloc(struct iwinfo_arena *a, size_t len);
+void iwinfo_arena_reset(struct iwinfo_arena *a);
+void iwinfo_arena_free(struct iwinfo_arena *a);
+
+struct iwinfo_ie_blob * iwinfo_ie_blob(struct iwinfo_arena *a,
+                                       const uint8_t *ies, int len);
+struct iwinfo_ie_blob * iwinfo_ie_blob_append(struct iwinfo_arena *a,
+                                              struct iwinfo_ie_blob *b,
+                                              const uint8_t *ies, int len);
+
+/*
+ * IEs of the last scan of a device, owned by the library and looked up by
+ * BSSID when scan results are widened to extended entries.
+ */
+#define IWINFO_IE_SET_MAX \
+	(IWINFO_BUFSIZE / sizeof(struct iwinfo_scanlist_entry))
+#define IWINFO_IE_SET_SLOTS	(2 * IWINFO_IE_SET_MAX)
+
+struct iwinfo_ie_ref {
+	uint8_t mac[6];
+	struct iwinfo_ie_blob *ies;
+};
+
+struct iwinfo_ie_set {
+	struct iwinfo_ie_set *next;
+	char ifname[IFNAMSIZ];
+	struct iwinfo_arena arena;
+	int count;
+	struct iwinfo_ie_ref refs[IWINFO_IE_SET_MAX];
+	int index[IWINFO_IE_SET_SLOTS];
+};
+
+struct iwinfo_ie_set * iwinfo_ie_set(const char *ifname);
+void iwinfo_ie_set_reset(struct iwinfo_ie_set *s);
+void iwinfo_ie_set_put(struct iwinfo_ie_set *s, const uint8_t *mac,
+                       struct iwinfo_ie_blob *b);
+struct iwinfo_ie_blob * iwinfo_ie_set_get(const struct iwinfo_ie_set *s,
+                                          const uint8_t *mac);
+void iwinfo_ie_sets_free(void);
+
+void iwinfo_scanlist_widen(const char *ifname, char *buf, int *len, int max);
+
+int iwinfo_filter_signal(const struct iwinfo_filter *f, int signal);
+int iwinfo_filter_has_channel(const struct iwinfo_filter *f, int channel);
+int iwinfo_filter_ssid(const struct iwinfo_filter *f,
+                       const uint8_t *ssid, int len);
+
+int iwinfo_assoc_signal(const void *e);
+int iwinfo_scan_signal(const void *e);
+
+int iwinfo_topn_push(void *base, int *count, int n, size_t size,
+                     const void *entry, int (*signal)(const void *));
+void iwinfo_topn_sort(void *base, int count, size_t size,
+                      int (*signal)(const void *));
+
+void iwinfo_filter_assoclist(const struct iwinfo_filter *f, char *buf, int *len);
+void iwinfo_filter_scanlist(const struct iwinfo_filter *f, char *buf, int *len);
+
+void iwinfo_assoclist_widen(char *buf, int *len, int max);
+void iwinfo_assoclist_narrow(char *buf, int *len);
+
+#define IWINFO_SCAN_MERGE_SLOTS \
+	(2 * (IWINFO_BUFSIZE / sizeof(struct iwinfo_scan_multi_entry)))
+
+struct iwinfo_scan_merge {
+	struct iwinfo_scan_multi_entry *e;
+	int count;
+	int max;
+	int index[IWINFO_SCAN_MERGE_SLOTS];
+};
+
+void iwinfo_scan_merge_init(struct iwinfo_scan_merge *m, char *buf, int len);
+void iwinfo_scan_merge_add(struct iwinfo_scan_merge *m, const char *buf,
+                           int len, uint32_t radios);
+
+int iwinfo_rates_update(const char *ifname,
+                        const struct iwinfo_assoclist_ext_entry *e, int count,
+                        int window, struct iwinfo_assoclist_rates *r);
+void iwinfo_rates_free(void);
+
+int iwinfo_scan_shared(const char *key, const char *ifname, char *buf,
+                       int *len, int store,
+                       int (*scan)(const char *, char *, int *));
+
 void iwinfo_parse_rsn(struct iwinfo_crypto_entry *c, uint8_t *data, uint8_t len,
-					  uint8_t defcipher, uint8_t defauth);
+					  uint16_t defcipher, uint8_t defauth);
 
 #endif
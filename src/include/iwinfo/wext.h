@@ -45,6 +45,7 @@ int wext_get_encryption(const char *ifname, char *buf);
 int wext_get_assoclist(const char *ifname, char *buf, int *len);
 int wext_get_txpwrlist(const char *ifname, char *buf, int *len);
 int wext_get_scanlist(const char *ifname, char *buf, int *len);
+int wext_get_scanlist_ext(const char *ifname, char *buf, int *len);
 int wext_get_freqlist(const char *ifname, char *buf, int *len);
 int wext_get_countrylist(const char *ifname, char *buf, int *len);
 int wext_get_hwmodelist(const char *ifname, int *buf);
@@ -76,6 +77,7 @@ static const struct iwinfo_ops wext_ops = {
 	.assoclist        = wext_get_assoclist,
 	.txpwrlist        = wext_get_txpwrlist,
 	.scanlist         = wext_get_scanlist,
+	.scanlist_ext     = wext_get_scanlist_ext,
 	.freqlist         = wext_get_freqlist,
 	.countrylist      = wext_get_countrylist,
 	.close            = wext_close
@@ -43,6 +43,9 @@ int wl_get_quality_max(const char *ifname, int *buf);
 int wl_get_enctype(const char *ifname, char *buf);
 int wl_get_encryption(const char *ifname, char *buf);
 int wl_get_assoclist(const char *ifname, char *buf, int *len);
+int wl_get_assoclist_ext(const char *ifname, char *buf, int *len);
+int wl_get_station(const char *ifname, const uint8_t *mac,
+                   struct iwinfo_assoclist_ext_entry *e);
 int wl_get_txpwrlist(const char *ifname, char *buf, int *len);
 int wl_get_scanlist(const char *ifname, char *buf, int *len);
 int wl_get_freqlist(const char *ifname, char *buf, int *len);
@@ -74,6 +77,8 @@ static const struct iwinfo_ops wl_ops = {
 	.hardware_name    = wl_get_hardware_name,
 	.encryption       = wl_get_encryption,
 	.assoclist        = wl_get_assoclist,
+	.assoclist_ext    = wl_get_assoclist_ext,
+	.station          = wl_get_station,
 	.txpwrlist        = wl_get_txpwrlist,
 	.scanlist         = wl_get_scanlist,
 	.freqlist         = wl_get_freqlist,
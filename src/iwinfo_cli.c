@@ -18,6 +18,10 @@
 
 #include <stdio.h>
 #include <glob.h>
+#include <poll.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stddef.h>
 
 #include "iwinfo.h"
 
@@ -158,6 +162,15 @@ static char * format_enc_ciphers(int ciphers)
 	if (ciphers & IWINFO_CIPHER_CCMP)
 		pos += sprintf(pos, "CCMP, ");
 
+	if (ciphers & IWINFO_CIPHER_CCMP256)
+		pos += sprintf(pos, "CCMP-256, ");
+
+	if (ciphers & IWINFO_CIPHER_GCMP)
+		pos += sprintf(pos, "GCMP, ");
+
+	if (ciphers & IWINFO_CIPHER_GCMP256)
+		pos += sprintf(pos, "GCMP-256, ");
+
 	if (ciphers & IWINFO_CIPHER_WRAP)
 		pos += sprintf(pos, "WRAP, ");
 
@@ -186,6 +199,12 @@ static char * format_enc_suites(int suites)
 	if (suites & IWINFO_KMGMT_8021x)
 		pos += sprintf(pos, "802.1X/");
 
+	if (suites & IWINFO_KMGMT_SAE)
+		pos += sprintf(pos, "SAE/");
+
+	if (suites & IWINFO_KMGMT_OWE)
+		pos += sprintf(pos, "OWE/");
+
 	if (!suites || (suites & IWINFO_KMGMT_NONE))
 		pos += sprintf(pos, "NONE/");
 
@@ -211,17 +230,17 @@ static char * format_encryption(struct iwinfo_crypto_entry *c)
 				(c->auth_algs & IWINFO_AUTH_SHARED))
 			{
 				snprintf(buf, sizeof(buf), "WEP Open/Shared (%s)",
-					format_enc_ciphers(c->pair_ciphers));
+					format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair)));
 			}
 			else if (c->auth_algs & IWINFO_AUTH_OPEN)
 			{
 				snprintf(buf, sizeof(buf), "WEP Open System (%s)",
-					format_enc_ciphers(c->pair_ciphers));
+					format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair)));
 			}
 			else if (c->auth_algs & IWINFO_AUTH_SHARED)
 			{
 				snprintf(buf, sizeof(buf), "WEP Shared Auth (%s)",
-					format_enc_ciphers(c->pair_ciphers));
+					format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair)));
 			}
 		}
 
@@ -232,19 +251,22 @@ static char * format_encryption(struct iwinfo_crypto_entry *c)
 				case 3:
 					snprintf(buf, sizeof(buf), "mixed WPA/WPA2 %s (%s)",
 						format_enc_suites(c->auth_suites),
-						format_enc_ciphers(c->pair_ciphers | c->group_ciphers));
+						format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair) |
+						                   IWINFO_CRYPTO_CIPHERS(c, group)));
 					break;
 
 				case 2:
 					snprintf(buf, sizeof(buf), "WPA2 %s (%s)",
 						format_enc_suites(c->auth_suites),
-						format_enc_ciphers(c->pair_ciphers | c->group_ciphers));
+						format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair) |
+						                   IWINFO_CRYPTO_CIPHERS(c, group)));
 					break;
 
 				case 1:
 					snprintf(buf, sizeof(buf), "WPA %s (%s)",
 						format_enc_suites(c->auth_suites),
-						format_enc_ciphers(c->pair_ciphers | c->group_ciphers));
+						format_enc_ciphers(IWINFO_CRYPTO_CIPHERS(c, pair) |
+						                   IWINFO_CRYPTO_CIPHERS(c, group)));
 					break;
 			}
 		}
@@ -306,6 +328,383 @@ static char * format_assocrate(struct iwinfo_rate_entry *r)
 }
 
 
+/*
+ * Machine readable output. Records are encoded straight into one static
+ * buffer which is written out whenever it runs low, long lists therefore
+ * stream entry by entry without any allocation. Field names follow the
+ * Lua binding, unavailable values are omitted.
+ *
+ * JSON: a single record becomes {"<name>":{...}}, a list {"<name>":[...]},
+ * each on its own line.
+ *
+ * Binary: the magic "IWB1" followed by records. A record is a big endian
+ * u16 payload length, the record name as u8 length + bytes and its fields,
+ * every field being u8 type, u8 key length, key and value:
+ *   'i' s32 BE, 'u' u64 BE, 'b' u8, 's' u8 length + bytes,
+ *   'o' / 'a' open an object / array, 'e' closes it and carries no key.
+ * Array members have an empty key, each list entry is a record of its own.
+ */
+
+enum {
+	OUT_TEXT,
+	OUT_JSON,
+	OUT_BINARY,
+};
+
+#define OUT_BUFSIZE    8192
+#define OUT_RECORDMAX  2048
+#define OUT_DEPTH      8
+
+static int out_format = OUT_TEXT;
+static char out_buf[OUT_BUFSIZE];
+static int out_len = 0;
+static int out_record = -1;
+static int out_list = 0;
+static int out_depth = 0;
+static uint8_t out_first[OUT_DEPTH];
+static char out_closer[OUT_DEPTH];
+
+static void out_flush(void)
+{
+	int rv, off = 0;
+
+	while (off < out_len)
+	{
+		if ((rv = write(1, out_buf + off, out_len - off)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		off += rv;
+	}
+
+	out_len = 0;
+}
+
+static void out_put(const void *p, int len)
+{
+	if (out_len + len > sizeof(out_buf))
+	{
+		/* binary records stay contiguous to patch their length, they are
+		 * bounded by OUT_RECORDMAX which record_begin keeps available */
+		if (out_record > -1)
+			return;
+
+		out_flush();
+
+		if (len > sizeof(out_buf))
+			len = sizeof(out_buf);
+	}
+
+	memcpy(out_buf + out_len, p, len);
+	out_len += len;
+}
+
+static void out_be(uint64_t v, int n)
+{
+	uint8_t b[8];
+	int i;
+
+	for (i = n - 1; i >= 0; i--, v >>= 8)
+		b[i] = v & 0xff;
+
+	out_put(b, n);
+}
+
+/* Length of the well-formed UTF-8 sequence at s or 0, overlong forms and
+ * surrogates are rejected like any other invalid byte */
+static int out_utf8_len(const uint8_t *s, int len)
+{
+	int i, n;
+	uint8_t lo = 0x80, hi = 0xbf;
+
+	if (s[0] >= 0xc2 && s[0] <= 0xdf)
+		n = 2;
+	else if (s[0] >= 0xe0 && s[0] <= 0xef)
+		n = 3;
+	else if (s[0] >= 0xf0 && s[0] <= 0xf4)
+		n = 4;
+	else
+		return 0;
+
+	if (s[0] == 0xe0)
+		lo = 0xa0;
+	else if (s[0] == 0xed)
+		hi = 0x9f;
+	else if (s[0] == 0xf0)
+		lo = 0x90;
+	else if (s[0] == 0xf4)
+		hi = 0x8f;
+
+	if (n > len)
+		return 0;
+
+	for (i = 1; i < n; i++, lo = 0x80, hi = 0xbf)
+		if (s[i] < lo || s[i] > hi)
+			return 0;
+
+	return n;
+}
+
+/* SSIDs are arbitrary bytes, whatever is not valid UTF-8 is escaped byte
+ * by byte as \u00XX to keep the document valid JSON */
+static void out_json_string(const char *s, int len)
+{
+	int i, n, run;
+	uint8_t c;
+	char esc[8];
+
+	out_put("\"", 1);
+
+	for (i = run = 0; i < len && s[i]; i += n)
+	{
+		c = s[i];
+		n = 1;
+
+		if (c >= 0x80)
+		{
+			if ((n = out_utf8_len((const uint8_t *)s + i, len - i)) > 0)
+				continue;
+
+			n = 1;
+		}
+		else if (c != '"' && c != '\\' && c >= 0x20)
+		{
+			continue;
+		}
+
+		out_put(s + run, i - run);
+		run = i + 1;
+
+		if (c == '"' || c == '\\')
+			snprintf(esc, sizeof(esc), "\\%c", c);
+		else
+			snprintf(esc, sizeof(esc), "\\u%04x", c);
+
+		out_put(esc, strlen(esc));
+	}
+
+	out_put(s + run, i - run);
+	out_put("\"", 1);
+}
+
+/* Emit the member separator and key of the next value */
+static void out_key(char type, const char *key)
+{
+	uint8_t n = key ? strlen(key) : 0;
+
+	if (out_format == OUT_BINARY)
+	{
+		out_put(&type, 1);
+		out_put(&n, 1);
+		out_put(key, n);
+		return;
+	}
+
+	if (out_depth && !out_first[out_depth])
+		out_put(",", 1);
+
+	out_first[out_depth] = 0;
+
+	if (key)
+	{
+		out_json_string(key, n);
+		out_put(":", 1);
+	}
+}
+
+static void out_open(const char *key, char type)
+{
+	out_key((type == '{') ? 'o' : 'a', key);
+
+	if (out_depth + 1 >= OUT_DEPTH)
+		return;
+
+	out_depth++;
+	out_first[out_depth] = 1;
+	out_closer[out_depth] = (type == '{') ? '}' : ']';
+
+	if (out_format == OUT_JSON)
+		out_put(&type, 1);
+}
+
+static void out_close(void)
+{
+	if (out_format == OUT_BINARY)
+		out_put("e\0", 2);
+	else
+		out_put(&out_closer[out_depth], 1);
+
+	out_depth--;
+}
+
+static void out_int(const char *key, int v)
+{
+	char buf[12];
+
+	out_key('i', key);
+
+	if (out_format == OUT_BINARY)
+		out_be((uint32_t)v, 4);
+	else
+		out_put(buf, snprintf(buf, sizeof(buf), "%d", v));
+}
+
+static void out_u64(const char *key, uint64_t v)
+{
+	char buf[24];
+
+	out_key('u', key);
+
+	if (out_format == OUT_BINARY)
+		out_be(v, 8);
+	else
+		out_put(buf, snprintf(buf, sizeof(buf), "%llu",
+		                      (unsigned long long)v));
+}
+
+static void out_bool(const char *key, int v)
+{
+	uint8_t b = !!v;
+
+	out_key('b', key);
+
+	if (out_format == OUT_BINARY)
+		out_put(&b, 1);
+	else if (b)
+		out_put("true", 4);
+	else
+		out_put("false", 5);
+}
+
+/* Strings are bounded by len as SSIDs are not necessarily terminated */
+static void out_strn(const char *key, const char *s, int len)
+{
+	uint8_t n = strnlen(s, (len > 255) ? 255 : len);
+
+	out_key('s', key);
+
+	if (out_format == OUT_BINARY)
+	{
+		out_put(&n, 1);
+		out_put(s, n);
+	}
+	else
+	{
+		out_json_string(s, n);
+	}
+}
+
+static void out_str(const char *key, const char *s)
+{
+	out_strn(key, s, 255);
+}
+
+static void out_names(const char *key, int mask, const char **names, int n)
+{
+	int i;
+
+	out_open(key, '[');
+
+	for (i = 0; i < n; i++)
+		if (mask & (1 << i))
+			out_str(NULL, names[i]);
+
+	out_close();
+}
+
+static void out_record_begin(const char *name)
+{
+	uint8_t n = strlen(name);
+
+	if (out_format == OUT_BINARY)
+	{
+		if (out_len + OUT_RECORDMAX > sizeof(out_buf))
+			out_flush();
+
+		out_record = out_len;
+		out_put("\0\0", 2);
+		out_put(&n, 1);
+		out_put(name, n);
+		return;
+	}
+
+	if (!out_list)
+	{
+		out_put("{", 1);
+		out_json_string(name, n);
+		out_put(":", 1);
+	}
+
+	out_open(NULL, '{');
+}
+
+static void out_record_end(void)
+{
+	int len;
+
+	if (out_format == OUT_BINARY)
+	{
+		len = out_len - out_record - 2;
+		out_buf[out_record]     = (len >> 8) & 0xff;
+		out_buf[out_record + 1] = len & 0xff;
+		out_record = -1;
+	}
+	else
+	{
+		out_close();
+
+		if (!out_list)
+			out_put("}\n", 2);
+	}
+
+	/* single records are mostly events, do not hold them back */
+	if (!out_list)
+		out_flush();
+	else if (out_len + OUT_RECORDMAX > sizeof(out_buf))
+		out_flush();
+}
+
+/* List entries are records named after the list, in JSON they are wrapped
+ * into one array instead */
+static void out_list_begin(const char *name)
+{
+	out_list = 1;
+
+	if (out_format != OUT_JSON)
+		return;
+
+	out_put("{", 1);
+	out_json_string(name, strlen(name));
+	out_put(":", 1);
+	out_open(NULL, '[');
+}
+
+static void out_list_end(void)
+{
+	out_list = 0;
+
+	if (out_format == OUT_JSON)
+	{
+		out_close();
+		out_put("}\n", 2);
+	}
+
+	out_flush();
+}
+
+static void out_error(const char *command, const char *message)
+{
+	out_record_begin("error");
+	out_str("command", command);
+	out_str("message", message);
+	out_record_end();
+}
+
+
 static const char * print_type(const struct iwinfo_ops *iw, const char *ifname)
 {
 	const char *type = iwinfo_type(ifname);
@@ -550,13 +949,113 @@ static void print_info(const struct iwinfo_ops *iw, const char *ifname)
 }
 
 
-static void print_scanlist(const struct iwinfo_ops *iw, const char *ifname)
+static void emit_crypto(struct iwinfo_crypto_entry *c)
+{
+	out_open("encryption", '{');
+	out_bool("enabled", c->enabled);
+	out_str("description", format_encryption(c));
+	out_bool("wep", c->enabled && !c->wpa_version);
+	out_int("wpa", c->wpa_version);
+	out_names("pair_ciphers", IWINFO_CRYPTO_CIPHERS(c, pair),
+	          IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+	out_names("group_ciphers", IWINFO_CRYPTO_CIPHERS(c, group),
+	          IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+	out_names("auth_suites", c->auth_suites,
+	          IWINFO_KMGMT_NAMES, IWINFO_KMGMT_COUNT);
+	out_names("auth_algs", c->auth_algs, IWINFO_AUTH_NAMES, 2);
+	out_close();
+}
+
+#define EMIT_INFO_INT(key, flag, val)			\
+	if (i.valid & IWINFO_INFO_##flag)			\
+		out_int(key, val)
+
+#define EMIT_INFO_STR(key, flag, val)			\
+	if (i.valid & IWINFO_INFO_##flag)			\
+		out_strn(key, val, sizeof(val))
+
+/* Unlike print_info() this gathers everything with a single bulk call */
+static void emit_info(const struct iwinfo_ops *iw, const char *ifname)
+{
+	struct iwinfo_info i;
+	const char *type = iwinfo_type(ifname);
+
+	if (iwinfo_info(iw, ifname, &i))
+		i.valid = 0;
+
+	out_record_begin("info");
+	out_str("ifname", ifname);
+
+	if (type)
+		out_str("type", type);
+
+	EMIT_INFO_STR("ssid",             SSID,             i.ssid);
+	EMIT_INFO_STR("bssid",            BSSID,            i.bssid);
+	EMIT_INFO_STR("country",          COUNTRY,          i.country);
+	EMIT_INFO_STR("hardware_name",    HARDWARE_NAME,    i.hardware_name);
+
+	if (i.valid & IWINFO_INFO_MODE)
+		out_str("mode", IWINFO_OPMODE_NAMES[i.mode]);
+
+	EMIT_INFO_INT("channel",          CHANNEL,          i.channel);
+	EMIT_INFO_INT("frequency",        FREQUENCY,        i.frequency);
+	EMIT_INFO_INT("frequency_offset", FREQUENCY_OFFSET, i.frequency_offset);
+	EMIT_INFO_INT("txpower",          TXPOWER,          i.txpower);
+	EMIT_INFO_INT("txpower_offset",   TXPOWER_OFFSET,   i.txpower_offset);
+	EMIT_INFO_INT("bitrate",          BITRATE,          i.bitrate);
+	EMIT_INFO_INT("signal",           SIGNAL,           i.signal);
+	EMIT_INFO_INT("noise",            NOISE,            i.noise);
+	EMIT_INFO_INT("quality",          QUALITY,          i.quality);
+	EMIT_INFO_INT("quality_max",      QUALITY_MAX,      i.quality_max);
+
+	if (i.valid & IWINFO_INFO_MBSSID_SUPPORT)
+		out_bool("mbssid_support", i.mbssid_support);
+
+	if (i.valid & IWINFO_INFO_HWMODES)
+	{
+		out_open("hwmodes", '[');
+
+		if (i.hwmodes & IWINFO_80211_A)
+			out_str(NULL, "a");
+
+		if (i.hwmodes & IWINFO_80211_B)
+			out_str(NULL, "b");
+
+		if (i.hwmodes & IWINFO_80211_G)
+			out_str(NULL, "g");
+
+		if (i.hwmodes & IWINFO_80211_N)
+			out_str(NULL, "n");
+
+		out_close();
+	}
+
+	if (i.valid & IWINFO_INFO_HARDWARE_ID)
+	{
+		out_open("hardware_id", '{');
+		out_int("vendor_id", i.hardware_id.vendor_id);
+		out_int("device_id", i.hardware_id.device_id);
+		out_int("subsystem_vendor_id", i.hardware_id.subsystem_vendor_id);
+		out_int("subsystem_device_id", i.hardware_id.subsystem_device_id);
+		out_close();
+	}
+
+	if (i.valid & IWINFO_INFO_ENCRYPTION)
+		emit_crypto(&i.crypto);
+
+	out_record_end();
+}
+
+
+static void print_scanlist(const struct iwinfo_ops *iw, const char *ifname,
+                           const struct iwinfo_filter *f)
 {
 	int i, x, len;
 	char buf[IWINFO_BUFSIZE];
 	struct iwinfo_scanlist_entry *e;
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
 
-	if (iw->scanlist(ifname, buf, &len))
+	if (iwinfo_scanlist_filter(iw, ifname, f, buf, &len))
 	{
 		printf("Scanning not possible\n\n");
 		return;
@@ -583,9 +1082,55 @@ static void print_scanlist(const struct iwinfo_ops *iw, const char *ifname)
 			format_signal(e->signal - 0x100),
 			format_quality(e->quality),
 			format_quality_max(e->quality_max));
-		printf("          Encryption: %s\n\n",
-			format_encryption(&e->crypto));
+
+		if (fields & IWINFO_FIELD_CRYPTO)
+			printf("          Encryption: %s\n",
+				format_encryption(&e->crypto));
+
+		printf("\n");
+	}
+}
+
+
+static void emit_scanlist(const struct iwinfo_ops *iw, const char *ifname,
+                          const struct iwinfo_filter *f)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_scanlist_entry *e;
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
+
+	if (iwinfo_scanlist_filter(iw, ifname, f, buf, &len))
+	{
+		out_error("scan", "Scanning not possible");
+		return;
+	}
+
+	out_list_begin("scan");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_scanlist_entry))
+	{
+		e = (struct iwinfo_scanlist_entry *) &buf[i];
+
+		out_record_begin("scan");
+		out_str("bssid", format_bssid(e->mac));
+
+		if (e->ssid[0])
+			out_strn("ssid", (char *)e->ssid, IWINFO_ESSID_MAX_SIZE);
+
+		out_str("mode", IWINFO_OPMODE_NAMES[e->mode]);
+		out_int("channel", e->channel);
+		out_int("signal", e->signal - 0x100);
+		out_int("quality", e->quality);
+		out_int("quality_max", e->quality_max);
+
+		if (fields & IWINFO_FIELD_CRYPTO)
+			emit_crypto(&e->crypto);
+
+		out_record_end();
 	}
+
+	out_list_end();
 }
 
 
@@ -619,6 +1164,41 @@ static void print_txpwrlist(const struct iwinfo_ops *iw, const char *ifname)
 }
 
 
+static void emit_txpwrlist(const struct iwinfo_ops *iw, const char *ifname)
+{
+	int len, pwr, off, i;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_txpwrlist_entry *e;
+
+	if (iw->txpwrlist(ifname, buf, &len))
+	{
+		out_error("txpowerlist", "No TX power information available");
+		return;
+	}
+
+	if (iw->txpower(ifname, &pwr))
+		pwr = -1;
+
+	if (iw->txpower_offset(ifname, &off))
+		off = 0;
+
+	out_list_begin("txpowerlist");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_txpwrlist_entry))
+	{
+		e = (struct iwinfo_txpwrlist_entry *) &buf[i];
+
+		out_record_begin("txpowerlist");
+		out_int("dbm", e->dbm + off);
+		out_int("mw", iwinfo_dbm2mw(e->dbm + off));
+		out_bool("active", pwr == e->dbm);
+		out_record_end();
+	}
+
+	out_list_end();
+}
+
+
 static void print_freqlist(const struct iwinfo_ops *iw, const char *ifname)
 {
 	int i, len, ch;
@@ -647,44 +1227,789 @@ static void print_freqlist(const struct iwinfo_ops *iw, const char *ifname)
 }
 
 
-static void print_assoclist(const struct iwinfo_ops *iw, const char *ifname)
+static void emit_freqlist(const struct iwinfo_ops *iw, const char *ifname)
 {
-	int i, len;
+	int i, len, ch;
 	char buf[IWINFO_BUFSIZE];
-	struct iwinfo_assoclist_entry *e;
+	struct iwinfo_freqlist_entry *e;
 
-	if (iw->assoclist(ifname, buf, &len))
+	if (iw->freqlist(ifname, buf, &len))
 	{
-		printf("No information available\n");
+		out_error("freqlist", "No frequency information available");
 		return;
 	}
-	else if (len <= 0)
-	{
-		printf("No station connected\n");
-		return;
+
+	if (iw->channel(ifname, &ch))
+		ch = -1;
+
+	out_list_begin("freqlist");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_freqlist_entry))
+	{
+		e = (struct iwinfo_freqlist_entry *) &buf[i];
+
+		out_record_begin("freqlist");
+		out_int("mhz", e->mhz);
+		out_int("channel", e->channel);
+		out_bool("restricted", e->restricted);
+		out_bool("active", ch == e->channel);
+		out_record_end();
 	}
 
-	for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_entry))
+	out_list_end();
+}
+
+
+static char * format_airtime(uint64_t part, uint64_t total)
+{
+	static char buf[32];
+
+	if (!total)
+		snprintf(buf, sizeof(buf), "%llu ms", (unsigned long long)part);
+	else
+		snprintf(buf, sizeof(buf), "%llu ms (%llu%%)",
+			(unsigned long long)part,
+			(unsigned long long)(part * 100 / total));
+
+	return buf;
+}
+
+static void print_survey(const struct iwinfo_ops *iw, const char *ifname)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_survey_entry *e;
+
+	if (!iw->survey || iw->survey(ifname, buf, &len) || len <= 0)
 	{
-		e = (struct iwinfo_assoclist_entry *) &buf[i];
+		printf("No survey information available\n");
+		return;
+	}
 
-		printf("%s  %s / %s (SNR %d)  %d ms ago\n",
-			format_bssid(e->mac),
-			format_signal(e->signal),
-			format_noise(e->noise),
-			(e->signal - e->noise),
-			e->inactive);
+	for (i = 0; i < len; i += sizeof(struct iwinfo_survey_entry))
+	{
+		e = (struct iwinfo_survey_entry *) &buf[i];
 
-		printf("	RX: %-38s  %8d Pkts.\n",
-			format_assocrate(&e->rx_rate),
-			e->rx_packets
-		);
+		printf("%s %s (Channel %s)  Noise: %s\n",
+			e->in_use ? "*" : " ",
+			format_frequency(e->mhz),
+			format_channel(e->channel),
+			format_noise(e->noise));
 
-		printf("	TX: %-38s  %8d Pkts.\n\n",
-			format_assocrate(&e->tx_rate),
-			e->tx_packets
-		);
+		if (!e->time)
+			continue;
+
+		printf("	Active: %llu ms  Busy: %s",
+			(unsigned long long)e->time,
+			format_airtime(e->time_busy, e->time));
+
+		printf("  RX: %s", format_airtime(e->time_rx, e->time));
+		printf("  TX: %s\n", format_airtime(e->time_tx, e->time));
+	}
+}
+
+static void emit_survey(const struct iwinfo_ops *iw, const char *ifname)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_survey_entry *e;
+
+	if (!iw->survey || iw->survey(ifname, buf, &len))
+	{
+		out_error("survey", "No survey information available");
+		return;
+	}
+
+	out_list_begin("survey");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_survey_entry))
+	{
+		e = (struct iwinfo_survey_entry *) &buf[i];
+
+		out_record_begin("survey");
+		out_int("mhz", e->mhz);
+		out_int("channel", e->channel);
+		out_bool("in_use", e->in_use);
+
+		if (e->noise)
+			out_int("noise", e->noise);
+
+		if (e->time)
+		{
+			out_u64("time", e->time);
+			out_u64("time_busy", e->time_busy);
+			out_u64("time_ext_busy", e->time_ext_busy);
+			out_u64("time_rx", e->time_rx);
+			out_u64("time_tx", e->time_tx);
+		}
+
+		out_record_end();
+	}
+
+	out_list_end();
+}
+
+/* One direction of a station, only the selected field groups */
+static void print_assoc_direction(const char *dir, struct iwinfo_rate_entry *r,
+                                  uint64_t packets, uint64_t bytes,
+                                  uint32_t fields)
+{
+	printf("	%s: ", dir);
+
+	if (fields & IWINFO_FIELD_RATES)
+		printf("%-38s", format_assocrate(r));
+
+	if (fields & IWINFO_FIELD_COUNTERS)
+		printf("  %8llu Pkts.  %12llu Bytes",
+			(unsigned long long)packets, (unsigned long long)bytes);
+
+	printf("\n");
+}
+
+static void print_assoc_entry(struct iwinfo_assoclist_ext_entry *x,
+                              uint32_t fields)
+{
+	struct iwinfo_assoclist_entry *e = &x->base;
+
+	printf("%s  %s / %s (SNR %d)  %d ms ago\n",
+		format_bssid(e->mac),
+		format_signal(e->signal),
+		format_noise(e->noise),
+		(e->signal - e->noise),
+		e->inactive);
+
+	if (fields & (IWINFO_FIELD_RATES | IWINFO_FIELD_COUNTERS))
+	{
+		print_assoc_direction("RX", &e->rx_rate,
+			x->rx_packets, x->rx_bytes, fields);
+
+		print_assoc_direction("TX", &e->tx_rate,
+			x->tx_packets, x->tx_bytes, fields);
+	}
+
+	if (fields & IWINFO_FIELD_COUNTERS)
+	{
+		printf("	Retries: %u  Failed: %u  Beacon loss: %u  Connected: %u s\n",
+			x->tx_retries, x->tx_failed, x->beacon_loss, x->connected_time);
+	}
+
+	printf("\n");
+}
+
+static void emit_rate(const char *prefix, struct iwinfo_rate_entry *r)
+{
+	char key[16];
+
+	snprintf(key, sizeof(key), "%s_rate", prefix);
+	out_int(key, r->rate);
+
+	if (r->mcs < 0)
+		return;
+
+	snprintf(key, sizeof(key), "%s_mcs", prefix);
+	out_int(key, r->mcs);
+
+	snprintf(key, sizeof(key), "%s_40mhz", prefix);
+	out_bool(key, r->is_40mhz);
+
+	snprintf(key, sizeof(key), "%s_short_gi", prefix);
+	out_bool(key, r->is_short_gi);
+}
+
+static void emit_assoc_entry(const char *name,
+                             struct iwinfo_assoclist_ext_entry *x,
+                             uint32_t fields)
+{
+	struct iwinfo_assoclist_entry *e = &x->base;
+
+	out_record_begin(name);
+	out_str("mac", format_bssid(e->mac));
+	out_int("signal", e->signal);
+	out_int("noise", e->noise);
+	out_int("inactive", e->inactive);
+
+	if (fields & IWINFO_FIELD_RATES)
+	{
+		emit_rate("rx", &e->rx_rate);
+		emit_rate("tx", &e->tx_rate);
+	}
+
+	if (fields & IWINFO_FIELD_COUNTERS)
+	{
+		out_u64("rx_packets", x->rx_packets);
+		out_u64("tx_packets", x->tx_packets);
+		out_u64("rx_bytes", x->rx_bytes);
+		out_u64("tx_bytes", x->tx_bytes);
+		out_u64("tx_retries", x->tx_retries);
+		out_u64("tx_failed", x->tx_failed);
+		out_u64("beacon_loss", x->beacon_loss);
+		out_u64("connected_time", x->connected_time);
+	}
+
+	out_record_end();
+}
+
+static void print_assoclist(const struct iwinfo_ops *iw, const char *ifname,
+                            const struct iwinfo_filter *f)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_assoclist_ext_entry *e;
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
+
+	if (iwinfo_assoclist_filter(iw, ifname, f, buf, &len))
+	{
+		printf("No information available\n");
+		return;
+	}
+	else if (len <= 0)
+	{
+		printf("No station connected\n");
+		return;
+	}
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_ext_entry))
+	{
+		e = (struct iwinfo_assoclist_ext_entry *) &buf[i];
+		print_assoc_entry(e, fields);
+	}
+}
+
+static void emit_assoclist(const struct iwinfo_ops *iw, const char *ifname,
+                           const struct iwinfo_filter *f)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
+
+	if (iwinfo_assoclist_filter(iw, ifname, f, buf, &len))
+	{
+		out_error("assoclist", "No information available");
+		return;
+	}
+
+	out_list_begin("assoclist");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_ext_entry))
+		emit_assoc_entry("assoclist",
+		                 (struct iwinfo_assoclist_ext_entry *) &buf[i], fields);
+
+	out_list_end();
+}
+
+static int print_station(const struct iwinfo_ops *iw, const char *ifname,
+                         const char *macstr, const struct iwinfo_filter *f)
+{
+	uint8_t mac[6];
+	struct iwinfo_assoclist_ext_entry e;
+
+	if (!macstr || sscanf(macstr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+	                      &mac[0], &mac[1], &mac[2],
+	                      &mac[3], &mac[4], &mac[5]) != 6)
+	{
+		fprintf(stderr, "Invalid station address: %s\n",
+			macstr ? macstr : "(none)");
+		return 1;
+	}
+
+	if (iwinfo_station_get(iw, ifname, mac, &e))
+	{
+		if (out_format)
+			out_error("station", "No such station");
+		else
+			printf("No such station\n");
+	}
+	else if (out_format)
+	{
+		emit_assoc_entry("station", &e, (f && f->fields) ? f->fields : ~0U);
+	}
+	else
+	{
+		print_assoc_entry(&e, (f && f->fields) ? f->fields : ~0U);
+	}
+
+	return 0;
+}
+
+
+/*
+ * Monitor mode samples the assoclist at a fixed interval from one process
+ * and prints what changed since the previous sample, or the per-interval
+ * rates of each station. The previous sample is kept in the second half
+ * of a double buffer, so a sample costs one dump and no copying.
+ */
+
+struct monitor_field {
+	const char *name;
+	uint32_t fields;
+	int offset;
+	int size;
+};
+
+#define MONITOR_FIELD(name, fields, member) \
+	{ name, fields, offsetof(struct iwinfo_assoclist_ext_entry, member), \
+	  sizeof(((struct iwinfo_assoclist_ext_entry *)0)->member) }
+
+/* inactive and connected_time change with every sample and are left out */
+static const struct monitor_field monitor_fields[] = {
+	MONITOR_FIELD("signal",      0,                      base.signal),
+	MONITOR_FIELD("noise",       0,                      base.noise),
+	MONITOR_FIELD("rx_rate",     IWINFO_FIELD_RATES,     base.rx_rate.rate),
+	MONITOR_FIELD("rx_mcs",      IWINFO_FIELD_RATES,     base.rx_rate.mcs),
+	MONITOR_FIELD("tx_rate",     IWINFO_FIELD_RATES,     base.tx_rate.rate),
+	MONITOR_FIELD("tx_mcs",      IWINFO_FIELD_RATES,     base.tx_rate.mcs),
+	MONITOR_FIELD("rx_packets",  IWINFO_FIELD_COUNTERS,  rx_packets),
+	MONITOR_FIELD("tx_packets",  IWINFO_FIELD_COUNTERS,  tx_packets),
+	MONITOR_FIELD("rx_bytes",    IWINFO_FIELD_COUNTERS,  rx_bytes),
+	MONITOR_FIELD("tx_bytes",    IWINFO_FIELD_COUNTERS,  tx_bytes),
+	MONITOR_FIELD("tx_retries",  IWINFO_FIELD_COUNTERS,  tx_retries),
+	MONITOR_FIELD("tx_failed",   IWINFO_FIELD_COUNTERS,  tx_failed),
+	MONITOR_FIELD("beacon_loss", IWINFO_FIELD_COUNTERS,  beacon_loss),
+};
+
+static char monitor_buf[2][IWINFO_BUFSIZE];
+static volatile sig_atomic_t monitor_stop = 0;
+
+static void monitor_signal(int sig)
+{
+	monitor_stop = 1;
+}
+
+static uint64_t monitor_usecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t monitor_value(const struct iwinfo_assoclist_ext_entry *e,
+                             const struct monitor_field *mf)
+{
+	const char *p = (const char *)e + mf->offset;
+
+	switch (mf->size)
+	{
+	case 1:
+		return *(const int8_t *)p;
+
+	case 4:
+		return *(const uint32_t *)p;
+
+	default:
+		return *(const uint64_t *)p;
+	}
+}
+
+/* Stations mostly keep their position between dumps, try that first */
+static struct iwinfo_assoclist_ext_entry * monitor_find(char *buf, int len,
+                                                     int hint,
+                                                     const uint8_t *mac)
+{
+	int i, n = len / sizeof(struct iwinfo_assoclist_ext_entry);
+	struct iwinfo_assoclist_ext_entry *e = (struct iwinfo_assoclist_ext_entry *)buf;
+
+	if (hint < n && !memcmp(e[hint].base.mac, mac, 6))
+		return &e[hint];
+
+	for (i = 0; i < n; i++)
+		if (!memcmp(e[i].base.mac, mac, 6))
+			return &e[i];
+
+	return NULL;
+}
+
+enum {
+	MONITOR_NEW,
+	MONITOR_UPDATE,
+	MONITOR_GONE,
+};
+
+static const char *monitor_changes[] = { "new", "update", "gone" };
+static const char monitor_marks[] = { '+', '~', '-' };
+
+#define MONITOR_FIELD_COUNT \
+	(sizeof(monitor_fields) / sizeof(monitor_fields[0]))
+
+static int monitor_changed(const struct iwinfo_assoclist_ext_entry *e,
+                           const struct iwinfo_assoclist_ext_entry *old,
+                           const struct monitor_field *mf, uint32_t fields)
+{
+	if (mf->fields && !(fields & mf->fields))
+		return 0;
+
+	return (!old || monitor_value(e, mf) != monitor_value(old, mf));
+}
+
+/* Print a station, updates only carry the fields which changed */
+static void monitor_change(int change, const struct iwinfo_assoclist_ext_entry *e,
+                           const struct iwinfo_assoclist_ext_entry *old,
+                           uint32_t fields)
+{
+	int i;
+	int64_t v;
+
+	if (out_format)
+	{
+		out_record_begin("changes");
+		out_str("change", monitor_changes[change]);
+		out_str("mac", format_bssid((unsigned char *)e->base.mac));
+	}
+	else
+	{
+		printf("%c %s", monitor_marks[change],
+			format_bssid((unsigned char *)e->base.mac));
+	}
+
+	for (i = 0; change != MONITOR_GONE && i < MONITOR_FIELD_COUNT; i++)
+	{
+		if (!monitor_changed(e, old, &monitor_fields[i], fields))
+			continue;
+
+		v = monitor_value(e, &monitor_fields[i]);
+
+		if (out_format && monitor_fields[i].size > 1)
+			out_u64(monitor_fields[i].name, v);
+		else if (out_format)
+			out_int(monitor_fields[i].name, v);
+		else
+			printf("  %s %lld", monitor_fields[i].name, (long long)v);
+	}
+
+	if (out_format)
+		out_record_end();
+	else
+		printf("\n");
+}
+
+static void monitor_diff(int cur, int *len, uint32_t fields)
+{
+	int i, k, prev = !cur;
+	struct iwinfo_assoclist_ext_entry *e, *old;
+
+	if (out_format)
+		out_list_begin("changes");
+
+	for (i = 0; i < len[cur]; i += sizeof(*e))
+	{
+		e = (struct iwinfo_assoclist_ext_entry *) &monitor_buf[cur][i];
+		old = monitor_find(monitor_buf[prev], len[prev], i / sizeof(*e), e->base.mac);
+
+		if (!old)
+		{
+			monitor_change(MONITOR_NEW, e, NULL, fields);
+			continue;
+		}
+
+		for (k = 0; k < MONITOR_FIELD_COUNT; k++)
+		{
+			if (monitor_changed(e, old, &monitor_fields[k], fields))
+			{
+				monitor_change(MONITOR_UPDATE, e, old, fields);
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < len[prev]; i += sizeof(*e))
+	{
+		old = (struct iwinfo_assoclist_ext_entry *) &monitor_buf[prev][i];
+
+		if (!monitor_find(monitor_buf[cur], len[cur], i / sizeof(*e), old->base.mac))
+			monitor_change(MONITOR_GONE, old, NULL, fields);
+	}
+
+	if (out_format)
+		out_list_end();
+}
+
+static void monitor_rates(char *buf, int len)
+{
+	int i;
+	struct iwinfo_assoclist_rates *r;
+
+	if (out_format)
+		out_list_begin("rates");
+
+	for (i = 0; i < len; i += sizeof(*r))
+	{
+		r = (struct iwinfo_assoclist_rates *) &buf[i];
+
+		/* no earlier sample of this station yet */
+		if (!r->interval)
+			continue;
+
+		if (!out_format)
+		{
+			printf("%s  RX: %llu B/s %u Pkts/s  TX: %llu B/s %u Pkts/s"
+			       "  Retries: %u.%02u%%  Failed: %u.%02u%%\n",
+				format_bssid(r->mac),
+				(unsigned long long)r->rx_byte_rate, r->rx_packet_rate,
+				(unsigned long long)r->tx_byte_rate, r->tx_packet_rate,
+				r->tx_retry_ratio / 100, r->tx_retry_ratio % 100,
+				r->tx_fail_ratio / 100, r->tx_fail_ratio % 100);
+			continue;
+		}
+
+		out_record_begin("rates");
+		out_str("mac", format_bssid(r->mac));
+		out_int("interval", r->interval);
+		out_u64("rx_byte_rate", r->rx_byte_rate);
+		out_u64("tx_byte_rate", r->tx_byte_rate);
+		out_int("rx_packet_rate", r->rx_packet_rate);
+		out_int("tx_packet_rate", r->tx_packet_rate);
+		out_int("tx_retry_ratio", r->tx_retry_ratio);
+		out_int("tx_fail_ratio", r->tx_fail_ratio);
+		out_record_end();
+	}
+
+	if (out_format)
+		out_list_end();
+}
+
+static int print_monitor(const char *ifname, const struct iwinfo_filter *f,
+                         int interval, int rates)
+{
+	int rv, cur = 0, len[2] = { 0, 0 };
+	uint64_t start, now, next, latency;
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
+	const struct iwinfo_ops *iw;
+	struct sigaction sa = { .sa_handler = monitor_signal };
+	struct timespec ts;
+
+	/* sample the driver directly, the daemon would serve cached copies */
+	iwinfo_client(0);
+
+	if (interval <= 0)
+	{
+		fprintf(stderr, "Invalid interval: %d\n", interval);
+		return 1;
+	}
+
+	if (!(iw = iwinfo_backend(ifname)))
+	{
+		fprintf(stderr, "No such wireless device: %s\n", ifname);
+		return 1;
+	}
+
+	/* no SA_RESTART, the signal has to interrupt nanosleep() */
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	start = next = monitor_usecs();
+
+	while (!monitor_stop)
+	{
+		now = monitor_usecs();
+
+		if (rates)
+			rv = iwinfo_assoclist_rates(iw, ifname, 1, monitor_buf[cur], &len[cur]);
+		else
+			rv = iwinfo_assoclist_filter(iw, ifname, f, monitor_buf[cur], &len[cur]);
+
+		latency = monitor_usecs() - now;
+
+		if (rv)
+		{
+			if (out_format)
+				out_error("monitor", "No information available");
+			else
+				printf("No information available\n");
+		}
+		else if (out_format)
+		{
+			out_record_begin("sample");
+			out_u64("time", (now - start) / 1000);
+			out_u64("latency", latency);
+			out_int("stations", len[cur] / (rates
+				? sizeof(struct iwinfo_assoclist_rates)
+				: sizeof(struct iwinfo_assoclist_ext_entry)));
+			out_record_end();
+		}
+		else
+		{
+			printf("[%llu ms] %d stations, sampled in %llu us\n",
+				(unsigned long long)(now - start) / 1000,
+				(int)(len[cur] / (rates
+					? sizeof(struct iwinfo_assoclist_rates)
+					: sizeof(struct iwinfo_assoclist_ext_entry))),
+				(unsigned long long)latency);
+		}
+
+		if (!rv && rates)
+			monitor_rates(monitor_buf[cur], len[cur]);
+		else if (!rv)
+			monitor_diff(cur, len, fields);
+
+		if (!out_format)
+			fflush(stdout);
+
+		/* a failed sample keeps the previous one as reference */
+		if (!rv)
+			cur = !cur;
+
+		/* keep to the schedule, samples missed while overrunning are
+		 * dropped rather than taken back to back */
+		next += (uint64_t)interval * 1000;
+		now = monitor_usecs();
+
+		while (next <= now)
+			next += (uint64_t)interval * 1000;
+
+		ts.tv_sec  = (next - now) / 1000000;
+		ts.tv_nsec = ((next - now) % 1000000) * 1000;
+		nanosleep(&ts, NULL);
+	}
+
+	out_flush();
+	return 0;
+}
+
+
+static void print_event(struct iwinfo_event *e)
+{
+	printf("%-10s %-15s", e->ifname[0] ? e->ifname : "-",
+		IWINFO_EVENT_NAMES[e->type]);
+
+	switch (e->type)
+	{
+	case IWINFO_EVENT_STA_NEW:
+	case IWINFO_EVENT_STA_DEL:
+		printf(" %s", format_bssid(e->u.sta.mac));
+		break;
+
+	case IWINFO_EVENT_CHANNEL_SWITCH:
+		printf(" %s (%s)", format_channel(e->u.chan.channel),
+			format_frequency(e->u.chan.mhz));
+		break;
+
+	case IWINFO_EVENT_REG_CHANGE:
+		printf(" %s", e->u.reg.alpha2[0] ? e->u.reg.alpha2 : "??");
+		break;
+
+	default:
+		break;
+	}
+
+	printf("\n");
+	fflush(stdout);
+}
+
+static void emit_event(struct iwinfo_event *e)
+{
+	out_record_begin("event");
+	out_str("type", IWINFO_EVENT_NAMES[e->type]);
+
+	if (e->ifname[0])
+		out_strn("ifname", e->ifname, sizeof(e->ifname));
+
+	switch (e->type)
+	{
+	case IWINFO_EVENT_STA_NEW:
+	case IWINFO_EVENT_STA_DEL:
+		out_str("mac", format_bssid(e->u.sta.mac));
+		break;
+
+	case IWINFO_EVENT_CHANNEL_SWITCH:
+		out_int("mhz", e->u.chan.mhz);
+		out_int("channel", e->u.chan.channel);
+		break;
+
+	case IWINFO_EVENT_REG_CHANGE:
+		if (e->u.reg.alpha2[0])
+			out_strn("alpha2", e->u.reg.alpha2, sizeof(e->u.reg.alpha2));
+
+		out_int("initiator", e->u.reg.initiator);
+		break;
+
+	default:
+		break;
 	}
+
+	out_record_end();
+}
+
+static int print_events(const struct iwinfo_ops *iw, const char *ifname)
+{
+	int rv;
+	struct iwinfo_event e;
+	struct iwinfo_events ev;
+	struct pollfd pfd = { .events = POLLIN };
+
+	if (!iw->events_open || iw->events_open(ifname, &ev))
+	{
+		if (out_format)
+			out_error("events", "No event support available");
+		else
+			printf("No event support available\n");
+
+		return 1;
+	}
+
+	pfd.fd = ev.fd;
+
+	while (poll(&pfd, 1, -1) > 0)
+	{
+		while ((rv = iw->events_read(&ev, &e)) > 0)
+		{
+			if (out_format)
+				emit_event(&e);
+			else
+				print_event(&e);
+		}
+
+		if (rv < 0)
+			break;
+	}
+
+	iw->events_close(&ev);
+	return 1;
+}
+
+
+static int publish_snapshots(const struct iwinfo_ops *iw, const char *ifname,
+                             const char *arg)
+{
+	int failed = 0, interval = arg ? atoi(arg) : 0;
+	struct timespec ts;
+
+	if (interval <= 0)
+	{
+		fprintf(stderr, "Invalid interval: %s\n", arg ? arg : "(none)");
+		return 1;
+	}
+
+	ts.tv_sec  = interval / 1000;
+	ts.tv_nsec = (interval % 1000) * 1000000;
+
+	/* the interface may come back, report each run of failures once */
+	while (1)
+	{
+		if (iwinfo_shm_publish(iw, ifname, interval))
+		{
+			if (!failed++)
+				fprintf(stderr, "Unable to publish snapshots of %s\n", ifname);
+		}
+		else if (failed)
+		{
+			fprintf(stderr, "Publishing snapshots of %s again after %d "
+			        "failures\n", ifname, failed);
+			failed = 0;
+		}
+
+		nanosleep(&ts, NULL);
+	}
+
+	return 0;
+}
+
+/* Serve a section from the snapshot only if it holds a fresh copy of it,
+ * the collector may have failed to gather some of them */
+static const struct iwinfo_ops * snapshot_ops(const struct iwinfo_ops *iw,
+                                              const char *ifname, int section)
+{
+	return shm_probe(ifname, section) ? &shm_ops : iw;
 }
 
 
@@ -733,32 +2058,357 @@ static void print_countrylist(const struct iwinfo_ops *iw, const char *ifname)
 }
 
 
+static void emit_countrylist(const struct iwinfo_ops *iw, const char *ifname)
+{
+	int len;
+	char buf[IWINFO_BUFSIZE];
+	char *ccode;
+	char curcode[3], iso[3] = { 0 };
+	const struct iwinfo_iso3166_label *l;
+
+	if (iw->countrylist(ifname, buf, &len))
+	{
+		out_error("countrylist", "No country code information available");
+		return;
+	}
+
+	if (iw->country(ifname, curcode))
+		memset(curcode, 0, sizeof(curcode));
+
+	out_list_begin("countrylist");
+
+	for (l = IWINFO_ISO3166_NAMES; l->iso3166; l++)
+	{
+		if ((ccode = lookup_country(buf, len, l->iso3166)) == NULL)
+			continue;
+
+		iso[0] = l->iso3166 / 256;
+		iso[1] = l->iso3166 % 256;
+
+		out_record_begin("countrylist");
+		out_strn("ccode", ccode, 4);
+		out_str("alpha2", iso);
+		out_strn("name", (const char *)l->name, sizeof(l->name));
+		out_bool("active", !strncmp(ccode, curcode, 2));
+		out_record_end();
+	}
+
+	out_list_end();
+}
+
+
+static char * format_bucket(int i)
+{
+	static char buf[16];
+	uint64_t us = 16ULL << (2 * i);
+
+	if (i == IWINFO_STATS_BUCKETS - 1)
+		us >>= 2;
+
+	snprintf(buf, sizeof(buf), "%s%llu%s",
+		(i == IWINFO_STATS_BUCKETS - 1) ? ">" : "<",
+		(unsigned long long)((us < 1000) ? us :
+		                     (us < 1000000) ? us / 1000 : us / 1000000),
+		(us < 1000) ? "us" : (us < 1000000) ? "ms" : "s");
+
+	return buf;
+}
+
+static void print_stats(void)
+{
+	int i, j, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_stats_entry *e;
+
+	if (iwinfo_stats(buf, &len))
+	{
+		printf("No statistics available, build with USE_STATS\n");
+		return;
+	}
+
+	printf("\nStatistics:\n");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_stats_entry))
+	{
+		e = (struct iwinfo_stats_entry *) &buf[i];
+
+		printf("  %-10s %-18s %llu calls  %llu errors  avg %llu us\n",
+			e->backend, e->op,
+			(unsigned long long)e->calls, (unsigned long long)e->errors,
+			(unsigned long long)(e->calls ? e->usecs / e->calls : 0));
+
+		if (e->calls)
+		{
+			printf("  %-29s", "");
+
+			for (j = 0; j < IWINFO_STATS_BUCKETS; j++)
+				if (e->latency[j])
+					printf(" %s %llu", format_bucket(j),
+						(unsigned long long)e->latency[j]);
+
+			printf("\n");
+		}
+
+		for (j = 0; j < IWINFO_STATS_COUNTERS && !e->count[j]; j++);
+
+		if (j == IWINFO_STATS_COUNTERS)
+			continue;
+
+		printf("  %-29s", "");
+
+		for (j = 0; j < IWINFO_STATS_COUNTERS; j++)
+			if (e->count[j])
+				printf(" %s %llu", IWINFO_STATS_NAMES[j],
+					(unsigned long long)e->count[j]);
+
+		printf("\n");
+	}
+}
+
+static void emit_stats(void)
+{
+	int i, j, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_stats_entry *e;
+
+	if (iwinfo_stats(buf, &len))
+	{
+		out_error("stats", "No statistics available");
+		return;
+	}
+
+	out_list_begin("stats");
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_stats_entry))
+	{
+		e = (struct iwinfo_stats_entry *) &buf[i];
+
+		out_record_begin("stats");
+		out_str("backend", e->backend);
+		out_str("op", e->op);
+		out_u64("calls", e->calls);
+		out_u64("errors", e->errors);
+		out_u64("usecs", e->usecs);
+
+		out_open("latency", '[');
+
+		for (j = 0; j < IWINFO_STATS_BUCKETS; j++)
+			out_u64(NULL, e->latency[j]);
+
+		out_close();
+
+		for (j = 0; j < IWINFO_STATS_COUNTERS; j++)
+			out_u64(IWINFO_STATS_NAMES[j], e->count[j]);
+
+		out_record_end();
+	}
+
+	out_list_end();
+}
+
+static void parse_list(char *arg, struct iwinfo_filter *f,
+                       void (*add)(struct iwinfo_filter *, int))
+{
+	char *p;
+
+	for (p = strtok(arg, ","); p; p = strtok(NULL, ","))
+		add(f, atoi(p));
+}
+
+static uint32_t parse_fields(char *arg)
+{
+	char *p;
+	uint32_t fields = 0;
+
+	for (p = strtok(arg, ","); p; p = strtok(NULL, ","))
+	{
+		if (!strcmp(p, "counters"))
+			fields |= IWINFO_FIELD_COUNTERS;
+		else if (!strcmp(p, "rates"))
+			fields |= IWINFO_FIELD_RATES;
+		else if (!strcmp(p, "crypto"))
+			fields |= IWINFO_FIELD_CRYPTO;
+	}
+
+	return fields;
+}
+
+struct cli_options {
+	int use_shm;
+	int interval;
+	int rates;
+	int stats;
+	struct iwinfo_filter filter;
+	struct iwinfo_filter *f;
+};
+
+/* Parse options up to the first operand, returns its index or -1. Runs
+ * again on the words following a command, argv[0] then being the command */
+static int parse_options(int argc, char **argv, struct cli_options *o)
+{
+	int opt;
+	static const struct option longopts[] = {
+		{ "json",     no_argument,       NULL, 'j' },
+		{ "binary",   no_argument,       NULL, 'b' },
+		{ "interval", required_argument, NULL, 'I' },
+		{ "rates",    no_argument,       NULL, 'R' },
+		{ "fields",   required_argument, NULL, 'o' },
+		{ "stats",    no_argument,       NULL, 'T' },
+		{ 0 }
+	};
+
+	optind = 0;
+
+	while ((opt = getopt_long(argc, argv, "+jbmI:RTs:S:c:f:e:i:n:o:",
+	                          longopts, NULL)) != -1)
+	{
+		switch (opt)
+		{
+		case 'j':
+			out_format = OUT_JSON;
+			continue;
+
+		case 'b':
+			out_format = OUT_BINARY;
+			continue;
+
+		case 'm':
+			o->use_shm = 1;
+			continue;
+
+		case 'I':
+			o->interval = atoi(optarg);
+			continue;
+
+		case 'R':
+			o->rates = 1;
+			continue;
+
+		case 'T':
+			o->stats = 1;
+			continue;
+
+		case 's':
+			o->filter.min_signal = atoi(optarg);
+			break;
+
+		case 'S':
+			o->filter.max_signal = atoi(optarg);
+			break;
+
+		case 'c':
+			parse_list(optarg, &o->filter, iwinfo_filter_channel);
+			break;
+
+		case 'f':
+			parse_list(optarg, &o->filter, iwinfo_filter_frequency);
+			break;
+
+		case 'e':
+			strncpy(o->filter.ssid, optarg, IWINFO_ESSID_MAX_SIZE);
+			break;
+
+		case 'i':
+			o->filter.max_inactive = atoi(optarg);
+			break;
+
+		case 'n':
+			o->filter.top = atoi(optarg);
+			break;
+
+		case 'o':
+			o->filter.fields = parse_fields(optarg);
+			break;
+
+		default:
+			return -1;
+		}
+
+		o->f = &o->filter;
+	}
+
+	return optind;
+}
+
 int main(int argc, char **argv)
 {
-	int i;
+	int i, n, format;
 	char *p;
-	const struct iwinfo_ops *iw;
+	const struct iwinfo_ops *iw, *siw;
 	glob_t globbuf;
+	struct cli_options o = { .interval = 1000 };
+
+	if ((n = parse_options(argc, argv, &o)) < 0)
+		return 1;
+
+	argc -= n - 1;
+	argv += n - 1;
+
+	if (argc == 2 && !strcmp(argv[1], "metrics"))
+	{
+		if (iwinfo_metrics(1) < 0)
+		{
+			fprintf(stderr, "Unable to gather metrics\n");
+			return 1;
+		}
+
+		iwinfo_finish();
+		return 0;
+	}
 
 	if (argc > 1 && argc < 3)
 	{
 		fprintf(stderr,
 			"Usage:\n"
-			"	iwinfo <device> info\n"
-			"	iwinfo <device> scan\n"
-			"	iwinfo <device> txpowerlist\n"
-			"	iwinfo <device> freqlist\n"
-			"	iwinfo <device> assoclist\n"
-			"	iwinfo <device> countrylist\n"
+			"	iwinfo metrics\n"
+			"	iwinfo [options] <device> info\n"
+			"	iwinfo [options] <device> scan\n"
+			"	iwinfo [options] <device> txpowerlist\n"
+			"	iwinfo [options] <device> freqlist\n"
+			"	iwinfo [options] <device> assoclist\n"
+			"	iwinfo [options] <device> station <mac>\n"
+			"	iwinfo [options] <device> countrylist\n"
+			"	iwinfo [options] <device> survey\n"
+			"	iwinfo [options] <device> events\n"
+			"	iwinfo [options] <device> monitor [options]\n"
+			"	iwinfo [options] <device> publish <ms>\n"
+			"\n"
+			"Output options:\n"
+			"	-j, --json       JSON, one line per record or list\n"
+			"	-b, --binary     length-prefixed binary records\n"
+			"	-T, --stats      per-operation library statistics\n"
+			"\n"
+			"Options for monitor:\n"
+			"	-I, --interval <ms>  sampling interval, default 1000\n"
+			"	-R, --rates      per-interval rates instead of changes\n"
+			"\n"
+			"Options for info, assoclist and survey:\n"
+			"	-m               read published snapshots if fresh\n"
+			"\n"
+			"Options for scan, assoclist and monitor:\n"
+			"	-s <dBm>         minimum signal\n"
+			"	-S <dBm>         maximum signal\n"
+			"	-c <ch>[,<ch>]   channels (scan)\n"
+			"	-f <MHz>[,<MHz>] frequencies (scan)\n"
+			"	-e <ssid>        ESSID (scan)\n"
+			"	-i <ms>          maximum inactive time (assoclist)\n"
+			"	-n <count>       only the strongest entries\n"
+			"	-o, --fields <field>[,...]  counters, rates, crypto\n"
 		);
 
 		return 1;
 	}
 
+	if (out_format == OUT_BINARY)
+		out_put("IWB1", 4);
+
 	if (argc == 1)
 	{
 		glob("/sys/class/net/*", 0, NULL, &globbuf);
 
+		if (out_format)
+			out_list_begin("info");
+
 		for (i = 0; i < globbuf.gl_pathc; i++)
 		{
 			p = strrchr(globbuf.gl_pathv[i], '/');
@@ -771,11 +2421,27 @@ int main(int argc, char **argv)
 			if (!iw)
 				continue;
 
+			if (out_format)
+			{
+				emit_info(iw, p);
+				continue;
+			}
+
 			print_info(iw, p);
 			printf("\n");
 		}
 
+		if (out_format)
+			out_list_end();
+
 		globfree(&globbuf);
+
+		if (o.stats && out_format)
+			emit_stats();
+		else if (o.stats)
+			print_stats();
+
+		out_flush();
 		return 0;
 	}
 
@@ -792,35 +2458,115 @@ int main(int argc, char **argv)
 		switch(argv[i][0])
 		{
 		case 'i':
-			print_info(iw, argv[1]);
+			siw = o.use_shm ? snapshot_ops(iw, argv[1], IWINFO_SHM_INFO) : iw;
+
+			if (out_format)
+				emit_info(siw, argv[1]);
+			else
+				print_info(siw, argv[1]);
 			break;
 
 		case 's':
-			print_scanlist(iw, argv[1]);
+			if (argv[i][1] == 'u')
+			{
+				siw = o.use_shm ? snapshot_ops(iw, argv[1], IWINFO_SHM_SURVEY) : iw;
+
+				if (out_format)
+					emit_survey(siw, argv[1]);
+				else
+					print_survey(siw, argv[1]);
+			}
+			else if (argv[i][1] == 't')
+			{
+				if (print_station(iw, argv[1], argv[i+1], o.f))
+					return 1;
+
+				i++;
+			}
+			else if (out_format)
+			{
+				emit_scanlist(iw, argv[1], o.f);
+			}
+			else
+			{
+				print_scanlist(iw, argv[1], o.f);
+			}
 			break;
 
 		case 't':
-			print_txpwrlist(iw, argv[1]);
+			if (out_format)
+				emit_txpwrlist(iw, argv[1]);
+			else
+				print_txpwrlist(iw, argv[1]);
 			break;
 
 		case 'f':
-			print_freqlist(iw, argv[1]);
+			if (out_format)
+				emit_freqlist(iw, argv[1]);
+			else
+				print_freqlist(iw, argv[1]);
 			break;
 
 		case 'a':
-			print_assoclist(iw, argv[1]);
+			siw = o.use_shm ? snapshot_ops(iw, argv[1], IWINFO_SHM_ASSOC) : iw;
+
+			if (out_format)
+				emit_assoclist(siw, argv[1], o.f);
+			else
+				print_assoclist(siw, argv[1], o.f);
+			break;
+
+		case 'p':
+			return publish_snapshots(iw, argv[1], argv[i+1]);
+
+		case 'm':
+			/* options may also follow the command, monitor takes all
+			 * remaining words */
+			format = out_format;
+
+			if ((n = parse_options(argc - i, argv + i, &o)) < 0)
+				return 1;
+
+			if (n < argc - i)
+			{
+				fprintf(stderr, "Unknown argument: %s\n", argv[i + n]);
+				return 1;
+			}
+
+			if (out_format == OUT_BINARY && format != OUT_BINARY)
+				out_put("IWB1", 4);
+
+			if (print_monitor(argv[1], o.f, o.interval, o.rates))
+				return 1;
+
+			i = argc;
 			break;
 
 		case 'c':
-			print_countrylist(iw, argv[1]);
+			if (out_format)
+				emit_countrylist(iw, argv[1]);
+			else
+				print_countrylist(iw, argv[1]);
+			break;
+
+		case 'e':
+			if (print_events(iw, argv[1]))
+				return 1;
 			break;
 
 		default:
+			out_flush();
 			fprintf(stderr, "Unknown command: %s\n", argv[i]);
 			return 1;
 		}
 	}
 
+	if (o.stats && out_format)
+		emit_stats();
+	else if (o.stats)
+		print_stats();
+
+	out_flush();
 	iwinfo_finish();
 
 	return 0;
@@ -16,7 +16,11 @@
  * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
  */
 
+#include <poll.h>
+#include <stddef.h>
+
 #include "iwinfo.h"
+#include "iwinfo/daemon.h"
 
 
 /*
@@ -31,12 +35,17 @@ const char *IWINFO_CIPHER_NAMES[] = {
 	"WEP104",
 	"AES-OCB",
 	"CKIP",
+	"GCMP",
+	"GCMP-256",
+	"CCMP-256",
 };
 
 const char *IWINFO_KMGMT_NAMES[] = {
 	"NONE",
 	"802.1X",
 	"PSK",
+	"SAE",
+	"OWE",
 };
 
 const char *IWINFO_AUTH_NAMES[] = {
@@ -57,6 +66,26 @@ const char *IWINFO_OPMODE_NAMES[] = {
 	"P2P Go",
 };
 
+const char *IWINFO_EVENT_NAMES[] = {
+	"none",
+	"station_new",
+	"station_del",
+	"scan_done",
+	"scan_aborted",
+	"channel_switch",
+	"reg_change",
+	"overrun",
+	"iface_change",
+};
+
+const char *IWINFO_STATS_NAMES[] = {
+	"nl_msgs",
+	"nl_bytes",
+	"ioctls",
+	"files",
+	"ctrl",
+};
+
 
 /*
  * ISO3166 country labels
@@ -314,7 +343,7 @@ const struct iwinfo_iso3166_label IWINFO_ISO3166_NAMES[] = {
 };
 
 
-const char * iwinfo_type(const char *ifname)
+static const char * iwinfo_type_local(const char *ifname)
 {
 #ifdef USE_NL80211
 	if (nl80211_probe(ifname))
@@ -346,12 +375,8 @@ const char * iwinfo_type(const char *ifname)
 	return NULL;
 }
 
-const struct iwinfo_ops * iwinfo_backend(const char *ifname)
+const struct iwinfo_ops * iwinfo_backend_by_name(const char *type)
 {
-	const char *type;
-	struct iwinfo_ops *ops;
-
-	type = iwinfo_type(ifname);
 	if (!type)
 		return NULL;
 
@@ -383,8 +408,1188 @@ const struct iwinfo_ops * iwinfo_backend(const char *ifname)
 	return NULL;
 }
 
+static const struct iwinfo_ops * iwinfo_backend_local(const char *ifname)
+{
+	return iwinfo_backend_by_name(iwinfo_type_local(ifname));
+}
+
+
+/*
+ * Instrumentation: with USE_STATS iwinfo_backend() hands out copies of the
+ * backend operations which time every call and make it the current
+ * operation, the backends add their netlink, ioctl, file and control socket
+ * traffic to it through IWINFO_STATS_COUNT(). Without USE_STATS neither the
+ * copies nor the counting exist.
+ */
+#ifdef USE_STATS
+#define IWINFO_STATS_SLOTS	8
+#define IWINFO_STATS_OPS	(sizeof(struct iwinfo_ops) / sizeof(void (*)(void)))
+#define IWINFO_STATS_INDEX(op)	\
+	(offsetof(struct iwinfo_ops, op) / sizeof(void (*)(void)))
+
+struct iwinfo_stats_slot {
+	const struct iwinfo_ops *local;
+	char name[16];
+	struct iwinfo_ops ops;
+	struct iwinfo_stats_entry e[IWINFO_STATS_OPS];
+};
+
+struct iwinfo_stats_call {
+	struct iwinfo_stats_entry *prev;
+	uint64_t start;
+};
+
+static struct iwinfo_stats_slot stats_slots[IWINFO_STATS_SLOTS];
+static struct iwinfo_stats_entry stats_type;
+static struct iwinfo_stats_entry stats_other;
+static struct iwinfo_stats_entry *stats_current = NULL;
+
+static uint64_t iwinfo_stats_usecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Counts made outside of any wrapped operation land in "other" */
+void iwinfo_stats_count(int counter, uint64_t n)
+{
+	struct iwinfo_stats_entry *e = stats_current ? stats_current : &stats_other;
+
+	e->count[counter] += n;
+}
+
+static void iwinfo_stats_begin(struct iwinfo_stats_call *c,
+                               struct iwinfo_stats_entry *e)
+{
+	c->prev = stats_current;
+	c->start = iwinfo_stats_usecs();
+	stats_current = e;
+}
+
+static int iwinfo_stats_end(struct iwinfo_stats_call *c, int rv)
+{
+	int i;
+	uint64_t t = iwinfo_stats_usecs() - c->start;
+	struct iwinfo_stats_entry *e = stats_current;
+
+	for (i = 0; i < IWINFO_STATS_BUCKETS - 1 && t >= (16ULL << (2 * i)); i++);
+
+	e->calls++;
+	e->errors += (rv < 0);
+	e->usecs += t;
+	e->latency[i]++;
+
+	stats_current = c->prev;
+
+	return rv;
+}
+
+/* Parameter and argument lists of the operation signatures */
+#define IWINFO_STATS_P_INT		(const char *ifname, int *buf)
+#define IWINFO_STATS_A_INT		(ifname, buf)
+#define IWINFO_STATS_P_STR		(const char *ifname, char *buf)
+#define IWINFO_STATS_A_STR		(ifname, buf)
+#define IWINFO_STATS_P_LIST		(const char *ifname, char *buf, int *len)
+#define IWINFO_STATS_A_LIST		(ifname, buf, len)
+#define IWINFO_STATS_P_INFO		(const char *ifname, struct iwinfo_info *info)
+#define IWINFO_STATS_A_INFO		(ifname, info)
+#define IWINFO_STATS_P_FILTER	(const char *ifname, const struct iwinfo_filter *f, \
+								 char *buf, int *len)
+#define IWINFO_STATS_A_FILTER	(ifname, f, buf, len)
+#define IWINFO_STATS_P_STATION	(const char *ifname, const uint8_t *mac, \
+								 struct iwinfo_assoclist_ext_entry *e)
+#define IWINFO_STATS_A_STATION	(ifname, mac, e)
+#define IWINFO_STATS_P_TRIGGER	(const char *ifname, struct iwinfo_scan *s)
+#define IWINFO_STATS_A_TRIGGER	(ifname, s)
+#define IWINFO_STATS_P_READY	(struct iwinfo_scan *s)
+#define IWINFO_STATS_A_READY	(s)
+#define IWINFO_STATS_P_RESULTS	(struct iwinfo_scan *s, char *buf, int *len)
+#define IWINFO_STATS_A_RESULTS	(s, buf, len)
+#define IWINFO_STATS_P_EVOPEN	(const char *ifname, struct iwinfo_events *ev)
+#define IWINFO_STATS_A_EVOPEN	(ifname, ev)
+#define IWINFO_STATS_P_EVREAD	(struct iwinfo_events *ev, struct iwinfo_event *e)
+#define IWINFO_STATS_A_EVREAD	(ev, e)
+#define IWINFO_STATS_P_SCHED	(const char *ifname, int interval)
+#define IWINFO_STATS_A_SCHED	(ifname, interval)
+
+/* All operations returning a status, the closing ones are not timed */
+#define IWINFO_STATS_FOREACH(X, n)			\
+	X(n, mode,             INT)				\
+	X(n, channel,          INT)				\
+	X(n, frequency,        INT)				\
+	X(n, frequency_offset, INT)				\
+	X(n, txpower,          INT)				\
+	X(n, txpower_offset,   INT)				\
+	X(n, bitrate,          INT)				\
+	X(n, signal,           INT)				\
+	X(n, noise,            INT)				\
+	X(n, quality,          INT)				\
+	X(n, quality_max,      INT)				\
+	X(n, mbssid_support,   INT)				\
+	X(n, hwmodelist,       INT)				\
+	X(n, ssid,             STR)				\
+	X(n, bssid,            STR)				\
+	X(n, country,          STR)				\
+	X(n, hardware_id,      STR)				\
+	X(n, hardware_name,    STR)				\
+	X(n, phyname,          STR)				\
+	X(n, encryption,       STR)				\
+	X(n, info,             INFO)			\
+	X(n, assoclist,        LIST)			\
+	X(n, assoclist_ext,    LIST)			\
+	X(n, assoclist_filter, FILTER)			\
+	X(n, station,          STATION)			\
+	X(n, txpwrlist,        LIST)			\
+	X(n, scanlist,         LIST)			\
+	X(n, scanlist_ext,     LIST)			\
+	X(n, scanlist_delta,   LIST)			\
+	X(n, scanlist_filter,  FILTER)			\
+	X(n, scan_trigger,     TRIGGER)			\
+	X(n, scan_ready,       READY)			\
+	X(n, scan_results,     RESULTS)			\
+	X(n, events_open,      EVOPEN)			\
+	X(n, events_read,      EVREAD)			\
+	X(n, scan_schedule,    SCHED)			\
+	X(n, scan_age,         INT)				\
+	X(n, freqlist,         LIST)			\
+	X(n, survey,           LIST)			\
+	X(n, countrylist,      LIST)
+
+#define IWINFO_STATS_WRAP(n, op, sig)								\
+	static int iwinfo_stats_##op##_##n IWINFO_STATS_P_##sig			\
+	{																\
+		struct iwinfo_stats_call c;									\
+		iwinfo_stats_begin(&c, &stats_slots[n].e[IWINFO_STATS_INDEX(op)]);	\
+		return iwinfo_stats_end(&c,									\
+			stats_slots[n].local->op IWINFO_STATS_A_##sig);			\
+	}
+
+#define IWINFO_STATS_HOOK(n, op, sig)								\
+	if (r->op)														\
+		r->op = iwinfo_stats_##op##_##n;
+
+#define IWINFO_STATS_NAME(n, op, sig)								\
+	[IWINFO_STATS_INDEX(op)] = #op,
+
+/* The wrappers cannot carry state, so every slot gets its own set */
+#define IWINFO_STATS_SLOT(n)										\
+	IWINFO_STATS_FOREACH(IWINFO_STATS_WRAP, n)						\
+	static void iwinfo_stats_hook_##n(struct iwinfo_ops *r)			\
+	{																\
+		IWINFO_STATS_FOREACH(IWINFO_STATS_HOOK, n)					\
+	}
+
+IWINFO_STATS_SLOT(0)
+IWINFO_STATS_SLOT(1)
+IWINFO_STATS_SLOT(2)
+IWINFO_STATS_SLOT(3)
+IWINFO_STATS_SLOT(4)
+IWINFO_STATS_SLOT(5)
+IWINFO_STATS_SLOT(6)
+IWINFO_STATS_SLOT(7)
+
+static void (* const stats_hooks[IWINFO_STATS_SLOTS])(struct iwinfo_ops *) = {
+	iwinfo_stats_hook_0, iwinfo_stats_hook_1,
+	iwinfo_stats_hook_2, iwinfo_stats_hook_3,
+	iwinfo_stats_hook_4, iwinfo_stats_hook_5,
+	iwinfo_stats_hook_6, iwinfo_stats_hook_7,
+};
+
+static const char *stats_ops[IWINFO_STATS_OPS] = {
+	IWINFO_STATS_FOREACH(IWINFO_STATS_NAME, 0)
+};
+
+/* Timed copy of ops, name labels the entries of the copy. Once all slots
+ * are taken further backends stay uninstrumented. */
+static const struct iwinfo_ops * iwinfo_stats_ops(const struct iwinfo_ops *ops,
+                                                  const char *name)
+{
+	int i;
+	struct iwinfo_stats_slot *s;
+
+	if (!ops)
+		return NULL;
+
+	for (i = 0; i < IWINFO_STATS_SLOTS; i++)
+	{
+		if (stats_slots[i].local == ops)
+			return &stats_slots[i].ops;
+
+		if (!stats_slots[i].local)
+			break;
+	}
+
+	if (i == IWINFO_STATS_SLOTS)
+		return ops;
+
+	s = &stats_slots[i];
+	s->local = ops;
+	s->ops = *ops;
+	strncpy(s->name, name, sizeof(s->name) - 1);
+
+	stats_hooks[i](&s->ops);
+
+	return &s->ops;
+}
+
+static const char * iwinfo_stats_type(const char *ifname)
+{
+	const char *type;
+	struct iwinfo_stats_call c;
+
+	iwinfo_stats_begin(&c, &stats_type);
+	type = iwinfo_type(ifname);
+	iwinfo_stats_end(&c, type ? 0 : -1);
+
+	return type;
+}
+
+static void iwinfo_stats_put(struct iwinfo_stats_entry *out, int *n,
+                             const struct iwinfo_stats_entry *e,
+                             const char *backend, const char *op)
+{
+	int i;
+
+	for (i = 0; i < IWINFO_STATS_COUNTERS && !e->count[i]; i++);
+
+	if ((!e->calls && i == IWINFO_STATS_COUNTERS) ||
+	    (*n + 1) * sizeof(*out) > IWINFO_BUFSIZE)
+		return;
+
+	out[*n] = *e;
+	strncpy(out[*n].backend, backend, sizeof(out[*n].backend) - 1);
+	strncpy(out[*n].op, op, sizeof(out[*n].op) - 1);
+	(*n)++;
+}
+
+/* Fill buf with a struct iwinfo_stats_entry for every operation that was
+ * called or counted anything since the start or the last reset */
+int iwinfo_stats(char *buf, int *len)
+{
+	int i, j, n = 0;
+	struct iwinfo_stats_entry *out = (struct iwinfo_stats_entry *)buf;
+
+	memset(buf, 0, IWINFO_BUFSIZE);
+
+	iwinfo_stats_put(out, &n, &stats_type, "-", "type");
+
+	for (i = 0; i < IWINFO_STATS_SLOTS && stats_slots[i].local; i++)
+		for (j = 0; j < IWINFO_STATS_OPS; j++)
+			if (stats_ops[j])
+				iwinfo_stats_put(out, &n, &stats_slots[i].e[j],
+				                 stats_slots[i].name, stats_ops[j]);
+
+	iwinfo_stats_put(out, &n, &stats_other, "-", "other");
+
+	*len = n * sizeof(*out);
+	return 0;
+}
+
+void iwinfo_stats_reset(void)
+{
+	int i;
+
+	for (i = 0; i < IWINFO_STATS_SLOTS; i++)
+		memset(stats_slots[i].e, 0, sizeof(stats_slots[i].e));
+
+	memset(&stats_type, 0, sizeof(stats_type));
+	memset(&stats_other, 0, sizeof(stats_other));
+}
+#else
+#define iwinfo_stats_ops(ops, name)	(ops)
+#define iwinfo_stats_type(ifname)	iwinfo_type(ifname)
+
+int iwinfo_stats(char *buf, int *len)
+{
+	*len = 0;
+	return -1;
+}
+
+void iwinfo_stats_reset(void)
+{
+}
+#endif
+
+/*
+ * Query daemon client: while iwinfod listens on IWINFO_DAEMON_SOCK the data
+ * operations of every backend are answered by it, so short lived callers
+ * skip the netlink and control socket setup entirely. Handle based
+ * operations like asynchronous scans and events keep running locally and
+ * any transport failure falls back to the local backend.
+ */
+#define IWINFO_CLIENT_FAILED	(-0x100)
+#define IWINFO_CLIENT_RETRY		5000	/* ms */
+#define IWINFO_CLIENT_BACKENDS	5
+
+struct iwinfo_client_backend {
+	const struct iwinfo_ops *local;
+	struct iwinfo_ops remote;
+};
+
+static struct iwinfo_client_backend client_backends[IWINFO_CLIENT_BACKENDS];
+static int client_fd = -1;
+static int client_enabled = 1;
+static uint64_t client_failed = 0;
+
+void iwinfo_client(int enable)
+{
+	client_enabled = enable;
+
+	if (!enable && client_fd > -1)
+	{
+		close(client_fd);
+		client_fd = -1;
+	}
+}
+
+static int iwinfo_client_connect(void)
+{
+	char *env;
+	struct timeval tv = { .tv_sec = IWINFO_DAEMON_TIMEOUT };
+	struct sockaddr_un sun = { .sun_family = AF_UNIX };
+
+	if (client_fd > -1)
+		return 0;
+
+	if (!client_enabled ||
+	    ((env = getenv("IWINFO_DAEMON")) != NULL && !strcmp(env, "0")))
+		return -1;
+
+	/* do not knock on every call while no daemon is running */
+	if (client_failed && iwinfo_msecs() - client_failed < IWINFO_CLIENT_RETRY)
+		return -1;
+
+	strncpy(sun.sun_path, IWINFO_DAEMON_SOCK, sizeof(sun.sun_path) - 1);
+
+	if ((client_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+		return -1;
+
+	if (connect(client_fd, (struct sockaddr *)&sun, sizeof(sun)))
+	{
+		close(client_fd);
+		client_fd = -1;
+		client_failed = iwinfo_msecs();
+		return -1;
+	}
+
+	setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	client_failed = 0;
+	return 0;
+}
+
+static int iwinfo_client_io(void *buf, int len, int wr)
+{
+	int n;
+	char *p = buf;
+
+	while (len > 0)
+	{
+		n = wr ? send(client_fd, p, len, MSG_NOSIGNAL)
+		       : recv(client_fd, p, len, 0);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0)
+			return -1;
+
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* Run op on the daemon, returns the result of the remote backend or
+ * IWINFO_CLIENT_FAILED if the daemon could not be asked */
+static int iwinfo_client_call(int op, const char *ifname,
+                              void *buf, int *len, int max)
+{
+	struct iwinfo_daemon_req req = { .magic = IWINFO_DAEMON_MAGIC, .op = op };
+	struct iwinfo_daemon_res res;
+
+	if (iwinfo_client_connect())
+		return IWINFO_CLIENT_FAILED;
+
+	strncpy(req.ifname, ifname, sizeof(req.ifname) - 1);
+
+	if (iwinfo_client_io(&req, sizeof(req), 1) ||
+	    iwinfo_client_io(&res, sizeof(res), 0) ||
+	    res.len > max ||
+	    iwinfo_client_io(buf, res.len, 0))
+	{
+		close(client_fd);
+		client_fd = -1;
+		return IWINFO_CLIENT_FAILED;
+	}
+
+	if (len)
+		*len = res.len;
+
+	return res.rv;
+}
+
+#define IWINFO_CLIENT_FALLBACK(op, ...)							\
+	do {														\
+		const struct iwinfo_ops *ops = iwinfo_backend_local(ifname);	\
+		return (ops && ops->op) ? ops->op(ifname, __VA_ARGS__) : -1;	\
+	} while (0)
+
+#define IWINFO_CLIENT_INT(op, OP)								\
+	static int iwinfo_client_##op(const char *ifname, int *buf)	\
+	{															\
+		int rv = iwinfo_client_call(IWINFO_DAEMON_##OP, ifname,	\
+		                            buf, NULL, sizeof(*buf));	\
+		if (rv != IWINFO_CLIENT_FAILED)							\
+			return rv;											\
+		IWINFO_CLIENT_FALLBACK(op, buf);						\
+	}
+
+#define IWINFO_CLIENT_DATA(op, OP, size)						\
+	static int iwinfo_client_##op(const char *ifname, char *buf)	\
+	{															\
+		int rv = iwinfo_client_call(IWINFO_DAEMON_##OP, ifname,	\
+		                            buf, NULL, size);			\
+		if (rv != IWINFO_CLIENT_FAILED)							\
+			return rv;											\
+		IWINFO_CLIENT_FALLBACK(op, buf);						\
+	}
+
+#define IWINFO_CLIENT_LIST(op, OP)								\
+	static int iwinfo_client_##op(const char *ifname, char *buf, int *len)	\
+	{															\
+		int rv = iwinfo_client_call(IWINFO_DAEMON_##OP, ifname,	\
+		                            buf, len, IWINFO_BUFSIZE);	\
+		if (rv != IWINFO_CLIENT_FAILED)							\
+			return rv;											\
+		IWINFO_CLIENT_FALLBACK(op, buf, len);					\
+	}
+
+IWINFO_CLIENT_INT(mode,              MODE)
+IWINFO_CLIENT_INT(channel,           CHANNEL)
+IWINFO_CLIENT_INT(frequency,         FREQUENCY)
+IWINFO_CLIENT_INT(frequency_offset,  FREQUENCY_OFFSET)
+IWINFO_CLIENT_INT(txpower,           TXPOWER)
+IWINFO_CLIENT_INT(txpower_offset,    TXPOWER_OFFSET)
+IWINFO_CLIENT_INT(bitrate,           BITRATE)
+IWINFO_CLIENT_INT(signal,            SIGNAL)
+IWINFO_CLIENT_INT(noise,             NOISE)
+IWINFO_CLIENT_INT(quality,           QUALITY)
+IWINFO_CLIENT_INT(quality_max,       QUALITY_MAX)
+IWINFO_CLIENT_INT(mbssid_support,    MBSSID_SUPPORT)
+IWINFO_CLIENT_INT(hwmodelist,        HWMODELIST)
+
+IWINFO_CLIENT_DATA(ssid,          SSID,          IWINFO_ESSID_MAX_SIZE + 1)
+IWINFO_CLIENT_DATA(bssid,         BSSID,         18)
+IWINFO_CLIENT_DATA(country,       COUNTRY,       3)
+IWINFO_CLIENT_DATA(hardware_id,   HARDWARE_ID,   sizeof(struct iwinfo_hardware_id))
+IWINFO_CLIENT_DATA(hardware_name, HARDWARE_NAME, 128)
+IWINFO_CLIENT_DATA(phyname,       PHYNAME,       IFNAMSIZ)
+IWINFO_CLIENT_DATA(encryption,    ENCRYPTION,    sizeof(struct iwinfo_crypto_entry))
+
+IWINFO_CLIENT_LIST(assoclist,   ASSOCLIST)
+IWINFO_CLIENT_LIST(txpwrlist,   TXPWRLIST)
+IWINFO_CLIENT_LIST(scanlist,    SCANLIST)
+IWINFO_CLIENT_LIST(freqlist,    FREQLIST)
+IWINFO_CLIENT_LIST(survey,      SURVEY)
+IWINFO_CLIENT_LIST(countrylist, COUNTRYLIST)
+IWINFO_CLIENT_LIST(assoclist_ext, ASSOCLIST_EXT)
+
+static int iwinfo_client_info(const char *ifname, struct iwinfo_info *info)
+{
+	const struct iwinfo_ops *ops;
+	int rv = iwinfo_client_call(IWINFO_DAEMON_INFO, ifname,
+	                            info, NULL, sizeof(*info));
+
+	if (rv != IWINFO_CLIENT_FAILED)
+		return rv;
+
+	if (!(ops = iwinfo_backend_local(ifname)))
+		return -1;
+
+	return iwinfo_info(ops, ifname, info);
+}
+
+#define IWINFO_CLIENT_ROUTE(op)	\
+	if (r->op)					\
+		r->op = iwinfo_client_##op
+
+/* Copy of the local backend with all data operations routed to the daemon,
+ * filtering and station lookups then run on the routed lists */
+static const struct iwinfo_ops * iwinfo_client_ops(const struct iwinfo_ops *local)
+{
+	int i;
+	struct iwinfo_ops *r;
+
+	for (i = 0; i < IWINFO_CLIENT_BACKENDS; i++)
+	{
+		if (client_backends[i].local == local)
+			return &client_backends[i].remote;
+
+		if (!client_backends[i].local)
+			break;
+	}
+
+	if (i == IWINFO_CLIENT_BACKENDS)
+		return local;
+
+	client_backends[i].local = local;
+	client_backends[i].remote = *local;
+
+	r = &client_backends[i].remote;
+
+	IWINFO_CLIENT_ROUTE(mode);
+	IWINFO_CLIENT_ROUTE(channel);
+	IWINFO_CLIENT_ROUTE(frequency);
+	IWINFO_CLIENT_ROUTE(frequency_offset);
+	IWINFO_CLIENT_ROUTE(txpower);
+	IWINFO_CLIENT_ROUTE(txpower_offset);
+	IWINFO_CLIENT_ROUTE(bitrate);
+	IWINFO_CLIENT_ROUTE(signal);
+	IWINFO_CLIENT_ROUTE(noise);
+	IWINFO_CLIENT_ROUTE(quality);
+	IWINFO_CLIENT_ROUTE(quality_max);
+	IWINFO_CLIENT_ROUTE(mbssid_support);
+	IWINFO_CLIENT_ROUTE(hwmodelist);
+	IWINFO_CLIENT_ROUTE(ssid);
+	IWINFO_CLIENT_ROUTE(bssid);
+	IWINFO_CLIENT_ROUTE(country);
+	IWINFO_CLIENT_ROUTE(hardware_id);
+	IWINFO_CLIENT_ROUTE(hardware_name);
+	IWINFO_CLIENT_ROUTE(phyname);
+	IWINFO_CLIENT_ROUTE(encryption);
+	IWINFO_CLIENT_ROUTE(assoclist);
+	IWINFO_CLIENT_ROUTE(txpwrlist);
+	IWINFO_CLIENT_ROUTE(scanlist);
+	IWINFO_CLIENT_ROUTE(freqlist);
+	IWINFO_CLIENT_ROUTE(survey);
+	IWINFO_CLIENT_ROUTE(countrylist);
+	IWINFO_CLIENT_ROUTE(assoclist_ext);
+
+	r->info = iwinfo_client_info;
+	r->assoclist_filter = NULL;
+	r->scanlist_filter = NULL;
+	r->scanlist_ext = NULL;
+	r->station = NULL;
+
+	return r;
+}
+
+static void iwinfo_client_close(void)
+{
+	if (client_fd > -1)
+		close(client_fd);
+
+	client_fd = -1;
+	client_failed = 0;
+}
+
+const char * iwinfo_type(const char *ifname)
+{
+	static char type[16];
+
+	memset(type, 0, sizeof(type));
+
+	switch (iwinfo_client_call(IWINFO_DAEMON_TYPE, ifname,
+	                           type, NULL, sizeof(type) - 1))
+	{
+	case IWINFO_CLIENT_FAILED:
+		return iwinfo_type_local(ifname);
+
+	case 0:
+		return type;
+
+	default:
+		return NULL;
+	}
+}
+
+const struct iwinfo_ops * iwinfo_backend(const char *ifname)
+{
+	const char *type = iwinfo_stats_type(ifname);
+	const struct iwinfo_ops *ops = iwinfo_backend_by_name(type);
+
+	if (!ops || client_fd < 0)
+		return iwinfo_stats_ops(ops, type);
+
+	/* counted under the backend the daemon answers for */
+	return iwinfo_stats_ops(iwinfo_client_ops(ops), type);
+}
+
+/* Route the backend named type through the daemon if that is the one it
+ * serves ifname with, callers holding their own copy of the ops get it
+ * back otherwise */
+const struct iwinfo_ops * iwinfo_backend_route(const struct iwinfo_ops *local,
+                                               const char *type,
+                                               const char *ifname)
+{
+	/* asking for the type connects to the daemon if there is one */
+	const char *served = iwinfo_type(ifname);
+
+	if (!served || strcmp(served, type) || client_fd < 0)
+		return local;
+
+	return iwinfo_client_ops(iwinfo_backend_by_name(type));
+}
+
+#define IWINFO_INFO_FETCH(op, flag, ptr)				\
+	if (ops->op && !ops->op(ifname, ptr))			\
+		info->valid |= IWINFO_INFO_##flag
+
+/* Gather all scalar properties of a device, backends able to share kernel
+ * round trips between fields provide their own info operation */
+int iwinfo_info(const struct iwinfo_ops *ops, const char *ifname,
+                struct iwinfo_info *info)
+{
+	if (ops->info)
+		return ops->info(ifname, info);
+
+	memset(info, 0, sizeof(*info));
+
+	IWINFO_INFO_FETCH(mode,             MODE,             &info->mode);
+	IWINFO_INFO_FETCH(channel,          CHANNEL,          &info->channel);
+	IWINFO_INFO_FETCH(frequency,        FREQUENCY,        &info->frequency);
+	IWINFO_INFO_FETCH(frequency_offset, FREQUENCY_OFFSET, &info->frequency_offset);
+	IWINFO_INFO_FETCH(txpower,          TXPOWER,          &info->txpower);
+	IWINFO_INFO_FETCH(txpower_offset,   TXPOWER_OFFSET,   &info->txpower_offset);
+	IWINFO_INFO_FETCH(bitrate,          BITRATE,          &info->bitrate);
+	IWINFO_INFO_FETCH(signal,           SIGNAL,           &info->signal);
+	IWINFO_INFO_FETCH(noise,            NOISE,            &info->noise);
+	IWINFO_INFO_FETCH(quality,          QUALITY,          &info->quality);
+	IWINFO_INFO_FETCH(quality_max,      QUALITY_MAX,      &info->quality_max);
+	IWINFO_INFO_FETCH(mbssid_support,   MBSSID_SUPPORT,   &info->mbssid_support);
+	IWINFO_INFO_FETCH(hwmodelist,       HWMODES,          &info->hwmodes);
+	IWINFO_INFO_FETCH(ssid,             SSID,             info->ssid);
+	IWINFO_INFO_FETCH(bssid,            BSSID,            info->bssid);
+	IWINFO_INFO_FETCH(country,          COUNTRY,          info->country);
+	IWINFO_INFO_FETCH(hardware_id,      HARDWARE_ID,      (char *)&info->hardware_id);
+	IWINFO_INFO_FETCH(hardware_name,    HARDWARE_NAME,    info->hardware_name);
+	IWINFO_INFO_FETCH(encryption,       ENCRYPTION,       (char *)&info->crypto);
+
+	return info->valid ? 0 : -1;
+}
+
+/* Station list as extended entries, backends without assoclist_ext get
+ * their original entries widened */
+int iwinfo_assoclist_ext(const struct iwinfo_ops *ops, const char *ifname,
+                         char *buf, int *len)
+{
+	if (ops->assoclist_ext)
+		return ops->assoclist_ext(ifname, buf, len);
+
+	if (!ops->assoclist || ops->assoclist(ifname, buf, len))
+		return -1;
+
+	iwinfo_assoclist_widen(buf, len, IWINFO_BUFSIZE);
+	return 0;
+}
+
+/* Scan results as extended entries, backends without scanlist_ext report
+ * no IEs */
+int iwinfo_scanlist_ext(const struct iwinfo_ops *ops, const char *ifname,
+                        char *buf, int *len)
+{
+	if (ops->scanlist_ext)
+		return ops->scanlist_ext(ifname, buf, len);
+
+	if (!ops->scanlist || ops->scanlist(ifname, buf, len))
+		return -1;
+
+	iwinfo_scanlist_widen(NULL, buf, len, IWINFO_BUFSIZE);
+	return 0;
+}
+
+int iwinfo_assoclist_filter(const struct iwinfo_ops *ops, const char *ifname,
+                            const struct iwinfo_filter *f, char *buf, int *len)
+{
+	if (ops->assoclist_filter && f)
+		return ops->assoclist_filter(ifname, f, buf, len);
+
+	if (iwinfo_assoclist_ext(ops, ifname, buf, len))
+		return -1;
+
+	if (f)
+		iwinfo_filter_assoclist(f, buf, len);
+
+	return 0;
+}
+
+int iwinfo_station_get(const struct iwinfo_ops *ops, const char *ifname,
+                       const uint8_t *mac,
+                       struct iwinfo_assoclist_ext_entry *e)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_assoclist_ext_entry *ae;
+
+	if (ops->station)
+		return ops->station(ifname, mac, e);
+
+	if (iwinfo_assoclist_ext(ops, ifname, buf, &len))
+		return -1;
+
+	for (i = 0, ae = (struct iwinfo_assoclist_ext_entry *)buf;
+	     i < len / sizeof(*ae); i++, ae++)
+	{
+		if (!memcmp(ae->base.mac, mac, 6))
+		{
+			*e = *ae;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+int iwinfo_assoclist_rates(const struct iwinfo_ops *ops, const char *ifname,
+                           int window, char *buf, int *len)
+{
+	int count;
+	char abuf[IWINFO_BUFSIZE];
+
+	if (iwinfo_assoclist_ext(ops, ifname, abuf, &count))
+		return -1;
+
+	count /= sizeof(struct iwinfo_assoclist_ext_entry);
+
+	if (count > IWINFO_BUFSIZE / sizeof(struct iwinfo_assoclist_rates))
+		count = IWINFO_BUFSIZE / sizeof(struct iwinfo_assoclist_rates);
+
+	if (iwinfo_rates_update(ifname, (struct iwinfo_assoclist_ext_entry *)abuf,
+	                        count, window, (struct iwinfo_assoclist_rates *)buf))
+		return -1;
+
+	*len = count * sizeof(struct iwinfo_assoclist_rates);
+	return 0;
+}
+
+int iwinfo_scanlist_filter(const struct iwinfo_ops *ops, const char *ifname,
+                           const struct iwinfo_filter *f, char *buf, int *len)
+{
+	if (ops->scanlist_filter && f)
+		return ops->scanlist_filter(ifname, f, buf, len);
+
+	if (ops->scanlist(ifname, buf, len))
+		return -1;
+
+	if (f)
+		iwinfo_filter_scanlist(f, buf, len);
+
+	return 0;
+}
+
+enum {
+	IWINFO_SCAN_MULTI_SKIP,
+	IWINFO_SCAN_MULTI_SYNC,
+	IWINFO_SCAN_MULTI_ASYNC,
+};
+
+/* Scan several devices at once: asynchronous scans are triggered first,
+ * blocking backends run while those dwell and all pending completions are
+ * then awaited together, so the total time is that of the slowest radio.
+ * Devices sharing a phy are scanned once and credited together. */
+int iwinfo_scan_multi(const char * const *ifnames, int count, int timeout,
+                      char *buf, int *len)
+{
+	int i, j, n, slen, ok = 0;
+	int state[IWINFO_SCAN_MULTI_MAX];
+	uint32_t radios[IWINFO_SCAN_MULTI_MAX];
+	char phy[IWINFO_SCAN_MULTI_MAX][IFNAMSIZ];
+	const struct iwinfo_ops *ops[IWINFO_SCAN_MULTI_MAX];
+	struct iwinfo_scan scan[IWINFO_SCAN_MULTI_MAX];
+	struct pollfd pfd[IWINFO_SCAN_MULTI_MAX];
+	struct iwinfo_scan_merge m;
+	char sbuf[IWINFO_BUFSIZE];
+	uint64_t now, deadline;
+
+	if (count > IWINFO_SCAN_MULTI_MAX)
+		count = IWINFO_SCAN_MULTI_MAX;
+
+	if (timeout <= 0)
+		timeout = IWINFO_SCAN_MULTI_TIMEOUT;
+
+	iwinfo_scan_merge_init(&m, buf, IWINFO_BUFSIZE);
+
+	for (i = 0; i < count; i++)
+	{
+		radios[i] = (1U << i);
+		state[i] = IWINFO_SCAN_MULTI_SKIP;
+
+		if (!(ops[i] = iwinfo_backend(ifnames[i])))
+			continue;
+
+		memset(phy[i], 0, sizeof(phy[i]));
+
+		if (!ops[i]->phyname || ops[i]->phyname(ifnames[i], phy[i]))
+			strncpy(phy[i], ifnames[i], sizeof(phy[i]) - 1);
+
+		for (j = 0; j < i; j++)
+			if (state[j] && ops[j] == ops[i] && !strcmp(phy[j], phy[i]))
+				break;
+
+		if (j < i)
+		{
+			radios[j] |= radios[i];
+			continue;
+		}
+
+		memset(&scan[i], 0, sizeof(scan[i]));
+		scan[i].fd = -1;
+
+		if (ops[i]->scan_trigger && !ops[i]->scan_trigger(ifnames[i], &scan[i]))
+			state[i] = IWINFO_SCAN_MULTI_ASYNC;
+		else
+			state[i] = IWINFO_SCAN_MULTI_SYNC;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (state[i] == IWINFO_SCAN_MULTI_SYNC &&
+		    !ops[i]->scanlist(ifnames[i], sbuf, &slen))
+		{
+			iwinfo_scan_merge_add(&m, sbuf, slen, radios[i]);
+			ok++;
+		}
+	}
+
+	deadline = iwinfo_msecs() + timeout;
+
+	do {
+		for (i = 0, n = 0; i < count; i++)
+		{
+			if (state[i] != IWINFO_SCAN_MULTI_ASYNC)
+				continue;
+
+			if (ops[i]->scan_ready(&scan[i]) != IWINFO_SCAN_PENDING)
+			{
+				if (!ops[i]->scan_results(&scan[i], sbuf, &slen))
+				{
+					iwinfo_scan_merge_add(&m, sbuf, slen, radios[i]);
+					ok++;
+				}
+
+				ops[i]->scan_close(&scan[i]);
+				state[i] = IWINFO_SCAN_MULTI_SKIP;
+				continue;
+			}
+
+			pfd[n].fd = scan[i].fd;
+			pfd[n].events = POLLIN;
+			n++;
+		}
+
+		now = iwinfo_msecs();
+		timeout = (now < deadline) ? (deadline - now) : 0;
+	} while (n > 0 && timeout > 0 &&
+	         (poll(pfd, n, timeout) >= 0 || errno == EINTR));
+
+	/* timed out, settle for whatever the stragglers have cached */
+	for (i = 0; i < count; i++)
+	{
+		if (state[i] != IWINFO_SCAN_MULTI_ASYNC)
+			continue;
+
+		if (!ops[i]->scan_results(&scan[i], sbuf, &slen))
+		{
+			iwinfo_scan_merge_add(&m, sbuf, slen, radios[i]);
+			ok++;
+		}
+
+		ops[i]->scan_close(&scan[i]);
+	}
+
+	*len = m.count * sizeof(struct iwinfo_scan_multi_entry);
+
+	return ok ? 0 : -1;
+}
+
+/*
+ * Generation counters: every tracked interface carries a number that is
+ * bumped whenever its configuration changes. Backends with an event
+ * channel bump it on channel switches, regulatory changes, interface
+ * changes and lost events. All interfaces of a backend share a single
+ * subscription, events are dispatched by interface and phy. The
+ * configuration fields of iwinfo_info are compared as well, at least every
+ * IWINFO_GENERATION_TTL ms to catch changes without an event, or every
+ * IWINFO_GENERATION_EVENT_TTL ms while the subscription is up.
+ */
+struct iwinfo_generation_events {
+	struct iwinfo_generation_events *next;
+	const struct iwinfo_ops *ops;
+	struct iwinfo_events ev;
+};
+
+struct iwinfo_generation {
+	struct iwinfo_generation *next;
+	const struct iwinfo_ops *ops;
+	struct iwinfo_generation_events *src;
+	char ifname[IFNAMSIZ];
+	char phy[IFNAMSIZ];
+	uint32_t generation;
+	uint32_t hash;
+	uint64_t checked;
+};
+
+static struct iwinfo_generation *generations = NULL;
+static struct iwinfo_generation_events *generation_events = NULL;
+
+static struct iwinfo_generation_events *
+iwinfo_generation_events(const struct iwinfo_ops *ops)
+{
+	struct iwinfo_generation_events *src;
+
+	if (!ops->events_open)
+		return NULL;
+
+	for (src = generation_events; src; src = src->next)
+		if (src->ops == ops)
+			return src;
+
+	if (!(src = malloc(sizeof(*src))))
+		return NULL;
+
+	memset(src, 0, sizeof(*src));
+	src->ops = ops;
+
+	if (ops->events_open("", &src->ev))
+		src->ev.priv = NULL;
+
+	src->next = generation_events;
+	generation_events = src;
+
+	return src;
+}
+
+static struct iwinfo_generation *
+iwinfo_generation_get(const struct iwinfo_ops *ops, const char *ifname)
+{
+	struct iwinfo_generation *g;
+
+	for (g = generations; g; g = g->next)
+		if (g->ops == ops && !strncmp(g->ifname, ifname, IFNAMSIZ))
+			return g;
+
+	if (!(g = malloc(sizeof(*g))))
+		return NULL;
+
+	memset(g, 0, sizeof(*g));
+	strncpy(g->ifname, ifname, sizeof(g->ifname) - 1);
+
+	g->ops = ops;
+	g->generation = 1;
+	g->src = iwinfo_generation_events(ops);
+
+	if (!ops->phyname || ops->phyname(ifname, g->phy))
+		g->phy[0] = 0;
+
+	g->next = generations;
+	generations = g;
+
+	return g;
+}
+
+static void iwinfo_generation_bump(struct iwinfo_generation_events *src,
+                                   const struct iwinfo_event *e)
+{
+	char phy[IFNAMSIZ] = { 0 };
+	struct iwinfo_generation *g;
+	int all = (!e->ifname[0] || e->type == IWINFO_EVENT_OVERRUN);
+
+	if (!all && src->ops->phyname && src->ops->phyname(e->ifname, phy))
+		phy[0] = 0;
+
+	for (g = generations; g; g = g->next)
+	{
+		if (g->src != src)
+			continue;
+
+		/* events without an interface concern everybody, the others
+		 * every interface on the same phy */
+		if (!all && strncmp(g->ifname, e->ifname, IFNAMSIZ) &&
+		    (!phy[0] || strncmp(g->phy, phy, IFNAMSIZ)))
+			continue;
+
+		g->generation++;
+		g->checked = 0;
+	}
+}
+
+static void iwinfo_generation_drain(struct iwinfo_generation *g)
+{
+	int rv;
+	struct iwinfo_event e;
+	struct iwinfo_generation_events *src = g->src;
+
+	if (!src || !src->ev.priv)
+		return;
+
+	while ((rv = src->ops->events_read(&src->ev, &e)) > 0)
+	{
+		switch (e.type)
+		{
+		case IWINFO_EVENT_CHANNEL_SWITCH:
+		case IWINFO_EVENT_REG_CHANGE:
+		case IWINFO_EVENT_IFACE_CHANGE:
+		case IWINFO_EVENT_OVERRUN:
+			iwinfo_generation_bump(src, &e);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/* subscription broke, changes are only found by comparing from now on */
+	if (rv < 0)
+	{
+		src->ops->events_close(&src->ev);
+		src->ev.priv = NULL;
+
+		memset(&e, 0, sizeof(e));
+		e.type = IWINFO_EVENT_OVERRUN;
+		iwinfo_generation_bump(src, &e);
+	}
+}
+
+static int iwinfo_generation_stale(struct iwinfo_generation *g)
+{
+	int ttl = (g->src && g->src->ev.priv)
+		? IWINFO_GENERATION_EVENT_TTL : IWINFO_GENERATION_TTL;
+
+	return (!g->checked || iwinfo_msecs() - g->checked >= ttl);
+}
+
+static uint32_t iwinfo_generation_hash(const struct iwinfo_info *info)
+{
+	int i;
+	uint32_t hash = 2166136261U;
+	struct iwinfo_info c;
+	const uint8_t *p = (const uint8_t *)&c;
+
+	/* hash a copy with everything but the configuration zeroed */
+	memset(&c, 0, sizeof(c));
+
+	c.valid            = info->valid & IWINFO_INFO_CONFIG;
+	c.mode             = info->mode;
+	c.channel          = info->channel;
+	c.frequency        = info->frequency;
+	c.frequency_offset = info->frequency_offset;
+	c.txpower          = info->txpower;
+	c.txpower_offset   = info->txpower_offset;
+	c.mbssid_support   = info->mbssid_support;
+	c.hwmodes          = info->hwmodes;
+	c.crypto           = info->crypto;
+
+	strncpy(c.ssid, info->ssid, sizeof(c.ssid));
+	strncpy(c.bssid, info->bssid, sizeof(c.bssid));
+	strncpy(c.country, info->country, sizeof(c.country));
+
+	/* FNV-1a */
+	for (i = 0; i < sizeof(c); i++)
+		hash = (hash ^ p[i]) * 16777619U;
+
+	return hash;
+}
+
+static int iwinfo_generation_check(struct iwinfo_generation *g,
+                                   struct iwinfo_info *info)
+{
+	uint32_t hash;
+
+	if (iwinfo_info(g->ops, g->ifname, info))
+		return -1;
+
+	hash = iwinfo_generation_hash(info);
+
+	if (g->checked && hash != g->hash)
+		g->generation++;
+
+	g->hash = hash;
+	g->checked = iwinfo_msecs();
+
+	return 0;
+}
+
+/* Current generation of ifname, 0 if it cannot be tracked */
+uint32_t iwinfo_generation(const struct iwinfo_ops *ops, const char *ifname)
+{
+	struct iwinfo_info info;
+	struct iwinfo_generation *g = iwinfo_generation_get(ops, ifname);
+
+	if (!g)
+		return 0;
+
+	iwinfo_generation_drain(g);
+
+	if (iwinfo_generation_stale(g))
+		iwinfo_generation_check(g, &info);
+
+	return g->generation;
+}
+
+/* Like iwinfo_info() but returns IWINFO_UNCHANGED if the configuration is
+ * still at *generation, info is then left untouched unless a revalidation
+ * had to fetch it anyway. Pass 0 to always fetch, *generation is updated
+ * to the generation the returned values belong to. Only the configuration
+ * fields are covered, link metrics in info may be outdated when the call
+ * returns IWINFO_UNCHANGED. */
+int iwinfo_info_since(const struct iwinfo_ops *ops, const char *ifname,
+                      uint32_t *generation, struct iwinfo_info *info)
+{
+	struct iwinfo_generation *g = iwinfo_generation_get(ops, ifname);
+
+	if (!g)
+		return iwinfo_info(ops, ifname, info);
+
+	iwinfo_generation_drain(g);
+
+	if (*generation == g->generation && !iwinfo_generation_stale(g))
+		return IWINFO_UNCHANGED;
+
+	if (iwinfo_generation_check(g, info))
+		return -1;
+
+	if (*generation == g->generation)
+		return IWINFO_UNCHANGED;
+
+	*generation = g->generation;
+	return 0;
+}
+
+static void iwinfo_generation_free(void)
+{
+	struct iwinfo_generation *g, *next;
+	struct iwinfo_generation_events *src, *snext;
+
+	for (g = generations; g; g = next)
+	{
+		next = g->next;
+		free(g);
+	}
+
+	for (src = generation_events; src; src = snext)
+	{
+		snext = src->next;
+
+		if (src->ev.priv)
+			src->ops->events_close(&src->ev);
+
+		free(src);
+	}
+
+	generations = NULL;
+	generation_events = NULL;
+}
+
 void iwinfo_finish(void)
 {
+	iwinfo_generation_free();
+
 #ifdef USE_WL
 	wl_close();
 #endif
@@ -398,5 +1603,9 @@ void iwinfo_finish(void)
 	nl80211_close();
 #endif
 	wext_close();
+	shm_close();
+	iwinfo_client_close();
 	iwinfo_close();
+	iwinfo_rates_free();
+	iwinfo_ie_sets_free();
 }
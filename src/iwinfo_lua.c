@@ -19,6 +19,169 @@
 #include "iwinfo/lua.h"
 
 
+/*
+ * Interned table keys, kept in a table which is bound as first upvalue
+ * to every backend function so that result tables can be filled with
+ * lua_rawgeti() + lua_rawset() instead of hashing C strings each time.
+ */
+enum {
+	IWINFO_L_KEY_SIGNAL = 1,
+	IWINFO_L_KEY_NOISE,
+	IWINFO_L_KEY_INACTIVE,
+	IWINFO_L_KEY_RX_PACKETS,
+	IWINFO_L_KEY_TX_PACKETS,
+	IWINFO_L_KEY_RX_BYTES,
+	IWINFO_L_KEY_TX_BYTES,
+	IWINFO_L_KEY_TX_RETRIES,
+	IWINFO_L_KEY_TX_FAILED,
+	IWINFO_L_KEY_BEACON_LOSS,
+	IWINFO_L_KEY_CONNECTED_TIME,
+	IWINFO_L_KEY_INTERVAL,
+	IWINFO_L_KEY_RX_BYTE_RATE,
+	IWINFO_L_KEY_TX_BYTE_RATE,
+	IWINFO_L_KEY_RX_PACKET_RATE,
+	IWINFO_L_KEY_TX_PACKET_RATE,
+	IWINFO_L_KEY_TX_RETRY_RATIO,
+	IWINFO_L_KEY_TX_FAIL_RATIO,
+	IWINFO_L_KEY_RX_RATE,
+	IWINFO_L_KEY_TX_RATE,
+	IWINFO_L_KEY_RX_MCS,
+	IWINFO_L_KEY_RX_40MHZ,
+	IWINFO_L_KEY_RX_SHORT_GI,
+	IWINFO_L_KEY_TX_MCS,
+	IWINFO_L_KEY_TX_40MHZ,
+	IWINFO_L_KEY_TX_SHORT_GI,
+	IWINFO_L_KEY_BSSID,
+	IWINFO_L_KEY_SSID,
+	IWINFO_L_KEY_CHANNEL,
+	IWINFO_L_KEY_MODE,
+	IWINFO_L_KEY_QUALITY,
+	IWINFO_L_KEY_QUALITY_MAX,
+	IWINFO_L_KEY_ENCRYPTION,
+	IWINFO_L_KEY_ENABLED,
+	IWINFO_L_KEY_DESCRIPTION,
+	IWINFO_L_KEY_WEP,
+	IWINFO_L_KEY_WPA,
+	IWINFO_L_KEY_PAIR_CIPHERS,
+	IWINFO_L_KEY_GROUP_CIPHERS,
+	IWINFO_L_KEY_AUTH_SUITES,
+	IWINFO_L_KEY_AUTH_ALGS,
+	IWINFO_L_KEY_MAC,
+	IWINFO_L_KEY_COUNT
+};
+
+static const char *iwinfo_L_keynames[IWINFO_L_KEY_COUNT] = {
+	[IWINFO_L_KEY_SIGNAL]         = "signal",
+	[IWINFO_L_KEY_NOISE]          = "noise",
+	[IWINFO_L_KEY_INACTIVE]       = "inactive",
+	[IWINFO_L_KEY_RX_PACKETS]     = "rx_packets",
+	[IWINFO_L_KEY_TX_PACKETS]     = "tx_packets",
+	[IWINFO_L_KEY_RX_BYTES]       = "rx_bytes",
+	[IWINFO_L_KEY_TX_BYTES]       = "tx_bytes",
+	[IWINFO_L_KEY_TX_RETRIES]     = "tx_retries",
+	[IWINFO_L_KEY_TX_FAILED]      = "tx_failed",
+	[IWINFO_L_KEY_BEACON_LOSS]    = "beacon_loss",
+	[IWINFO_L_KEY_CONNECTED_TIME] = "connected_time",
+	[IWINFO_L_KEY_INTERVAL]       = "interval",
+	[IWINFO_L_KEY_RX_BYTE_RATE]   = "rx_byte_rate",
+	[IWINFO_L_KEY_TX_BYTE_RATE]   = "tx_byte_rate",
+	[IWINFO_L_KEY_RX_PACKET_RATE] = "rx_packet_rate",
+	[IWINFO_L_KEY_TX_PACKET_RATE] = "tx_packet_rate",
+	[IWINFO_L_KEY_TX_RETRY_RATIO] = "tx_retry_ratio",
+	[IWINFO_L_KEY_TX_FAIL_RATIO]  = "tx_fail_ratio",
+	[IWINFO_L_KEY_RX_RATE]        = "rx_rate",
+	[IWINFO_L_KEY_TX_RATE]        = "tx_rate",
+	[IWINFO_L_KEY_RX_MCS]         = "rx_mcs",
+	[IWINFO_L_KEY_RX_40MHZ]       = "rx_40mhz",
+	[IWINFO_L_KEY_RX_SHORT_GI]    = "rx_short_gi",
+	[IWINFO_L_KEY_TX_MCS]         = "tx_mcs",
+	[IWINFO_L_KEY_TX_40MHZ]       = "tx_40mhz",
+	[IWINFO_L_KEY_TX_SHORT_GI]    = "tx_short_gi",
+	[IWINFO_L_KEY_BSSID]          = "bssid",
+	[IWINFO_L_KEY_SSID]           = "ssid",
+	[IWINFO_L_KEY_CHANNEL]        = "channel",
+	[IWINFO_L_KEY_MODE]           = "mode",
+	[IWINFO_L_KEY_QUALITY]        = "quality",
+	[IWINFO_L_KEY_QUALITY_MAX]    = "quality_max",
+	[IWINFO_L_KEY_ENCRYPTION]     = "encryption",
+	[IWINFO_L_KEY_ENABLED]        = "enabled",
+	[IWINFO_L_KEY_DESCRIPTION]    = "description",
+	[IWINFO_L_KEY_WEP]            = "wep",
+	[IWINFO_L_KEY_WPA]            = "wpa",
+	[IWINFO_L_KEY_PAIR_CIPHERS]   = "pair_ciphers",
+	[IWINFO_L_KEY_GROUP_CIPHERS]  = "group_ciphers",
+	[IWINFO_L_KEY_AUTH_SUITES]    = "auth_suites",
+	[IWINFO_L_KEY_AUTH_ALGS]      = "auth_algs",
+	[IWINFO_L_KEY_MAC]            = "mac",
+};
+
+/* Push the interned key, the caller pushes the value and does lua_rawset(),
+ * the same table maps each name back to its id for lazy field lookups */
+#define iwinfo_L_key(L, k) \
+	lua_rawgeti(L, lua_upvalueindex(1), IWINFO_L_KEY_##k)
+
+static void iwinfo_L_keytable(lua_State *L)
+{
+	int i;
+
+	lua_createtable(L, IWINFO_L_KEY_COUNT - 1, IWINFO_L_KEY_COUNT - 1);
+
+	for (i = 1; i < IWINFO_L_KEY_COUNT; i++)
+	{
+		lua_pushstring(L, iwinfo_L_keynames[i]);
+		lua_rawseti(L, -2, i);
+
+		lua_pushinteger(L, i);
+		lua_setfield(L, -2, iwinfo_L_keynames[i]);
+	}
+}
+
+/* Map a field name at the given stack index to its key id, 0 if unknown */
+static int iwinfo_L_keyid(lua_State *L, int idx)
+{
+	int id;
+
+	if (lua_type(L, idx) != LUA_TSTRING)
+		return 0;
+
+	lua_pushvalue(L, idx);
+	lua_rawget(L, lua_upvalueindex(1));
+	id = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+
+	return id;
+}
+
+/* Format a MAC address as upper case hex string, returns its length */
+static int iwinfo_L_macstr(char *str, const uint8_t *mac)
+{
+	int i;
+	static const char hex[] = "0123456789ABCDEF";
+
+	for (i = 0; i < 6; i++)
+	{
+		*str++ = hex[mac[i] >> 4];
+		*str++ = hex[mac[i] & 0xf];
+		*str++ = ':';
+	}
+
+	*--str = 0;
+
+	return 17;
+}
+
+/* Number of set bits, used to presize name list tables */
+static int iwinfo_L_bits(uint32_t mask)
+{
+	int n;
+
+	for (n = 0; mask; n++)
+		mask &= mask - 1;
+
+	return n;
+}
+
+
 /* Determine type */
 static int iwinfo_L_type(lua_State *L)
 {
@@ -33,6 +196,103 @@ static int iwinfo_L_type(lua_State *L)
 	return 1;
 }
 
+/* Set the cross-process scan reuse window in ms, 0 disables it */
+static int iwinfo_L_scan_coalesce(lua_State *L)
+{
+	iwinfo_scan_coalesce(luaL_checkinteger(L, 1));
+	return 0;
+}
+
+/* Configuration generation of a device, nil if it cannot be tracked */
+static int iwinfo_L_generation(lua_State *L)
+{
+	uint32_t gen = 0;
+	const char *ifname = luaL_checkstring(L, 1);
+	const struct iwinfo_ops *ops = iwinfo_backend(ifname);
+
+	if (ops && (gen = iwinfo_generation(ops, ifname)) > 0)
+		lua_pushnumber(L, gen);
+	else
+		lua_pushnil(L);
+
+	return 1;
+}
+
+/* Publish one snapshot of a device for shared memory readers */
+static int iwinfo_L_publish(lua_State *L)
+{
+	const char *ifname = luaL_checkstring(L, 1);
+	int interval = luaL_checkinteger(L, 2);
+	const struct iwinfo_ops *ops = iwinfo_backend(ifname);
+
+	lua_pushboolean(L, ops && !iwinfo_shm_publish(ops, ifname, interval));
+	return 1;
+}
+
+/* Per-operation library statistics, nil unless built with USE_STATS */
+static int iwinfo_L_stats(lua_State *L)
+{
+	int i, j, len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_stats_entry *e;
+
+	if (iwinfo_stats(buf, &len))
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_newtable(L);
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_stats_entry))
+	{
+		e = (struct iwinfo_stats_entry *) &buf[i];
+
+		lua_newtable(L);
+
+		lua_pushstring(L, e->backend);
+		lua_setfield(L, -2, "backend");
+
+		lua_pushstring(L, e->op);
+		lua_setfield(L, -2, "op");
+
+		lua_pushnumber(L, e->calls);
+		lua_setfield(L, -2, "calls");
+
+		lua_pushnumber(L, e->errors);
+		lua_setfield(L, -2, "errors");
+
+		lua_pushnumber(L, e->usecs);
+		lua_setfield(L, -2, "usecs");
+
+		lua_newtable(L);
+
+		for (j = 0; j < IWINFO_STATS_BUCKETS; j++)
+		{
+			lua_pushnumber(L, e->latency[j]);
+			lua_rawseti(L, -2, j + 1);
+		}
+
+		lua_setfield(L, -2, "latency");
+
+		for (j = 0; j < IWINFO_STATS_COUNTERS; j++)
+		{
+			lua_pushnumber(L, e->count[j]);
+			lua_setfield(L, -2, IWINFO_STATS_NAMES[j]);
+		}
+
+		lua_rawseti(L, -2, i / sizeof(struct iwinfo_stats_entry) + 1);
+	}
+
+	return 1;
+}
+
+static int iwinfo_L_stats_reset(lua_State *L)
+{
+	iwinfo_stats_reset();
+	return 0;
+}
+
 /* Shutdown backends */
 static int iwinfo_L__gc(lua_State *L)
 {
@@ -61,6 +321,15 @@ static char * iwinfo_crypto_print_ciphers(int ciphers)
 	if (ciphers & IWINFO_CIPHER_CCMP)
 		pos += sprintf(pos, "CCMP, ");
 
+	if (ciphers & IWINFO_CIPHER_CCMP256)
+		pos += sprintf(pos, "CCMP-256, ");
+
+	if (ciphers & IWINFO_CIPHER_GCMP)
+		pos += sprintf(pos, "GCMP, ");
+
+	if (ciphers & IWINFO_CIPHER_GCMP256)
+		pos += sprintf(pos, "GCMP-256, ");
+
 	if (ciphers & IWINFO_CIPHER_WRAP)
 		pos += sprintf(pos, "WRAP, ");
 
@@ -89,6 +358,12 @@ static char * iwinfo_crypto_print_suites(int suites)
 	if (suites & IWINFO_KMGMT_8021x)
 		pos += sprintf(pos, "802.1X/");
 
+	if (suites & IWINFO_KMGMT_SAE)
+		pos += sprintf(pos, "SAE/");
+
+	if (suites & IWINFO_KMGMT_OWE)
+		pos += sprintf(pos, "OWE/");
+
 	if (!suites || (suites & IWINFO_KMGMT_NONE))
 		pos += sprintf(pos, "NONE/");
 
@@ -112,17 +387,20 @@ static char * iwinfo_crypto_desc(struct iwinfo_crypto_entry *c)
 				    (c->auth_algs & IWINFO_AUTH_SHARED))
 				{
 					sprintf(desc, "WEP Open/Shared (%s)",
-						iwinfo_crypto_print_ciphers(c->pair_ciphers));
+						iwinfo_crypto_print_ciphers(
+							IWINFO_CRYPTO_CIPHERS(c, pair)));
 				}
 				else if (c->auth_algs & IWINFO_AUTH_OPEN)
 				{
 					sprintf(desc, "WEP Open System (%s)",
-						iwinfo_crypto_print_ciphers(c->pair_ciphers));
+						iwinfo_crypto_print_ciphers(
+							IWINFO_CRYPTO_CIPHERS(c, pair)));
 				}
 				else if (c->auth_algs & IWINFO_AUTH_SHARED)
 				{
 					sprintf(desc, "WEP Shared Auth (%s)",
-						iwinfo_crypto_print_ciphers(c->pair_ciphers));
+						iwinfo_crypto_print_ciphers(
+							IWINFO_CRYPTO_CIPHERS(c, pair)));
 				}
 			}
 
@@ -134,21 +412,24 @@ static char * iwinfo_crypto_desc(struct iwinfo_crypto_entry *c)
 						sprintf(desc, "mixed WPA/WPA2 %s (%s)",
 							iwinfo_crypto_print_suites(c->auth_suites),
 							iwinfo_crypto_print_ciphers(
-								c->pair_ciphers & c->group_ciphers));
+								IWINFO_CRYPTO_CIPHERS(c, pair) &
+								IWINFO_CRYPTO_CIPHERS(c, group)));
 						break;
 
 					case 2:
 						sprintf(desc, "WPA2 %s (%s)",
 							iwinfo_crypto_print_suites(c->auth_suites),
 							iwinfo_crypto_print_ciphers(
-								c->pair_ciphers & c->group_ciphers));
+								IWINFO_CRYPTO_CIPHERS(c, pair) &
+								IWINFO_CRYPTO_CIPHERS(c, group)));
 						break;
 
 					case 1:
 						sprintf(desc, "WPA %s (%s)",
 							iwinfo_crypto_print_suites(c->auth_suites),
 							iwinfo_crypto_print_ciphers(
-								c->pair_ciphers & c->group_ciphers));
+								IWINFO_CRYPTO_CIPHERS(c, pair) &
+								IWINFO_CRYPTO_CIPHERS(c, group)));
 						break;
 				}
 			}
@@ -170,292 +451,1437 @@ static char * iwinfo_crypto_desc(struct iwinfo_crypto_entry *c)
 	return desc;
 }
 
-/* Build Lua table from crypto data */
-static void iwinfo_L_cryptotable(lua_State *L, struct iwinfo_crypto_entry *c)
+/* Build Lua array of the names whose bit is set in mask */
+static void iwinfo_L_namelist(lua_State *L, uint32_t mask,
+                              const char **names, int count)
 {
 	int i, j;
 
-	lua_newtable(L);
+	lua_createtable(L, iwinfo_L_bits(mask), 0);
+
+	for (i = 0, j = 1; i < count; i++)
+	{
+		if (mask & (1 << i))
+		{
+			lua_pushstring(L, names[i]);
+			lua_rawseti(L, -2, j++);
+		}
+	}
+}
+
+/* Build Lua table from crypto data */
+static void iwinfo_L_cryptotable(lua_State *L, struct iwinfo_crypto_entry *c)
+{
+	lua_createtable(L, 0, 8);
 
+	iwinfo_L_key(L, ENABLED);
 	lua_pushboolean(L, c->enabled);
-	lua_setfield(L, -2, "enabled");
+	lua_rawset(L, -3);
 
+	iwinfo_L_key(L, DESCRIPTION);
 	lua_pushstring(L, iwinfo_crypto_desc(c));
-	lua_setfield(L, -2, "description");
+	lua_rawset(L, -3);
 
+	iwinfo_L_key(L, WEP);
 	lua_pushboolean(L, (c->enabled && !c->wpa_version));
-	lua_setfield(L, -2, "wep");
+	lua_rawset(L, -3);
 
+	iwinfo_L_key(L, WPA);
 	lua_pushinteger(L, c->wpa_version);
-	lua_setfield(L, -2, "wpa");
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, PAIR_CIPHERS);
+	iwinfo_L_namelist(L, IWINFO_CRYPTO_CIPHERS(c, pair),
+	                  IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, GROUP_CIPHERS);
+	iwinfo_L_namelist(L, IWINFO_CRYPTO_CIPHERS(c, group),
+	                  IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, AUTH_SUITES);
+	iwinfo_L_namelist(L, c->auth_suites,
+	                  IWINFO_KMGMT_NAMES, IWINFO_KMGMT_COUNT);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, AUTH_ALGS);
+	iwinfo_L_namelist(L, c->auth_algs, IWINFO_AUTH_NAMES, 8);
+	lua_rawset(L, -3);
+}
 
-	lua_newtable(L);
-	for (i = 0, j = 1; i < 8; i++)
+
+/* Wrapper for mode */
+static int iwinfo_L_mode(lua_State *L, int (*func)(const char *, int *))
+{
+	int mode;
+	const char *ifname = luaL_checkstring(L, 1);
+
+	if ((*func)(ifname, &mode))
+		mode = IWINFO_OPMODE_UNKNOWN;
+
+	lua_pushstring(L, IWINFO_OPMODE_NAMES[mode]);
+	return 1;
+}
+
+/* Build Lua table from assoclist entry */
+static void iwinfo_L_assoctable(lua_State *L,
+                                struct iwinfo_assoclist_ext_entry *x)
+{
+	struct iwinfo_assoclist_entry *e = &x->base;
+
+	lua_createtable(L, 0, 19);
+
+	iwinfo_L_key(L, SIGNAL);
+	lua_pushnumber(L, e->signal);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, NOISE);
+	lua_pushnumber(L, e->noise);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, INACTIVE);
+	lua_pushnumber(L, e->inactive);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, RX_PACKETS);
+	lua_pushnumber(L, x->rx_packets);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, TX_PACKETS);
+	lua_pushnumber(L, x->tx_packets);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, RX_BYTES);
+	lua_pushnumber(L, x->rx_bytes);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, TX_BYTES);
+	lua_pushnumber(L, x->tx_bytes);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, TX_RETRIES);
+	lua_pushnumber(L, x->tx_retries);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, TX_FAILED);
+	lua_pushnumber(L, x->tx_failed);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, BEACON_LOSS);
+	lua_pushnumber(L, x->beacon_loss);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, CONNECTED_TIME);
+	lua_pushnumber(L, x->connected_time);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, RX_RATE);
+	lua_pushnumber(L, e->rx_rate.rate);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, TX_RATE);
+	lua_pushnumber(L, e->tx_rate.rate);
+	lua_rawset(L, -3);
+
+	if (e->rx_rate.mcs >= 0)
 	{
-		if (c->pair_ciphers & (1 << i))
-		{
-			lua_pushstring(L, IWINFO_CIPHER_NAMES[i]);
-			lua_rawseti(L, -2, j++);
-		}
+		iwinfo_L_key(L, RX_MCS);
+		lua_pushnumber(L, e->rx_rate.mcs);
+		lua_rawset(L, -3);
+
+		iwinfo_L_key(L, RX_40MHZ);
+		lua_pushboolean(L, e->rx_rate.is_40mhz);
+		lua_rawset(L, -3);
+
+		iwinfo_L_key(L, RX_SHORT_GI);
+		lua_pushboolean(L, e->rx_rate.is_short_gi);
+		lua_rawset(L, -3);
 	}
-	lua_setfield(L, -2, "pair_ciphers");
 
-	lua_newtable(L);
-	for (i = 0, j = 1; i < 8; i++)
+	if (e->tx_rate.mcs >= 0)
 	{
-		if (c->group_ciphers & (1 << i))
-		{
-			lua_pushstring(L, IWINFO_CIPHER_NAMES[i]);
-			lua_rawseti(L, -2, j++);
-		}
+		iwinfo_L_key(L, TX_MCS);
+		lua_pushnumber(L, e->tx_rate.mcs);
+		lua_rawset(L, -3);
+
+		iwinfo_L_key(L, TX_40MHZ);
+		lua_pushboolean(L, e->tx_rate.is_40mhz);
+		lua_rawset(L, -3);
+
+		iwinfo_L_key(L, TX_SHORT_GI);
+		lua_pushboolean(L, e->tx_rate.is_short_gi);
+		lua_rawset(L, -3);
 	}
-	lua_setfield(L, -2, "group_ciphers");
+}
 
-	lua_newtable(L);
-	for (i = 0, j = 1; i < 8; i++)
+/* Wrapper for assoclist */
+/* Read list filter options from the table at idx, if any */
+static int iwinfo_L_filter_int(lua_State *L, int idx, const char *key)
+{
+	int rv;
+
+	lua_getfield(L, idx, key);
+	rv = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+
+	return rv;
+}
+
+static void iwinfo_L_filter_set(lua_State *L, int idx, const char *key,
+                                struct iwinfo_filter *f,
+                                void (*add)(struct iwinfo_filter *, int))
+{
+	int i, n;
+
+	lua_getfield(L, idx, key);
+
+	if (lua_isnumber(L, -1))
+	{
+		add(f, lua_tointeger(L, -1));
+	}
+	else if (lua_istable(L, -1))
 	{
-		if (c->auth_suites & (1 << i))
+		for (i = 1, n = lua_objlen(L, -1); i <= n; i++)
 		{
-			lua_pushstring(L, IWINFO_KMGMT_NAMES[i]);
-			lua_rawseti(L, -2, j++);
+			lua_rawgeti(L, -1, i);
+			add(f, lua_tointeger(L, -1));
+			lua_pop(L, 1);
 		}
 	}
-	lua_setfield(L, -2, "auth_suites");
 
-	lua_newtable(L);
-	for (i = 0, j = 1; i < 8; i++)
+	lua_pop(L, 1);
+}
+
+static int iwinfo_L_filter(lua_State *L, int idx, struct iwinfo_filter *f)
+{
+	int i, n;
+	size_t len;
+	const char *s;
+
+	memset(f, 0, sizeof(*f));
+
+	if (!lua_istable(L, idx))
+		return 0;
+
+	f->min_signal   = iwinfo_L_filter_int(L, idx, "min_signal");
+	f->max_signal   = iwinfo_L_filter_int(L, idx, "max_signal");
+	f->max_inactive = iwinfo_L_filter_int(L, idx, "max_inactive");
+	f->top          = iwinfo_L_filter_int(L, idx, "top");
+
+	iwinfo_L_filter_set(L, idx, "channels", f, iwinfo_filter_channel);
+	iwinfo_L_filter_set(L, idx, "frequencies", f, iwinfo_filter_frequency);
+
+	lua_getfield(L, idx, "ssid");
+	if ((s = lua_tolstring(L, -1, &len)) != NULL)
+		memcpy(f->ssid, s, (len < IWINFO_ESSID_MAX_SIZE)
+		                   ? len : IWINFO_ESSID_MAX_SIZE);
+	lua_pop(L, 1);
+
+	lua_getfield(L, idx, "fields");
+	if (lua_istable(L, -1))
 	{
-		if (c->auth_algs & (1 << i))
+		for (i = 1, n = lua_objlen(L, -1); i <= n; i++)
 		{
-			lua_pushstring(L, IWINFO_AUTH_NAMES[i]);
-			lua_rawseti(L, -2, j++);
+			lua_rawgeti(L, -1, i);
+
+			if ((s = lua_tostring(L, -1)) != NULL)
+			{
+				if (!strcmp(s, "counters"))
+					f->fields |= IWINFO_FIELD_COUNTERS;
+				else if (!strcmp(s, "rates"))
+					f->fields |= IWINFO_FIELD_RATES;
+				else if (!strcmp(s, "crypto"))
+					f->fields |= IWINFO_FIELD_CRYPTO;
+			}
+
+			lua_pop(L, 1);
 		}
 	}
-	lua_setfield(L, -2, "auth_algs");
-}
+	lua_pop(L, 1);
 
+	return 1;
+}
 
-/* Wrapper for mode */
-static int iwinfo_L_mode(lua_State *L, int (*func)(const char *, int *))
+static int iwinfo_L_assoclist(lua_State *L, const struct iwinfo_ops *ops)
 {
-	int mode;
+	int i, len;
+	char rv[IWINFO_BUFSIZE];
+	char macstr[18];
 	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_assoclist_ext_entry *e;
+	struct iwinfo_filter f;
 
-	if ((*func)(ifname, &mode))
-		mode = IWINFO_OPMODE_UNKNOWN;
+	if (iwinfo_assoclist_filter(ops, ifname,
+	                            iwinfo_L_filter(L, 2, &f) ? &f : NULL,
+	                            rv, &len))
+	{
+		lua_newtable(L);
+		return 1;
+	}
+
+	lua_createtable(L, 0, len / sizeof(struct iwinfo_assoclist_ext_entry));
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_ext_entry))
+	{
+		e = (struct iwinfo_assoclist_ext_entry *) &rv[i];
+
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, e->base.mac));
+		iwinfo_L_assoctable(L, e);
+		lua_rawset(L, -3);
+	}
 
-	lua_pushstring(L, IWINFO_OPMODE_NAMES[mode]);
 	return 1;
 }
 
-/* Wrapper for assoclist */
-static int iwinfo_L_assoclist(lua_State *L, int (*func)(const char *, char *, int *))
+/* Wrapper for per-station rates, window counts samples back */
+static int iwinfo_L_assoclist_rates(lua_State *L, const struct iwinfo_ops *ops)
 {
 	int i, len;
 	char rv[IWINFO_BUFSIZE];
 	char macstr[18];
 	const char *ifname = luaL_checkstring(L, 1);
-	struct iwinfo_assoclist_entry *e;
+	int window = luaL_optinteger(L, 2, 1);
+	struct iwinfo_assoclist_rates *r;
 
-	lua_newtable(L);
-	memset(rv, 0, sizeof(rv));
+	if (iwinfo_assoclist_rates(ops, ifname, window, rv, &len))
+	{
+		lua_newtable(L);
+		return 1;
+	}
 
-	if (!(*func)(ifname, rv, &len))
+	lua_createtable(L, 0, len / sizeof(struct iwinfo_assoclist_rates));
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_rates))
 	{
-		for (i = 0; i < len; i += sizeof(struct iwinfo_assoclist_entry))
-		{
-			e = (struct iwinfo_assoclist_entry *) &rv[i];
+		r = (struct iwinfo_assoclist_rates *) &rv[i];
 
-			sprintf(macstr, "%02X:%02X:%02X:%02X:%02X:%02X",
-				e->mac[0], e->mac[1], e->mac[2],
-				e->mac[3], e->mac[4], e->mac[5]);
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, r->mac));
+		lua_createtable(L, 0, 11);
 
-			lua_newtable(L);
+		iwinfo_L_key(L, INTERVAL);
+		lua_pushnumber(L, r->interval);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->signal);
-			lua_setfield(L, -2, "signal");
+		iwinfo_L_key(L, RX_BYTES);
+		lua_pushnumber(L, r->rx_bytes);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->noise);
-			lua_setfield(L, -2, "noise");
+		iwinfo_L_key(L, TX_BYTES);
+		lua_pushnumber(L, r->tx_bytes);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->inactive);
-			lua_setfield(L, -2, "inactive");
+		iwinfo_L_key(L, RX_PACKETS);
+		lua_pushnumber(L, r->rx_packets);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->rx_packets);
-			lua_setfield(L, -2, "rx_packets");
+		iwinfo_L_key(L, TX_PACKETS);
+		lua_pushnumber(L, r->tx_packets);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->tx_packets);
-			lua_setfield(L, -2, "tx_packets");
+		iwinfo_L_key(L, RX_BYTE_RATE);
+		lua_pushnumber(L, r->rx_byte_rate);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->rx_rate.rate);
-			lua_setfield(L, -2, "rx_rate");
+		iwinfo_L_key(L, TX_BYTE_RATE);
+		lua_pushnumber(L, r->tx_byte_rate);
+		lua_rawset(L, -3);
 
-			lua_pushnumber(L, e->tx_rate.rate);
-			lua_setfield(L, -2, "tx_rate");
+		iwinfo_L_key(L, RX_PACKET_RATE);
+		lua_pushnumber(L, r->rx_packet_rate);
+		lua_rawset(L, -3);
 
-			if (e->rx_rate.mcs >= 0)
-			{
-				lua_pushnumber(L, e->rx_rate.mcs);
-				lua_setfield(L, -2, "rx_mcs");
+		iwinfo_L_key(L, TX_PACKET_RATE);
+		lua_pushnumber(L, r->tx_packet_rate);
+		lua_rawset(L, -3);
+
+		/* ratios in percent */
+		iwinfo_L_key(L, TX_RETRY_RATIO);
+		lua_pushnumber(L, r->tx_retry_ratio / 100.0);
+		lua_rawset(L, -3);
+
+		iwinfo_L_key(L, TX_FAIL_RATIO);
+		lua_pushnumber(L, r->tx_fail_ratio / 100.0);
+		lua_rawset(L, -3);
+
+		lua_rawset(L, -3);
+	}
+
+	return 1;
+}
+
+/* Wrapper for single station lookup */
+static int iwinfo_L_station(lua_State *L, const struct iwinfo_ops *ops)
+{
+	uint8_t mac[6];
+	const char *ifname = luaL_checkstring(L, 1);
+	const char *macstr = luaL_checkstring(L, 2);
+	struct iwinfo_assoclist_ext_entry e;
+
+	if (sscanf(macstr, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+	           &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6)
+		return luaL_argerror(L, 2, "invalid MAC address");
+
+	if (iwinfo_station_get(ops, ifname, mac, &e))
+		lua_pushnil(L);
+	else
+		iwinfo_L_assoctable(L, &e);
+
+	return 1;
+}
+
+/*
+ * Lazy lists: a single userdata holds the raw result array, entries and
+ * their encryption info are only converted into Lua values on access.
+ */
+enum {
+	IWINFO_L_LIST_ASSOC,
+	IWINFO_L_LIST_SCAN,
+};
+
+struct iwinfo_L_list {
+	int type;
+	int count;
+	char data[];
+};
+
+struct iwinfo_L_entry {
+	int type;
+	union {
+		struct iwinfo_assoclist_ext_entry assoc;
+		struct iwinfo_scanlist_entry scan;
+	} u;
+};
+
+static size_t iwinfo_L_list_esize(int type)
+{
+	return (type == IWINFO_L_LIST_ASSOC)
+		? sizeof(struct iwinfo_assoclist_ext_entry)
+		: sizeof(struct iwinfo_scanlist_entry);
+}
+
+static int iwinfo_L_list_new(lua_State *L, int type,
+                             int (*func)(const char *, char *, int *))
+{
+	int len;
+	char rv[IWINFO_BUFSIZE];
+	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_L_list *l;
+
+	if ((*func)(ifname, rv, &len))
+		len = 0;
+
+	/* backend getters return plain entries, lists hold extended ones */
+	if (type == IWINFO_L_LIST_ASSOC)
+		iwinfo_assoclist_widen(rv, &len, sizeof(rv));
+
+	l = lua_newuserdata(L, sizeof(*l) + len);
+	l->type  = type;
+	l->count = len / iwinfo_L_list_esize(type);
+	memcpy(l->data, rv, len);
+
+	luaL_getmetatable(L, IWINFO_LIST_META);
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+static void iwinfo_L_entry_push(lua_State *L, struct iwinfo_L_list *l, int i)
+{
+	size_t esize = iwinfo_L_list_esize(l->type);
+	struct iwinfo_L_entry *e = lua_newuserdata(L, sizeof(*e));
+
+	e->type = l->type;
+	memcpy(&e->u, l->data + i * esize, esize);
+
+	luaL_getmetatable(L, IWINFO_ENTRY_META);
+	lua_setmetatable(L, -2);
+}
+
+static void iwinfo_L_crypto_push(lua_State *L, struct iwinfo_crypto_entry *c)
+{
+	struct iwinfo_crypto_entry *p = lua_newuserdata(L, sizeof(*p));
+
+	memcpy(p, c, sizeof(*p));
+
+	luaL_getmetatable(L, IWINFO_CRYPTO_META);
+	lua_setmetatable(L, -2);
+}
+
+/* list[n] yields the n-th entry, assoc lists may also be indexed by MAC */
+static int iwinfo_L_list_index(lua_State *L)
+{
+	int i;
+	char macstr[18];
+	const char *key;
+	struct iwinfo_L_list *l = luaL_checkudata(L, 1, IWINFO_LIST_META);
+
+	if (lua_type(L, 2) == LUA_TNUMBER)
+	{
+		i = lua_tointeger(L, 2);
+
+		if (i >= 1 && i <= l->count)
+		{
+			iwinfo_L_entry_push(L, l, i - 1);
+			return 1;
+		}
+	}
+	else if (l->type == IWINFO_L_LIST_ASSOC &&
+	         (key = lua_tostring(L, 2)) != NULL && strlen(key) == 17)
+	{
+		for (i = 0; i < l->count; i++)
+		{
+			iwinfo_L_macstr(macstr,
+				((struct iwinfo_assoclist_ext_entry *)l->data)[i].base.mac);
+
+			if (!strcasecmp(macstr, key))
+			{
+				iwinfo_L_entry_push(L, l, i);
+				return 1;
+			}
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+static int iwinfo_L_list_len(lua_State *L)
+{
+	struct iwinfo_L_list *l = luaL_checkudata(L, 1, IWINFO_LIST_META);
+
+	lua_pushinteger(L, l->count);
+	return 1;
+}
+
+/* Iterator closure, upvalue 2 holds the position */
+static int iwinfo_L_list_next(lua_State *L)
+{
+	char macstr[18];
+	struct iwinfo_L_list *l = luaL_checkudata(L, 1, IWINFO_LIST_META);
+	int i = lua_tointeger(L, lua_upvalueindex(2));
+
+	if (i >= l->count)
+		return 0;
+
+	lua_pushinteger(L, i + 1);
+	lua_replace(L, lua_upvalueindex(2));
+
+	if (l->type == IWINFO_L_LIST_ASSOC)
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr,
+			((struct iwinfo_assoclist_ext_entry *)l->data)[i].base.mac));
+	else
+		lua_pushinteger(L, i + 1);
+
+	iwinfo_L_entry_push(L, l, i);
+	return 2;
+}
+
+/* Keys are MAC strings for assoc lists and indexes for scan lists */
+static int iwinfo_L_list_pairs(lua_State *L)
+{
+	luaL_checkudata(L, 1, IWINFO_LIST_META);
+
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_pushinteger(L, 0);
+	lua_pushcclosure(L, iwinfo_L_list_next, 2);
+	lua_pushvalue(L, 1);
+	lua_pushnil(L);
+
+	return 3;
+}
+
+static int iwinfo_L_entry_assoc(lua_State *L,
+                                struct iwinfo_assoclist_ext_entry *x, int key)
+{
+	char macstr[18];
+	struct iwinfo_assoclist_entry *e = &x->base;
+	struct iwinfo_rate_entry *r = NULL;
+
+	switch (key)
+	{
+	case IWINFO_L_KEY_MAC:
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, e->mac));
+		return 1;
+
+	case IWINFO_L_KEY_SIGNAL:     lua_pushnumber(L, e->signal);       return 1;
+	case IWINFO_L_KEY_NOISE:      lua_pushnumber(L, e->noise);        return 1;
+	case IWINFO_L_KEY_INACTIVE:   lua_pushnumber(L, e->inactive);     return 1;
+	case IWINFO_L_KEY_RX_PACKETS: lua_pushnumber(L, x->rx_packets);   return 1;
+	case IWINFO_L_KEY_TX_PACKETS: lua_pushnumber(L, x->tx_packets);   return 1;
+	case IWINFO_L_KEY_RX_BYTES:   lua_pushnumber(L, x->rx_bytes);     return 1;
+	case IWINFO_L_KEY_TX_BYTES:   lua_pushnumber(L, x->tx_bytes);     return 1;
+	case IWINFO_L_KEY_TX_RETRIES: lua_pushnumber(L, x->tx_retries);   return 1;
+	case IWINFO_L_KEY_TX_FAILED:  lua_pushnumber(L, x->tx_failed);    return 1;
+	case IWINFO_L_KEY_RX_RATE:    lua_pushnumber(L, e->rx_rate.rate); return 1;
+	case IWINFO_L_KEY_TX_RATE:    lua_pushnumber(L, e->tx_rate.rate); return 1;
+
+	case IWINFO_L_KEY_BEACON_LOSS:
+		lua_pushnumber(L, x->beacon_loss);
+		return 1;
+
+	case IWINFO_L_KEY_CONNECTED_TIME:
+		lua_pushnumber(L, x->connected_time);
+		return 1;
+
+	case IWINFO_L_KEY_RX_MCS:
+	case IWINFO_L_KEY_RX_40MHZ:
+	case IWINFO_L_KEY_RX_SHORT_GI:
+		r = &e->rx_rate;
+		break;
+
+	case IWINFO_L_KEY_TX_MCS:
+	case IWINFO_L_KEY_TX_40MHZ:
+	case IWINFO_L_KEY_TX_SHORT_GI:
+		r = &e->tx_rate;
+		break;
+	}
+
+	/* MCS details are only present for HT rates */
+	if (!r || r->mcs < 0)
+		return 0;
+
+	switch (key)
+	{
+	case IWINFO_L_KEY_RX_MCS:
+	case IWINFO_L_KEY_TX_MCS:
+		lua_pushnumber(L, r->mcs);
+		break;
+
+	case IWINFO_L_KEY_RX_40MHZ:
+	case IWINFO_L_KEY_TX_40MHZ:
+		lua_pushboolean(L, r->is_40mhz);
+		break;
+
+	default:
+		lua_pushboolean(L, r->is_short_gi);
+		break;
+	}
+
+	return 1;
+}
+
+static int iwinfo_L_entry_scan(lua_State *L, struct iwinfo_scanlist_entry *e,
+                               int key)
+{
+	char macstr[18];
+
+	switch (key)
+	{
+	case IWINFO_L_KEY_BSSID:
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, e->mac));
+		return 1;
+
+	case IWINFO_L_KEY_SSID:
+		if (!e->ssid[0])
+			return 0;
+
+		lua_pushstring(L, (char *) e->ssid);
+		return 1;
+
+	case IWINFO_L_KEY_CHANNEL:     lua_pushinteger(L, e->channel);        return 1;
+	case IWINFO_L_KEY_QUALITY:     lua_pushinteger(L, e->quality);        return 1;
+	case IWINFO_L_KEY_QUALITY_MAX: lua_pushinteger(L, e->quality_max);    return 1;
+	case IWINFO_L_KEY_SIGNAL:      lua_pushnumber(L, e->signal - 0x100);  return 1;
+
+	case IWINFO_L_KEY_MODE:
+		lua_pushstring(L, IWINFO_OPMODE_NAMES[e->mode]);
+		return 1;
+
+	case IWINFO_L_KEY_ENCRYPTION:
+		iwinfo_L_crypto_push(L, &e->crypto);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int iwinfo_L_entry_index(lua_State *L)
+{
+	struct iwinfo_L_entry *e = luaL_checkudata(L, 1, IWINFO_ENTRY_META);
+	int key = iwinfo_L_keyid(L, 2);
+	int rv;
+
+	if (e->type == IWINFO_L_LIST_ASSOC)
+		rv = iwinfo_L_entry_assoc(L, &e->u.assoc, key);
+	else
+		rv = iwinfo_L_entry_scan(L, &e->u.scan, key);
+
+	if (!rv)
+		lua_pushnil(L);
+
+	return 1;
+}
+
+static int iwinfo_L_crypto_index(lua_State *L)
+{
+	struct iwinfo_crypto_entry *c = luaL_checkudata(L, 1, IWINFO_CRYPTO_META);
+
+	switch (iwinfo_L_keyid(L, 2))
+	{
+	case IWINFO_L_KEY_ENABLED:
+		lua_pushboolean(L, c->enabled);
+		break;
+
+	case IWINFO_L_KEY_DESCRIPTION:
+		lua_pushstring(L, iwinfo_crypto_desc(c));
+		break;
+
+	case IWINFO_L_KEY_WEP:
+		lua_pushboolean(L, (c->enabled && !c->wpa_version));
+		break;
+
+	case IWINFO_L_KEY_WPA:
+		lua_pushinteger(L, c->wpa_version);
+		break;
+
+	case IWINFO_L_KEY_PAIR_CIPHERS:
+		iwinfo_L_namelist(L, IWINFO_CRYPTO_CIPHERS(c, pair),
+		                  IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+		break;
+
+	case IWINFO_L_KEY_GROUP_CIPHERS:
+		iwinfo_L_namelist(L, IWINFO_CRYPTO_CIPHERS(c, group),
+		                  IWINFO_CIPHER_NAMES, IWINFO_CIPHER_COUNT);
+		break;
+
+	case IWINFO_L_KEY_AUTH_SUITES:
+		iwinfo_L_namelist(L, c->auth_suites,
+		                  IWINFO_KMGMT_NAMES, IWINFO_KMGMT_COUNT);
+		break;
+
+	case IWINFO_L_KEY_AUTH_ALGS:
+		iwinfo_L_namelist(L, c->auth_algs, IWINFO_AUTH_NAMES, 8);
+		break;
+
+	default:
+		lua_pushnil(L);
+		break;
+	}
+
+	return 1;
+}
+
+/* Wrapper for lazy assoclist */
+static int iwinfo_L_assoclist_lazy(lua_State *L,
+                                   int (*func)(const char *, char *, int *))
+{
+	return iwinfo_L_list_new(L, IWINFO_L_LIST_ASSOC, func);
+}
+
+/* Wrapper for lazy scan list */
+static int iwinfo_L_scanlist_lazy(lua_State *L,
+                                  int (*func)(const char *, char *, int *))
+{
+	return iwinfo_L_list_new(L, IWINFO_L_LIST_SCAN, func);
+}
+
+/* Wrapper for tx power list */
+static int iwinfo_L_txpwrlist(lua_State *L, int (*func)(const char *, char *, int *))
+{
+	int i, x, len;
+	char rv[IWINFO_BUFSIZE];
+	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_txpwrlist_entry *e;
+
+	memset(rv, 0, sizeof(rv));
+
+	if (!(*func)(ifname, rv, &len))
+	{
+		lua_newtable(L);
+
+		for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_txpwrlist_entry), x++)
+		{
+			e = (struct iwinfo_txpwrlist_entry *) &rv[i];
+
+			lua_newtable(L);
+
+			lua_pushnumber(L, e->mw);
+			lua_setfield(L, -2, "mw");
+
+			lua_pushnumber(L, e->dbm);
+			lua_setfield(L, -2, "dbm");
+
+			lua_rawseti(L, -2, x);
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Build Lua table from scanlist entry */
+static void iwinfo_L_scantable(lua_State *L, struct iwinfo_scanlist_entry *e)
+{
+	char macstr[18];
+
+	lua_createtable(L, 0, 8);
+
+	/* BSSID */
+	iwinfo_L_key(L, BSSID);
+	lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, e->mac));
+	lua_rawset(L, -3);
+
+	/* ESSID */
+	if (e->ssid[0])
+	{
+		iwinfo_L_key(L, SSID);
+		lua_pushstring(L, (char *) e->ssid);
+		lua_rawset(L, -3);
+	}
+
+	/* Channel */
+	iwinfo_L_key(L, CHANNEL);
+	lua_pushinteger(L, e->channel);
+	lua_rawset(L, -3);
+
+	/* Mode */
+	iwinfo_L_key(L, MODE);
+	lua_pushstring(L, IWINFO_OPMODE_NAMES[e->mode]);
+	lua_rawset(L, -3);
+
+	/* Quality, Signal */
+	iwinfo_L_key(L, QUALITY);
+	lua_pushinteger(L, e->quality);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, QUALITY_MAX);
+	lua_pushinteger(L, e->quality_max);
+	lua_rawset(L, -3);
+
+	iwinfo_L_key(L, SIGNAL);
+	lua_pushnumber(L, (e->signal - 0x100));
+	lua_rawset(L, -3);
+
+	/* Crypto */
+	iwinfo_L_key(L, ENCRYPTION);
+	iwinfo_L_cryptotable(L, &e->crypto);
+	lua_rawset(L, -3);
+}
+
+/* Wrapper for scan list */
+static void iwinfo_L_scanarray(lua_State *L, char *buf, int len)
+{
+	int i, x;
+	struct iwinfo_scanlist_entry *e;
+
+	lua_createtable(L, len / sizeof(struct iwinfo_scanlist_entry), 0);
+
+	for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_scanlist_entry), x++)
+	{
+		e = (struct iwinfo_scanlist_entry *) &buf[i];
+
+		iwinfo_L_scantable(L, e);
+		lua_rawseti(L, -2, x);
+	}
+}
+
+static int iwinfo_L_scanlist(lua_State *L, const struct iwinfo_ops *ops)
+{
+	int len;
+	char rv[IWINFO_BUFSIZE];
+	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_filter f;
+
+	if (iwinfo_scanlist_filter(ops, ifname,
+	                           iwinfo_L_filter(L, 2, &f) ? &f : NULL,
+	                           rv, &len))
+		len = 0;
+
+	iwinfo_L_scanarray(L, rv, len);
+	return 1;
+}
+
+/*
+ * Streaming iterators: a cursor walks the raw result array and only
+ * builds tables for entries which pass the filter options.
+ */
+struct iwinfo_L_cursor {
+	int pos;
+	int limit;
+	int yielded;
+	int min_signal;
+	int match_ssid;
+	char ssid[IWINFO_ESSID_MAX_SIZE + 1];
+};
+
+static int iwinfo_L_entry_signal(struct iwinfo_L_list *l, int i)
+{
+	if (l->type == IWINFO_L_LIST_ASSOC)
+		return ((struct iwinfo_assoclist_ext_entry *)l->data)[i].base.signal;
+
+	return ((struct iwinfo_scanlist_entry *)l->data)[i].signal - 0x100;
+}
+
+static int iwinfo_L_cmp_assoc(const void *a, const void *b)
+{
+	return ((const struct iwinfo_assoclist_ext_entry *)b)->base.signal -
+	       ((const struct iwinfo_assoclist_ext_entry *)a)->base.signal;
+}
+
+static int iwinfo_L_cmp_scan(const void *a, const void *b)
+{
+	return ((const struct iwinfo_scanlist_entry *)b)->signal -
+	       ((const struct iwinfo_scanlist_entry *)a)->signal;
+}
+
+static int iwinfo_L_iter_next(lua_State *L)
+{
+	int i;
+	char macstr[18];
+	struct iwinfo_assoclist_ext_entry *a;
+	struct iwinfo_scanlist_entry *e;
+	struct iwinfo_L_list *l = lua_touserdata(L, lua_upvalueindex(2));
+	struct iwinfo_L_cursor *c = lua_touserdata(L, lua_upvalueindex(3));
+
+	while (c->pos < l->count && (!c->limit || c->yielded < c->limit))
+	{
+		i = c->pos++;
+
+		if (iwinfo_L_entry_signal(l, i) < c->min_signal)
+			continue;
+
+		if (l->type == IWINFO_L_LIST_ASSOC)
+		{
+			a = &((struct iwinfo_assoclist_ext_entry *)l->data)[i];
+			c->yielded++;
+
+			lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, a->base.mac));
+			iwinfo_L_assoctable(L, a);
+			return 2;
+		}
+
+		e = &((struct iwinfo_scanlist_entry *)l->data)[i];
+
+		if (c->match_ssid && strcmp((char *)e->ssid, c->ssid))
+			continue;
+
+		c->yielded++;
+
+		iwinfo_L_scantable(L, e);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Options: ssid = "name", min_signal = dBm, limit = n, sort = "signal" */
+static int iwinfo_L_iter_new(lua_State *L, int type,
+                             int (*func)(const char *, char *, int *))
+{
+	const char *str;
+	struct iwinfo_L_list *l;
+	struct iwinfo_L_cursor *c;
+
+	if (!lua_isnoneornil(L, 2))
+		luaL_checktype(L, 2, LUA_TTABLE);
+
+	lua_pushvalue(L, lua_upvalueindex(1));
+	iwinfo_L_list_new(L, type, func);
+	l = lua_touserdata(L, -1);
+
+	c = lua_newuserdata(L, sizeof(*c));
+	memset(c, 0, sizeof(*c));
+	c->min_signal = -0x100;
+
+	if (lua_istable(L, 2))
+	{
+		lua_getfield(L, 2, "ssid");
+		if ((str = lua_tostring(L, -1)) != NULL)
+		{
+			c->match_ssid = 1;
+			snprintf(c->ssid, sizeof(c->ssid), "%s", str);
+		}
+		lua_pop(L, 1);
+
+		lua_getfield(L, 2, "min_signal");
+		if (lua_isnumber(L, -1))
+			c->min_signal = lua_tointeger(L, -1);
+		lua_pop(L, 1);
+
+		lua_getfield(L, 2, "limit");
+		if (lua_isnumber(L, -1))
+			c->limit = lua_tointeger(L, -1);
+		lua_pop(L, 1);
+
+		/* strongest first, combined with limit this yields the top N */
+		lua_getfield(L, 2, "sort");
+		if ((str = lua_tostring(L, -1)) != NULL && !strcmp(str, "signal"))
+			qsort(l->data, l->count, iwinfo_L_list_esize(type),
+			      (type == IWINFO_L_LIST_ASSOC)
+			        ? iwinfo_L_cmp_assoc : iwinfo_L_cmp_scan);
+		lua_pop(L, 1);
+	}
+
+	lua_pushcclosure(L, iwinfo_L_iter_next, 3);
+	return 1;
+}
+
+/* Wrapper for assoclist iterator */
+static int iwinfo_L_assoclist_iter(lua_State *L,
+                                   int (*func)(const char *, char *, int *))
+{
+	return iwinfo_L_iter_new(L, IWINFO_L_LIST_ASSOC, func);
+}
+
+/* Wrapper for scan list iterator */
+static int iwinfo_L_scanlist_iter(lua_State *L,
+                                  int (*func)(const char *, char *, int *))
+{
+	return iwinfo_L_iter_new(L, IWINFO_L_LIST_SCAN, func);
+}
+
+/*
+ * Asynchronous scans: scan_start() hands out a handle around a pending
+ * scan whose descriptor can be watched by an external event loop. Backends
+ * without asynchronous support, or a refused trigger, yield a handle which
+ * is ready at once and scans synchronously when results() is called.
+ */
+struct iwinfo_L_scan {
+	const struct iwinfo_ops *ops;
+	int sync;
+	struct iwinfo_scan scan;
+};
+
+static const char iwinfo_L_scan_wait[] =
+	"local s = ...\n"
+	"while true do\n"
+	"	local ok, err = s:ready()\n"
+	"	if ok then break end\n"
+	"	if ok == nil then s:close() return nil, err end\n"
+	"	if coroutine.running() then\n"
+	"		coroutine.yield(s:fd(), s)\n"
+	"	else\n"
+	"		s:poll()\n"
+	"	end\n"
+	"end\n"
+	"local rv = s:results()\n"
+	"s:close()\n"
+	"return rv\n";
+
+static int iwinfo_L_scan_start(lua_State *L, const struct iwinfo_ops *ops)
+{
+	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_L_scan *s = lua_newuserdata(L, sizeof(*s));
+
+	memset(s, 0, sizeof(*s));
+	s->scan.fd = -1;
+
+	luaL_getmetatable(L, IWINFO_SCAN_META);
+	lua_setmetatable(L, -2);
+
+	s->ops = ops;
+
+	if (!ops->scan_trigger || ops->scan_trigger(ifname, &s->scan))
+	{
+		memset(&s->scan, 0, sizeof(s->scan));
+		strncpy(s->scan.ifname, ifname, sizeof(s->scan.ifname) - 1);
+
+		s->sync = 1;
+		s->scan.fd = -1;
+		s->scan.state = IWINFO_SCAN_READY;
+	}
+
+	return 1;
+}
+
+static int iwinfo_L_scan_state(lua_State *L, struct iwinfo_L_scan *s)
+{
+	if (s->scan.priv && s->ops->scan_ready)
+		s->ops->scan_ready(&s->scan);
+
+	switch (s->scan.state)
+	{
+	case IWINFO_SCAN_READY:
+		lua_pushboolean(L, 1);
+		return 1;
+
+	case IWINFO_SCAN_PENDING:
+		lua_pushboolean(L, 0);
+		return 1;
+
+	default:
+		lua_pushnil(L);
+		lua_pushliteral(L, "aborted");
+		return 2;
+	}
+}
+
+static int iwinfo_L_scan_fd(lua_State *L)
+{
+	struct iwinfo_L_scan *s = luaL_checkudata(L, 1, IWINFO_SCAN_META);
+
+	if (s->scan.fd > -1)
+		lua_pushinteger(L, s->scan.fd);
+	else
+		lua_pushnil(L);
+
+	return 1;
+}
+
+static int iwinfo_L_scan_ready(lua_State *L)
+{
+	struct iwinfo_L_scan *s = luaL_checkudata(L, 1, IWINFO_SCAN_META);
+
+	return iwinfo_L_scan_state(L, s);
+}
+
+/* Block on the descriptor for up to timeout ms, forever if omitted */
+static int iwinfo_L_scan_poll(lua_State *L)
+{
+	struct iwinfo_L_scan *s = luaL_checkudata(L, 1, IWINFO_SCAN_META);
+	struct pollfd pfd = { .fd = s->scan.fd, .events = POLLIN };
+	int timeout = luaL_optinteger(L, 2, -1);
+
+	if (s->scan.fd > -1 && s->scan.state == IWINFO_SCAN_PENDING)
+		poll(&pfd, 1, timeout);
+
+	return iwinfo_L_scan_state(L, s);
+}
+
+static int iwinfo_L_scan_results(lua_State *L)
+{
+	int len = 0;
+	char rv[IWINFO_BUFSIZE];
+	struct iwinfo_L_scan *s = luaL_checkudata(L, 1, IWINFO_SCAN_META);
+
+	if (s->sync)
+	{
+		if (s->ops->scanlist(s->scan.ifname, rv, &len))
+			len = 0;
+	}
+	else if (!s->scan.priv ||
+	         s->ops->scan_results(&s->scan, rv, &len))
+	{
+		len = 0;
+	}
+
+	iwinfo_L_scanarray(L, rv, len);
+	return 1;
+}
+
+static int iwinfo_L_scan_close(lua_State *L)
+{
+	struct iwinfo_L_scan *s = luaL_checkudata(L, 1, IWINFO_SCAN_META);
+
+	if (s->scan.priv && s->ops->scan_close)
+		s->ops->scan_close(&s->scan);
+
+	return 0;
+}
+
+/*
+ * Event iterator: events(ifname[, timeout]) returns a function yielding one
+ * event table per call, blocking for up to timeout ms (forever if omitted)
+ * and ending the loop on timeout. The handle is returned as second value,
+ * its fd() can be watched by an external event loop. If the subscription
+ * fails the iterator ends right away, the handle is nil and an error
+ * message follows as third value.
+ */
+struct iwinfo_L_events {
+	const struct iwinfo_ops *ops;
+	int timeout;
+	struct iwinfo_events ev;
+};
+
+static void iwinfo_L_eventtable(lua_State *L, struct iwinfo_event *e)
+{
+	char macstr[18];
+
+	lua_newtable(L);
+
+	lua_pushstring(L, IWINFO_EVENT_NAMES[e->type]);
+	lua_setfield(L, -2, "type");
+
+	if (e->ifname[0])
+	{
+		lua_pushstring(L, e->ifname);
+		lua_setfield(L, -2, "ifname");
+	}
+
+	switch (e->type)
+	{
+	case IWINFO_EVENT_STA_NEW:
+	case IWINFO_EVENT_STA_DEL:
+		lua_pushlstring(L, macstr, iwinfo_L_macstr(macstr, e->u.sta.mac));
+		lua_setfield(L, -2, "mac");
+		break;
+
+	case IWINFO_EVENT_CHANNEL_SWITCH:
+		lua_pushinteger(L, e->u.chan.channel);
+		lua_setfield(L, -2, "channel");
+
+		lua_pushinteger(L, e->u.chan.mhz);
+		lua_setfield(L, -2, "mhz");
+		break;
+
+	case IWINFO_EVENT_REG_CHANGE:
+		if (e->u.reg.alpha2[0])
+		{
+			lua_pushstring(L, e->u.reg.alpha2);
+			lua_setfield(L, -2, "country");
+		}
+
+		lua_pushinteger(L, e->u.reg.initiator);
+		lua_setfield(L, -2, "initiator");
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int iwinfo_L_events_next(lua_State *L)
+{
+	int rv;
+	struct iwinfo_event e;
+	struct iwinfo_L_events *h = lua_touserdata(L, lua_upvalueindex(1));
+	struct pollfd pfd = { .fd = h->ev.fd, .events = POLLIN };
+
+	if (!h->ev.priv)
+		return 0;
+
+	while (!(rv = h->ops->events_read(&h->ev, &e)))
+		if (poll(&pfd, 1, h->timeout) <= 0)
+			return 0;
+
+	if (rv < 0)
+		return 0;
+
+	iwinfo_L_eventtable(L, &e);
+	return 1;
+}
+
+static int iwinfo_L_events(lua_State *L, const struct iwinfo_ops *ops)
+{
+	const char *ifname = luaL_checkstring(L, 1);
+	struct iwinfo_L_events *h;
+
+	h = lua_newuserdata(L, sizeof(*h));
+	memset(h, 0, sizeof(*h));
+	h->ev.fd = -1;
+
+	luaL_getmetatable(L, IWINFO_EVENTS_META);
+	lua_setmetatable(L, -2);
+
+	h->ops = ops;
+	h->timeout = luaL_optinteger(L, 2, -1);
+
+	if (!ops->events_open || ops->events_open(ifname, &h->ev))
+	{
+		/* the handle has no subscription, the iterator yields nothing */
+		lua_pushcclosure(L, iwinfo_L_events_next, 1);
+		lua_pushnil(L);
+		lua_pushstring(L, ops->events_open
+			? "Unable to subscribe to events" : "Events not supported");
+		return 3;
+	}
+
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, iwinfo_L_events_next, 1);
+	lua_insert(L, -2);
 
-				lua_pushboolean(L, e->rx_rate.is_40mhz);
-				lua_setfield(L, -2, "rx_40mhz");
+	return 2;
+}
 
-				lua_pushboolean(L, e->rx_rate.is_short_gi);
-				lua_setfield(L, -2, "rx_short_gi");
-			}
+static int iwinfo_L_events_fd(lua_State *L)
+{
+	struct iwinfo_L_events *h = luaL_checkudata(L, 1, IWINFO_EVENTS_META);
 
-			if (e->tx_rate.mcs >= 0)
-			{
-				lua_pushnumber(L, e->tx_rate.mcs);
-				lua_setfield(L, -2, "tx_mcs");
+	if (h->ev.fd > -1)
+		lua_pushinteger(L, h->ev.fd);
+	else
+		lua_pushnil(L);
 
-				lua_pushboolean(L, e->tx_rate.is_40mhz);
-				lua_setfield(L, -2, "tx_40mhz");
+	return 1;
+}
 
-				lua_pushboolean(L, e->tx_rate.is_short_gi);
-				lua_setfield(L, -2, "tx_short_gi");
-			}
+static int iwinfo_L_events_close(lua_State *L)
+{
+	struct iwinfo_L_events *h = luaL_checkudata(L, 1, IWINFO_EVENTS_META);
 
-			lua_setfield(L, -2, macstr);
-		}
-	}
+	if (h->ev.priv && h->ops->events_close)
+		h->ops->events_close(&h->ev);
 
-	return 1;
+	return 0;
 }
 
-/* Wrapper for tx power list */
-static int iwinfo_L_txpwrlist(lua_State *L, int (*func)(const char *, char *, int *))
+/* Wrapper for frequency list */
+static int iwinfo_L_freqlist(lua_State *L, int (*func)(const char *, char *, int *))
 {
 	int i, x, len;
 	char rv[IWINFO_BUFSIZE];
 	const char *ifname = luaL_checkstring(L, 1);
-	struct iwinfo_txpwrlist_entry *e;
+	struct iwinfo_freqlist_entry *e;
 
+	lua_newtable(L);
 	memset(rv, 0, sizeof(rv));
 
 	if (!(*func)(ifname, rv, &len))
 	{
-		lua_newtable(L);
-
-		for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_txpwrlist_entry), x++)
+		for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_freqlist_entry), x++)
 		{
-			e = (struct iwinfo_txpwrlist_entry *) &rv[i];
+			e = (struct iwinfo_freqlist_entry *) &rv[i];
 
 			lua_newtable(L);
 
-			lua_pushnumber(L, e->mw);
-			lua_setfield(L, -2, "mw");
+			/* MHz */
+			lua_pushinteger(L, e->mhz);
+			lua_setfield(L, -2, "mhz");
 
-			lua_pushnumber(L, e->dbm);
-			lua_setfield(L, -2, "dbm");
+			/* Channel */
+			lua_pushinteger(L, e->channel);
+			lua_setfield(L, -2, "channel");
+
+			/* Restricted (DFS/TPC/Radar) */
+			lua_pushboolean(L, e->restricted);
+			lua_setfield(L, -2, "restricted");
 
 			lua_rawseti(L, -2, x);
 		}
-
-		return 1;
 	}
 
-	return 0;
+	return 1;
 }
 
-/* Wrapper for scan list */
-static int iwinfo_L_scanlist(lua_State *L, int (*func)(const char *, char *, int *))
+/* Concurrent scan of several devices, merged by BSSID */
+static int iwinfo_L_scan_multi(lua_State *L)
 {
-	int i, x, len;
+	int i, j, x, n, len;
 	char rv[IWINFO_BUFSIZE];
-	char macstr[18];
-	const char *ifname = luaL_checkstring(L, 1);
-	struct iwinfo_scanlist_entry *e;
+	const char *ifnames[IWINFO_SCAN_MULTI_MAX];
+	int timeout = luaL_optinteger(L, 2, 0);
+	struct iwinfo_scan_multi_entry *e;
 
-	lua_newtable(L);
-	memset(rv, 0, sizeof(rv));
+	luaL_checktype(L, 1, LUA_TTABLE);
 
-	if (!(*func)(ifname, rv, &len))
+	for (n = 0; n < IWINFO_SCAN_MULTI_MAX; n++)
 	{
-		for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_scanlist_entry), x++)
+		lua_rawgeti(L, 1, n + 1);
+
+		if (!lua_isstring(L, -1))
 		{
-			e = (struct iwinfo_scanlist_entry *) &rv[i];
+			lua_pop(L, 1);
+			break;
+		}
 
-			lua_newtable(L);
+		/* the strings stay referenced by the argument table */
+		ifnames[n] = lua_tostring(L, -1);
+		lua_pop(L, 1);
+	}
 
-			/* BSSID */
-			sprintf(macstr, "%02X:%02X:%02X:%02X:%02X:%02X",
-				e->mac[0], e->mac[1], e->mac[2],
-				e->mac[3], e->mac[4], e->mac[5]);
+	if (iwinfo_scan_multi(ifnames, n, timeout, rv, &len))
+	{
+		lua_newtable(L);
+		return 1;
+	}
 
-			lua_pushstring(L, macstr);
-			lua_setfield(L, -2, "bssid");
+	lua_createtable(L, len / sizeof(struct iwinfo_scan_multi_entry), 0);
 
-			/* ESSID */
-			if (e->ssid[0])
-			{
-				lua_pushstring(L, (char *) e->ssid);
-				lua_setfield(L, -2, "ssid");
-			}
+	for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_scan_multi_entry), x++)
+	{
+		e = (struct iwinfo_scan_multi_entry *) &rv[i];
 
-			/* Channel */
-			lua_pushinteger(L, e->channel);
-			lua_setfield(L, -2, "channel");
+		iwinfo_L_scantable(L, &e->bss);
 
-			/* Mode */
-			lua_pushstring(L, IWINFO_OPMODE_NAMES[e->mode]);
-			lua_setfield(L, -2, "mode");
+		lua_newtable(L);
 
-			/* Quality, Signal */
-			lua_pushinteger(L, e->quality);
-			lua_setfield(L, -2, "quality");
+		for (j = 0; j < n; j++)
+		{
+			if (e->radios & (1U << j))
+			{
+				lua_pushstring(L, ifnames[j]);
+				lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
+			}
+		}
 
-			lua_pushinteger(L, e->quality_max);
-			lua_setfield(L, -2, "quality_max");
+		lua_setfield(L, -2, "radios");
+		lua_rawseti(L, -2, x);
+	}
 
-			lua_pushnumber(L, (e->signal - 0x100));
-			lua_setfield(L, -2, "signal");
+	return 1;
+}
 
-			/* Crypto */
-			iwinfo_L_cryptotable(L, &e->crypto);
-			lua_setfield(L, -2, "encryption");
+/* Wrapper for channel survey */
+/* Scheduled background scanning, interval in ms or 0 to stop */
+static int iwinfo_L_scan_schedule(lua_State *L, const struct iwinfo_ops *ops)
+{
+	const char *ifname = luaL_checkstring(L, 1);
+	int interval = luaL_optinteger(L, 2, 0);
 
-			lua_rawseti(L, -2, x);
-		}
-	}
+	lua_pushboolean(L, ops->scan_schedule &&
+	                   !ops->scan_schedule(ifname, interval));
 
 	return 1;
 }
 
-/* Wrapper for frequency list */
-static int iwinfo_L_freqlist(lua_State *L, int (*func)(const char *, char *, int *))
+static int iwinfo_L_survey(lua_State *L, const struct iwinfo_ops *ops)
 {
 	int i, x, len;
 	char rv[IWINFO_BUFSIZE];
 	const char *ifname = luaL_checkstring(L, 1);
-	struct iwinfo_freqlist_entry *e;
+	struct iwinfo_survey_entry *e;
 
 	lua_newtable(L);
-	memset(rv, 0, sizeof(rv));
 
-	if (!(*func)(ifname, rv, &len))
+	if (!ops->survey || ops->survey(ifname, rv, &len))
+		return 1;
+
+	for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_survey_entry), x++)
 	{
-		for (i = 0, x = 1; i < len; i += sizeof(struct iwinfo_freqlist_entry), x++)
+		e = (struct iwinfo_survey_entry *) &rv[i];
+
+		lua_newtable(L);
+
+		lua_pushinteger(L, e->mhz);
+		lua_setfield(L, -2, "mhz");
+
+		lua_pushinteger(L, e->channel);
+		lua_setfield(L, -2, "channel");
+
+		lua_pushboolean(L, e->in_use);
+		lua_setfield(L, -2, "in_use");
+
+		if (e->noise)
 		{
-			e = (struct iwinfo_freqlist_entry *) &rv[i];
+			lua_pushinteger(L, e->noise);
+			lua_setfield(L, -2, "noise");
+		}
 
-			lua_newtable(L);
+		/* Cumulative radio times in ms */
+		lua_pushnumber(L, e->time);
+		lua_setfield(L, -2, "time");
 
-			/* MHz */
-			lua_pushinteger(L, e->mhz);
-			lua_setfield(L, -2, "mhz");
+		lua_pushnumber(L, e->time_busy);
+		lua_setfield(L, -2, "time_busy");
 
-			/* Channel */
-			lua_pushinteger(L, e->channel);
-			lua_setfield(L, -2, "channel");
+		lua_pushnumber(L, e->time_ext_busy);
+		lua_setfield(L, -2, "time_ext_busy");
 
-			/* Restricted (DFS/TPC/Radar) */
-			lua_pushboolean(L, e->restricted);
-			lua_setfield(L, -2, "restricted");
+		lua_pushnumber(L, e->time_rx);
+		lua_setfield(L, -2, "time_rx");
 
-			lua_rawseti(L, -2, x);
+		lua_pushnumber(L, e->time_tx);
+		lua_setfield(L, -2, "time_tx");
+
+		/* Utilization in percent since the previous sample */
+		if (e->interval)
+		{
+			lua_pushinteger(L, e->interval);
+			lua_setfield(L, -2, "interval");
+
+			lua_pushnumber(L, e->busy_ratio / 100.0);
+			lua_setfield(L, -2, "busy");
+
+			lua_pushnumber(L, e->rx_ratio / 100.0);
+			lua_setfield(L, -2, "rx");
+
+			lua_pushnumber(L, e->tx_ratio / 100.0);
+			lua_setfield(L, -2, "tx");
 		}
+
+		lua_rawseti(L, -2, x);
 	}
 
 	return 1;
@@ -477,6 +1903,24 @@ static int iwinfo_L_encryption(lua_State *L, int (*func)(const char *, char *))
 	return 1;
 }
 
+/* Build Lua table from hwmode flags */
+static void iwinfo_L_hwmodes(lua_State *L, int hwmodes)
+{
+	lua_createtable(L, 0, 4);
+
+	lua_pushboolean(L, hwmodes & IWINFO_80211_A);
+	lua_setfield(L, -2, "a");
+
+	lua_pushboolean(L, hwmodes & IWINFO_80211_B);
+	lua_setfield(L, -2, "b");
+
+	lua_pushboolean(L, hwmodes & IWINFO_80211_G);
+	lua_setfield(L, -2, "g");
+
+	lua_pushboolean(L, hwmodes & IWINFO_80211_N);
+	lua_setfield(L, -2, "n");
+}
+
 /* Wrapper for hwmode list */
 static int iwinfo_L_hwmodelist(lua_State *L, int (*func)(const char *, int *))
 {
@@ -485,20 +1929,7 @@ static int iwinfo_L_hwmodelist(lua_State *L, int (*func)(const char *, int *))
 
 	if (!(*func)(ifname, &hwmodes))
 	{
-		lua_newtable(L);
-
-		lua_pushboolean(L, hwmodes & IWINFO_80211_A);
-		lua_setfield(L, -2, "a");
-
-		lua_pushboolean(L, hwmodes & IWINFO_80211_B);
-		lua_setfield(L, -2, "b");
-
-		lua_pushboolean(L, hwmodes & IWINFO_80211_G);
-		lua_setfield(L, -2, "g");
-
-		lua_pushboolean(L, hwmodes & IWINFO_80211_N);
-		lua_setfield(L, -2, "n");
-
+		iwinfo_L_hwmodes(L, hwmodes);
 		return 1;
 	}
 
@@ -522,6 +1953,24 @@ static int iwinfo_L_mbssid_support(lua_State *L, int (*func)(const char *, int *
 	return 1;
 }
 
+/* Build Lua table from hardware ids */
+static void iwinfo_L_hwid(lua_State *L, struct iwinfo_hardware_id *ids)
+{
+	lua_createtable(L, 0, 4);
+
+	lua_pushnumber(L, ids->vendor_id);
+	lua_setfield(L, -2, "vendor_id");
+
+	lua_pushnumber(L, ids->device_id);
+	lua_setfield(L, -2, "device_id");
+
+	lua_pushnumber(L, ids->subsystem_vendor_id);
+	lua_setfield(L, -2, "subsystem_vendor_id");
+
+	lua_pushnumber(L, ids->subsystem_device_id);
+	lua_setfield(L, -2, "subsystem_device_id");
+}
+
 /* Wrapper for hardware_id */
 static int iwinfo_L_hardware_id(lua_State *L, int (*func)(const char *, char *))
 {
@@ -530,19 +1979,7 @@ static int iwinfo_L_hardware_id(lua_State *L, int (*func)(const char *, char *))
 
 	if (!(*func)(ifname, (char *)&ids))
 	{
-		lua_newtable(L);
-
-		lua_pushnumber(L, ids.vendor_id);
-		lua_setfield(L, -2, "vendor_id");
-
-		lua_pushnumber(L, ids.device_id);
-		lua_setfield(L, -2, "device_id");
-
-		lua_pushnumber(L, ids.subsystem_vendor_id);
-		lua_setfield(L, -2, "subsystem_vendor_id");
-
-		lua_pushnumber(L, ids.subsystem_device_id);
-		lua_setfield(L, -2, "subsystem_device_id");
+		iwinfo_L_hwid(L, &ids);
 	}
 	else
 	{
@@ -608,6 +2045,207 @@ static int iwinfo_L_countrylist(lua_State *L, int (*func)(const char *, char *,
 	return 1;
 }
 
+/*
+ * Device handles: iwinfo.open() resolves backend, ifindex and phy once.
+ * Methods not implemented here are forwarded to the backend table with
+ * the cached interface name in place of the handle, the cached ifindex
+ * and phy are handed to the backend for the duration of the call.
+ */
+struct iwinfo_L_device {
+	const struct iwinfo_ops *ops;
+	const char *type;
+	int ifindex;
+	int resolved_phy;
+	char ifname[IFNAMSIZ];
+	char phy[IFNAMSIZ];
+};
+
+static void iwinfo_L_device_resolved(struct iwinfo_L_device *d)
+{
+	iwinfo_resolved(d->ifname, d->ifindex, d->resolved_phy ? d->phy : NULL);
+}
+
+static int iwinfo_L_open(lua_State *L)
+{
+	const char *ifname = luaL_checkstring(L, 1);
+	const char *type = iwinfo_type(ifname);
+	const struct iwinfo_ops *ops = iwinfo_backend_by_name(type);
+	struct iwinfo_L_device *d;
+
+	if (!ops || strlen(ifname) >= IFNAMSIZ)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+
+	d = lua_newuserdata(L, sizeof(*d));
+	memset(d, 0, sizeof(*d));
+
+	d->ops = ops;
+	d->type = type;
+	d->ifindex = if_nametoindex(ifname);
+
+	strcpy(d->ifname, ifname);
+
+	if (!ops->phyname || ops->phyname(ifname, d->phy))
+		strcpy(d->phy, ifname);
+	else
+		d->resolved_phy = 1;
+
+	luaL_getmetatable(L, IWINFO_DEVICE_META);
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+#define iwinfo_L_device_check(L) \
+	((struct iwinfo_L_device *) luaL_checkudata(L, 1, IWINFO_DEVICE_META))
+
+static int iwinfo_L_device_ifname(lua_State *L)
+{
+	lua_pushstring(L, iwinfo_L_device_check(L)->ifname);
+	return 1;
+}
+
+static int iwinfo_L_device_ifindex(lua_State *L)
+{
+	lua_pushinteger(L, iwinfo_L_device_check(L)->ifindex);
+	return 1;
+}
+
+static int iwinfo_L_device_phy(lua_State *L)
+{
+	lua_pushstring(L, iwinfo_L_device_check(L)->phy);
+	return 1;
+}
+
+static int iwinfo_L_device_type(lua_State *L)
+{
+	lua_pushstring(L, iwinfo_L_device_check(L)->type);
+	return 1;
+}
+
+#define iwinfo_L_info_field(L, i, flag, push, name) \
+	if ((i)->valid & IWINFO_INFO_##flag)            \
+	{                                               \
+		push;                                       \
+		lua_setfield(L, -2, name);                  \
+	}
+
+/* All scalar properties in one table, keyed like the backend getters */
+static int iwinfo_L_device_info(lua_State *L)
+{
+	struct iwinfo_L_device *d = iwinfo_L_device_check(L);
+	struct iwinfo_info i;
+	int rv;
+
+	iwinfo_L_device_resolved(d);
+	rv = iwinfo_info(d->ops, d->ifname, &i);
+	iwinfo_resolved(NULL, 0, NULL);
+
+	if (rv)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_createtable(L, 0, 19);
+
+	iwinfo_L_info_field(L, &i, MODE,
+		lua_pushstring(L, IWINFO_OPMODE_NAMES[i.mode]), "mode");
+	iwinfo_L_info_field(L, &i, CHANNEL,
+		lua_pushinteger(L, i.channel), "channel");
+	iwinfo_L_info_field(L, &i, FREQUENCY,
+		lua_pushinteger(L, i.frequency), "frequency");
+	iwinfo_L_info_field(L, &i, FREQUENCY_OFFSET,
+		lua_pushinteger(L, i.frequency_offset), "frequency_offset");
+	iwinfo_L_info_field(L, &i, TXPOWER,
+		lua_pushinteger(L, i.txpower), "txpower");
+	iwinfo_L_info_field(L, &i, TXPOWER_OFFSET,
+		lua_pushinteger(L, i.txpower_offset), "txpower_offset");
+	iwinfo_L_info_field(L, &i, BITRATE,
+		lua_pushinteger(L, i.bitrate), "bitrate");
+	iwinfo_L_info_field(L, &i, SIGNAL,
+		lua_pushinteger(L, i.signal), "signal");
+	iwinfo_L_info_field(L, &i, NOISE,
+		lua_pushinteger(L, i.noise), "noise");
+	iwinfo_L_info_field(L, &i, QUALITY,
+		lua_pushinteger(L, i.quality), "quality");
+	iwinfo_L_info_field(L, &i, QUALITY_MAX,
+		lua_pushinteger(L, i.quality_max), "quality_max");
+	iwinfo_L_info_field(L, &i, MBSSID_SUPPORT,
+		lua_pushboolean(L, i.mbssid_support), "mbssid_support");
+	iwinfo_L_info_field(L, &i, HWMODES,
+		iwinfo_L_hwmodes(L, i.hwmodes), "hwmodelist");
+	iwinfo_L_info_field(L, &i, SSID,
+		lua_pushstring(L, i.ssid), "ssid");
+	iwinfo_L_info_field(L, &i, BSSID,
+		lua_pushstring(L, i.bssid), "bssid");
+	iwinfo_L_info_field(L, &i, COUNTRY,
+		lua_pushstring(L, i.country), "country");
+	iwinfo_L_info_field(L, &i, HARDWARE_ID,
+		iwinfo_L_hwid(L, &i.hardware_id), "hardware_id");
+	iwinfo_L_info_field(L, &i, HARDWARE_NAME,
+		lua_pushstring(L, i.hardware_name), "hardware_name");
+	iwinfo_L_info_field(L, &i, ENCRYPTION,
+		iwinfo_L_cryptotable(L, &i.crypto), "encryption");
+
+	return 1;
+}
+
+/* Call a backend function with the handle replaced by the device name */
+static int iwinfo_L_device_call(lua_State *L)
+{
+	struct iwinfo_L_device *d = lua_touserdata(L, lua_upvalueindex(2));
+	int rv;
+
+	lua_pushstring(L, d->ifname);
+	lua_replace(L, 1);
+
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_insert(L, 1);
+
+	iwinfo_L_device_resolved(d);
+	rv = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
+	iwinfo_resolved(NULL, 0, NULL);
+
+	if (rv)
+		return lua_error(L);
+
+	return lua_gettop(L);
+}
+
+static int iwinfo_L_device_index(lua_State *L)
+{
+	struct iwinfo_L_device *d = iwinfo_L_device_check(L);
+
+	if (!lua_isstring(L, 2))
+		return 0;
+
+	lua_pushvalue(L, 2);
+	lua_rawget(L, lua_upvalueindex(2));
+
+	if (!lua_isnil(L, -1))
+		return 1;
+
+	lua_pushfstring(L, IWINFO_META ".%s", d->type);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+
+	if (!lua_istable(L, -1))
+		return 0;
+
+	lua_pushvalue(L, 2);
+	lua_rawget(L, -2);
+
+	if (!lua_isfunction(L, -1))
+		return 0;
+
+	lua_pushvalue(L, 1);
+	lua_pushcclosure(L, iwinfo_L_device_call, 2);
+
+	return 1;
+}
+
 #ifdef USE_RA
 /* Ralink */
 LUA_WRAP_INT(ra,channel)
@@ -625,9 +2263,16 @@ LUA_WRAP_STRING(ra,bssid)
 LUA_WRAP_STRING(ra,country)
 LUA_WRAP_STRING(ra,hardware_name)
 LUA_WRAP_STRUCT(ra,mode)
-LUA_WRAP_STRUCT(ra,assoclist)
+LUA_WRAP_LIST(ra,assoclist)
+LUA_WRAP_LIST(ra,station)
+LUA_WRAP_LIST(ra,assoclist_rates)
 LUA_WRAP_STRUCT(ra,txpwrlist)
-LUA_WRAP_STRUCT(ra,scanlist)
+LUA_WRAP_LIST(ra,scanlist)
+LUA_WRAP_LAZY(ra,assoclist)
+LUA_WRAP_LAZY(ra,scanlist)
+LUA_WRAP_ITER(ra,assoclist_iter,assoclist)
+LUA_WRAP_ITER(ra,scan_iter,scanlist)
+LUA_WRAP_SCAN(ra)
 LUA_WRAP_STRUCT(ra,freqlist)
 LUA_WRAP_STRUCT(ra,countrylist)
 LUA_WRAP_STRUCT(ra,hwmodelist)
@@ -653,9 +2298,16 @@ LUA_WRAP_STRING(wl,bssid)
 LUA_WRAP_STRING(wl,country)
 LUA_WRAP_STRING(wl,hardware_name)
 LUA_WRAP_STRUCT(wl,mode)
-LUA_WRAP_STRUCT(wl,assoclist)
+LUA_WRAP_LIST(wl,assoclist)
+LUA_WRAP_LIST(wl,station)
+LUA_WRAP_LIST(wl,assoclist_rates)
 LUA_WRAP_STRUCT(wl,txpwrlist)
-LUA_WRAP_STRUCT(wl,scanlist)
+LUA_WRAP_LIST(wl,scanlist)
+LUA_WRAP_LAZY(wl,assoclist)
+LUA_WRAP_LAZY(wl,scanlist)
+LUA_WRAP_ITER(wl,assoclist_iter,assoclist)
+LUA_WRAP_ITER(wl,scan_iter,scanlist)
+LUA_WRAP_SCAN(wl)
 LUA_WRAP_STRUCT(wl,freqlist)
 LUA_WRAP_STRUCT(wl,countrylist)
 LUA_WRAP_STRUCT(wl,hwmodelist)
@@ -681,9 +2333,16 @@ LUA_WRAP_STRING(madwifi,bssid)
 LUA_WRAP_STRING(madwifi,country)
 LUA_WRAP_STRING(madwifi,hardware_name)
 LUA_WRAP_STRUCT(madwifi,mode)
-LUA_WRAP_STRUCT(madwifi,assoclist)
+LUA_WRAP_LIST(madwifi,assoclist)
+LUA_WRAP_LIST(madwifi,station)
+LUA_WRAP_LIST(madwifi,assoclist_rates)
 LUA_WRAP_STRUCT(madwifi,txpwrlist)
-LUA_WRAP_STRUCT(madwifi,scanlist)
+LUA_WRAP_LIST(madwifi,scanlist)
+LUA_WRAP_LAZY(madwifi,assoclist)
+LUA_WRAP_LAZY(madwifi,scanlist)
+LUA_WRAP_ITER(madwifi,assoclist_iter,assoclist)
+LUA_WRAP_ITER(madwifi,scan_iter,scanlist)
+LUA_WRAP_SCAN(madwifi)
 LUA_WRAP_STRUCT(madwifi,freqlist)
 LUA_WRAP_STRUCT(madwifi,countrylist)
 LUA_WRAP_STRUCT(madwifi,hwmodelist)
@@ -704,15 +2363,26 @@ LUA_WRAP_INT(nl80211,signal)
 LUA_WRAP_INT(nl80211,noise)
 LUA_WRAP_INT(nl80211,quality)
 LUA_WRAP_INT(nl80211,quality_max)
+LUA_WRAP_INT(nl80211,scan_age)
 LUA_WRAP_STRING(nl80211,ssid)
 LUA_WRAP_STRING(nl80211,bssid)
 LUA_WRAP_STRING(nl80211,country)
 LUA_WRAP_STRING(nl80211,hardware_name)
 LUA_WRAP_STRUCT(nl80211,mode)
-LUA_WRAP_STRUCT(nl80211,assoclist)
+LUA_WRAP_LIST(nl80211,assoclist)
+LUA_WRAP_LIST(nl80211,station)
+LUA_WRAP_LIST(nl80211,assoclist_rates)
 LUA_WRAP_STRUCT(nl80211,txpwrlist)
-LUA_WRAP_STRUCT(nl80211,scanlist)
+LUA_WRAP_LIST(nl80211,scanlist)
+LUA_WRAP_LAZY(nl80211,assoclist)
+LUA_WRAP_LAZY(nl80211,scanlist)
+LUA_WRAP_ITER(nl80211,assoclist_iter,assoclist)
+LUA_WRAP_ITER(nl80211,scan_iter,scanlist)
+LUA_WRAP_SCAN(nl80211)
 LUA_WRAP_STRUCT(nl80211,freqlist)
+LUA_WRAP_LIST(nl80211,survey)
+LUA_WRAP_LIST(nl80211,scan_schedule)
+LUA_WRAP_LIST(nl80211,events)
 LUA_WRAP_STRUCT(nl80211,countrylist)
 LUA_WRAP_STRUCT(nl80211,hwmodelist)
 LUA_WRAP_STRUCT(nl80211,encryption)
@@ -736,9 +2406,16 @@ LUA_WRAP_STRING(wext,bssid)
 LUA_WRAP_STRING(wext,country)
 LUA_WRAP_STRING(wext,hardware_name)
 LUA_WRAP_STRUCT(wext,mode)
-LUA_WRAP_STRUCT(wext,assoclist)
+LUA_WRAP_LIST(wext,assoclist)
+LUA_WRAP_LIST(wext,station)
+LUA_WRAP_LIST(wext,assoclist_rates)
 LUA_WRAP_STRUCT(wext,txpwrlist)
-LUA_WRAP_STRUCT(wext,scanlist)
+LUA_WRAP_LIST(wext,scanlist)
+LUA_WRAP_LAZY(wext,assoclist)
+LUA_WRAP_LAZY(wext,scanlist)
+LUA_WRAP_ITER(wext,assoclist_iter,assoclist)
+LUA_WRAP_ITER(wext,scan_iter,scanlist)
+LUA_WRAP_SCAN(wext)
 LUA_WRAP_STRUCT(wext,freqlist)
 LUA_WRAP_STRUCT(wext,countrylist)
 LUA_WRAP_STRUCT(wext,hwmodelist)
@@ -746,6 +2423,55 @@ LUA_WRAP_STRUCT(wext,encryption)
 LUA_WRAP_STRUCT(wext,mbssid_support)
 LUA_WRAP_STRUCT(wext,hardware_id)
 
+/* Shared memory snapshots */
+LUA_WRAP_INT(shm,channel)
+LUA_WRAP_INT(shm,frequency)
+LUA_WRAP_INT(shm,frequency_offset)
+LUA_WRAP_INT(shm,txpower)
+LUA_WRAP_INT(shm,txpower_offset)
+LUA_WRAP_INT(shm,bitrate)
+LUA_WRAP_INT(shm,signal)
+LUA_WRAP_INT(shm,noise)
+LUA_WRAP_INT(shm,quality)
+LUA_WRAP_INT(shm,quality_max)
+LUA_WRAP_STRING(shm,ssid)
+LUA_WRAP_STRING(shm,bssid)
+LUA_WRAP_STRING(shm,country)
+LUA_WRAP_STRING(shm,hardware_name)
+LUA_WRAP_STRUCT(shm,mode)
+LUA_WRAP_LIST(shm,assoclist)
+LUA_WRAP_LIST(shm,survey)
+LUA_WRAP_STRUCT(shm,hwmodelist)
+LUA_WRAP_STRUCT(shm,encryption)
+LUA_WRAP_STRUCT(shm,mbssid_support)
+LUA_WRAP_STRUCT(shm,hardware_id)
+
+/* Shared memory snapshot table */
+static const luaL_reg R_shm[] = {
+	LUA_REG(shm,channel),
+	LUA_REG(shm,frequency),
+	LUA_REG(shm,frequency_offset),
+	LUA_REG(shm,txpower),
+	LUA_REG(shm,txpower_offset),
+	LUA_REG(shm,bitrate),
+	LUA_REG(shm,signal),
+	LUA_REG(shm,noise),
+	LUA_REG(shm,quality),
+	LUA_REG(shm,quality_max),
+	LUA_REG(shm,mode),
+	LUA_REG(shm,ssid),
+	LUA_REG(shm,bssid),
+	LUA_REG(shm,country),
+	LUA_REG(shm,assoclist),
+	LUA_REG(shm,survey),
+	LUA_REG(shm,hwmodelist),
+	LUA_REG(shm,encryption),
+	LUA_REG(shm,mbssid_support),
+	LUA_REG(shm,hardware_id),
+	LUA_REG(shm,hardware_name),
+	{ NULL, NULL }
+};
+
 #ifdef USE_WL
 /* Broadcom table */
 static const luaL_reg R_wl[] = {
@@ -764,8 +2490,15 @@ static const luaL_reg R_wl[] = {
 	LUA_REG(wl,bssid),
 	LUA_REG(wl,country),
 	LUA_REG(wl,assoclist),
+	LUA_REG(wl,station),
+	LUA_REG(wl,assoclist_rates),
 	LUA_REG(wl,txpwrlist),
 	LUA_REG(wl,scanlist),
+	LUA_REG(wl,assoclist_lazy),
+	LUA_REG(wl,scanlist_lazy),
+	LUA_REG(wl,assoclist_iter),
+	LUA_REG(wl,scan_iter),
+	LUA_REG(wl,scan_start),
 	LUA_REG(wl,freqlist),
 	LUA_REG(wl,countrylist),
 	LUA_REG(wl,hwmodelist),
@@ -795,8 +2528,15 @@ static const luaL_reg R_madwifi[] = {
 	LUA_REG(madwifi,bssid),
 	LUA_REG(madwifi,country),
 	LUA_REG(madwifi,assoclist),
+	LUA_REG(madwifi,station),
+	LUA_REG(madwifi,assoclist_rates),
 	LUA_REG(madwifi,txpwrlist),
 	LUA_REG(madwifi,scanlist),
+	LUA_REG(madwifi,assoclist_lazy),
+	LUA_REG(madwifi,scanlist_lazy),
+	LUA_REG(madwifi,assoclist_iter),
+	LUA_REG(madwifi,scan_iter),
+	LUA_REG(madwifi,scan_start),
 	LUA_REG(madwifi,freqlist),
 	LUA_REG(madwifi,countrylist),
 	LUA_REG(madwifi,hwmodelist),
@@ -826,9 +2566,20 @@ static const luaL_reg R_nl80211[] = {
 	LUA_REG(nl80211,bssid),
 	LUA_REG(nl80211,country),
 	LUA_REG(nl80211,assoclist),
+	LUA_REG(nl80211,station),
+	LUA_REG(nl80211,assoclist_rates),
 	LUA_REG(nl80211,txpwrlist),
 	LUA_REG(nl80211,scanlist),
+	LUA_REG(nl80211,assoclist_lazy),
+	LUA_REG(nl80211,scanlist_lazy),
+	LUA_REG(nl80211,assoclist_iter),
+	LUA_REG(nl80211,scan_iter),
+	LUA_REG(nl80211,scan_start),
 	LUA_REG(nl80211,freqlist),
+	LUA_REG(nl80211,survey),
+	LUA_REG(nl80211,scan_schedule),
+	LUA_REG(nl80211,scan_age),
+	LUA_REG(nl80211,events),
 	LUA_REG(nl80211,countrylist),
 	LUA_REG(nl80211,hwmodelist),
 	LUA_REG(nl80211,encryption),
@@ -856,8 +2607,15 @@ static const luaL_reg R_wext[] = {
 	LUA_REG(wext,bssid),
 	LUA_REG(wext,country),
 	LUA_REG(wext,assoclist),
+	LUA_REG(wext,station),
+	LUA_REG(wext,assoclist_rates),
 	LUA_REG(wext,txpwrlist),
 	LUA_REG(wext,scanlist),
+	LUA_REG(wext,assoclist_lazy),
+	LUA_REG(wext,scanlist_lazy),
+	LUA_REG(wext,assoclist_iter),
+	LUA_REG(wext,scan_iter),
+	LUA_REG(wext,scan_start),
 	LUA_REG(wext,freqlist),
 	LUA_REG(wext,countrylist),
 	LUA_REG(wext,hwmodelist),
@@ -886,8 +2644,15 @@ static const luaL_reg R_ra[] = {
 	LUA_REG(ra,bssid),
 	LUA_REG(ra,country),
 	LUA_REG(ra,assoclist),
+	LUA_REG(ra,station),
+	LUA_REG(ra,assoclist_rates),
 	LUA_REG(ra,txpwrlist),
 	LUA_REG(ra,scanlist),
+	LUA_REG(ra,assoclist_lazy),
+	LUA_REG(ra,scanlist_lazy),
+	LUA_REG(ra,assoclist_iter),
+	LUA_REG(ra,scan_iter),
+	LUA_REG(ra,scan_start),
 	LUA_REG(ra,freqlist),
 	LUA_REG(ra,countrylist),
 	LUA_REG(ra,hwmodelist),
@@ -900,53 +2665,166 @@ static const luaL_reg R_ra[] = {
 
 #endif
 
+static const luaL_reg R_list[] = {
+	{ "__index", iwinfo_L_list_index },
+	{ "__len",   iwinfo_L_list_len   },
+	{ "__pairs", iwinfo_L_list_pairs },
+	{ NULL, NULL }
+};
+
+static const luaL_reg R_entry[] = {
+	{ "__index", iwinfo_L_entry_index },
+	{ NULL, NULL }
+};
+
+static const luaL_reg R_crypto[] = {
+	{ "__index", iwinfo_L_crypto_index },
+	{ NULL, NULL }
+};
+
+static const luaL_reg R_scan[] = {
+	{ "fd",      iwinfo_L_scan_fd      },
+	{ "ready",   iwinfo_L_scan_ready   },
+	{ "poll",    iwinfo_L_scan_poll    },
+	{ "results", iwinfo_L_scan_results },
+	{ "close",   iwinfo_L_scan_close   },
+	{ "__gc",    iwinfo_L_scan_close   },
+	{ NULL, NULL }
+};
+
+static const luaL_reg R_events[] = {
+	{ "fd",      iwinfo_L_events_fd    },
+	{ "close",   iwinfo_L_events_close },
+	{ "__gc",    iwinfo_L_events_close },
+	{ NULL, NULL }
+};
+
+static const luaL_reg R_device[] = {
+	{ "ifname",  iwinfo_L_device_ifname  },
+	{ "ifindex", iwinfo_L_device_ifindex },
+	{ "phy",     iwinfo_L_device_phy     },
+	{ "type",    iwinfo_L_device_type    },
+	{ "info",    iwinfo_L_device_info    },
+	{ NULL, NULL }
+};
+
 static const luaL_reg R_common[] = {
-	{ "type", iwinfo_L_type },
-	{ "__gc", iwinfo_L__gc  },
+	{ "type",          iwinfo_L_type          },
+	{ "open",          iwinfo_L_open          },
+	{ "scan_coalesce", iwinfo_L_scan_coalesce },
+	{ "generation",    iwinfo_L_generation    },
+	{ "publish",       iwinfo_L_publish       },
+	{ "stats",         iwinfo_L_stats         },
+	{ "stats_reset",   iwinfo_L_stats_reset   },
+	{ "__gc",          iwinfo_L__gc           },
 	{ NULL, NULL }
 };
 
 
 LUALIB_API int luaopen_iwinfo(lua_State *L) {
+	int lib, keys;
+
 	luaL_register(L, IWINFO_META, R_common);
+	lib = lua_gettop(L);
+
+	iwinfo_L_keytable(L);
+	keys = lua_gettop(L);
+
+	lua_pushvalue(L, keys);
+	lua_pushcclosure(L, iwinfo_L_scan_multi, 1);
+	lua_setfield(L, lib, "scan_multi");
+
+	luaL_newmetatable(L, IWINFO_LIST_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_list, 1);
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, IWINFO_ENTRY_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_entry, 1);
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, IWINFO_CRYPTO_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_crypto, 1);
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, IWINFO_SCAN_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_scan, 1);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	if (!luaL_loadbuffer(L, iwinfo_L_scan_wait, sizeof(iwinfo_L_scan_wait) - 1,
+	                     "=iwinfo.scan.wait"))
+		lua_setfield(L, -2, "wait");
+	lua_settop(L, keys);
+
+	luaL_newmetatable(L, IWINFO_EVENTS_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_events, 1);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, IWINFO_DEVICE_META);
+	lua_pushvalue(L, keys);
+	lua_newtable(L);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_device, 1);
+	lua_pushcclosure(L, iwinfo_L_device_index, 2);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
 
 #ifdef USE_RA
 	luaL_newmetatable(L, IWINFO_RA_META);
-	luaL_register(L, NULL, R_ra);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_ra, 1);
 	lua_pushvalue(L, -1);
 	lua_setfield(L, -2, "__index");
-	lua_setfield(L, -2, "ra");
+	lua_setfield(L, lib, "ra");
 #endif
 
 #ifdef USE_WL
 	luaL_newmetatable(L, IWINFO_WL_META);
-	luaL_register(L, NULL, R_wl);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_wl, 1);
 	lua_pushvalue(L, -1);
 	lua_setfield(L, -2, "__index");
-	lua_setfield(L, -2, "wl");
+	lua_setfield(L, lib, "wl");
 #endif
 
 #ifdef USE_MADWIFI
 	luaL_newmetatable(L, IWINFO_MADWIFI_META);
-	luaL_register(L, NULL, R_madwifi);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_madwifi, 1);
 	lua_pushvalue(L, -1);
 	lua_setfield(L, -2, "__index");
-	lua_setfield(L, -2, "madwifi");
+	lua_setfield(L, lib, "madwifi");
 #endif
 
 #ifdef USE_NL80211
 	luaL_newmetatable(L, IWINFO_NL80211_META);
-	luaL_register(L, NULL, R_nl80211);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_nl80211, 1);
 	lua_pushvalue(L, -1);
 	lua_setfield(L, -2, "__index");
-	lua_setfield(L, -2, "nl80211");
+	lua_setfield(L, lib, "nl80211");
 #endif
 
 	luaL_newmetatable(L, IWINFO_WEXT_META);
-	luaL_register(L, NULL, R_wext);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_wext, 1);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	lua_setfield(L, lib, "wext");
+
+	luaL_newmetatable(L, IWINFO_SHM_META);
+	lua_pushvalue(L, keys);
+	luaL_openlib(L, NULL, R_shm, 1);
 	lua_pushvalue(L, -1);
 	lua_setfield(L, -2, "__index");
-	lua_setfield(L, -2, "wext");
+	lua_setfield(L, lib, "shm");
 
+	lua_settop(L, lib);
 	return 1;
 }
\ No newline at end of file
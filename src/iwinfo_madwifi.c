@@ -248,6 +248,7 @@ static char * madwifi_isvap(const char *ifname, const char *wifiname)
 	if( strlen(ifname) <= 9 )
 	{
 		sprintf(path, "/proc/sys/net/%s/%%parent", ifname);
+		IWINFO_STATS_COUNT(FILES, 1);
 
 		if( (fd = open(path, O_RDONLY)) > -1 )
 		{
@@ -721,6 +722,32 @@ int madwifi_get_encryption(const char *ifname, char *buf)
 	return 0;
 }
 
+static void madwifi_get_assoclist_entry(struct ieee80211req_sta_info *si,
+                                        struct iwinfo_assoclist_entry *e)
+{
+	memset(e, 0, sizeof(*e));
+
+	e->signal = (si->isi_rssi - 95);
+	memcpy(e->mac, &si->isi_macaddr, 6);
+
+	e->inactive = si->isi_inact * 1000;
+
+	e->tx_packets = (si->isi_txseqs[0] & IEEE80211_SEQ_SEQ_MASK)
+		>> IEEE80211_SEQ_SEQ_SHIFT;
+
+	e->rx_packets = (si->isi_rxseqs[0] & IEEE80211_SEQ_SEQ_MASK)
+		>> IEEE80211_SEQ_SEQ_SHIFT;
+
+	e->tx_rate.rate =
+		(si->isi_rates[si->isi_txrate] & IEEE80211_RATE_VAL) * 500;
+
+	/* XXX: this is just a guess */
+	e->rx_rate.rate = e->tx_rate.rate;
+
+	e->rx_rate.mcs = -1;
+	e->tx_rate.mcs = -1;
+}
+
 int madwifi_get_assoclist(const char *ifname, char *buf, int *len)
 {
 	int bl, tl, noise;
@@ -740,37 +767,56 @@ int madwifi_get_assoclist(const char *ifname, char *buf, int *len)
 		do {
 			si = (struct ieee80211req_sta_info *) cp;
 
-			memset(&entry, 0, sizeof(entry));
+			madwifi_get_assoclist_entry(si, &entry);
+			entry.noise = noise;
 
-			entry.signal = (si->isi_rssi - 95);
-			entry.noise  = noise;
-			memcpy(entry.mac, &si->isi_macaddr, 6);
+			memcpy(&buf[bl], &entry, sizeof(struct iwinfo_assoclist_entry));
 
-			entry.inactive = si->isi_inact * 1000;
+			bl += sizeof(struct iwinfo_assoclist_entry);
+			cp += si->isi_len;
+			tl -= si->isi_len;
+		} while (tl >= sizeof(struct ieee80211req_sta_info));
 
-			entry.tx_packets = (si->isi_txseqs[0] & IEEE80211_SEQ_SEQ_MASK)
-				>> IEEE80211_SEQ_SEQ_SHIFT;
+		*len = bl;
+		return 0;
+	}
 
-			entry.rx_packets = (si->isi_rxseqs[0] & IEEE80211_SEQ_SEQ_MASK)
-				>> IEEE80211_SEQ_SEQ_SHIFT;
+	return -1;
+}
 
-			entry.tx_rate.rate =
-				(si->isi_rates[si->isi_txrate] & IEEE80211_RATE_VAL) * 500;
+/* STA_INFO has no per-MAC selector, so walk the table but only decode
+ * the matching record and skip the noise query on a miss. */
+int madwifi_get_station(const char *ifname, const uint8_t *mac,
+                        struct iwinfo_assoclist_ext_entry *e)
+{
+	int tl, noise;
+	uint8_t *cp;
+	uint8_t tmp[24*1024];
+	struct ieee80211req_sta_info *si;
 
-			/* XXX: this is just a guess */
-			entry.rx_rate.rate = entry.tx_rate.rate;
+	if( (tl = get80211priv(ifname, IEEE80211_IOCTL_STA_INFO, tmp, 24*1024)) <= 0 )
+		return -1;
 
-			entry.rx_rate.mcs = -1;
-			entry.tx_rate.mcs = -1;
+	for (cp = tmp; tl >= sizeof(struct ieee80211req_sta_info);
+	     cp += si->isi_len, tl -= si->isi_len)
+	{
+		si = (struct ieee80211req_sta_info *) cp;
 
-			memcpy(&buf[bl], &entry, sizeof(struct iwinfo_assoclist_entry));
+		if (!si->isi_len)
+			break;
 
-			bl += sizeof(struct iwinfo_assoclist_entry);
-			cp += si->isi_len;
-			tl -= si->isi_len;
-		} while (tl >= sizeof(struct ieee80211req_sta_info));
+		if (memcmp(&si->isi_macaddr, mac, 6))
+			continue;
+
+		memset(e, 0, sizeof(*e));
+		madwifi_get_assoclist_entry(si, &e->base);
+
+		e->rx_packets = e->base.rx_packets;
+		e->tx_packets = e->base.tx_packets;
+
+		if( !madwifi_get_noise(ifname, &noise) )
+			e->base.noise = noise;
 
-		*len = bl;
 		return 0;
 	}
 
@@ -923,6 +969,7 @@ int madwifi_get_country(const char *ifname, char *buf)
 	if( wifi )
 	{
 		snprintf(buffer, sizeof(buffer), "/proc/sys/dev/%s/countrycode", wifi);
+		IWINFO_STATS_COUNT(FILES, 1);
 
 		if( (fd = open(buffer, O_RDONLY)) > -1 )
 		{
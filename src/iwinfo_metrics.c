@@ -0,0 +1,480 @@
+/*
+ * iwinfo - Wireless Information Library - OpenMetrics Exporter
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * All wireless interfaces are gathered in one pass before anything is
+ * formatted, OpenMetrics wants the samples of a family kept together.
+ * Per interface that is the backend type lookup, done by iwinfo_backend()
+ * and again for the type label, the phy name, iwinfo_info() and one
+ * station dump. iwinfo_info() is a single bulk query on nl80211 only,
+ * other backends fall back to one request per field. The channel survey
+ * is taken once per radio. bench/metrics_scrape times the whole scrape.
+ */
+
+#include <glob.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "iwinfo.h"
+
+
+#define METRICS_DEVS  64
+
+struct metrics_dev {
+	char ifname[IFNAMSIZ];
+	char phy[IFNAMSIZ];
+	const char *type;
+	struct iwinfo_info info;
+	char *assoc;
+	int assoc_len;
+	char *survey;
+	int survey_len;
+};
+
+struct metrics_buf {
+	char *data;
+	int len;
+	int size;
+};
+
+/* value types, the MSECS ones are exported in seconds */
+enum {
+	METRICS_INT,
+	METRICS_INT8,
+	METRICS_U32,
+	METRICS_U64,
+	METRICS_BOOL,
+	METRICS_MSECS,
+	METRICS_MSECS64,
+};
+
+struct metrics_family {
+	const char *name;
+	const char *type;
+	const char *help;
+	int offset;
+	int kind;
+	uint32_t flag;
+};
+
+#define METRICS_INFO(name, help, field, flag) \
+	{ name, "gauge", help, offsetof(struct iwinfo_info, field), \
+	  METRICS_INT, IWINFO_INFO_##flag }
+
+#define METRICS_ENTRY(s, name, type, help, field, kind) \
+	{ name, type, help, offsetof(struct s, field), METRICS_##kind, 0 }
+
+static const struct metrics_family metrics_interface[] = {
+	METRICS_INFO("iwinfo_channel", "Operating channel",
+	             channel, CHANNEL),
+	METRICS_INFO("iwinfo_frequency_mhz", "Operating frequency",
+	             frequency, FREQUENCY),
+	METRICS_INFO("iwinfo_txpower_dbm", "Transmit power",
+	             txpower, TXPOWER),
+	METRICS_INFO("iwinfo_bitrate_kbps", "Current bit rate",
+	             bitrate, BITRATE),
+	METRICS_INFO("iwinfo_signal_dbm", "Signal of the associated network",
+	             signal, SIGNAL),
+	METRICS_INFO("iwinfo_noise_dbm", "Noise floor",
+	             noise, NOISE),
+	METRICS_INFO("iwinfo_quality", "Link quality",
+	             quality, QUALITY),
+	METRICS_INFO("iwinfo_quality_max", "Maximum link quality",
+	             quality_max, QUALITY_MAX),
+};
+
+static const struct metrics_family metrics_station[] = {
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_signal_dbm",
+	              "gauge", "Station signal", base.signal, INT8),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_noise_dbm",
+	              "gauge", "Station noise", base.noise, INT8),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_inactive_seconds",
+	              "gauge", "Time since the last activity", base.inactive, MSECS),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_connected_seconds",
+	              "gauge", "Time since association", connected_time, U32),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_rx_rate_kbps",
+	              "gauge", "Last receive bit rate", base.rx_rate.rate, U32),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_tx_rate_kbps",
+	              "gauge", "Last transmit bit rate", base.tx_rate.rate, U32),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_rx_bytes",
+	              "counter", "Received bytes", rx_bytes, U64),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_tx_bytes",
+	              "counter", "Transmitted bytes", tx_bytes, U64),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_rx_packets",
+	              "counter", "Received packets", rx_packets, U64),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_tx_packets",
+	              "counter", "Transmitted packets", tx_packets, U64),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_tx_retries",
+	              "counter", "Transmit retries", tx_retries, U32),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_tx_failed",
+	              "counter", "Failed transmissions", tx_failed, U32),
+	METRICS_ENTRY(iwinfo_assoclist_ext_entry, "iwinfo_station_beacon_loss",
+	              "counter", "Lost beacons", beacon_loss, U32),
+};
+
+static const struct metrics_family metrics_survey[] = {
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_in_use",
+	              "gauge", "Channel the radio operates on", in_use, BOOL),
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_noise_dbm",
+	              "gauge", "Channel noise floor", noise, INT8),
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_active_seconds",
+	              "counter", "Radio on time", time, MSECS64),
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_busy_seconds",
+	              "counter", "Channel busy time", time_busy, MSECS64),
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_rx_seconds",
+	              "counter", "Receive time", time_rx, MSECS64),
+	METRICS_ENTRY(iwinfo_survey_entry, "iwinfo_survey_tx_seconds",
+	              "counter", "Transmit time", time_tx, MSECS64),
+};
+
+#define METRICS_COUNT(t) (sizeof(t) / sizeof(t[0]))
+
+
+static int metrics_grow(struct metrics_buf *b, int need)
+{
+	int size = b->size ? b->size : 16384;
+	char *data;
+
+	while (size - b->len < need)
+		size *= 2;
+
+	if (size == b->size)
+		return 0;
+
+	if (!(data = realloc(b->data, size)))
+		return -1;
+
+	b->data = data;
+	b->size = size;
+
+	return 0;
+}
+
+static void metrics_printf(struct metrics_buf *b, const char *fmt, ...)
+{
+	int n;
+	va_list ap;
+
+	va_start(ap, fmt);
+	n = vsnprintf(b->data + b->len, b->size - b->len, fmt, ap);
+	va_end(ap);
+
+	if (n < b->size - b->len)
+	{
+		b->len += n;
+		return;
+	}
+
+	if (metrics_grow(b, n + 1))
+		return;
+
+	va_start(ap, fmt);
+	b->len += vsnprintf(b->data + b->len, b->size - b->len, fmt, ap);
+	va_end(ap);
+}
+
+/* Label values escape backslash, double quote and line feed */
+static void metrics_label(struct metrics_buf *b, const char *sep,
+                          const char *name, const char *val, int len)
+{
+	int i;
+
+	metrics_printf(b, "%s%s=\"", sep, name);
+
+	if (metrics_grow(b, 2 * len + 2))
+		return;
+
+	for (i = 0; i < len && val[i]; i++)
+	{
+		if (val[i] == '\\' || val[i] == '"')
+			b->data[b->len++] = '\\';
+		else if (val[i] == '\n')
+		{
+			b->data[b->len++] = '\\';
+			b->data[b->len++] = 'n';
+			continue;
+		}
+
+		b->data[b->len++] = val[i];
+	}
+
+	b->data[b->len++] = '"';
+}
+
+static void metrics_labels(struct metrics_buf *b, const struct metrics_dev *d)
+{
+	metrics_label(b, "{", "ifname", d->ifname, sizeof(d->ifname));
+	metrics_label(b, ",", "phy", d->phy, sizeof(d->phy));
+}
+
+static void metrics_header(struct metrics_buf *b,
+                           const struct metrics_family *f)
+{
+	metrics_printf(b, "# TYPE %s %s\n# HELP %s %s\n",
+	               f->name, f->type, f->name, f->help);
+}
+
+static void metrics_value(struct metrics_buf *b,
+                          const struct metrics_family *f, const void *base)
+{
+	const char *p = (const char *)base + f->offset;
+	uint64_t v;
+
+	switch (f->kind)
+	{
+	case METRICS_INT:
+		metrics_printf(b, "} %d\n", *(const int *)p);
+		return;
+
+	case METRICS_INT8:
+		metrics_printf(b, "} %d\n", *(const int8_t *)p);
+		return;
+
+	case METRICS_U32:
+		metrics_printf(b, "} %u\n", *(const uint32_t *)p);
+		return;
+
+	case METRICS_U64:
+		metrics_printf(b, "} %llu\n", (unsigned long long)*(const uint64_t *)p);
+		return;
+
+	case METRICS_BOOL:
+		metrics_printf(b, "} %d\n", !!*(const uint8_t *)p);
+		return;
+
+	case METRICS_MSECS:
+		v = *(const uint32_t *)p;
+		break;
+
+	default:
+		v = *(const uint64_t *)p;
+		break;
+	}
+
+	metrics_printf(b, "} %llu.%03llu\n",
+	               (unsigned long long)v / 1000, (unsigned long long)v % 1000);
+}
+
+static void metrics_name(struct metrics_buf *b,
+                         const struct metrics_family *f)
+{
+	metrics_printf(b, "%s%s", f->name,
+	               strcmp(f->type, "counter") ? "" : "_total");
+}
+
+
+/* Gather everything of one interface, the survey only for the first
+ * interface seen on a radio as every interface would report the same */
+static int metrics_gather(struct metrics_dev *devs, int n, const char *ifname)
+{
+	int i, len;
+	char buf[IWINFO_BUFSIZE];
+	const struct iwinfo_ops *ops;
+	struct metrics_dev *d = &devs[n];
+
+	if (!(ops = iwinfo_backend(ifname)))
+		return 0;
+
+	memset(d, 0, sizeof(*d));
+	strncpy(d->ifname, ifname, sizeof(d->ifname) - 1);
+	d->type = iwinfo_type(ifname);
+
+	if (!ops->phyname || ops->phyname(ifname, d->phy))
+		strncpy(d->phy, ifname, sizeof(d->phy) - 1);
+
+	if (iwinfo_info(ops, ifname, &d->info))
+		d->info.valid = 0;
+
+	if (!iwinfo_assoclist_ext(ops, ifname, buf, &len) && len > 0 &&
+	    (d->assoc = malloc(len)) != NULL)
+	{
+		memcpy(d->assoc, buf, len);
+		d->assoc_len = len;
+	}
+
+	for (i = 0; i < n; i++)
+		if (!strcmp(devs[i].phy, d->phy))
+			return 1;
+
+	if (ops->survey && !ops->survey(ifname, buf, &len) && len > 0 &&
+	    (d->survey = malloc(len)) != NULL)
+	{
+		memcpy(d->survey, buf, len);
+		d->survey_len = len;
+	}
+
+	return 1;
+}
+
+static void metrics_format(struct metrics_buf *b, struct metrics_dev *devs,
+                           int n, uint64_t duration)
+{
+	int i, j, k;
+	const struct metrics_family *f;
+	const struct iwinfo_info *in;
+	const struct iwinfo_assoclist_ext_entry *e;
+	const struct iwinfo_survey_entry *s;
+
+	metrics_printf(b, "# TYPE iwinfo_interface info\n"
+	                  "# HELP iwinfo_interface Wireless interface\n");
+
+	for (i = 0; i < n; i++)
+	{
+		in = &devs[i].info;
+
+		metrics_printf(b, "iwinfo_interface_info");
+		metrics_labels(b, &devs[i]);
+		metrics_label(b, ",", "type",
+		              devs[i].type ? devs[i].type : "", 16);
+		metrics_label(b, ",", "mode", (in->valid & IWINFO_INFO_MODE)
+		              ? IWINFO_OPMODE_NAMES[in->mode] : "", 16);
+		metrics_label(b, ",", "ssid", (in->valid & IWINFO_INFO_SSID)
+		              ? in->ssid : "", sizeof(in->ssid));
+		metrics_label(b, ",", "bssid", (in->valid & IWINFO_INFO_BSSID)
+		              ? in->bssid : "", sizeof(in->bssid));
+		metrics_label(b, ",", "country", (in->valid & IWINFO_INFO_COUNTRY)
+		              ? in->country : "", sizeof(in->country));
+		metrics_printf(b, "} 1\n");
+	}
+
+	for (k = 0; k < METRICS_COUNT(metrics_interface); k++)
+	{
+		f = &metrics_interface[k];
+		metrics_header(b, f);
+
+		for (i = 0; i < n; i++)
+		{
+			if (!(devs[i].info.valid & f->flag))
+				continue;
+
+			metrics_name(b, f);
+			metrics_labels(b, &devs[i]);
+			metrics_value(b, f, &devs[i].info);
+		}
+	}
+
+	metrics_printf(b, "# TYPE iwinfo_stations gauge\n"
+	                  "# HELP iwinfo_stations Associated stations\n");
+
+	for (i = 0; i < n; i++)
+	{
+		metrics_printf(b, "iwinfo_stations");
+		metrics_labels(b, &devs[i]);
+		metrics_printf(b, "} %d\n",
+		               (int)(devs[i].assoc_len / sizeof(*e)));
+	}
+
+	for (k = 0; k < METRICS_COUNT(metrics_station); k++)
+	{
+		f = &metrics_station[k];
+		metrics_header(b, f);
+
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j < devs[i].assoc_len; j += sizeof(*e))
+			{
+				e = (const struct iwinfo_assoclist_ext_entry *)&devs[i].assoc[j];
+
+				metrics_name(b, f);
+				metrics_labels(b, &devs[i]);
+				metrics_printf(b, ",mac=\"%02X:%02X:%02X:%02X:%02X:%02X\"",
+				               e->base.mac[0], e->base.mac[1], e->base.mac[2],
+				               e->base.mac[3], e->base.mac[4], e->base.mac[5]);
+				metrics_value(b, f, e);
+			}
+		}
+	}
+
+	for (k = 0; k < METRICS_COUNT(metrics_survey); k++)
+	{
+		f = &metrics_survey[k];
+		metrics_header(b, f);
+
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j < devs[i].survey_len; j += sizeof(*s))
+			{
+				s = (const struct iwinfo_survey_entry *)&devs[i].survey[j];
+
+				/* noise only, no times without an active dwell */
+				if ((f->kind == METRICS_INT8 && !s->noise) ||
+				    (f->kind == METRICS_MSECS64 && !s->time))
+					continue;
+
+				metrics_name(b, f);
+				metrics_label(b, "{", "phy", devs[i].phy,
+				              sizeof(devs[i].phy));
+				metrics_printf(b, ",frequency=\"%u\"", s->mhz);
+				metrics_value(b, f, s);
+			}
+		}
+	}
+
+	metrics_printf(b, "# TYPE iwinfo_scrape_duration_seconds gauge\n"
+	                  "# HELP iwinfo_scrape_duration_seconds "
+	                  "Time taken to query all interfaces\n"
+	                  "iwinfo_scrape_duration_seconds %llu.%03llu\n"
+	                  "# EOF\n",
+	               (unsigned long long)duration / 1000,
+	               (unsigned long long)duration % 1000);
+}
+
+/* Export the state of all wireless interfaces as OpenMetrics text to fd
+ * with a single write, returns the number of interfaces or -1 */
+int iwinfo_metrics(int fd)
+{
+	int i, n = 0, off, rv;
+	char *p;
+	glob_t globbuf;
+	uint64_t start = iwinfo_msecs();
+	struct metrics_buf b = { 0 };
+	static struct metrics_dev devs[METRICS_DEVS];
+
+	if (glob("/sys/class/net/*", 0, NULL, &globbuf))
+		return -1;
+
+	for (i = 0; i < globbuf.gl_pathc && n < METRICS_DEVS; i++)
+		if ((p = strrchr(globbuf.gl_pathv[i], '/')) != NULL)
+			n += metrics_gather(devs, n, p + 1);
+
+	globfree(&globbuf);
+
+	if (!metrics_grow(&b, 1))
+		metrics_format(&b, devs, n, iwinfo_msecs() - start);
+
+	for (i = 0; i < n; i++)
+	{
+		free(devs[i].assoc);
+		free(devs[i].survey);
+	}
+
+	for (off = 0; off < b.len; off += rv)
+	{
+		if ((rv = write(fd, b.data + off, b.len - off)) < 0)
+		{
+			if (errno == EINTR)
+			{
+				rv = 0;
+				continue;
+			}
+
+			n = -1;
+			break;
+		}
+	}
+
+	free(b.data);
+
+	return b.len ? n : -1;
+}
@@ -27,11 +27,70 @@
 
 #define min(x, y) ((x) < (y)) ? (x) : (y)
 
+#ifndef SOL_NETLINK
+#define SOL_NETLINK		270
+#endif
+
+#ifndef NETLINK_CAP_ACK
+#define NETLINK_CAP_ACK		10
+#endif
+
+#ifndef NETLINK_EXT_ACK
+#define NETLINK_EXT_ACK		11
+#endif
+
+#ifndef NLM_F_DUMP_INTR
+#define NLM_F_DUMP_INTR		0x10
+#endif
+
+/* Receive buffer sizes for the request and the multicast event socket */
+#define NL80211_REQ_RCVBUF	(1024 * 1024)
+#define NL80211_EVT_RCVBUF	(256 * 1024)
+
+/* How often an interrupted dump is restarted before giving up */
+#define NL80211_DUMP_RETRIES	3
+
+#define NL80211_SURVEY_TABLES	4
+#define NL80211_SURVEY_TTL		1000	/* ms */
+
 static struct nl80211_state *nls = NULL;
 
+static struct nl_sock * nl80211_sock(int rcvbuf)
+{
+	int fd, on = 1;
+	struct nl_sock *sock;
+
+	sock = nl_socket_alloc();
+	if (!sock)
+		return NULL;
+
+	if (genl_connect(sock))
+		goto err;
+
+	fd = nl_socket_get_fd(sock);
+	if (fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC) < 0)
+		goto err;
+
+	/* Large dumps overrun the default socket buffer on busy radios,
+	 * peeking lets libnl size each read to the pending message */
+	nl_socket_set_buffer_size(sock, rcvbuf, 0);
+	nl_socket_enable_msg_peek(sock);
+
+	/* Do not echo requests back in acks, report extended errors;
+	 * both are optional and silently unsupported on older kernels */
+	setsockopt(fd, SOL_NETLINK, NETLINK_CAP_ACK, &on, sizeof(on));
+	setsockopt(fd, SOL_NETLINK, NETLINK_EXT_ACK, &on, sizeof(on));
+
+	return sock;
+
+err:
+	nl_socket_free(sock);
+	return NULL;
+}
+
 static int nl80211_init(void)
 {
-	int err, fd;
+	int err;
 
 	if (!nls)
 	{
@@ -43,20 +102,17 @@ static int nl80211_init(void)
 
 		memset(nls, 0, sizeof(*nls));
 
-		nls->nl_sock = nl_socket_alloc();
+		nls->nl_sock = nl80211_sock(NL80211_REQ_RCVBUF);
 		if (!nls->nl_sock) {
-			err = -ENOMEM;
-			goto err;
-		}
-
-		if (genl_connect(nls->nl_sock)) {
 			err = -ENOLINK;
 			goto err;
 		}
 
-		fd = nl_socket_get_fd(nls->nl_sock);
-		if (fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC) < 0) {
-			err = -EINVAL;
+		/* Multicast subscriptions live on their own socket so that
+		 * event bursts cannot interleave with or overrun dumps */
+		nls->nl_evsock = nl80211_sock(NL80211_EVT_RCVBUF);
+		if (!nls->nl_evsock) {
+			err = -ENOLINK;
 			goto err;
 		}
 
@@ -114,6 +170,19 @@ static int nl80211_msg_response(struct nl_msg *msg, void *arg)
 	return NL_SKIP;
 }
 
+static int nl80211_msg_in(struct nl_msg *msg, void *arg)
+{
+	int *intr = arg;
+
+	IWINFO_STATS_COUNT(NL_MSGS, 1);
+	IWINFO_STATS_COUNT(NL_BYTES, nlmsg_hdr(msg)->nlmsg_len);
+
+	if (nlmsg_hdr(msg)->nlmsg_flags & NLM_F_DUMP_INTR)
+		*intr = 1;
+
+	return NL_OK;
+}
+
 static void nl80211_free(struct nl80211_msg_conveyor *cv)
 {
 	if (cv)
@@ -186,7 +255,7 @@ static struct nl80211_msg_conveyor * nl80211_msg(const char *ifname,
 		phyidx = atoi(&ifname[5]);
 	else if (!strncmp(ifname, "mon.", 4))
 		ifidx = if_nametoindex(&ifname[4]);
-	else
+	else if ((ifidx = iwinfo_resolved_ifindex(ifname)) <= 0)
 		ifidx = if_nametoindex(ifname);
 
 	if ((ifidx < 0) && (phyidx < 0))
@@ -221,16 +290,25 @@ static struct nl80211_msg_conveyor * nl80211_send(
 	else
 		nl_cb_set(cv->cb, NL_CB_VALID, NL_CB_CUSTOM, nl80211_msg_response, &rcv);
 
+	nls->dump_intr = 0;
+
 	if (nl_send_auto_complete(nls->nl_sock, cv->msg) < 0)
 		goto err;
 
+	IWINFO_STATS_COUNT(NL_MSGS, 1);
+	IWINFO_STATS_COUNT(NL_BYTES, nlmsg_hdr(cv->msg)->nlmsg_len);
+
 	nl_cb_err(cv->cb,               NL_CB_CUSTOM, nl80211_msg_error,  &err);
 	nl_cb_set(cv->cb, NL_CB_FINISH, NL_CB_CUSTOM, nl80211_msg_finish, &err);
 	nl_cb_set(cv->cb, NL_CB_ACK,    NL_CB_CUSTOM, nl80211_msg_ack,    &err);
+	nl_cb_set(cv->cb, NL_CB_MSG_IN, NL_CB_CUSTOM, nl80211_msg_in,
+	          &nls->dump_intr);
 
 	while (err > 0)
 		nl_recvmsgs(nls->nl_sock, cv->cb);
 
+	nls->msg_err = err;
+
 	return &rcv;
 
 err:
@@ -240,6 +318,42 @@ err:
 	return NULL;
 }
 
+/* Run a dump request and restart it with a freshly built message if the
+ * kernel flagged it as interrupted by a concurrent change. The callback
+ * argument is restored to its initial state before every attempt. Returns
+ * the netlink error if the kernel rejected the dump. */
+static int nl80211_dump(const char *ifname, int cmd,
+                        int (*cb_func)(struct nl_msg *, void *),
+                        void *cb_arg, size_t arg_len)
+{
+	int try, rv;
+	char init[arg_len];
+	struct nl80211_msg_conveyor *req;
+
+	memcpy(init, cb_arg, arg_len);
+
+	for (try = 0; try < NL80211_DUMP_RETRIES; try++)
+	{
+		if (try)
+			memcpy(cb_arg, init, arg_len);
+
+		req = nl80211_msg(ifname, cmd, NLM_F_DUMP);
+		if (!req)
+			return -1;
+
+		rv = nl80211_send(req, cb_func, cb_arg) ? nls->msg_err : -1;
+		nl80211_free(req);
+
+		if (rv < 0)
+			return rv;
+
+		if (!nls->dump_intr)
+			return 0;
+	}
+
+	return -1;
+}
+
 static struct nlattr ** nl80211_parse(struct nl_msg *msg)
 {
 	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
@@ -282,7 +396,7 @@ static int nl80211_subscribe_cb(struct nl_msg *msg, void *arg)
 	return NL_SKIP;
 }
 
-static int nl80211_subscribe(const char *family, const char *group)
+static int nl80211_mcast_group(const char *family, const char *group)
 {
 	struct nl80211_group_conveyor cv = { .name = group, .id = -ENOENT };
 	struct nl80211_msg_conveyor *req;
@@ -297,7 +411,13 @@ nla_put_failure:
 		nl80211_free(req);
 	}
 
-	return nl_socket_add_membership(nls->nl_sock, cv.id);
+	return cv.id;
+}
+
+static int nl80211_subscribe(const char *family, const char *group)
+{
+	return nl_socket_add_membership(nls->nl_evsock,
+	                                nl80211_mcast_group(family, group));
 }
 
 
@@ -305,6 +425,12 @@ static int nl80211_wait_cb(struct nl_msg *msg, void *arg)
 {
 	struct nl80211_event_conveyor *cv = arg;
 	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nlattr **attr = nl80211_parse(msg);
+
+	/* events of other interfaces share the group */
+	if (cv->ifidx > 0 && (!attr[NL80211_ATTR_IFINDEX] ||
+	    nla_get_u32(attr[NL80211_ATTR_IFINDEX]) != cv->ifidx))
+		return NL_SKIP;
 
 	if (gnlh->cmd == cv->wait)
 		cv->recv = gnlh->cmd;
@@ -317,14 +443,27 @@ static int nl80211_wait_seq_check(struct nl_msg *msg, void *arg)
 	return NL_OK;
 }
 
-static int nl80211_wait(const char *family, const char *group, int cmd)
+/* Subscribe to group and drop what the event socket kept from earlier
+ * waits, must happen before the request whose completion is awaited */
+static int nl80211_wait_prepare(const char *family, const char *group)
 {
-	struct nl80211_event_conveyor cv = { .wait = cmd };
-	struct nl_cb *cb;
+	char buf[256];
 
 	if (nl80211_subscribe(family, group))
 		return -ENOENT;
 
+	while (recv(nl_socket_get_fd(nls->nl_evsock), buf, sizeof(buf),
+	            MSG_DONTWAIT) > 0);
+
+	return 0;
+}
+
+/* Wait for event cmd concerning ifidx, any interface if ifidx is 0 */
+static int nl80211_wait(uint32_t ifidx, int cmd)
+{
+	struct nl80211_event_conveyor cv = { .wait = cmd, .ifidx = ifidx };
+	struct nl_cb *cb;
+
 	cb = nl_cb_alloc(NL_CB_DEFAULT);
 
  	if (!cb)
@@ -334,7 +473,7 @@ static int nl80211_wait(const char *family, const char *group, int cmd)
 	nl_cb_set(cb, NL_CB_VALID,     NL_CB_CUSTOM, nl80211_wait_cb,        &cv );
 
 	while (!cv.recv)
-		nl_recvmsgs(nls->nl_sock, cb);
+		nl_recvmsgs(nls->nl_evsock, cb);
 
 	nl_cb_put(cb);
 
@@ -440,9 +579,16 @@ static char * nl80211_ifname2phy(const char *ifname)
 {
 	static char phy[32] = { 0 };
 	struct nl80211_msg_conveyor *req;
+	const char *res;
 
 	memset(phy, 0, sizeof(phy));
 
+	if ((res = iwinfo_resolved_phy(ifname)) != NULL)
+	{
+		snprintf(phy, sizeof(phy), "%s", res);
+		return phy;
+	}
+
 	req = nl80211_msg(ifname, NL80211_CMD_GET_WIPHY, 0);
 	if (req)
 	{
@@ -453,22 +599,18 @@ static char * nl80211_ifname2phy(const char *ifname)
 	return phy[0] ? phy : NULL;
 }
 
-static char * nl80211_hostapd_info(const char *ifname)
+static char * nl80211_hostapd_conf(int mode, const char *phy)
 {
-	int mode;
-	char *phy;
 	char path[32] = { 0 };
 	static char buf[4096] = { 0 };
 	FILE *conf;
 
-	if (nl80211_get_mode(ifname, &mode))
-		return NULL;
-
-	if ((mode == IWINFO_OPMODE_MASTER || mode == IWINFO_OPMODE_AP_VLAN) &&
-	    (phy = nl80211_ifname2phy(ifname)) != NULL)
+	if ((mode == IWINFO_OPMODE_MASTER || mode == IWINFO_OPMODE_AP_VLAN) && phy)
 	{
 		snprintf(path, sizeof(path), "/var/run/hostapd-%s.conf", phy);
 
+		IWINFO_STATS_COUNT(FILES, 1);
+
 		if ((conf = fopen(path, "r")) != NULL)
 		{
 			fread(buf, sizeof(buf) - 1, 1, conf);
@@ -481,15 +623,26 @@ static char * nl80211_hostapd_info(const char *ifname)
 	return NULL;
 }
 
+static char * nl80211_hostapd_info(const char *ifname)
+{
+	int mode;
+
+	if (nl80211_get_mode(ifname, &mode))
+		return NULL;
+
+	return nl80211_hostapd_conf(mode, nl80211_ifname2phy(ifname));
+}
+
 static inline int nl80211_wpactl_recv(int sock, char *buf, int blen)
 {
+	int len;
 	fd_set rfds;
 	struct timeval tv = { 2, 0 };
 
 	FD_ZERO(&rfds);
 	FD_SET(sock, &rfds);
 
-	memset(buf, 0, blen);
+	buf[0] = 0;
 
 
 	if (select(sock + 1, &rfds, NULL, NULL, &tv) < 0)
@@ -498,58 +651,92 @@ static inline int nl80211_wpactl_recv(int sock, char *buf, int blen)
 	if (!FD_ISSET(sock, &rfds))
 		return -1;
 
-	return recv(sock, buf, blen, 0);
+	if ((len = recv(sock, buf, blen - 1, 0)) > 0)
+		buf[len] = 0;
+
+	return len;
 }
 
-static char * nl80211_wpactl_info(const char *ifname, const char *cmd,
-								   const char *event)
+static void nl80211_wpactl_close(struct nl80211_wpactl *ctl)
 {
-	int numtry = 0;
-	int sock = -1;
-	char *rv = NULL;
-	size_t remote_length, local_length;
-	static char buffer[10240] = { 0 };
+	if (ctl->sock >= 0)
+		close(ctl->sock);
 
-	struct sockaddr_un local = { 0 };
-	struct sockaddr_un remote = { 0 };
+	if (ctl->local.sun_family)
+		unlink(ctl->local.sun_path);
 
+	ctl->sock = -1;
+	ctl->local.sun_family = 0;
+}
 
-	sock = socket(PF_UNIX, SOCK_DGRAM, 0);
-	if (sock < 0)
-		return NULL;
+static int nl80211_wpactl_open(const char *ifname, struct nl80211_wpactl *ctl)
+{
+	static unsigned int serial = 0;
+	size_t remote_length, local_length;
+	struct sockaddr_un remote = { 0 }, local = { 0 };
+
+	memset(ctl, 0, sizeof(*ctl));
+
+	ctl->sock = socket(PF_UNIX, SOCK_DGRAM, 0);
+	if (ctl->sock < 0)
+		return -1;
 
 	remote.sun_family = AF_UNIX;
 	remote_length = sizeof(remote.sun_family) + sprintf(remote.sun_path,
 		"/var/run/wpa_supplicant-%s/%s", ifname, ifname);
 
-	if (fcntl(sock, F_SETFD, fcntl(sock, F_GETFD) | FD_CLOEXEC) < 0)
-		goto out;
+	if (fcntl(ctl->sock, F_SETFD, fcntl(ctl->sock, F_GETFD) | FD_CLOEXEC) < 0)
+		goto err;
+
+	IWINFO_STATS_COUNT(CTRL, 1);
 
-	if (connect(sock, (struct sockaddr *) &remote, remote_length))
-		goto out;
+	if (connect(ctl->sock, (struct sockaddr *) &remote, remote_length))
+		goto err;
 
+	/* every socket gets its own path, a scan handle keeps one open while
+	 * other queries of the same interface come and go */
 	local.sun_family = AF_UNIX;
 	local_length = sizeof(local.sun_family) +
-		sprintf(local.sun_path, "/var/run/iwinfo-%s-%d", ifname, getpid());
+		sprintf(local.sun_path, "/var/run/iwinfo-%s-%d-%u",
+		        ifname, getpid(), serial++);
+
+	/* a path in use can only be left over by a dead process of our pid */
+	if (bind(ctl->sock, (struct sockaddr *) &local, local_length) &&
+	    (errno != EADDRINUSE || unlink(local.sun_path) ||
+	     bind(ctl->sock, (struct sockaddr *) &local, local_length)))
+		goto err;
+
+	/* only a bound path is ours to unlink */
+	ctl->local = local;
+
+	return 0;
 
-	if (bind(sock, (struct sockaddr *) &local, local_length))
-		goto out;
+err:
+	nl80211_wpactl_close(ctl);
+	return -1;
+}
 
+static char * nl80211_wpactl_request(struct nl80211_wpactl *ctl,
+                                     const char *cmd, const char *event)
+{
+	int numtry = 0;
+	static char buffer[10240] = { 0 };
 
 	if (event)
 	{
-		send(sock, "ATTACH", 6, 0);
+		send(ctl->sock, "ATTACH", 6, 0);
 
-		if (nl80211_wpactl_recv(sock, buffer, sizeof(buffer)) <= 0)
-			goto out;
+		if (nl80211_wpactl_recv(ctl->sock, buffer, sizeof(buffer)) <= 0)
+			return NULL;
 	}
 
 
-	send(sock, cmd, strlen(cmd), 0);
+	IWINFO_STATS_COUNT(CTRL, 1);
+	send(ctl->sock, cmd, strlen(cmd), 0);
 
 	while( numtry++ < 5 )
 	{
-		if (nl80211_wpactl_recv(sock, buffer, sizeof(buffer)) <= 0)
+		if (nl80211_wpactl_recv(ctl->sock, buffer, sizeof(buffer)) <= 0)
 		{
 			if (event)
 				continue;
@@ -561,13 +748,21 @@ static char * nl80211_wpactl_info(const char *ifname, const char *cmd,
 			break;
 	}
 
-	rv = buffer;
+	return buffer;
+}
+
+static char * nl80211_wpactl_info(const char *ifname, const char *cmd,
+								   const char *event)
+{
+	char *rv;
+	struct nl80211_wpactl ctl;
+
+	if (nl80211_wpactl_open(ifname, &ctl))
+		return NULL;
 
-out:
-	close(sock);
+	rv = nl80211_wpactl_request(&ctl, cmd, event);
 
-	if (local.sun_family)
-		unlink(local.sun_path);
+	nl80211_wpactl_close(&ctl);
 
 	return rv;
 }
@@ -578,6 +773,8 @@ static inline int nl80211_readint(const char *path)
 	int rv = -1;
 	char buffer[16];
 
+	IWINFO_STATS_COUNT(FILES, 1);
+
 	if ((fd = open(path, O_RDONLY)) > -1)
 	{
 		if (read(fd, buffer, sizeof(buffer)) > 0)
@@ -609,6 +806,8 @@ static char * nl80211_phy2ifname(const char *ifname)
 
 	if (phyidx > -1)
 	{
+		IWINFO_STATS_COUNT(FILES, 1);
+
 		if ((d = opendir("/sys/class/net")) != NULL)
 		{
 			while ((e = readdir(d)) != NULL)
@@ -688,6 +887,8 @@ static void nl80211_hostapd_hup(const char *ifname)
 	if (phy)
 	{
 		snprintf(buf, sizeof(buf), "/var/run/wifi-%s.pid", phy);
+		IWINFO_STATS_COUNT(FILES, 1);
+
 		if ((fd = open(buf, O_RDONLY)) > 0)
 		{
 			if (read(fd, buf, sizeof(buf)) > 0)
@@ -702,157 +903,506 @@ static void nl80211_hostapd_hup(const char *ifname)
 }
 
 
-int nl80211_probe(const char *ifname)
+/*
+ * Resident BSS table. Decoded scan entries are kept per device and keyed by
+ * BSSID, a BSS is only decoded again if the hash of its IEs changed since the
+ * last dump. The pending change flags are consumed by the delta query.
+ */
+
+#define NL80211_BSS_TABLES	4
+#define NL80211_BSS_DROP	0xff
+#define NL80211_HASH_INIT	2166136261U
+
+static struct nl80211_bss_table *bss_tables[NL80211_BSS_TABLES];
+static struct nl80211_bss_table *bss_cur = NULL;
+static const struct iwinfo_filter *scan_filter = NULL;
+
+static uint32_t nl80211_hash(uint32_t hash, const void *data, int len)
 {
-	return !!nl80211_ifname2phy(ifname);
+	const uint8_t *p = data;
+
+	/* FNV-1a */
+	while (len-- > 0)
+		hash = (hash ^ *p++) * 16777619U;
+
+	return hash;
 }
 
-void nl80211_close(void)
+static void nl80211_bss_table_free(struct nl80211_bss_table *t)
 {
-	if (nls)
+	if (t)
 	{
-		if (nls->nlctrl)
-			genl_family_put(nls->nlctrl);
+		free(t->index);
+		free(t->nodes);
+		free(t);
+	}
+}
 
-		if (nls->nl80211)
-			genl_family_put(nls->nl80211);
+static struct nl80211_bss_table * nl80211_bss_table(const char *ifname)
+{
+	int i;
+	struct nl80211_bss_table *t;
 
-		if (nls->nl_sock)
-			nl_socket_free(nls->nl_sock);
+	for (i = 0; i < NL80211_BSS_TABLES && bss_tables[i]; i++)
+		if (!strncmp(bss_tables[i]->ifname, ifname, IFNAMSIZ))
+			return bss_tables[i];
 
-		if (nls->nl_cache)
-			nl_cache_free(nls->nl_cache);
+	/* all slots taken, evict the oldest table */
+	if (i == NL80211_BSS_TABLES)
+	{
+		nl80211_bss_table_free(bss_tables[0]);
+		memmove(&bss_tables[0], &bss_tables[1],
+		        (NL80211_BSS_TABLES - 1) * sizeof(bss_tables[0]));
 
-		free(nls);
-		nls = NULL;
+		bss_tables[--i] = NULL;
 	}
-}
-
 
-static int nl80211_get_mode_cb(struct nl_msg *msg, void *arg)
-{
-	int *mode = arg;
-	struct nlattr **tb = nl80211_parse(msg);
-	const int ifmodes[NL80211_IFTYPE_MAX + 1] = {
-		IWINFO_OPMODE_UNKNOWN,		/* unspecified */
-		IWINFO_OPMODE_ADHOC,		/* IBSS */
-		IWINFO_OPMODE_CLIENT,		/* managed */
-		IWINFO_OPMODE_MASTER,		/* AP */
-		IWINFO_OPMODE_AP_VLAN,		/* AP/VLAN */
-		IWINFO_OPMODE_WDS,			/* WDS */
-		IWINFO_OPMODE_MONITOR,		/* monitor */
-		IWINFO_OPMODE_MESHPOINT,	/* mesh point */
-		IWINFO_OPMODE_P2P_CLIENT,	/* P2P-client */
-		IWINFO_OPMODE_P2P_GO,		/* P2P-GO */
-	};
+	if (!(t = calloc(1, sizeof(*t))))
+		return NULL;
 
-	if (tb[NL80211_ATTR_IFTYPE])
-		*mode = ifmodes[nla_get_u32(tb[NL80211_ATTR_IFTYPE])];
+	strncpy(t->ifname, ifname, IFNAMSIZ - 1);
+	bss_tables[i] = t;
 
-	return NL_SKIP;
+	return t;
 }
 
-int nl80211_get_mode(const char *ifname, int *buf)
+static void nl80211_bss_tables_free(void)
 {
-	char *res;
-	struct nl80211_msg_conveyor *req;
-
-	res = nl80211_phy2ifname(ifname);
-	req = nl80211_msg(res ? res : ifname, NL80211_CMD_GET_INTERFACE, 0);
-	*buf = IWINFO_OPMODE_UNKNOWN;
+	int i;
 
-	if (req)
+	for (i = 0; i < NL80211_BSS_TABLES; i++)
 	{
-		nl80211_send(req, nl80211_get_mode_cb, buf);
-		nl80211_free(req);
+		nl80211_bss_table_free(bss_tables[i]);
+		bss_tables[i] = NULL;
 	}
 
-	return (*buf == IWINFO_OPMODE_UNKNOWN) ? -1 : 0;
+	bss_cur = NULL;
 }
 
+static struct nl80211_survey *survey_tables[NL80211_SURVEY_TABLES];
 
-struct nl80211_ssid_bssid {
-	unsigned char *ssid;
-	unsigned char bssid[7];
-};
-
-static int nl80211_get_ssid_bssid_cb(struct nl_msg *msg, void *arg)
+static struct nl80211_survey * nl80211_survey_table(const char *ifname)
 {
-	int ielen;
-	unsigned char *ie;
-	struct nl80211_ssid_bssid *sb = arg;
-	struct nlattr **tb = nl80211_parse(msg);
-	struct nlattr *bss[NL80211_BSS_MAX + 1];
+	int i;
+	struct nl80211_survey *t;
 
-	static struct nla_policy bss_policy[NL80211_BSS_MAX + 1] = {
-		[NL80211_BSS_INFORMATION_ELEMENTS] = {                 },
-		[NL80211_BSS_STATUS]               = { .type = NLA_U32 },
-	};
+	for (i = 0; i < NL80211_SURVEY_TABLES && survey_tables[i]; i++)
+		if (!strncmp(survey_tables[i]->ifname, ifname, IFNAMSIZ))
+			return survey_tables[i];
 
-	if (!tb[NL80211_ATTR_BSS] ||
-	    nla_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS],
-	                     bss_policy) ||
-	    !bss[NL80211_BSS_BSSID] ||
-	    !bss[NL80211_BSS_STATUS] ||
-	    !bss[NL80211_BSS_INFORMATION_ELEMENTS])
+	/* all slots taken, evict the oldest table */
+	if (i == NL80211_SURVEY_TABLES)
 	{
-		return NL_SKIP;
+		free(survey_tables[0]);
+		memmove(&survey_tables[0], &survey_tables[1],
+		        (NL80211_SURVEY_TABLES - 1) * sizeof(survey_tables[0]));
+
+		survey_tables[--i] = NULL;
 	}
 
-	switch (nla_get_u32(bss[NL80211_BSS_STATUS]))
-	{
-	case NL80211_BSS_STATUS_ASSOCIATED:
-	case NL80211_BSS_STATUS_AUTHENTICATED:
-	case NL80211_BSS_STATUS_IBSS_JOINED:
+	if (!(t = calloc(1, sizeof(*t))))
+		return NULL;
 
-		if (sb->ssid)
-		{
-			ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
-			ielen = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	strncpy(t->ifname, ifname, IFNAMSIZ - 1);
+	survey_tables[i] = t;
 
-			while (ielen >= 2 && ielen >= ie[1])
-			{
-				if (ie[0] == 0)
-				{
-					memcpy(sb->ssid, ie + 2, min(ie[1], IWINFO_ESSID_MAX_SIZE));
-					return NL_SKIP;
-				}
+	return t;
+}
 
-				ielen -= ie[1] + 2;
-				ie += ie[1] + 2;
-			}
-		}
-		else
-		{
-			sb->bssid[0] = 1;
-			memcpy(sb->bssid + 1, nla_data(bss[NL80211_BSS_BSSID]), 6);
-			return NL_SKIP;
-		}
+static void nl80211_survey_tables_free(void)
+{
+	int i;
 
-	default:
-		return NL_SKIP;
+	for (i = 0; i < NL80211_SURVEY_TABLES; i++)
+	{
+		free(survey_tables[i]);
+		survey_tables[i] = NULL;
 	}
 }
 
-int nl80211_get_ssid(const char *ifname, char *buf)
+/*
+ * Scheduled scanning. The kernel repeats the scan by itself where the
+ * driver supports NL80211_CMD_START_SCHED_SCAN, otherwise scans are
+ * triggered whenever the interval elapsed. Result events are drained from
+ * a private "scan" group socket on every access and the kernel BSS list is
+ * dumped into a resident set that scanlist hands out without blocking.
+ */
+static struct nl80211_sched sched[NL80211_SCHED_MAX];
+static struct nl_sock *sched_sock = NULL;
+static struct nl_cb *sched_cb = NULL;
+
+static struct nl80211_sched * nl80211_sched_find(const char *ifname)
 {
-	char *res;
-	struct nl80211_msg_conveyor *req;
-	struct nl80211_ssid_bssid sb;
+	int i;
 
-	/* try to find ssid from scan dump results */
-	res = nl80211_phy2ifname(ifname);
-	req = nl80211_msg(res ? res : ifname, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
+	/* schedules are kept under the interface a radioX name resolved to */
+	if (!strncmp(ifname, "radio", 5) && !(ifname = nl80211_phy2ifname(ifname)))
+		return NULL;
 
-	sb.ssid = buf;
-	*buf = 0;
+	for (i = 0; i < NL80211_SCHED_MAX; i++)
+		if (sched[i].interval && !strncmp(sched[i].ifname, ifname, IFNAMSIZ))
+			return &sched[i];
+
+	return NULL;
+}
+
+static int nl80211_sched_request(struct nl80211_sched *s, int cmd)
+{
+	struct nlattr *ssids;
+	struct nl80211_msg_conveyor *req;
+
+	req = nl80211_msg(s->ifname, cmd, 0);
+	if (!req)
+		return -1;
+
+	if (cmd == NL80211_CMD_START_SCHED_SCAN)
+	{
+		NLA_PUT_U32(req->msg, NL80211_ATTR_SCHED_SCAN_INTERVAL, s->interval);
+
+		/* probe for the wildcard SSID instead of scanning passively */
+		if (!(ssids = nla_nest_start(req->msg, NL80211_ATTR_SCAN_SSIDS)))
+			goto nla_put_failure;
+
+		NLA_PUT(req->msg, 1, 0, "");
+		nla_nest_end(req->msg, ssids);
+	}
+
+	nl80211_send(req, NULL, NULL);
+	nl80211_free(req);
+
+	return (nls->msg_err < 0 && nls->msg_err != -EBUSY) ? -1 : 0;
+
+nla_put_failure:
+	nl80211_free(req);
+	return -1;
+}
+
+static void nl80211_sched_stop(struct nl80211_sched *s)
+{
+	if (s->kernel)
+		nl80211_sched_request(s, NL80211_CMD_STOP_SCHED_SCAN);
+
+	free(s->buf);
+	memset(s, 0, sizeof(*s));
+}
+
+static void nl80211_sched_free(void)
+{
+	int i;
+
+	for (i = 0; i < NL80211_SCHED_MAX; i++)
+		if (sched[i].interval)
+			nl80211_sched_stop(&sched[i]);
+
+	if (sched_cb)
+		nl_cb_put(sched_cb);
+
+	if (sched_sock)
+		nl_socket_free(sched_sock);
+
+	sched_sock = NULL;
+	sched_cb = NULL;
+}
+
+static int nl80211_bss_slot(struct nl80211_bss_table *t, const uint8_t *mac)
+{
+	int mask = (t->size * 2) - 1;
+	int slot = nl80211_hash(NL80211_HASH_INIT, mac, 6) & mask;
+
+	while (t->index[slot] > -1 &&
+	       memcmp(t->nodes[t->index[slot]].e.mac, mac, 6))
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+static void nl80211_bss_reindex(struct nl80211_bss_table *t)
+{
+	int i;
+
+	for (i = 0; i < t->size * 2; i++)
+		t->index[i] = -1;
+
+	for (i = 0; i < t->count; i++)
+		t->index[nl80211_bss_slot(t, t->nodes[i].e.mac)] = i;
+}
+
+static int nl80211_bss_grow(struct nl80211_bss_table *t)
+{
+	int size = t->size ? t->size * 2 : 32;
+	struct nl80211_bss_node *nodes;
+	int *index;
+
+	if (!(nodes = realloc(t->nodes, size * sizeof(*nodes))))
+		return -ENOMEM;
+
+	t->nodes = nodes;
+
+	if (!(index = realloc(t->index, size * 2 * sizeof(*index))))
+		return -ENOMEM;
+
+	t->index = index;
+	t->size  = size;
+
+	nl80211_bss_reindex(t);
+
+	return 0;
+}
+
+static struct nl80211_bss_node * nl80211_bss_lookup(struct nl80211_bss_table *t,
+                                                    const uint8_t *mac)
+{
+	int slot;
+	struct nl80211_bss_node *n;
+
+	if (t->count >= t->size && nl80211_bss_grow(t))
+		return NULL;
+
+	slot = nl80211_bss_slot(t, mac);
+
+	if (t->index[slot] > -1)
+		return &t->nodes[t->index[slot]];
+
+	n = &t->nodes[t->count];
+	memset(n, 0, sizeof(*n));
+	memcpy(n->e.mac, mac, 6);
+
+	n->change = IWINFO_BSS_ADDED;
+	t->index[slot] = t->count++;
+
+	return n;
+}
+
+/* Mark node as seen in the current dump, returns nonzero if the cached
+ * entry is stale and needs to be decoded again */
+static int nl80211_bss_touch(struct nl80211_bss_node *n, uint32_t hash)
+{
+	int stale = (!n->seen || n->iehash != hash);
+
+	if (stale && n->seen)
+		n->change |= n->known ? IWINFO_BSS_CHANGED : IWINFO_BSS_ADDED;
+
+	n->change &= ~IWINFO_BSS_REMOVED;
+	n->iehash  = hash;
+	n->seen    = bss_cur->serial;
+
+	return stale;
+}
+
+static void nl80211_bss_compact(struct nl80211_bss_table *t)
+{
+	int i, j;
+
+	for (i = 0, j = 0; i < t->count; i++)
+	{
+		if (t->nodes[i].change == NL80211_BSS_DROP)
+			continue;
+
+		if (i != j)
+			t->nodes[j] = t->nodes[i];
+
+		j++;
+	}
+
+	if (j != t->count)
+	{
+		t->count = j;
+		nl80211_bss_reindex(t);
+	}
+}
+
+static void nl80211_bss_expire(struct nl80211_bss_table *t)
+{
+	int i;
+	struct nl80211_bss_node *n;
+
+	for (i = 0, n = t->nodes; i < t->count; i++, n++)
+	{
+		if (n->seen == t->serial)
+			continue;
+
+		/* entries never reported through the delta query are dropped
+		 * silently, known ones are kept until the removal is reported */
+		n->change = n->known ? IWINFO_BSS_REMOVED : NL80211_BSS_DROP;
+	}
+
+	nl80211_bss_compact(t);
+}
+
+static void nl80211_bss_track(struct iwinfo_scanlist_entry *e)
+{
+	uint32_t hash = NL80211_HASH_INIT;
+	struct nl80211_bss_node *n;
+
+	if (!bss_cur || !(n = nl80211_bss_lookup(bss_cur, e->mac)))
+		return;
+
+	hash = nl80211_hash(hash, e->ssid, sizeof(e->ssid));
+	hash = nl80211_hash(hash, &e->mode, sizeof(e->mode));
+	hash = nl80211_hash(hash, &e->channel, sizeof(e->channel));
+	hash = nl80211_hash(hash, &e->crypto, sizeof(e->crypto));
+
+	nl80211_bss_touch(n, hash);
+
+	n->age = 0;
+	n->e = *e;
+}
+
+
+int nl80211_probe(const char *ifname)
+{
+	return !!nl80211_ifname2phy(ifname);
+}
+
+void nl80211_close(void)
+{
+	/* stop scheduled scans while the request socket is still there */
+	nl80211_sched_free();
+
+	if (nls)
+	{
+		if (nls->nlctrl)
+			genl_family_put(nls->nlctrl);
+
+		if (nls->nl80211)
+			genl_family_put(nls->nl80211);
+
+		if (nls->nl_sock)
+			nl_socket_free(nls->nl_sock);
+
+		if (nls->nl_evsock)
+			nl_socket_free(nls->nl_evsock);
+
+		if (nls->nl_cache)
+			nl_cache_free(nls->nl_cache);
+
+		free(nls);
+		nls = NULL;
+	}
+
+	nl80211_bss_tables_free();
+	nl80211_survey_tables_free();
+}
+
+
+static int nl80211_get_mode_cb(struct nl_msg *msg, void *arg)
+{
+	int *mode = arg;
+	struct nlattr **tb = nl80211_parse(msg);
+	const int ifmodes[NL80211_IFTYPE_MAX + 1] = {
+		IWINFO_OPMODE_UNKNOWN,		/* unspecified */
+		IWINFO_OPMODE_ADHOC,		/* IBSS */
+		IWINFO_OPMODE_CLIENT,		/* managed */
+		IWINFO_OPMODE_MASTER,		/* AP */
+		IWINFO_OPMODE_AP_VLAN,		/* AP/VLAN */
+		IWINFO_OPMODE_WDS,			/* WDS */
+		IWINFO_OPMODE_MONITOR,		/* monitor */
+		IWINFO_OPMODE_MESHPOINT,	/* mesh point */
+		IWINFO_OPMODE_P2P_CLIENT,	/* P2P-client */
+		IWINFO_OPMODE_P2P_GO,		/* P2P-GO */
+	};
+
+	if (tb[NL80211_ATTR_IFTYPE])
+		*mode = ifmodes[nla_get_u32(tb[NL80211_ATTR_IFTYPE])];
+
+	return NL_SKIP;
+}
+
+int nl80211_get_mode(const char *ifname, int *buf)
+{
+	char *res;
+	struct nl80211_msg_conveyor *req;
+
+	res = nl80211_phy2ifname(ifname);
+	req = nl80211_msg(res ? res : ifname, NL80211_CMD_GET_INTERFACE, 0);
+	*buf = IWINFO_OPMODE_UNKNOWN;
 
 	if (req)
 	{
-		nl80211_send(req, nl80211_get_ssid_bssid_cb, &sb);
+		nl80211_send(req, nl80211_get_mode_cb, buf);
 		nl80211_free(req);
 	}
 
+	return (*buf == IWINFO_OPMODE_UNKNOWN) ? -1 : 0;
+}
+
+
+struct nl80211_ssid_bssid {
+	unsigned char *ssid;
+	unsigned char bssid[7];
+};
+
+static int nl80211_get_ssid_bssid_cb(struct nl_msg *msg, void *arg)
+{
+	int ielen;
+	unsigned char *ie;
+	struct nl80211_ssid_bssid *sb = arg;
+	struct nlattr **tb = nl80211_parse(msg);
+	struct nlattr *bss[NL80211_BSS_MAX + 1];
+
+	static struct nla_policy bss_policy[NL80211_BSS_MAX + 1] = {
+		[NL80211_BSS_INFORMATION_ELEMENTS] = {                 },
+		[NL80211_BSS_STATUS]               = { .type = NLA_U32 },
+	};
+
+	if (!tb[NL80211_ATTR_BSS] ||
+	    nla_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS],
+	                     bss_policy) ||
+	    !bss[NL80211_BSS_BSSID] ||
+	    !bss[NL80211_BSS_STATUS] ||
+	    !bss[NL80211_BSS_INFORMATION_ELEMENTS])
+	{
+		return NL_SKIP;
+	}
+
+	switch (nla_get_u32(bss[NL80211_BSS_STATUS]))
+	{
+	case NL80211_BSS_STATUS_ASSOCIATED:
+	case NL80211_BSS_STATUS_AUTHENTICATED:
+	case NL80211_BSS_STATUS_IBSS_JOINED:
+
+		sb->bssid[0] = 1;
+		memcpy(sb->bssid + 1, nla_data(bss[NL80211_BSS_BSSID]), 6);
+
+		if (sb->ssid)
+		{
+			ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+			ielen = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+
+			while (ielen >= 2 && ielen >= ie[1] + 2)
+			{
+				if (ie[0] == 0)
+				{
+					memcpy(sb->ssid, ie + 2, min(ie[1], IWINFO_ESSID_MAX_SIZE));
+					return NL_SKIP;
+				}
+
+				ielen -= ie[1] + 2;
+				ie += ie[1] + 2;
+			}
+		}
+
+		return NL_SKIP;
+
+	default:
+		return NL_SKIP;
+	}
+}
+
+int nl80211_get_ssid(const char *ifname, char *buf)
+{
+	char *res;
+	struct nl80211_ssid_bssid sb;
+
+	/* try to find ssid from scan dump results */
+	res = nl80211_phy2ifname(ifname);
+
+	sb.ssid = buf;
+	*buf = 0;
+
+	nl80211_dump(res ? res : ifname, NL80211_CMD_GET_SCAN,
+	             nl80211_get_ssid_bssid_cb, &sb, sizeof(sb));
+
 	/* failed, try to find from hostapd info */
 	if ((*buf == 0) &&
 	    (res = nl80211_hostapd_info(ifname)) &&
@@ -867,21 +1417,16 @@ int nl80211_get_ssid(const char *ifname, char *buf)
 int nl80211_get_bssid(const char *ifname, char *buf)
 {
 	char *res;
-	struct nl80211_msg_conveyor *req;
 	struct nl80211_ssid_bssid sb;
 
 	/* try to find bssid from scan dump results */
 	res = nl80211_phy2ifname(ifname);
-	req = nl80211_msg(res ? res : ifname, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
 
 	sb.ssid = NULL;
 	sb.bssid[0] = 0;
 
-	if (req)
-	{
-		nl80211_send(req, nl80211_get_ssid_bssid_cb, &sb);
-		nl80211_free(req);
-	}
+	nl80211_dump(res ? res : ifname, NL80211_CMD_GET_SCAN,
+	             nl80211_get_ssid_bssid_cb, &sb, sizeof(sb));
 
 	/* failed, try to find mac from hostapd info */
 	if ((sb.bssid[0] == 0) &&
@@ -973,14 +1518,9 @@ int nl80211_get_frequency(const char *ifname, int *buf)
 		if (*buf == 0)
 		{
 			res = nl80211_phy2ifname(ifname);
-			req = nl80211_msg(res ? res : ifname, NL80211_CMD_GET_SCAN,
-			                  NLM_F_DUMP);
 
-			if (req)
-			{
-				nl80211_send(req, nl80211_get_frequency_scan_cb, buf);
-				nl80211_free(req);
-			}
+			nl80211_dump(res ? res : ifname, NL80211_CMD_GET_SCAN,
+			             nl80211_get_frequency_scan_cb, buf, sizeof(*buf));
 		}
 	}
 
@@ -1081,11 +1621,12 @@ static void nl80211_fill_signal(const char *ifname, struct nl80211_rssi_rate *r)
 {
 	DIR *d;
 	struct dirent *de;
-	struct nl80211_msg_conveyor *req;
 
 	r->rssi = 0;
 	r->rate = 0;
 
+	IWINFO_STATS_COUNT(FILES, 1);
+
 	if ((d = opendir("/sys/class/net")) != NULL)
 	{
 		while ((de = readdir(d)) != NULL)
@@ -1094,14 +1635,8 @@ static void nl80211_fill_signal(const char *ifname, struct nl80211_rssi_rate *r)
 			    (!de->d_name[strlen(ifname)] ||
 			     !strncmp(&de->d_name[strlen(ifname)], ".sta", 4)))
 			{
-				req = nl80211_msg(de->d_name, NL80211_CMD_GET_STATION,
-				                  NLM_F_DUMP);
-
-				if (req)
-				{
-					nl80211_send(req, nl80211_fill_signal_cb, r);
-					nl80211_free(req);
-				}
+				nl80211_dump(de->d_name, NL80211_CMD_GET_STATION,
+				             nl80211_fill_signal_cb, r, sizeof(*r));
 			}
 		}
 
@@ -1139,83 +1674,192 @@ int nl80211_get_signal(const char *ifname, int *buf)
 	return -1;
 }
 
-static int nl80211_get_noise_cb(struct nl_msg *msg, void *arg)
+static int nl80211_get_survey_cb(struct nl_msg *msg, void *arg)
 {
-	int8_t *noise = arg;
+	struct nl80211_survey_dump *sd = arg;
+	struct iwinfo_survey_entry *e;
 	struct nlattr **tb = nl80211_parse(msg);
 	struct nlattr *si[NL80211_SURVEY_INFO_MAX + 1];
 
 	static struct nla_policy sp[NL80211_SURVEY_INFO_MAX + 1] = {
-		[NL80211_SURVEY_INFO_FREQUENCY] = { .type = NLA_U32 },
-		[NL80211_SURVEY_INFO_NOISE]     = { .type = NLA_U8  },
+		[NL80211_SURVEY_INFO_FREQUENCY]              = { .type = NLA_U32 },
+		[NL80211_SURVEY_INFO_NOISE]                  = { .type = NLA_U8  },
+		[NL80211_SURVEY_INFO_CHANNEL_TIME]           = { .type = NLA_U64 },
+		[NL80211_SURVEY_INFO_CHANNEL_TIME_BUSY]      = { .type = NLA_U64 },
+		[NL80211_SURVEY_INFO_CHANNEL_TIME_EXT_BUSY]  = { .type = NLA_U64 },
+		[NL80211_SURVEY_INFO_CHANNEL_TIME_RX]        = { .type = NLA_U64 },
+		[NL80211_SURVEY_INFO_CHANNEL_TIME_TX]        = { .type = NLA_U64 },
 	};
 
-	if (!tb[NL80211_ATTR_SURVEY_INFO])
+	if (!tb[NL80211_ATTR_SURVEY_INFO] || sd->count >= NL80211_SURVEY_MAX)
 		return NL_SKIP;
 
 	if (nla_parse_nested(si, NL80211_SURVEY_INFO_MAX,
 	                     tb[NL80211_ATTR_SURVEY_INFO], sp))
 		return NL_SKIP;
 
-	if (!si[NL80211_SURVEY_INFO_NOISE])
+	if (!si[NL80211_SURVEY_INFO_FREQUENCY])
 		return NL_SKIP;
 
-	if (!*noise || si[NL80211_SURVEY_INFO_IN_USE])
-		*noise = (int8_t)nla_get_u8(si[NL80211_SURVEY_INFO_NOISE]);
+	e = &sd->e[sd->count++];
+	memset(e, 0, sizeof(*e));
+
+	e->mhz = nla_get_u32(si[NL80211_SURVEY_INFO_FREQUENCY]);
+	e->channel = nl80211_freq2channel(e->mhz);
+	e->in_use = !!si[NL80211_SURVEY_INFO_IN_USE];
+
+	if (si[NL80211_SURVEY_INFO_NOISE])
+		e->noise = (int8_t)nla_get_u8(si[NL80211_SURVEY_INFO_NOISE]);
+
+	if (si[NL80211_SURVEY_INFO_CHANNEL_TIME])
+		e->time = nla_get_u64(si[NL80211_SURVEY_INFO_CHANNEL_TIME]);
+
+	if (si[NL80211_SURVEY_INFO_CHANNEL_TIME_BUSY])
+		e->time_busy = nla_get_u64(si[NL80211_SURVEY_INFO_CHANNEL_TIME_BUSY]);
+
+	if (si[NL80211_SURVEY_INFO_CHANNEL_TIME_EXT_BUSY])
+		e->time_ext_busy =
+			nla_get_u64(si[NL80211_SURVEY_INFO_CHANNEL_TIME_EXT_BUSY]);
+
+	if (si[NL80211_SURVEY_INFO_CHANNEL_TIME_RX])
+		e->time_rx = nla_get_u64(si[NL80211_SURVEY_INFO_CHANNEL_TIME_RX]);
+
+	if (si[NL80211_SURVEY_INFO_CHANNEL_TIME_TX])
+		e->time_tx = nla_get_u64(si[NL80211_SURVEY_INFO_CHANNEL_TIME_TX]);
 
 	return NL_SKIP;
 }
 
+static uint16_t nl80211_survey_ratio(uint64_t cur, uint64_t prev, uint64_t dt)
+{
+	uint64_t d = (cur > prev) ? (cur - prev) : 0;
 
-int nl80211_get_noise(const char *ifname, int *buf)
+	return (d >= dt) ? 10000 : (d * 10000) / dt;
+}
+
+static void nl80211_survey_delta(struct iwinfo_survey_entry *e,
+                                 const struct iwinfo_survey_entry *prev)
 {
-	int8_t noise;
-	struct nl80211_msg_conveyor *req;
+	uint64_t dt;
 
-	req = nl80211_msg(ifname, NL80211_CMD_GET_SURVEY, NLM_F_DUMP);
-	if (req)
+	/* new channel or counters reset, nothing to compare against */
+	if (!prev || e->time < prev->time)
+		return;
+
+	/* off-channel counters only move during scans, keep the last ratios */
+	if (!(dt = e->time - prev->time))
 	{
-		noise = 0;
+		e->interval   = prev->interval;
+		e->busy_ratio = prev->busy_ratio;
+		e->rx_ratio   = prev->rx_ratio;
+		e->tx_ratio   = prev->tx_ratio;
+		return;
+	}
 
-		nl80211_send(req, nl80211_get_noise_cb, &noise);
-		nl80211_free(req);
+	e->interval   = dt;
+	e->busy_ratio = nl80211_survey_ratio(e->time_busy, prev->time_busy, dt);
+	e->rx_ratio   = nl80211_survey_ratio(e->time_rx, prev->time_rx, dt);
+	e->tx_ratio   = nl80211_survey_ratio(e->time_tx, prev->time_tx, dt);
+}
 
-		if (noise)
-		{
-			*buf = noise;
-			return 0;
-		}
+/* Survey results are shared by noise, assoclist and survey queries and
+ * only refreshed once NL80211_SURVEY_TTL has passed, so one poll of an
+ * interface costs a single dump. Ratios are computed against the entry
+ * of the same frequency from the previous dump. */
+static struct nl80211_survey * nl80211_survey_get(const char *ifname)
+{
+	int i, j;
+	uint64_t now = iwinfo_msecs();
+	struct nl80211_survey *t;
+	struct iwinfo_survey_entry e[NL80211_SURVEY_MAX];
+	struct nl80211_survey_dump sd = { .e = e };
+
+	if (!(t = nl80211_survey_table(ifname)))
+		return NULL;
+
+	if (t->stamp && (now - t->stamp) < NL80211_SURVEY_TTL)
+		return t->valid ? t : NULL;
+
+	t->stamp = now;
+	t->valid = !nl80211_dump(ifname, NL80211_CMD_GET_SURVEY,
+	                         nl80211_get_survey_cb, &sd, sizeof(sd));
+
+	if (!t->valid)
+		return NULL;
+
+	for (i = 0; i < sd.count; i++)
+	{
+		for (j = 0; j < t->count && t->e[j].mhz != e[i].mhz; j++);
+		nl80211_survey_delta(&e[i], (j < t->count) ? &t->e[j] : NULL);
+	}
+
+	memcpy(t->e, e, sd.count * sizeof(*e));
+	t->count = sd.count;
+
+	return t;
+}
+
+int nl80211_get_noise(const char *ifname, int *buf)
+{
+	int i;
+	int8_t noise = 0;
+	struct nl80211_survey *t = nl80211_survey_get(ifname);
+
+	if (!t)
+		return -1;
+
+	/* prefer the channel in use, else the first one reporting noise */
+	for (i = 0; i < t->count; i++)
+		if (t->e[i].noise && (!noise || t->e[i].in_use))
+			noise = t->e[i].noise;
+
+	if (noise)
+	{
+		*buf = noise;
+		return 0;
 	}
 
 	return -1;
 }
 
+int nl80211_get_survey(const char *ifname, char *buf, int *len)
+{
+	struct nl80211_survey *t = nl80211_survey_get(ifname);
+
+	if (!t)
+		return -1;
+
+	memcpy(buf, t->e, t->count * sizeof(struct iwinfo_survey_entry));
+	*len = t->count * sizeof(struct iwinfo_survey_entry);
+
+	return 0;
+}
+
+static int nl80211_signal2quality(int signal)
+{
+	/* A positive signal level is usually just a quality
+	 * value, pass through as-is */
+	if (signal >= 0)
+		return signal;
+
+	/* The cfg80211 wext compat layer assumes a signal range
+	 * of -110 dBm to -40 dBm, the quality value is derived
+	 * by adding 110 to the signal level */
+	if (signal < -110)
+		signal = -110;
+	else if (signal > -40)
+		signal = -40;
+
+	return (signal + 110);
+}
+
 int nl80211_get_quality(const char *ifname, int *buf)
 {
 	int signal;
 
 	if (!nl80211_get_signal(ifname, &signal))
 	{
-		/* A positive signal level is usually just a quality
-		 * value, pass through as-is */
-		if (signal >= 0)
-		{
-			*buf = signal;
-		}
-
-		/* The cfg80211 wext compat layer assumes a signal range
-		 * of -110 dBm to -40 dBm, the quality value is derived
-		 * by adding 110 to the signal level */
-		else
-		{
-			if (signal < -110)
-				signal = -110;
-			else if (signal > -40)
-				signal = -40;
-
-			*buf = (signal + 110);
-		}
-
+		*buf = nl80211_signal2quality(signal);
 		return 0;
 	}
 
@@ -1231,6 +1875,23 @@ int nl80211_get_quality_max(const char *ifname, int *buf)
 	return 0;
 }
 
+/* Match a whole word within a space separated hostapd list */
+static int nl80211_hastoken(const char *list, const char *tok)
+{
+	int len = strlen(tok);
+	const char *p = list;
+
+	while ((p = strstr(p, tok)) != NULL)
+	{
+		if ((p == list || p[-1] == ' ') && (!p[len] || p[len] == ' '))
+			return 1;
+
+		p += len;
+	}
+
+	return 0;
+}
+
 int nl80211_get_encryption(const char *ifname, char *buf)
 {
 	int i;
@@ -1251,8 +1912,9 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 			else if (strstr(val, "WEP-104"))
 				c->pair_ciphers |= IWINFO_CIPHER_WEP104;
 
-			c->enabled       = 1;
-			c->group_ciphers = c->pair_ciphers;
+			c->enabled           = 1;
+			c->group_ciphers     = c->pair_ciphers;
+			c->group_ciphers_ext = c->pair_ciphers_ext;
 
 			c->auth_suites |= IWINFO_KMGMT_NONE;
 			c->auth_algs   |= IWINFO_AUTH_OPEN; /* XXX: assumption */
@@ -1264,9 +1926,18 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 			if (strstr(val, "TKIP"))
 				c->pair_ciphers |= IWINFO_CIPHER_TKIP;
 
+			else if (strstr(val, "CCMP-256"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_CCMP256);
+
+			else if (strstr(val, "GCMP-256"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_GCMP256);
+
 			else if (strstr(val, "CCMP"))
 				c->pair_ciphers |= IWINFO_CIPHER_CCMP;
 
+			else if (strstr(val, "GCMP"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_GCMP);
+
 			else if (strstr(val, "NONE"))
 				c->pair_ciphers |= IWINFO_CIPHER_NONE;
 
@@ -1282,9 +1953,18 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 				if (strstr(val, "TKIP"))
 					c->group_ciphers |= IWINFO_CIPHER_TKIP;
 
+				else if (strstr(val, "CCMP-256"))
+					IWINFO_CRYPTO_ADD_CIPHERS(c, group, IWINFO_CIPHER_CCMP256);
+
+				else if (strstr(val, "GCMP-256"))
+					IWINFO_CRYPTO_ADD_CIPHERS(c, group, IWINFO_CIPHER_GCMP256);
+
 				else if (strstr(val, "CCMP"))
 					c->group_ciphers |= IWINFO_CIPHER_CCMP;
 
+				else if (strstr(val, "GCMP"))
+					IWINFO_CRYPTO_ADD_CIPHERS(c, group, IWINFO_CIPHER_GCMP);
+
 				else if (strstr(val, "NONE"))
 					c->group_ciphers |= IWINFO_CIPHER_NONE;
 
@@ -1298,7 +1978,8 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 
 			if ((val = nl80211_getval(NULL, res, "key_mgmt")))
 			{
-				if (strstr(val, "WPA2"))
+				if (strstr(val, "WPA2") || strstr(val, "SAE") ||
+				    strstr(val, "OWE"))
 					c->wpa_version = 2;
 
 				else if (strstr(val, "WPA"))
@@ -1308,6 +1989,12 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 				if (strstr(val, "PSK"))
 					c->auth_suites |= IWINFO_KMGMT_PSK;
 
+				else if (strstr(val, "SAE"))
+					c->auth_suites |= IWINFO_KMGMT_SAE;
+
+				else if (strstr(val, "OWE"))
+					c->auth_suites |= IWINFO_KMGMT_OWE;
+
 				else if (strstr(val, "EAP") || strstr(val, "802.1X"))
 					c->auth_suites |= IWINFO_KMGMT_8021x;
 
@@ -1335,6 +2022,12 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 		if (val && strstr(val, "EAP"))
 			c->auth_suites |= IWINFO_KMGMT_8021x;
 
+		if (val && strstr(val, "SAE"))
+			c->auth_suites |= IWINFO_KMGMT_SAE;
+
+		if (val && strstr(val, "OWE"))
+			c->auth_suites |= IWINFO_KMGMT_OWE;
+
 		if (val && strstr(val, "NONE"))
 			c->auth_suites |= IWINFO_KMGMT_NONE;
 
@@ -1343,9 +2036,18 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 			if (strstr(val, "TKIP"))
 				c->pair_ciphers |= IWINFO_CIPHER_TKIP;
 
-			if (strstr(val, "CCMP"))
+			if (strstr(val, "CCMP-256"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_CCMP256);
+
+			if (strstr(val, "GCMP-256"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_GCMP256);
+
+			if (nl80211_hastoken(val, "CCMP"))
 				c->pair_ciphers |= IWINFO_CIPHER_CCMP;
 
+			if (nl80211_hastoken(val, "GCMP"))
+				IWINFO_CRYPTO_ADD_CIPHERS(c, pair, IWINFO_CIPHER_GCMP);
+
 			if (strstr(val, "NONE"))
 				c->pair_ciphers |= IWINFO_CIPHER_NONE;
 		}
@@ -1386,7 +2088,8 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 		}
 
 		c->group_ciphers = c->pair_ciphers;
-		c->enabled = (c->wpa_version || c->pair_ciphers) ? 1 : 0;
+		c->group_ciphers_ext = c->pair_ciphers_ext;
+		c->enabled = (c->wpa_version || IWINFO_CRYPTO_CIPHERS(c, pair)) ? 1 : 0;
 
 		return 0;
 	}
@@ -1395,23 +2098,11 @@ int nl80211_get_encryption(const char *ifname, char *buf)
 }
 
 
-static int nl80211_get_assoclist_cb(struct nl_msg *msg, void *arg)
+static void nl80211_get_assoclist_rate(struct nlattr *attr,
+                                       struct iwinfo_rate_entry *re)
 {
-	struct nl80211_array_buf *arr = arg;
-	struct iwinfo_assoclist_entry *e = arr->buf;
-	struct nlattr **attr = nl80211_parse(msg);
-	struct nlattr *sinfo[NL80211_STA_INFO_MAX + 1];
 	struct nlattr *rinfo[NL80211_RATE_INFO_MAX + 1];
 
-	static struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
-		[NL80211_STA_INFO_INACTIVE_TIME] = { .type = NLA_U32    },
-		[NL80211_STA_INFO_RX_PACKETS]    = { .type = NLA_U32    },
-		[NL80211_STA_INFO_TX_PACKETS]    = { .type = NLA_U32    },
-		[NL80211_STA_INFO_RX_BITRATE]    = { .type = NLA_NESTED },
-		[NL80211_STA_INFO_TX_BITRATE]    = { .type = NLA_NESTED },
-		[NL80211_STA_INFO_SIGNAL]        = { .type = NLA_U8     },
-	};
-
 	static struct nla_policy rate_policy[NL80211_RATE_INFO_MAX + 1] = {
 		[NL80211_RATE_INFO_BITRATE]      = { .type = NLA_U16    },
 		[NL80211_RATE_INFO_MCS]          = { .type = NLA_U8     },
@@ -1419,80 +2110,133 @@ static int nl80211_get_assoclist_cb(struct nl_msg *msg, void *arg)
 		[NL80211_RATE_INFO_SHORT_GI]     = { .type = NLA_FLAG   },
 	};
 
-	/* advance to end of array */
-	e += arr->count;
-	memset(e, 0, sizeof(*e));
+	if (!attr ||
+	    nla_parse_nested(rinfo, NL80211_RATE_INFO_MAX, attr, rate_policy))
+		return;
+
+	if (rinfo[NL80211_RATE_INFO_BITRATE])
+		re->rate = nla_get_u16(rinfo[NL80211_RATE_INFO_BITRATE]) * 100;
+
+	if (rinfo[NL80211_RATE_INFO_MCS])
+		re->mcs = nla_get_u8(rinfo[NL80211_RATE_INFO_MCS]);
+
+	if (rinfo[NL80211_RATE_INFO_40_MHZ_WIDTH])
+		re->is_40mhz = 1;
+
+	if (rinfo[NL80211_RATE_INFO_SHORT_GI])
+		re->is_short_gi = 1;
+}
+
+static int nl80211_get_assoclist_cb(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_assoclist *al = arg;
+	const struct iwinfo_filter *f = al->filter;
+	struct iwinfo_assoclist_ext_entry e = { { { 0 } } };
+	struct nlattr **attr = nl80211_parse(msg);
+	struct nlattr *sinfo[NL80211_STA_INFO_MAX + 1] = { 0 };
+	uint32_t fields = (f && f->fields) ? f->fields : ~0U;
+
+	static struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
+		[NL80211_STA_INFO_INACTIVE_TIME]  = { .type = NLA_U32    },
+		[NL80211_STA_INFO_CONNECTED_TIME] = { .type = NLA_U32    },
+		[NL80211_STA_INFO_RX_PACKETS]     = { .type = NLA_U32    },
+		[NL80211_STA_INFO_TX_PACKETS]     = { .type = NLA_U32    },
+		[NL80211_STA_INFO_RX_BYTES]       = { .type = NLA_U32    },
+		[NL80211_STA_INFO_TX_BYTES]       = { .type = NLA_U32    },
+		[NL80211_STA_INFO_RX_BYTES64]     = { .type = NLA_U64    },
+		[NL80211_STA_INFO_TX_BYTES64]     = { .type = NLA_U64    },
+		[NL80211_STA_INFO_TX_RETRIES]     = { .type = NLA_U32    },
+		[NL80211_STA_INFO_TX_FAILED]      = { .type = NLA_U32    },
+		[NL80211_STA_INFO_BEACON_LOSS]    = { .type = NLA_U32    },
+		[NL80211_STA_INFO_RX_BITRATE]     = { .type = NLA_NESTED },
+		[NL80211_STA_INFO_TX_BITRATE]     = { .type = NLA_NESTED },
+		[NL80211_STA_INFO_SIGNAL]         = { .type = NLA_U8     },
+	};
 
 	if (attr[NL80211_ATTR_MAC])
-		memcpy(e->mac, nla_data(attr[NL80211_ATTR_MAC]), 6);
+		memcpy(e.base.mac, nla_data(attr[NL80211_ATTR_MAC]), 6);
 
-	if (attr[NL80211_ATTR_STA_INFO] &&
-	    !nla_parse_nested(sinfo, NL80211_STA_INFO_MAX,
-	                      attr[NL80211_ATTR_STA_INFO], stats_policy))
-	{
-		if (sinfo[NL80211_STA_INFO_SIGNAL])
-			e->signal = nla_get_u8(sinfo[NL80211_STA_INFO_SIGNAL]);
+	if (attr[NL80211_ATTR_STA_INFO])
+		nla_parse_nested(sinfo, NL80211_STA_INFO_MAX,
+		                 attr[NL80211_ATTR_STA_INFO], stats_policy);
+
+	if (sinfo[NL80211_STA_INFO_SIGNAL])
+		e.base.signal = nla_get_u8(sinfo[NL80211_STA_INFO_SIGNAL]);
 
-		if (sinfo[NL80211_STA_INFO_INACTIVE_TIME])
-			e->inactive = nla_get_u32(sinfo[NL80211_STA_INFO_INACTIVE_TIME]);
+	if (sinfo[NL80211_STA_INFO_INACTIVE_TIME])
+		e.base.inactive = nla_get_u32(sinfo[NL80211_STA_INFO_INACTIVE_TIME]);
 
+	/* reject before decoding anything nested */
+	if (f && !iwinfo_filter_assoc(f, &e.base))
+		return NL_SKIP;
+
+	if (fields & IWINFO_FIELD_COUNTERS)
+	{
 		if (sinfo[NL80211_STA_INFO_RX_PACKETS])
-			e->rx_packets = nla_get_u32(sinfo[NL80211_STA_INFO_RX_PACKETS]);
+			e.rx_packets = nla_get_u32(sinfo[NL80211_STA_INFO_RX_PACKETS]);
 
 		if (sinfo[NL80211_STA_INFO_TX_PACKETS])
-			e->tx_packets = nla_get_u32(sinfo[NL80211_STA_INFO_TX_PACKETS]);
+			e.tx_packets = nla_get_u32(sinfo[NL80211_STA_INFO_TX_PACKETS]);
 
-		if (sinfo[NL80211_STA_INFO_RX_BITRATE] &&
-		    !nla_parse_nested(rinfo, NL80211_RATE_INFO_MAX,
-		                      sinfo[NL80211_STA_INFO_RX_BITRATE], rate_policy))
-		{
-			if (rinfo[NL80211_RATE_INFO_BITRATE])
-				e->rx_rate.rate =
-					nla_get_u16(rinfo[NL80211_RATE_INFO_BITRATE]) * 100;
+		e.base.rx_packets = e.rx_packets;
+		e.base.tx_packets = e.tx_packets;
 
-			if (rinfo[NL80211_RATE_INFO_MCS])
-				e->rx_rate.mcs = nla_get_u8(rinfo[NL80211_RATE_INFO_MCS]);
+		/* prefer the 64 bit byte counters of newer kernels */
+		if (sinfo[NL80211_STA_INFO_RX_BYTES64])
+			e.rx_bytes = nla_get_u64(sinfo[NL80211_STA_INFO_RX_BYTES64]);
+		else if (sinfo[NL80211_STA_INFO_RX_BYTES])
+			e.rx_bytes = nla_get_u32(sinfo[NL80211_STA_INFO_RX_BYTES]);
 
-			if (rinfo[NL80211_RATE_INFO_40_MHZ_WIDTH])
-				e->rx_rate.is_40mhz = 1;
+		if (sinfo[NL80211_STA_INFO_TX_BYTES64])
+			e.tx_bytes = nla_get_u64(sinfo[NL80211_STA_INFO_TX_BYTES64]);
+		else if (sinfo[NL80211_STA_INFO_TX_BYTES])
+			e.tx_bytes = nla_get_u32(sinfo[NL80211_STA_INFO_TX_BYTES]);
 
-			if (rinfo[NL80211_RATE_INFO_SHORT_GI])
-				e->rx_rate.is_short_gi = 1;
-		}
+		if (sinfo[NL80211_STA_INFO_TX_RETRIES])
+			e.tx_retries = nla_get_u32(sinfo[NL80211_STA_INFO_TX_RETRIES]);
 
-		if (sinfo[NL80211_STA_INFO_TX_BITRATE] &&
-		    !nla_parse_nested(rinfo, NL80211_RATE_INFO_MAX,
-		                      sinfo[NL80211_STA_INFO_TX_BITRATE], rate_policy))
-		{
-			if (rinfo[NL80211_RATE_INFO_BITRATE])
-				e->tx_rate.rate =
-					nla_get_u16(rinfo[NL80211_RATE_INFO_BITRATE]) * 100;
+		if (sinfo[NL80211_STA_INFO_TX_FAILED])
+			e.tx_failed = nla_get_u32(sinfo[NL80211_STA_INFO_TX_FAILED]);
 
-			if (rinfo[NL80211_RATE_INFO_MCS])
-				e->tx_rate.mcs = nla_get_u8(rinfo[NL80211_RATE_INFO_MCS]);
+		if (sinfo[NL80211_STA_INFO_BEACON_LOSS])
+			e.beacon_loss = nla_get_u32(sinfo[NL80211_STA_INFO_BEACON_LOSS]);
+	}
 
-			if (rinfo[NL80211_RATE_INFO_40_MHZ_WIDTH])
-				e->tx_rate.is_40mhz = 1;
+	if (sinfo[NL80211_STA_INFO_CONNECTED_TIME])
+		e.connected_time = nla_get_u32(sinfo[NL80211_STA_INFO_CONNECTED_TIME]);
 
-			if (rinfo[NL80211_RATE_INFO_SHORT_GI])
-				e->tx_rate.is_short_gi = 1;
-		}
+	if (fields & IWINFO_FIELD_RATES)
+	{
+		nl80211_get_assoclist_rate(sinfo[NL80211_STA_INFO_RX_BITRATE],
+		                           &e.base.rx_rate);
+		nl80211_get_assoclist_rate(sinfo[NL80211_STA_INFO_TX_BITRATE],
+		                           &e.base.tx_rate);
 	}
 
-	e->noise = 0; /* filled in by caller */
-	arr->count++;
+	e.base.noise = 0; /* filled in by caller */
+
+	if (f && f->top)
+		iwinfo_topn_push(al->e, &al->count, min(f->top, NL80211_ASSOCLIST_MAX),
+		                 sizeof(e), &e, iwinfo_assoc_signal);
+	else if (al->count < NL80211_ASSOCLIST_MAX)
+		al->e[al->count++] = e;
 
 	return NL_SKIP;
 }
 
-int nl80211_get_assoclist(const char *ifname, char *buf, int *len)
+int nl80211_get_assoclist_filter(const char *ifname,
+                                 const struct iwinfo_filter *f,
+                                 char *buf, int *len)
 {
 	DIR *d;
 	int i, noise = 0;
 	struct dirent *de;
-	struct nl80211_msg_conveyor *req;
-	struct nl80211_array_buf arr = { .buf = buf, .count = 0 };
-	struct iwinfo_assoclist_entry *e;
+	struct nl80211_assoclist al = {
+		.e = (struct iwinfo_assoclist_ext_entry *)buf,
+		.filter = f
+	};
+
+	IWINFO_STATS_COUNT(FILES, 1);
 
 	if ((d = opendir("/sys/class/net")) != NULL)
 	{
@@ -1502,30 +2246,94 @@ int nl80211_get_assoclist(const char *ifname, char *buf, int *len)
 			    (!de->d_name[strlen(ifname)] ||
 			     !strncmp(&de->d_name[strlen(ifname)], ".sta", 4)))
 			{
-				req = nl80211_msg(de->d_name, NL80211_CMD_GET_STATION,
-				                  NLM_F_DUMP);
-
-				if (req)
-				{
-					nl80211_send(req, nl80211_get_assoclist_cb, &arr);
-					nl80211_free(req);
-				}
+				nl80211_dump(de->d_name, NL80211_CMD_GET_STATION,
+				             nl80211_get_assoclist_cb, &al, sizeof(al));
 			}
 		}
 
 		closedir(d);
 
 		if (!nl80211_get_noise(ifname, &noise))
-			for (i = 0, e = arr.buf; i < arr.count; i++, e++)
-				e->noise = noise;
+			for (i = 0; i < al.count; i++)
+				al.e[i].base.noise = noise;
 
-		*len = (arr.count * sizeof(struct iwinfo_assoclist_entry));
+		if (f && f->top)
+			iwinfo_topn_sort(al.e, al.count, sizeof(*al.e), iwinfo_assoc_signal);
+
+		*len = (al.count * sizeof(struct iwinfo_assoclist_ext_entry));
 		return 0;
 	}
 
 	return -1;
 }
 
+int nl80211_get_assoclist_ext(const char *ifname, char *buf, int *len)
+{
+	return nl80211_get_assoclist_filter(ifname, NULL, buf, len);
+}
+
+int nl80211_get_assoclist(const char *ifname, char *buf, int *len)
+{
+	if (nl80211_get_assoclist_filter(ifname, NULL, buf, len))
+		return -1;
+
+	iwinfo_assoclist_narrow(buf, len);
+	return 0;
+}
+
+static int nl80211_get_station_dev(const char *ifname, const uint8_t *mac,
+                                   struct nl80211_assoclist *al)
+{
+	struct nl80211_msg_conveyor *req;
+
+	req = nl80211_msg(ifname, NL80211_CMD_GET_STATION, 0);
+	if (!req)
+		return -1;
+
+	NLA_PUT(req->msg, NL80211_ATTR_MAC, 6, mac);
+	nl80211_send(req, nl80211_get_assoclist_cb, al);
+
+nla_put_failure:
+	nl80211_free(req);
+	return al->count ? 0 : -1;
+}
+
+int nl80211_get_station(const char *ifname, const uint8_t *mac,
+                        struct iwinfo_assoclist_ext_entry *e)
+{
+	DIR *d;
+	int found, noise;
+	struct dirent *de;
+	size_t len = strlen(ifname);
+	struct nl80211_assoclist al = { .e = e };
+
+	found = !nl80211_get_station_dev(ifname, mac, &al);
+
+	/* WDS peers live on <ifname>.staN, only look there on a miss */
+	if (!found)
+	{
+		IWINFO_STATS_COUNT(FILES, 1);
+
+		if ((d = opendir("/sys/class/net")) != NULL)
+		{
+			while (!found && (de = readdir(d)) != NULL)
+				if (!strncmp(de->d_name, ifname, len) &&
+				    !strncmp(&de->d_name[len], ".sta", 4))
+					found = !nl80211_get_station_dev(de->d_name, mac, &al);
+
+			closedir(d);
+		}
+	}
+
+	if (!found)
+		return -1;
+
+	if (!nl80211_get_noise(ifname, &noise))
+		e->base.noise = noise;
+
+	return 0;
+}
+
 static int nl80211_get_txpwrlist_cb(struct nl_msg *msg, void *arg)
 {
 	int *dbm_max = arg;
@@ -1620,353 +2428,1581 @@ int nl80211_get_txpwrlist(const char *ifname, char *buf, int *len)
 	return -1;
 }
 
-static void nl80211_get_scancrypto(const char *spec,
-	struct iwinfo_crypto_entry *c)
-{
-	if (strstr(spec, "WPA") || strstr(spec, "WEP"))
-	{
-		c->enabled = 1;
+struct nl80211_scanlist {
+	struct iwinfo_scanlist_entry *e;
+	struct iwinfo_scanlist_entry *base;
+	int len;
+	int partial;
+};
 
-		if (strstr(spec, "WPA2-") && strstr(spec, "WPA-"))
-			c->wpa_version = 3;
+#define NL80211_SCANLIST_MAX \
+	(IWINFO_BUFSIZE / sizeof(struct iwinfo_scanlist_entry))
 
-		else if (strstr(spec, "WPA2"))
-			c->wpa_version = 2;
 
-		else if (strstr(spec, "WPA"))
-			c->wpa_version = 1;
+struct nl80211_wpactl_suite {
+	const char *name;
+	uint8_t len;
+	uint8_t kmgmt;
+	uint16_t cipher;
+};
 
-		else if (strstr(spec, "WEP"))
-			c->auth_algs = IWINFO_AUTH_OPEN | IWINFO_AUTH_SHARED;
+#define NL80211_WPACTL_SUITE(n, k, c)	{ n, sizeof(n) - 1, k, c }
+
+/* Longer names first, FT and SHA-256 variants match their base AKM */
+static const struct nl80211_wpactl_suite nl80211_wpactl_suites[] = {
+	NL80211_WPACTL_SUITE("PSK",      IWINFO_KMGMT_PSK,   0),
+	NL80211_WPACTL_SUITE("EAP",      IWINFO_KMGMT_8021x, 0),
+	NL80211_WPACTL_SUITE("SAE",      IWINFO_KMGMT_SAE,   0),
+	NL80211_WPACTL_SUITE("OWE",      IWINFO_KMGMT_OWE,   0),
+	NL80211_WPACTL_SUITE("None",     IWINFO_KMGMT_NONE,  0),
+	NL80211_WPACTL_SUITE("CCMP-256", 0, IWINFO_CIPHER_CCMP256),
+	NL80211_WPACTL_SUITE("GCMP-256", 0, IWINFO_CIPHER_GCMP256),
+	NL80211_WPACTL_SUITE("CCMP",     0, IWINFO_CIPHER_CCMP),
+	NL80211_WPACTL_SUITE("GCMP",     0, IWINFO_CIPHER_GCMP),
+	NL80211_WPACTL_SUITE("TKIP",     0, IWINFO_CIPHER_TKIP),
+	{ NULL }
+};
 
+#define NL80211_WPACTL_BSS_MASK \
+	(0x1 /* id */ | 0x2 /* bssid */ | 0x4 /* freq */ | 0x80 /* level */ | \
+	 0x800 /* flags */ | 0x1000 /* ssid */ | 0x20000 /* delimiter */)
 
-		if (strstr(spec, "PSK"))
-			c->auth_suites |= IWINFO_KMGMT_PSK;
+static inline int nl80211_wpactl_nibble(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	else if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	else if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
 
-		if (strstr(spec, "802.1X") || strstr(spec, "EAP"))
-			c->auth_suites |= IWINFO_KMGMT_8021x;
+	return -1;
+}
 
-		if (strstr(spec, "WPA-NONE"))
-			c->auth_suites |= IWINFO_KMGMT_NONE;
+static int nl80211_wpactl_mac(const char *p, const char *end, uint8_t *mac)
+{
+	int i, hi, lo;
 
+	if (end - p < 17)
+		return -1;
 
-		if (strstr(spec, "TKIP"))
-			c->pair_ciphers |= IWINFO_CIPHER_TKIP;
+	for (i = 0; i < 6; i++, p += 3)
+	{
+		if ((hi = nl80211_wpactl_nibble(p[0])) < 0 ||
+		    (lo = nl80211_wpactl_nibble(p[1])) < 0 ||
+		    (i < 5 && p[2] != ':'))
+			return -1;
 
-		if (strstr(spec, "CCMP"))
-			c->pair_ciphers |= IWINFO_CIPHER_CCMP;
+		mac[i] = (hi << 4) | lo;
+	}
 
-		if (strstr(spec, "WEP-40"))
-			c->pair_ciphers |= IWINFO_CIPHER_WEP40;
+	return 0;
+}
 
-		if (strstr(spec, "WEP-104"))
-			c->pair_ciphers |= IWINFO_CIPHER_WEP104;
+static int nl80211_wpactl_int(const char **pp, const char *end)
+{
+	int neg = 0, val = 0;
+	const char *p = *pp;
 
-		c->group_ciphers = c->pair_ciphers;
-	}
-	else
+	if (p < end && *p == '-')
 	{
-		c->enabled = 0;
+		neg = 1;
+		p++;
 	}
-}
 
+	while (p < end && *p >= '0' && *p <= '9')
+		val = val * 10 + (*p++ - '0');
 
-struct nl80211_scanlist {
-	struct iwinfo_scanlist_entry *e;
-	int len;
-};
+	*pp = p;
 
+	return neg ? -val : val;
+}
 
-static void nl80211_get_scanlist_ie(struct nlattr **bss,
-                                    struct iwinfo_scanlist_entry *e)
+/* Undo the printf-style escaping wpa_supplicant applies to SSIDs */
+static void nl80211_wpactl_ssid(const char *p, const char *end, uint8_t *ssid)
 {
-	int ielen = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
-	unsigned char *ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
-	static unsigned char ms_oui[3] = { 0x00, 0x50, 0xf2 };
+	int hi, lo, len = 0;
 
-	while (ielen >= 2 && ielen >= ie[1])
+	while (p < end && len < IWINFO_ESSID_MAX_SIZE)
 	{
-		switch (ie[0])
+		if (*p != '\\' || p + 1 >= end)
 		{
-		case 0: /* SSID */
-			memcpy(e->ssid, ie + 2, min(ie[1], IWINFO_ESSID_MAX_SIZE));
-			break;
+			ssid[len++] = *p++;
+			continue;
+		}
 
-		case 48: /* RSN */
-			iwinfo_parse_rsn(&e->crypto, ie + 2, ie[1],
-			                 IWINFO_CIPHER_CCMP, IWINFO_KMGMT_8021x);
-			break;
+		switch (p[1])
+		{
+		case 'n': ssid[len++] = '\n';   p += 2; break;
+		case 'r': ssid[len++] = '\r';   p += 2; break;
+		case 't': ssid[len++] = '\t';   p += 2; break;
+		case 'e': ssid[len++] = '\033'; p += 2; break;
+
+		case 'x':
+			if (p + 3 < end &&
+			    (hi = nl80211_wpactl_nibble(p[2])) >= 0 &&
+			    (lo = nl80211_wpactl_nibble(p[3])) >= 0)
+			{
+				ssid[len++] = (hi << 4) | lo;
+				p += 4;
+				break;
+			}
 
-		case 221: /* Vendor */
-			if (ie[1] >= 4 && !memcmp(ie + 2, ms_oui, 3) && ie[5] == 1)
-				iwinfo_parse_rsn(&e->crypto, ie + 6, ie[1] - 4,
-				                 IWINFO_CIPHER_TKIP, IWINFO_KMGMT_PSK);
+			/* fall through */
+
+		default:
+			ssid[len++] = p[1];
+			p += 2;
 			break;
 		}
-
-		ielen -= ie[1] + 2;
-		ie += ie[1] + 2;
 	}
+
+	ssid[len] = 0;
 }
 
-static int nl80211_get_scanlist_cb(struct nl_msg *msg, void *arg)
+/* Decode a flags string like "[WPA2-PSK+SAE-CCMP][WPS][ESS]" in one pass */
+static void nl80211_wpactl_flags(const char *p, const char *end,
+                                 struct iwinfo_scanlist_entry *e)
 {
-	int8_t rssi;
-	uint16_t caps;
+	int boundary;
+	const char *grp;
+	const struct nl80211_wpactl_suite *s;
+	struct iwinfo_crypto_entry *c = &e->crypto;
 
-	struct nl80211_scanlist *sl = arg;
-	struct nlattr **tb = nl80211_parse(msg);
-	struct nlattr *bss[NL80211_BSS_MAX + 1];
+	while (p < end)
+	{
+		if (*p++ != '[')
+			continue;
 
-	static struct nla_policy bss_policy[NL80211_BSS_MAX + 1] = {
-		[NL80211_BSS_TSF]                  = { .type = NLA_U64 },
-		[NL80211_BSS_FREQUENCY]            = { .type = NLA_U32 },
-		[NL80211_BSS_BSSID]                = {                 },
-		[NL80211_BSS_BEACON_INTERVAL]      = { .type = NLA_U16 },
-		[NL80211_BSS_CAPABILITY]           = { .type = NLA_U16 },
-		[NL80211_BSS_INFORMATION_ELEMENTS] = {                 },
-		[NL80211_BSS_SIGNAL_MBM]           = { .type = NLA_U32 },
-		[NL80211_BSS_SIGNAL_UNSPEC]        = { .type = NLA_U8  },
-		[NL80211_BSS_STATUS]               = { .type = NLA_U32 },
-		[NL80211_BSS_SEEN_MS_AGO]          = { .type = NLA_U32 },
-		[NL80211_BSS_BEACON_IES]           = {                 },
-	};
+		grp = p;
 
-	if (!tb[NL80211_ATTR_BSS] ||
-		nla_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS],
-		                 bss_policy) ||
-		!bss[NL80211_BSS_BSSID])
+		if (!strncmp(grp, "WPA2-", 5) || !strncmp(grp, "RSN-", 4))
+			c->wpa_version |= 2;
+
+		else if (!strncmp(grp, "WPA-", 4))
+			c->wpa_version |= 1;
+
+		else if (!strncmp(grp, "WEP]", 4))
+		{
+			c->enabled      = 1;
+			c->auth_algs    = IWINFO_AUTH_OPEN | IWINFO_AUTH_SHARED;
+			c->pair_ciphers = IWINFO_CIPHER_WEP40 | IWINFO_CIPHER_WEP104;
+		}
+
+		else if (!strncmp(grp, "IBSS]", 5))
+			e->mode = IWINFO_OPMODE_ADHOC;
+
+		else if (!strncmp(grp, "MESH]", 5))
+			e->mode = IWINFO_OPMODE_MESHPOINT;
+
+		/* skip the protocol, then match suite names on word boundaries */
+		while (p < end && *p != ']' && *p != '-')
+			p++;
+
+		for (boundary = 1; p < end && *p != ']'; p++)
+		{
+			if (boundary)
+			{
+				for (s = nl80211_wpactl_suites; s->name; s++)
+				{
+					if (end - p >= s->len && !strncmp(p, s->name, s->len))
+					{
+						c->enabled      = 1;
+						c->auth_suites |= s->kmgmt;
+						IWINFO_CRYPTO_ADD_CIPHERS(c, pair, s->cipher);
+						p += s->len - 1;
+						break;
+					}
+				}
+			}
+
+			boundary = (*p == '-' || *p == '+' || *p == '/');
+		}
+	}
+
+	c->group_ciphers     = c->pair_ciphers;
+	c->group_ciphers_ext = c->pair_ciphers_ext;
+}
+
+static void nl80211_wpactl_signal(struct iwinfo_scanlist_entry *e,
+                                  int rssi, int qmax)
+{
+	e->signal = rssi;
+
+	if (rssi < 0)
 	{
-		return NL_SKIP;
+		/* The cfg80211 wext compat layer assumes a signal range
+		 * of -110 dBm to -40 dBm, the quality value is derived
+		 * by adding 110 to the signal level */
+		if (rssi < -110)
+			rssi = -110;
+		else if (rssi > -40)
+			rssi = -40;
+
+		e->quality = (rssi + 110);
+	}
+	else
+	{
+		e->quality = rssi;
+	}
+
+	e->quality_max = qmax;
+}
+
+/* Parse "BSS RANGE=" records of key=value lines terminated by "====", the
+ * supplicant ends the last record of the table with "####" instead and
+ * next is set to -1 then */
+static int nl80211_wpactl_parse_bss(const char *p, struct iwinfo_scanlist_entry *e,
+                                    int max, int qmax, int *next)
+{
+	int count = 0, valid = 0;
+	const char *eol, *val;
+
+	memset(e, 0, sizeof(*e));
+
+	while (*p && count < max)
+	{
+		if (!(eol = strchr(p, '\n')))
+			eol = p + strlen(p);
+
+		/* record delimiter */
+		if (eol - p == 4 && (!strncmp(p, "====", 4) || !strncmp(p, "####", 4)))
+		{
+			if (valid)
+			{
+				if (!e->mode)
+					e->mode = IWINFO_OPMODE_MASTER;
+
+				nl80211_bss_track(e);
+
+				if (++count < max)
+					memset(++e, 0, sizeof(*e));
+			}
+			else
+			{
+				memset(e, 0, sizeof(*e));
+			}
+
+			valid = 0;
+
+			if (*p == '#')
+			{
+				*next = -1;
+				break;
+			}
+		}
+		else if (!(val = memchr(p, '=', eol - p)))
+		{
+			/* not a key=value line */
+		}
+		else if (!strncmp(p, "id=", 3))
+		{
+			val++;
+			*next = nl80211_wpactl_int(&val, eol) + 1;
+		}
+		else if (!strncmp(p, "bssid=", 6))
+		{
+			valid = !nl80211_wpactl_mac(val + 1, eol, e->mac);
+		}
+		else if (!strncmp(p, "freq=", 5))
+		{
+			val++;
+			e->channel = nl80211_freq2channel(nl80211_wpactl_int(&val, eol));
+		}
+		else if (!strncmp(p, "level=", 6))
+		{
+			val++;
+			nl80211_wpactl_signal(e, nl80211_wpactl_int(&val, eol), qmax);
+		}
+		else if (!strncmp(p, "flags=", 6))
+		{
+			nl80211_wpactl_flags(val + 1, eol, e);
+		}
+		else if (!strncmp(p, "ssid=", 5))
+		{
+			nl80211_wpactl_ssid(val + 1, eol, e->ssid);
+		}
+
+		p = *eol ? eol + 1 : eol;
+	}
+
+	return count;
+}
+
+/* Parse tab separated SCAN_RESULTS lines, used if "BSS RANGE=" is missing */
+static int nl80211_wpactl_parse_results(const char *p,
+                                        struct iwinfo_scanlist_entry *e,
+                                        int max, int qmax)
+{
+	int freq, rssi, count = 0;
+	const char *eol, *flags;
+
+	/* skip header line */
+	if (!(p = strchr(p, '\n')))
+		return 0;
+
+	for (p++; *p && count < max; p = *eol ? eol + 1 : eol)
+	{
+		if (!(eol = strchr(p, '\n')))
+			eol = p + strlen(p);
+
+		memset(e, 0, sizeof(*e));
+
+		if (nl80211_wpactl_mac(p, eol, e->mac))
+			continue;
+
+		for (p += 17; p < eol && (*p == '\t' || *p == ' '); p++);
+		freq = nl80211_wpactl_int(&p, eol);
+
+		for (; p < eol && (*p == '\t' || *p == ' '); p++);
+		rssi = nl80211_wpactl_int(&p, eol);
+
+		for (; p < eol && (*p == '\t' || *p == ' '); p++);
+		for (flags = p; p < eol && *p != '\t'; p++);
+
+		/* Mode (assume master) */
+		e->mode = IWINFO_OPMODE_MASTER;
+
+		nl80211_wpactl_flags(flags, p, e);
+
+		if (p < eol)
+			nl80211_wpactl_ssid(p + 1, eol, e->ssid);
+
+		e->channel = nl80211_freq2channel(freq);
+		nl80211_wpactl_signal(e, rssi, qmax);
+
+		nl80211_bss_track(e);
+
+		count++;
+		e++;
+	}
+
+	return count;
+}
+
+/* Control socket of an asynchronous scan being collected, queried instead
+ * of opening another one */
+static struct nl80211_wpactl *scan_ctl = NULL;
+
+static int nl80211_get_scanlist_wpactl(const char *ifname,
+                                       struct iwinfo_scanlist_entry *e)
+{
+	int n, qmax, next = 0, count = 0;
+	char cmd[64], *res;
+	struct nl80211_wpactl own, *ctl = scan_ctl;
+
+	if (!ctl && nl80211_wpactl_open(ifname, ctl = &own))
+		return -1;
+
+	nl80211_get_quality_max(ifname, &qmax);
+
+	/* Page through the BSS table, each reply carries as many complete
+	 * records as fit into the supplicants reply buffer */
+	while (count < NL80211_SCANLIST_MAX)
+	{
+		snprintf(cmd, sizeof(cmd), "BSS RANGE=%d- MASK=0x%x",
+		         next, NL80211_WPACTL_BSS_MASK);
+
+		if (!(res = nl80211_wpactl_request(ctl, cmd, NULL)) ||
+		    !strncmp(res, "FAIL", 4) || !strncmp(res, "UNKNOWN", 7))
+			break;
+
+		n = nl80211_wpactl_parse_bss(res, e + count,
+		                             NL80211_SCANLIST_MAX - count,
+		                             qmax, &next);
+
+		if (n <= 0)
+			break;
+
+		count += n;
+
+		if (next < 0)
+			break;
+	}
+
+	if (!count && (res = nl80211_wpactl_request(ctl, "SCAN_RESULTS", NULL)))
+		count = nl80211_wpactl_parse_results(res, e, NL80211_SCANLIST_MAX, qmax);
+
+	if (ctl == &own)
+		nl80211_wpactl_close(ctl);
+
+	return count;
+}
+
+
+static void nl80211_get_scanlist_ie(struct nlattr **bss,
+                                    struct iwinfo_scanlist_entry *e)
+{
+	int ielen = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	unsigned char *ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	static unsigned char ms_oui[3] = { 0x00, 0x50, 0xf2 };
+
+	while (ielen >= 2 && ielen >= ie[1] + 2)
+	{
+		switch (ie[0])
+		{
+		case 0: /* SSID */
+			memcpy(e->ssid, ie + 2, min(ie[1], IWINFO_ESSID_MAX_SIZE));
+			break;
+
+		case 48: /* RSN */
+			iwinfo_parse_rsn(&e->crypto, ie + 2, ie[1],
+			                 IWINFO_CIPHER_CCMP, IWINFO_KMGMT_8021x);
+			break;
+
+		case 221: /* Vendor */
+			if (ie[1] >= 4 && !memcmp(ie + 2, ms_oui, 3) && ie[5] == 1)
+				iwinfo_parse_rsn(&e->crypto, ie + 6, ie[1] - 4,
+				                 IWINFO_CIPHER_TKIP, IWINFO_KMGMT_PSK);
+			break;
+		}
+
+		ielen -= ie[1] + 2;
+		ie += ie[1] + 2;
 	}
+}
+
+static uint32_t nl80211_get_scanlist_hash(struct nlattr **bss)
+{
+	int i;
+	uint32_t hash = NL80211_HASH_INIT;
+	static const int attrs[] = {
+		NL80211_BSS_FREQUENCY,
+		NL80211_BSS_CAPABILITY,
+		NL80211_BSS_INFORMATION_ELEMENTS,
+	};
+
+	for (i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++)
+		if (bss[attrs[i]])
+			hash = nl80211_hash(hash, nla_data(bss[attrs[i]]),
+			                    nla_len(bss[attrs[i]]));
+
+	return hash;
+}
+
+static void nl80211_get_scanlist_decode(struct nlattr **bss,
+                                        struct iwinfo_scanlist_entry *e)
+{
+	uint16_t caps;
 
 	if (bss[NL80211_BSS_CAPABILITY])
 		caps = nla_get_u16(bss[NL80211_BSS_CAPABILITY]);
 	else
 		caps = 0;
 
-	memset(sl->e, 0, sizeof(*sl->e));
-	memcpy(sl->e->mac, nla_data(bss[NL80211_BSS_BSSID]), 6);
+	memset(e, 0, sizeof(*e));
+	memcpy(e->mac, nla_data(bss[NL80211_BSS_BSSID]), 6);
 
 	if (caps & (1<<1))
-		sl->e->mode = IWINFO_OPMODE_ADHOC;
+		e->mode = IWINFO_OPMODE_ADHOC;
 	else
-		sl->e->mode = IWINFO_OPMODE_MASTER;
+		e->mode = IWINFO_OPMODE_MASTER;
 
 	if (caps & (1<<4))
-		sl->e->crypto.enabled = 1;
+		e->crypto.enabled = 1;
 
 	if (bss[NL80211_BSS_FREQUENCY])
-		sl->e->channel = nl80211_freq2channel(nla_get_u32(
+		e->channel = nl80211_freq2channel(nla_get_u32(
 			bss[NL80211_BSS_FREQUENCY]));
 
-	if (bss[NL80211_BSS_INFORMATION_ELEMENTS])
-		nl80211_get_scanlist_ie(bss, sl->e);
+	if (bss[NL80211_BSS_INFORMATION_ELEMENTS])
+		nl80211_get_scanlist_ie(bss, e);
+
+	if (e->crypto.enabled && !e->crypto.wpa_version)
+	{
+		e->crypto.auth_algs    = IWINFO_AUTH_OPEN | IWINFO_AUTH_SHARED;
+		e->crypto.pair_ciphers = IWINFO_CIPHER_WEP40 | IWINFO_CIPHER_WEP104;
+	}
+}
+
+static void nl80211_get_scanlist_signal(struct nlattr **bss,
+                                        struct iwinfo_scanlist_entry *e)
+{
+	int8_t rssi;
+
+	if (bss[NL80211_BSS_SIGNAL_MBM])
+	{
+		e->signal =
+			(uint8_t)((int32_t)nla_get_u32(bss[NL80211_BSS_SIGNAL_MBM]) / 100);
+
+		rssi = e->signal - 0x100;
+
+		if (rssi < -110)
+			rssi = -110;
+		else if (rssi > -40)
+			rssi = -40;
+
+		e->quality = (rssi + 110);
+		e->quality_max = 70;
+	}
+}
+
+/* Check the criteria available from raw attributes before any decoding */
+static int nl80211_get_scanlist_match(struct nlattr **bss,
+                                      const struct iwinfo_filter *f)
+{
+	int ielen;
+	unsigned char *ie;
+
+	if (bss[NL80211_BSS_FREQUENCY] &&
+	    !iwinfo_filter_has_channel(f, nl80211_freq2channel(
+			nla_get_u32(bss[NL80211_BSS_FREQUENCY]))))
+		return 0;
+
+	if (bss[NL80211_BSS_SIGNAL_MBM] &&
+	    !iwinfo_filter_signal(f,
+			(int32_t)nla_get_u32(bss[NL80211_BSS_SIGNAL_MBM]) / 100))
+		return 0;
+
+	if (!f->ssid[0])
+		return 1;
+
+	if (!bss[NL80211_BSS_INFORMATION_ELEMENTS])
+		return 0;
+
+	ie = nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	ielen = nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+
+	while (ielen >= 2 && ielen >= ie[1] + 2)
+	{
+		if (ie[0] == 0)
+			return iwinfo_filter_ssid(f, ie + 2, ie[1]);
+
+		ielen -= ie[1] + 2;
+		ie += ie[1] + 2;
+	}
+
+	return 0;
+}
+
+static int nl80211_get_scanlist_cb(struct nl_msg *msg, void *arg)
+{
+	uint32_t hash, gen = 0;
+
+	struct nl80211_scanlist *sl = arg;
+	struct nl80211_bss_node *n = NULL;
+	struct iwinfo_scanlist_entry *e;
+	struct nlattr **tb = nl80211_parse(msg);
+	struct nlattr *bss[NL80211_BSS_MAX + 1];
+
+	static struct nla_policy bss_policy[NL80211_BSS_MAX + 1] = {
+		[NL80211_BSS_TSF]                  = { .type = NLA_U64 },
+		[NL80211_BSS_FREQUENCY]            = { .type = NLA_U32 },
+		[NL80211_BSS_BSSID]                = {                 },
+		[NL80211_BSS_BEACON_INTERVAL]      = { .type = NLA_U16 },
+		[NL80211_BSS_CAPABILITY]           = { .type = NLA_U16 },
+		[NL80211_BSS_INFORMATION_ELEMENTS] = {                 },
+		[NL80211_BSS_SIGNAL_MBM]           = { .type = NLA_U32 },
+		[NL80211_BSS_SIGNAL_UNSPEC]        = { .type = NLA_U8  },
+		[NL80211_BSS_STATUS]               = { .type = NLA_U32 },
+		[NL80211_BSS_SEEN_MS_AGO]          = { .type = NLA_U32 },
+		[NL80211_BSS_BEACON_IES]           = {                 },
+	};
+
+	if (!tb[NL80211_ATTR_BSS] ||
+		nla_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS],
+		                 bss_policy) ||
+		!bss[NL80211_BSS_BSSID])
+	{
+		return NL_SKIP;
+	}
+
+	/* rejected entries are not seen, so the table must not expire */
+	if (scan_filter && !nl80211_get_scanlist_match(bss, scan_filter))
+	{
+		sl->partial = 1;
+		return NL_SKIP;
+	}
+
+	if (tb[NL80211_ATTR_GENERATION])
+		gen = nla_get_u32(tb[NL80211_ATTR_GENERATION]);
+
+	if (bss_cur)
+		n = nl80211_bss_lookup(bss_cur, nla_data(bss[NL80211_BSS_BSSID]));
+
+	if (n)
+	{
+		/* the kernel bumps the generation whenever its bss list changes,
+		 * if it did not move the cached entry cannot be stale */
+		if (n->seen && gen && n->generation == gen)
+			hash = n->iehash;
+		else
+			hash = nl80211_get_scanlist_hash(bss);
+
+		n->generation = gen;
+
+		if (nl80211_bss_touch(n, hash))
+			nl80211_get_scanlist_decode(bss, &n->e);
+
+		if (bss[NL80211_BSS_SEEN_MS_AGO])
+			n->age = nla_get_u32(bss[NL80211_BSS_SEEN_MS_AGO]);
+
+		e = &n->e;
+	}
+	else
+	{
+		if (sl->len >= NL80211_SCANLIST_MAX)
+			return NL_SKIP;
+
+		nl80211_get_scanlist_decode(bss, sl->e);
+		e = sl->e;
+	}
+
+	nl80211_get_scanlist_signal(bss, e);
+
+	/* raw IEs go to the IE set of the device for lazy decoding */
+	if (bss_cur && bss_cur->ies && bss[NL80211_BSS_INFORMATION_ELEMENTS])
+		iwinfo_ie_set_put(bss_cur->ies, e->mac,
+			iwinfo_ie_blob(&bss_cur->ies->arena,
+				nla_data(bss[NL80211_BSS_INFORMATION_ELEMENTS]),
+				nla_len(bss[NL80211_BSS_INFORMATION_ELEMENTS])));
+
+	/* one slot stays free as decode scratch for entries pending eviction */
+	if (scan_filter && scan_filter->top)
+	{
+		iwinfo_topn_push(sl->base, &sl->len,
+		                 min(scan_filter->top, NL80211_SCANLIST_MAX - 1),
+		                 sizeof(*e), e, iwinfo_scan_signal);
+
+		sl->e = sl->base + sl->len;
+		return NL_SKIP;
+	}
+
+	if (sl->len >= NL80211_SCANLIST_MAX)
+		return NL_SKIP;
+
+	if (e != sl->e)
+		*sl->e = *e;
+
+	sl->e++;
+	sl->len++;
+
+	return NL_SKIP;
+}
+
+static int nl80211_get_scanlist_dump(const char *ifname, char *buf, int *len)
+{
+	struct nl80211_scanlist sl = {
+		.e    = (struct iwinfo_scanlist_entry *)buf,
+		.base = (struct iwinfo_scanlist_entry *)buf
+	};
+
+	/* an interrupted or filtered dump may miss entries, do not expire */
+	if (!nl80211_dump(ifname, NL80211_CMD_GET_SCAN,
+	                  nl80211_get_scanlist_cb, &sl, sizeof(sl)) &&
+	    bss_cur && !sl.partial)
+		bss_cur->dumped = 1;
+
+	*len = sl.len * sizeof(struct iwinfo_scanlist_entry);
+	return *len ? 0 : -1;
+}
+
+static int nl80211_get_scanlist_nl(const char *ifname, char *buf, int *len)
+{
+	int err = -1, wait;
+	struct nl80211_msg_conveyor *req;
+
+	/* subscribed first, the scan may finish before we look */
+	wait = !nl80211_wait_prepare("nl80211", "scan");
+
+	req = nl80211_msg(ifname, NL80211_CMD_TRIGGER_SCAN, 0);
+	if (req)
+	{
+		if (nl80211_send(req, NULL, NULL))
+			err = nls->msg_err;
+
+		nl80211_free(req);
+	}
+
+	/* a scan already in flight completes with the same event */
+	if (wait && (err >= 0 || err == -EBUSY))
+		nl80211_wait(if_nametoindex(ifname), NL80211_CMD_NEW_SCAN_RESULTS);
+
+	return nl80211_get_scanlist_dump(ifname, buf, len);
+}
+
+static int nl80211_get_scanlist_sup(const char *ifname, char *buf, int *len)
+{
+	int count;
+
+	if ((count = nl80211_get_scanlist_wpactl(ifname,
+	        (struct iwinfo_scanlist_entry *)buf)) < 0)
+		return -1;
+
+	if (bss_cur)
+		bss_cur->dumped = 1;
+
+	*len = count * sizeof(struct iwinfo_scanlist_entry);
+	return 0;
+}
+
+static int nl80211_get_scanlist_dev(const char *ifname, char *buf, int *len)
+{
+	int count;
+	char *res;
+
+	/* Got a radioX pseudo interface, find some interface on it or create one */
+	if (!strncmp(ifname, "radio", 5))
+	{
+		/* Reuse existing interface */
+		if ((res = nl80211_phy2ifname(ifname)) != NULL)
+		{
+			return nl80211_get_scanlist(res, buf, len);
+		}
+
+		/* Need to spawn a temporary iface for scanning */
+		else if ((res = nl80211_ifadd(ifname)) != NULL)
+		{
+			count = nl80211_get_scanlist(res, buf, len);
+			nl80211_ifdel(res);
+			return count;
+		}
+	}
+
+	/* WPA supplicant */
+	if ((res = nl80211_wpactl_info(ifname, "SCAN", "CTRL-EVENT-SCAN-RESULTS")))
+	{
+		if (!nl80211_get_scanlist_sup(ifname, buf, len))
+			return 0;
+	}
+
+	/* AP scan */
+	else
+	{
+		/* Got a temp interface, don't create yet another one */
+		if (!strncmp(ifname, "tmp.", 4))
+		{
+			if (!iwinfo_ifup(ifname))
+				return -1;
+
+			nl80211_get_scanlist_nl(ifname, buf, len);
+			iwinfo_ifdown(ifname);
+			return 0;
+		}
+
+		/* Spawn a new scan interface */
+		else
+		{
+			if (!(res = nl80211_ifadd(ifname)))
+				goto out;
+
+			if (!iwinfo_ifmac(res))
+				goto out;
+
+			/* if we can take the new interface up, the driver supports an
+			 * additional interface and there's no need to tear down the ap */
+			if (iwinfo_ifup(res))
+			{
+				nl80211_get_scanlist_nl(res, buf, len);
+				iwinfo_ifdown(res);
+			}
+
+			/* driver cannot create secondary interface, take down ap
+			 * during scan */
+			else if (iwinfo_ifdown(ifname) && iwinfo_ifup(res))
+			{
+				nl80211_get_scanlist_nl(res, buf, len);
+				iwinfo_ifdown(res);
+				iwinfo_ifup(ifname);
+				nl80211_hostapd_hup(ifname);
+			}
+
+		out:
+			nl80211_ifdel(res);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/* Run a scan collector with the resident BSS table of the device selected,
+ * entries not seen by a complete dump are expired afterwards */
+static int nl80211_get_scanlist_tracked(const char *ifname, char *buf, int *len,
+	int (*collect)(const char *, char *, int *))
+{
+	int rv;
+	struct nl80211_bss_table *t;
+
+	/* nested call for a pseudo or temporary interface */
+	if (bss_cur || !(t = nl80211_bss_table(ifname)))
+		return collect(ifname, buf, len);
+
+	bss_cur = t;
+	t->serial++;
+	t->dumped = 0;
+
+	if ((t->ies = iwinfo_ie_set(ifname)) != NULL)
+		iwinfo_ie_set_reset(t->ies);
+
+	*len = 0;
+	rv = collect(ifname, buf, len);
+
+	if (t->dumped)
+		nl80211_bss_expire(t);
+
+	bss_cur = NULL;
+
+	return rv;
+}
+
+static int nl80211_sched_event_cb(struct nl_msg *msg, void *arg)
+{
+	int i, ifidx;
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nlattr **attr = nl80211_parse(msg);
+
+	if (!attr[NL80211_ATTR_IFINDEX])
+		return NL_SKIP;
+
+	ifidx = nla_get_u32(attr[NL80211_ATTR_IFINDEX]);
+
+	for (i = 0; i < NL80211_SCHED_MAX; i++)
+	{
+		if (!sched[i].interval || sched[i].ifidx != ifidx)
+			continue;
+
+		switch (gnlh->cmd)
+		{
+		case NL80211_CMD_NEW_SCAN_RESULTS:
+		case NL80211_CMD_SCHED_SCAN_RESULTS:
+			sched[i].pending = 1;
+			break;
+
+		/* the driver gave up, continue with timed triggers */
+		case NL80211_CMD_SCHED_SCAN_STOPPED:
+			sched[i].kernel = 0;
+			break;
+		}
+	}
+
+	return NL_SKIP;
+}
+
+static int nl80211_sched_socket(void)
+{
+	int id;
+
+	if (sched_sock)
+		return 0;
+
+	if ((id = nl80211_mcast_group("nl80211", "scan")) < 0)
+		return -1;
+
+	sched_sock = nl80211_sock(NL80211_EVT_RCVBUF);
+	sched_cb = nl_cb_alloc(NL_CB_DEFAULT);
+
+	if (!sched_sock || !sched_cb || nl_socket_add_membership(sched_sock, id))
+	{
+		if (sched_cb)
+			nl_cb_put(sched_cb);
+
+		if (sched_sock)
+			nl_socket_free(sched_sock);
+
+		sched_sock = NULL;
+		sched_cb = NULL;
+		return -1;
+	}
+
+	nl_socket_set_nonblocking(sched_sock);
+	nl_cb_set(sched_cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, nl80211_wait_seq_check, NULL);
+	nl_cb_set(sched_cb, NL_CB_VALID,     NL_CB_CUSTOM, nl80211_sched_event_cb, NULL);
+
+	return 0;
+}
+
+static void nl80211_sched_collect(struct nl80211_sched *s)
+{
+	int len = 0;
+
+	nl80211_get_scanlist_tracked(s->ifname, s->buf, &len,
+	                             nl80211_get_scanlist_dump);
+
+	s->len = len;
+	s->stamp = iwinfo_msecs();
+	s->pending = 0;
+}
+
+static void nl80211_sched_pump(void)
+{
+	int i, lost = 0;
+	uint64_t now;
+	struct pollfd pfd = { .events = POLLIN };
+
+	if (!sched_sock)
+		return;
+
+	/* nl_recvmsgs() returns 0 on an empty non-blocking socket */
+	pfd.fd = nl_socket_get_fd(sched_sock);
+
+	while (poll(&pfd, 1, 0) > 0)
+	{
+		if (nl_recvmsgs(sched_sock, sched_cb) < 0)
+		{
+			lost = 1;
+			break;
+		}
+	}
+
+	now = iwinfo_msecs();
+
+	for (i = 0; i < NL80211_SCHED_MAX; i++)
+	{
+		if (!sched[i].interval)
+			continue;
+
+		/* events were lost on overrun, refresh everything */
+		if (sched[i].pending || lost)
+			nl80211_sched_collect(&sched[i]);
+
+		if (!sched[i].kernel && now - sched[i].triggered >= sched[i].interval)
+		{
+			nl80211_sched_request(&sched[i], NL80211_CMD_TRIGGER_SCAN);
+			sched[i].triggered = now;
+		}
+	}
+}
+
+/* Keep the results of ifname fresh by scanning every interval ms in the
+ * background, an interval of zero stops it again */
+int nl80211_scan_schedule(const char *ifname, int interval)
+{
+	int i;
+	struct nl80211_sched *s;
+
+	if (!strncmp(ifname, "radio", 5) && !(ifname = nl80211_phy2ifname(ifname)))
+		return -1;
+
+	s = nl80211_sched_find(ifname);
+
+	if (interval <= 0)
+	{
+		if (s)
+			nl80211_sched_stop(s);
+
+		return 0;
+	}
+
+	if (nl80211_init() < 0 || nl80211_sched_socket())
+		return -1;
+
+	if (!s)
+	{
+		for (i = 0; i < NL80211_SCHED_MAX && sched[i].interval; i++);
+
+		if (i == NL80211_SCHED_MAX)
+			return -1;
+
+		s = &sched[i];
+
+		if (!(s->ifidx = if_nametoindex(ifname)) ||
+		    !(s->buf = malloc(IWINFO_BUFSIZE)))
+			return -1;
+
+		strncpy(s->ifname, ifname, IFNAMSIZ - 1);
+	}
+	else if (s->kernel)
+	{
+		nl80211_sched_request(s, NL80211_CMD_STOP_SCHED_SCAN);
+	}
+
+	s->interval = interval;
+	s->kernel = !nl80211_sched_request(s, NL80211_CMD_START_SCHED_SCAN);
+
+	/* start out with whatever the kernel knows already */
+	if (!s->stamp)
+		nl80211_sched_collect(s);
+
+	if (!s->kernel)
+	{
+		nl80211_sched_request(s, NL80211_CMD_TRIGGER_SCAN);
+		s->triggered = iwinfo_msecs();
+	}
+
+	return 0;
+}
+
+int nl80211_get_scan_age(const char *ifname, int *buf)
+{
+	struct nl80211_sched *s = nl80211_sched_find(ifname);
+
+	if (!s)
+		return -1;
+
+	nl80211_sched_pump();
+
+	*buf = iwinfo_msecs() - s->stamp;
+	return 0;
+}
+
+static int nl80211_get_scanlist_local(const char *ifname, char *buf, int *len)
+{
+	return nl80211_get_scanlist_tracked(ifname, buf, len,
+	                                    nl80211_get_scanlist_dev);
+}
+
+/* Scans are coalesced per phy with other processes, a filtered dump is
+ * incomplete and therefore not published */
+int nl80211_get_scanlist(const char *ifname, char *buf, int *len)
+{
+	char *phy;
+	struct nl80211_sched *s = nl80211_sched_find(ifname);
+
+	if (s)
+	{
+		nl80211_sched_pump();
+		memcpy(buf, s->buf, s->len);
+		*len = s->len;
+		return 0;
+	}
+
+	phy = nl80211_ifname2phy(ifname);
+
+	return iwinfo_scan_shared(phy ? phy : ifname, ifname, buf, len,
+	                          !scan_filter, nl80211_get_scanlist_local);
+}
+
+int nl80211_get_scanlist_ext(const char *ifname, char *buf, int *len)
+{
+	if (nl80211_get_scanlist(ifname, buf, len))
+		return -1;
+
+	iwinfo_scanlist_widen(ifname, buf, len, IWINFO_BUFSIZE);
+	return 0;
+}
+
+int nl80211_get_scanlist_filter(const char *ifname,
+                                const struct iwinfo_filter *f,
+                                char *buf, int *len)
+{
+	int rv;
+
+	scan_filter = f;
+	rv = nl80211_get_scanlist(ifname, buf, len);
+	scan_filter = NULL;
+
+	/* the supplicant path is not filtered at the source, and a top-N
+	 * heap still needs ordering */
+	if (!rv)
+		iwinfo_filter_scanlist(f, buf, len);
+
+	return rv;
+}
+
+int nl80211_get_scanlist_delta(const char *ifname, char *buf, int *len)
+{
+	int i, count, rv;
+	char *res;
+	struct nl80211_bss_table *t;
+	struct nl80211_bss_node *n;
+	struct iwinfo_scanlist_delta_entry *d =
+		(struct iwinfo_scanlist_delta_entry *)buf;
+
+	if (!(t = nl80211_bss_table(ifname)) || !(res = malloc(IWINFO_BUFSIZE)))
+		return -1;
+
+	/* change tracking needs a scan of our own, not a shared result */
+	rv = nl80211_get_scanlist_local(ifname, res, &count);
+	free(res);
+
+	if (rv)
+		return -1;
+
+	for (i = 0, count = 0, n = t->nodes;
+	     i < t->count && count < (IWINFO_BUFSIZE / sizeof(*d));
+	     i++, n++)
+	{
+		if (!n->change)
+			continue;
+
+		d->change = n->change;
+		d->age    = n->age;
+		d->bss    = n->e;
+
+		if (n->change & IWINFO_BSS_REMOVED)
+		{
+			n->change = NL80211_BSS_DROP;
+		}
+		else
+		{
+			n->change = 0;
+			n->known  = 1;
+		}
+
+		d++;
+		count++;
+	}
+
+	nl80211_bss_compact(t);
+
+	*len = count * sizeof(*d);
+	return 0;
+}
+
+
+/*
+ * Asynchronous scanning. The trigger returns immediately and hands out a
+ * descriptor that becomes readable when the scan completes, so callers can
+ * drive scans on several radios from their own poll loop. Supplicant
+ * managed interfaces are scanned through the supplicant and completion is
+ * taken from its event stream, everything else triggers through nl80211
+ * and watches the scan multicast group on a private socket.
+ */
+
+static int nl80211_scan_event_cb(struct nl_msg *msg, void *arg)
+{
+	struct iwinfo_scan *s = arg;
+	struct nl80211_scan_handle *h = s->priv;
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nlattr **attr = nl80211_parse(msg);
+
+	if (!attr[NL80211_ATTR_IFINDEX] ||
+	    nla_get_u32(attr[NL80211_ATTR_IFINDEX]) != h->ifidx)
+		return NL_SKIP;
+
+	if (gnlh->cmd == NL80211_CMD_NEW_SCAN_RESULTS)
+		s->state = IWINFO_SCAN_READY;
+	else if (gnlh->cmd == NL80211_CMD_SCAN_ABORTED)
+		s->state = IWINFO_SCAN_ABORTED;
+
+	return NL_SKIP;
+}
+
+static int nl80211_scan_trigger_sup(struct iwinfo_scan *s)
+{
+	struct nl80211_scan_handle *h = s->priv;
+	char *res;
+
+	if (nl80211_wpactl_open(s->ifname, &h->ctl))
+		return -1;
+
+	if (!(res = nl80211_wpactl_request(&h->ctl, "ATTACH", NULL)) ||
+	    strncmp(res, "OK", 2))
+		return -1;
+
+	/* a scan already in flight completes with the same event */
+	if (!(res = nl80211_wpactl_request(&h->ctl, "SCAN", NULL)) ||
+	    (strncmp(res, "OK", 2) && strncmp(res, "FAIL-BUSY", 9)))
+		return -1;
+
+	s->fd = h->ctl.sock;
+	return 0;
+}
+
+static int nl80211_scan_trigger_nl(struct iwinfo_scan *s)
+{
+	struct nl80211_scan_handle *h = s->priv;
+	struct nl80211_msg_conveyor *req;
+	int id;
+
+	if (!(h->ifidx = if_nametoindex(s->ifname)))
+		return -1;
+
+	if ((id = nl80211_mcast_group("nl80211", "scan")) < 0)
+		return -1;
+
+	/* subscribe before triggering, the scan may finish before we look */
+	h->sock = nl80211_sock(NL80211_EVT_RCVBUF);
+	h->cb = nl_cb_alloc(NL_CB_DEFAULT);
+
+	if (!h->sock || !h->cb || nl_socket_add_membership(h->sock, id))
+		return -1;
+
+	nl_socket_set_nonblocking(h->sock);
+	nl_cb_set(h->cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, nl80211_wait_seq_check, NULL);
+	nl_cb_set(h->cb, NL_CB_VALID,     NL_CB_CUSTOM, nl80211_scan_event_cb,  s);
+
+	req = nl80211_msg(s->ifname, NL80211_CMD_TRIGGER_SCAN, 0);
+	if (!req)
+		return -1;
+
+	nl80211_send(req, NULL, NULL);
+	nl80211_free(req);
+
+	if (nls->msg_err < 0 && nls->msg_err != -EBUSY)
+		return -1;
+
+	s->fd = nl_socket_get_fd(h->sock);
+	return 0;
+}
+
+int nl80211_scan_trigger(const char *ifname, struct iwinfo_scan *s)
+{
+	struct nl80211_scan_handle *h;
+
+	memset(s, 0, sizeof(*s));
+	s->fd = -1;
+
+	/* Never spawn temporary interfaces here, a radioX pseudo interface
+	 * is only usable if it already has one */
+	if (!strncmp(ifname, "radio", 5) && !(ifname = nl80211_phy2ifname(ifname)))
+		return -1;
+
+	if (nl80211_init() < 0 || !(h = malloc(sizeof(*h))))
+		return -1;
+
+	memset(h, 0, sizeof(*h));
+	h->ctl.sock = -1;
+
+	strncpy(s->ifname, ifname, sizeof(s->ifname) - 1);
+	s->state = IWINFO_SCAN_PENDING;
+	s->priv  = h;
+
+	if (!nl80211_scan_trigger_sup(s))
+		return 0;
+
+	nl80211_wpactl_close(&h->ctl);
+
+	if (!nl80211_scan_trigger_nl(s))
+		return 0;
+
+	nl80211_scan_close(s);
+	return -1;
+}
+
+int nl80211_scan_ready(struct iwinfo_scan *s)
+{
+	int n;
+	char buf[128];
+	struct nl80211_scan_handle *h = s->priv;
+	struct pollfd pfd = { .fd = s->fd, .events = POLLIN };
+
+	if (!h)
+		return -1;
+
+	while (s->state == IWINFO_SCAN_PENDING && poll(&pfd, 1, 0) > 0)
+	{
+		if (h->sock)
+		{
+			/* events were dropped on overrun, collect what is there */
+			if (nl_recvmsgs(h->sock, h->cb) < 0)
+				s->state = IWINFO_SCAN_READY;
+
+			continue;
+		}
+
+		if ((n = recv(h->ctl.sock, buf, sizeof(buf) - 1, MSG_DONTWAIT)) <= 0)
+			break;
+
+		buf[n] = 0;
+
+		if (strstr(buf, "CTRL-EVENT-SCAN-RESULTS"))
+			s->state = IWINFO_SCAN_READY;
+		else if (strstr(buf, "CTRL-EVENT-SCAN-FAILED"))
+			s->state = IWINFO_SCAN_ABORTED;
+	}
+
+	return s->state;
+}
+
+int nl80211_scan_results(struct iwinfo_scan *s, char *buf, int *len)
+{
+	int rv;
+	struct nl80211_scan_handle *h = s->priv;
+
+	if (!h)
+		return -1;
+
+	if (h->ctl.sock < 0)
+		return nl80211_get_scanlist_tracked(s->ifname, buf, len,
+		                                    nl80211_get_scanlist_dump);
+
+	/* stop the event stream, the results are read over the same socket */
+	nl80211_wpactl_request(&h->ctl, "DETACH", NULL);
+
+	scan_ctl = &h->ctl;
+	rv = nl80211_get_scanlist_tracked(s->ifname, buf, len,
+	                                  nl80211_get_scanlist_sup);
+	scan_ctl = NULL;
+
+	return rv;
+}
+
+void nl80211_scan_close(struct iwinfo_scan *s)
+{
+	struct nl80211_scan_handle *h = s->priv;
+
+	if (h)
+	{
+		if (h->ctl.sock > -1)
+			send(h->ctl.sock, "DETACH", 6, 0);
+
+		nl80211_wpactl_close(&h->ctl);
+
+		if (h->cb)
+			nl_cb_put(h->cb);
+
+		if (h->sock)
+			nl_socket_free(h->sock);
+
+		free(h);
+	}
+
+	s->priv = NULL;
+	s->fd = -1;
+}
+
+/*
+ * Event subscription: a dedicated socket joins the config, mlme, scan and
+ * regulatory groups, decoded events are queued on the handle until the
+ * consumer reads them. Filtering happens on the ifindex for interfaces and
+ * on the wiphy index for phyX/radioX, regulatory changes not bound to any
+ * wiphy are always passed. An empty ifname subscribes to all interfaces.
+ */
+static int nl80211_ifname2phyidx(const char *ifname)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "/sys/class/net/%s/phy80211/index", ifname);
+
+	return nl80211_readint(path);
+}
+
+static int nl80211_event_match(struct nl80211_event_handle *h,
+                               struct nlattr **attr)
+{
+	int phyidx = -1;
+	char ifname[IFNAMSIZ];
+
+	if (h->ifidx < 0 && h->phyidx < 0)
+		return 1;
+
+	if (attr[NL80211_ATTR_IFINDEX])
+	{
+		if (h->ifidx > -1)
+			return (nla_get_u32(attr[NL80211_ATTR_IFINDEX]) == h->ifidx);
 
-	if (bss[NL80211_BSS_SIGNAL_MBM])
+		if (if_indextoname(nla_get_u32(attr[NL80211_ATTR_IFINDEX]), ifname))
+			phyidx = nl80211_ifname2phyidx(ifname);
+	}
+	else if (attr[NL80211_ATTR_WIPHY])
 	{
-		sl->e->signal =
-			(uint8_t)((int32_t)nla_get_u32(bss[NL80211_BSS_SIGNAL_MBM]) / 100);
+		phyidx = nla_get_u32(attr[NL80211_ATTR_WIPHY]);
+	}
+	else
+	{
+		return 1;
+	}
 
-		rssi = sl->e->signal - 0x100;
+	return (phyidx > -1 && phyidx == h->phyidx);
+}
 
-		if (rssi < -110)
-			rssi = -110;
-		else if (rssi > -40)
-			rssi = -40;
+/* Reserve the next queue slot, the last free one is used to report that
+ * further events had to be dropped */
+static struct iwinfo_event * nl80211_event_slot(struct nl80211_event_handle *h)
+{
+	struct iwinfo_event *e;
 
-		sl->e->quality = (rssi + 110);
-		sl->e->quality_max = 70;
-	}
+	if (h->count >= IWINFO_EVENT_QUEUE)
+		return NULL;
 
-	if (sl->e->crypto.enabled && !sl->e->crypto.wpa_version)
-	{
-		sl->e->crypto.auth_algs    = IWINFO_AUTH_OPEN | IWINFO_AUTH_SHARED;
-		sl->e->crypto.pair_ciphers = IWINFO_CIPHER_WEP40 | IWINFO_CIPHER_WEP104;
-	}
+	e = &h->queue[(h->head + h->count++) % IWINFO_EVENT_QUEUE];
+	memset(e, 0, sizeof(*e));
 
-	sl->e++;
-	sl->len++;
+	if (h->count < IWINFO_EVENT_QUEUE)
+		return e;
 
-	return NL_SKIP;
+	e->type = IWINFO_EVENT_OVERRUN;
+	return NULL;
 }
 
-static int nl80211_get_scanlist_nl(const char *ifname, char *buf, int *len)
+static int nl80211_event_cb(struct nl_msg *msg, void *arg)
 {
-	struct nl80211_msg_conveyor *req;
-	struct nl80211_scanlist sl = { .e = (struct iwinfo_scanlist_entry *)buf };
+	int type;
+	struct nl80211_event_handle *h = arg;
+	struct genlmsghdr *gnlh = nlmsg_data(nlmsg_hdr(msg));
+	struct nlattr **attr = nl80211_parse(msg);
+	struct iwinfo_event *e;
 
-	req = nl80211_msg(ifname, NL80211_CMD_TRIGGER_SCAN, 0);
-	if (req)
+	switch (gnlh->cmd)
 	{
-		nl80211_send(req, NULL, NULL);
-		nl80211_free(req);
-	}
-
-	nl80211_wait("nl80211", "scan", NL80211_CMD_NEW_SCAN_RESULTS);
+	case NL80211_CMD_NEW_STATION:
+		type = IWINFO_EVENT_STA_NEW;
+		break;
+
+	case NL80211_CMD_DEL_STATION:
+		type = IWINFO_EVENT_STA_DEL;
+		break;
+
+	case NL80211_CMD_NEW_SCAN_RESULTS:
+		type = IWINFO_EVENT_SCAN_DONE;
+		break;
+
+	case NL80211_CMD_SCAN_ABORTED:
+		type = IWINFO_EVENT_SCAN_ABORTED;
+		break;
+
+	case NL80211_CMD_CH_SWITCH_NOTIFY:
+		type = IWINFO_EVENT_CHANNEL_SWITCH;
+		break;
+
+	case NL80211_CMD_REG_CHANGE:
+		type = IWINFO_EVENT_REG_CHANGE;
+		break;
+
+	case NL80211_CMD_NEW_INTERFACE:
+	case NL80211_CMD_SET_INTERFACE:
+	case NL80211_CMD_DEL_INTERFACE:
+	case NL80211_CMD_CONNECT:
+	case NL80211_CMD_DISCONNECT:
+		type = IWINFO_EVENT_IFACE_CHANGE;
+		break;
 
-	req = nl80211_msg(ifname, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
-	if (req)
-	{
-		nl80211_send(req, nl80211_get_scanlist_cb, &sl);
-		nl80211_free(req);
+	default:
+		return NL_SKIP;
 	}
 
-	*len = sl.len * sizeof(struct iwinfo_scanlist_entry);
-	return *len ? 0 : -1;
-}
+	if (!nl80211_event_match(h, attr) || !(e = nl80211_event_slot(h)))
+		return NL_SKIP;
 
-int nl80211_get_scanlist(const char *ifname, char *buf, int *len)
-{
-	int freq, rssi, qmax, count;
-	char *res;
-	char ssid[128] = { 0 };
-	char bssid[18] = { 0 };
-	char cipher[256] = { 0 };
+	e->type = type;
 
-	/* Got a radioX pseudo interface, find some interface on it or create one */
-	if (!strncmp(ifname, "radio", 5))
+	if (attr[NL80211_ATTR_IFINDEX])
+		if_indextoname(nla_get_u32(attr[NL80211_ATTR_IFINDEX]), e->ifname);
+	else if (attr[NL80211_ATTR_WIPHY])
+		snprintf(e->ifname, sizeof(e->ifname), "phy%u",
+		         nla_get_u32(attr[NL80211_ATTR_WIPHY]));
+
+	switch (type)
 	{
-		/* Reuse existing interface */
-		if ((res = nl80211_phy2ifname(ifname)) != NULL)
+	case IWINFO_EVENT_STA_NEW:
+	case IWINFO_EVENT_STA_DEL:
+		if (attr[NL80211_ATTR_MAC])
+			memcpy(e->u.sta.mac, nla_data(attr[NL80211_ATTR_MAC]), 6);
+		break;
+
+	case IWINFO_EVENT_CHANNEL_SWITCH:
+		if (attr[NL80211_ATTR_WIPHY_FREQ])
 		{
-			return nl80211_get_scanlist(res, buf, len);
+			e->u.chan.mhz = nla_get_u32(attr[NL80211_ATTR_WIPHY_FREQ]);
+			e->u.chan.channel = nl80211_freq2channel(e->u.chan.mhz);
 		}
+		break;
 
-		/* Need to spawn a temporary iface for scanning */
-		else if ((res = nl80211_ifadd(ifname)) != NULL)
-		{
-			count = nl80211_get_scanlist(res, buf, len);
-			nl80211_ifdel(res);
-			return count;
-		}
+	case IWINFO_EVENT_REG_CHANGE:
+		if (attr[NL80211_ATTR_REG_ALPHA2])
+			strncpy(e->u.reg.alpha2,
+			        nla_get_string(attr[NL80211_ATTR_REG_ALPHA2]), 2);
+
+		if (attr[NL80211_ATTR_REG_INITIATOR])
+			e->u.reg.initiator = nla_get_u8(attr[NL80211_ATTR_REG_INITIATOR]);
+		break;
 	}
 
-	struct iwinfo_scanlist_entry *e = (struct iwinfo_scanlist_entry *)buf;
+	return NL_SKIP;
+}
 
-	/* WPA supplicant */
-	if ((res = nl80211_wpactl_info(ifname, "SCAN", "CTRL-EVENT-SCAN-RESULTS")))
-	{
-		if ((res = nl80211_wpactl_info(ifname, "SCAN_RESULTS", NULL)))
-		{
-			nl80211_get_quality_max(ifname, &qmax);
+int nl80211_events_open(const char *ifname, struct iwinfo_events *ev)
+{
+	int i, id;
+	struct nl80211_event_handle *h;
+	static const char *groups[] = { "config", "mlme", "scan", "regulatory" };
 
-			/* skip header line */
-			while (*res++ != '\n');
+	memset(ev, 0, sizeof(*ev));
+	ev->fd = -1;
 
-			count = 0;
+	if (nl80211_init() < 0 || !(h = malloc(sizeof(*h))))
+		return -1;
 
-			while (sscanf(res, "%17s %d %d %255s%*[ \t]%127[^\n]\n",
-			              bssid, &freq, &rssi, cipher, ssid) > 0)
-			{
-				/* BSSID */
-				e->mac[0] = strtol(&bssid[0],  NULL, 16);
-				e->mac[1] = strtol(&bssid[3],  NULL, 16);
-				e->mac[2] = strtol(&bssid[6],  NULL, 16);
-				e->mac[3] = strtol(&bssid[9],  NULL, 16);
-				e->mac[4] = strtol(&bssid[12], NULL, 16);
-				e->mac[5] = strtol(&bssid[15], NULL, 16);
+	memset(h, 0, sizeof(*h));
+	h->ifidx = -1;
 
-				/* SSID */
-				memcpy(e->ssid, ssid, min(strlen(ssid), sizeof(e->ssid) - 1));
+	strncpy(ev->ifname, ifname, sizeof(ev->ifname) - 1);
+	ev->priv = h;
 
-				/* Mode (assume master) */
-				e->mode = IWINFO_OPMODE_MASTER;
+	if (!*ifname)
+		h->phyidx = -1;
+	else if (!strncmp(ifname, "phy", 3))
+		h->phyidx = atoi(&ifname[3]);
+	else if (!strncmp(ifname, "radio", 5))
+		h->phyidx = atoi(&ifname[5]);
+	else if ((h->ifidx = if_nametoindex(ifname)) > 0)
+		h->phyidx = nl80211_ifname2phyidx(ifname);
+	else
+		goto err;
 
-				/* Channel */
-				e->channel = nl80211_freq2channel(freq);
+	h->sock = nl80211_sock(NL80211_EVT_RCVBUF);
+	h->cb = nl_cb_alloc(NL_CB_DEFAULT);
 
-				/* Signal */
-				e->signal = rssi;
+	if (!h->sock || !h->cb)
+		goto err;
 
-				/* Quality */
-				if (rssi < 0)
-				{
-					/* The cfg80211 wext compat layer assumes a signal range
-					 * of -110 dBm to -40 dBm, the quality value is derived
-					 * by adding 110 to the signal level */
-					if (rssi < -110)
-						rssi = -110;
-					else if (rssi > -40)
-						rssi = -40;
-
-					e->quality = (rssi + 110);
-				}
-				else
-				{
-					e->quality = rssi;
-				}
+	for (i = 0; i < sizeof(groups) / sizeof(groups[0]); i++)
+		if ((id = nl80211_mcast_group("nl80211", groups[i])) < 0 ||
+		    nl_socket_add_membership(h->sock, id))
+			goto err;
 
-				/* Max. Quality */
-				e->quality_max = qmax;
+	nl_socket_set_nonblocking(h->sock);
+	nl_cb_set(h->cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, nl80211_wait_seq_check, NULL);
+	nl_cb_set(h->cb, NL_CB_VALID,     NL_CB_CUSTOM, nl80211_event_cb, h);
 
-				/* Crypto */
-				nl80211_get_scancrypto(cipher, &e->crypto);
+	ev->fd = nl_socket_get_fd(h->sock);
+	return 0;
 
-				/* advance to next line */
-				while (*res && *res++ != '\n');
+err:
+	nl80211_events_close(ev);
+	return -1;
+}
 
-				count++;
-				e++;
+/* Fetch the next queued event without blocking, returns 1 if e was filled,
+ * 0 if nothing is pending and -1 on error */
+int nl80211_events_read(struct iwinfo_events *ev, struct iwinfo_event *e)
+{
+	int rv;
+	struct nl80211_event_handle *h = ev->priv;
+	struct pollfd pfd = { .fd = ev->fd, .events = POLLIN };
 
-				memset(ssid, 0, sizeof(ssid));
-				memset(bssid, 0, sizeof(bssid));
-				memset(cipher, 0, sizeof(cipher));
-			}
+	if (!h)
+		return -1;
 
-			*len = count * sizeof(struct iwinfo_scanlist_entry);
+	while (!h->count)
+	{
+		/* nl_recvmsgs() returns 0 on an empty non-blocking socket */
+		if (poll(&pfd, 1, 0) <= 0)
 			return 0;
-		}
-	}
 
-	/* AP scan */
-	else
-	{
-		/* Got a temp interface, don't create yet another one */
-		if (!strncmp(ifname, "tmp.", 4))
-		{
-			if (!iwinfo_ifup(ifname))
-				return -1;
+		rv = nl_recvmsgs(h->sock, h->cb);
 
-			nl80211_get_scanlist_nl(ifname, buf, len);
-			iwinfo_ifdown(ifname);
+		if (rv == -NLE_AGAIN)
 			return 0;
-		}
 
-		/* Spawn a new scan interface */
-		else
+		/* the socket buffer overflowed, tell the consumer to resync */
+		if (rv == -NLE_NOMEM)
 		{
-			if (!(res = nl80211_ifadd(ifname)))
-				goto out;
+			memset(e, 0, sizeof(*e));
+			e->type = IWINFO_EVENT_OVERRUN;
+			return 1;
+		}
 
-			if (!iwinfo_ifmac(res))
-				goto out;
+		if (rv < 0)
+			return -1;
+	}
 
-			/* if we can take the new interface up, the driver supports an
-			 * additional interface and there's no need to tear down the ap */
-			if (iwinfo_ifup(res))
-			{
-				nl80211_get_scanlist_nl(res, buf, len);
-				iwinfo_ifdown(res);
-			}
+	*e = h->queue[h->head];
+	h->head = (h->head + 1) % IWINFO_EVENT_QUEUE;
+	h->count--;
 
-			/* driver cannot create secondary interface, take down ap
-			 * during scan */
-			else if (iwinfo_ifdown(ifname) && iwinfo_ifup(res))
-			{
-				nl80211_get_scanlist_nl(res, buf, len);
-				iwinfo_ifdown(res);
-				iwinfo_ifup(ifname);
-				nl80211_hostapd_hup(ifname);
-			}
+	return 1;
+}
 
-		out:
-			nl80211_ifdel(res);
-			return 0;
-		}
+void nl80211_events_close(struct iwinfo_events *ev)
+{
+	struct nl80211_event_handle *h = ev->priv;
+
+	if (h)
+	{
+		if (h->cb)
+			nl_cb_put(h->cb);
+
+		if (h->sock)
+			nl_socket_free(h->sock);
+
+		free(h);
 	}
 
-	return -1;
+	ev->priv = NULL;
+	ev->fd = -1;
 }
 
 static int nl80211_get_freqlist_cb(struct nl_msg *msg, void *arg)
@@ -2300,3 +4336,240 @@ int nl80211_get_frequency_offset(const char *ifname, int *buf)
 	*buf = hw->frequency_offset;
 	return 0;
 }
+
+int nl80211_get_phyname(const char *ifname, char *buf)
+{
+	char *res;
+
+	if (!(res = nl80211_ifname2phy(ifname)))
+		return -1;
+
+	strcpy(buf, res);
+	return 0;
+}
+
+
+struct nl80211_iface_info {
+	int mode;
+	int freq;
+	int phyidx;
+	int txpower;
+	int has_txpower;
+};
+
+static int nl80211_get_info_cb(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_iface_info *ii = arg;
+	struct nlattr **attr;
+
+	nl80211_get_mode_cb(msg, &ii->mode);
+	nl80211_get_frequency_info_cb(msg, &ii->freq);
+
+	attr = nl80211_parse(msg);
+
+	if (attr[NL80211_ATTR_WIPHY])
+		ii->phyidx = nla_get_u32(attr[NL80211_ATTR_WIPHY]);
+
+	/* newer kernels report the current level in mBm, older ones
+	 * leave it to the wireless extensions */
+	if (attr[NL80211_ATTR_WIPHY_TX_POWER_LEVEL])
+	{
+		ii->txpower = (int32_t)nla_get_u32(attr[NL80211_ATTR_WIPHY_TX_POWER_LEVEL]) / 100;
+		ii->has_txpower = 1;
+	}
+
+	return NL_SKIP;
+}
+
+struct nl80211_wiphy_info {
+	char phy[32];
+	int hwmodes;
+	int mbssid;
+};
+
+static int nl80211_get_wiphy_info_cb(struct nl_msg *msg, void *arg)
+{
+	struct nl80211_wiphy_info *wi = arg;
+
+	nl80211_ifname2phy_cb(msg, wi->phy);
+	nl80211_get_hwmodelist_cb(msg, &wi->hwmodes);
+	nl80211_get_ifcomb_cb(msg, &wi->mbssid);
+
+	return NL_SKIP;
+}
+
+/* Bulk variant of the scalar getters, every kernel query and config
+ * lookup is issued once and shared by all fields derived from it */
+int nl80211_get_info(const char *ifname, struct iwinfo_info *info)
+{
+	int i, chn;
+	char *res, *conf = NULL, dev[IFNAMSIZ], phy[16];
+	struct nl80211_iface_info ii = { .mode = IWINFO_OPMODE_UNKNOWN, .phyidx = -1 };
+	struct nl80211_wiphy_info wi = { .phy = { 0 } };
+	struct nl80211_ssid_bssid sb;
+	struct nl80211_rssi_rate rr;
+	struct nl80211_msg_conveyor *req;
+	const struct iwinfo_hardware_entry *hw = NULL;
+
+	memset(info, 0, sizeof(*info));
+
+	res = nl80211_phy2ifname(ifname);
+	snprintf(dev, sizeof(dev), "%s", res ? res : ifname);
+
+	/* mode and operating frequency */
+	req = nl80211_msg(dev, NL80211_CMD_GET_INTERFACE, 0);
+	if (req)
+	{
+		nl80211_send(req, nl80211_get_info_cb, &ii);
+		nl80211_free(req);
+	}
+
+	if (ii.mode != IWINFO_OPMODE_UNKNOWN)
+	{
+		info->mode = ii.mode;
+		info->valid |= IWINFO_INFO_MODE;
+	}
+
+	/* phy name, band capabilities and interface combinations, addressed
+	 * by the wiphy index from above to skip another name lookup */
+	if (ii.phyidx > -1)
+		snprintf(phy, sizeof(phy), "phy%d", ii.phyidx);
+	else
+		snprintf(phy, sizeof(phy), "%s", ifname);
+
+	req = nl80211_msg(phy, NL80211_CMD_GET_WIPHY, 0);
+	if (req)
+	{
+		nl80211_send(req, nl80211_get_wiphy_info_cb, &wi);
+		nl80211_free(req);
+	}
+
+	/* ssid and bssid of the joined network */
+	sb.ssid = (unsigned char *)info->ssid;
+	sb.bssid[0] = 0;
+
+	nl80211_dump(dev, NL80211_CMD_GET_SCAN,
+	             nl80211_get_ssid_bssid_cb, &sb, sizeof(sb));
+
+	/* access points take the rest from the hostapd config */
+	if (!info->ssid[0] || !sb.bssid[0] || !ii.freq)
+		conf = nl80211_hostapd_conf(ii.mode, wi.phy[0] ? wi.phy : NULL);
+
+	if (!info->ssid[0] && conf && (res = nl80211_getval(ifname, conf, "ssid")))
+		snprintf(info->ssid, sizeof(info->ssid), "%s", res);
+
+	if (info->ssid[0])
+		info->valid |= IWINFO_INFO_SSID;
+
+	if (!sb.bssid[0] && conf && (res = nl80211_getval(ifname, conf, "bssid")))
+	{
+		sb.bssid[0] = 1;
+
+		for (i = 0; i < 6; i++)
+			sb.bssid[i + 1] = strtol(&res[i * 3], NULL, 16);
+	}
+
+	if (sb.bssid[0])
+	{
+		sprintf(info->bssid, "%02X:%02X:%02X:%02X:%02X:%02X",
+		        sb.bssid[1], sb.bssid[2], sb.bssid[3],
+		        sb.bssid[4], sb.bssid[5], sb.bssid[6]);
+
+		info->valid |= IWINFO_INFO_BSSID;
+	}
+
+	if (!ii.freq && conf && (res = nl80211_getval(NULL, conf, "channel")))
+	{
+		chn = atoi(res);
+		ii.freq = nl80211_channel2freq(chn, nl80211_getval(NULL, conf, "hw_mode"));
+	}
+	else if (!ii.freq)
+	{
+		nl80211_dump(dev, NL80211_CMD_GET_SCAN,
+		             nl80211_get_frequency_scan_cb, &ii.freq, sizeof(ii.freq));
+	}
+
+	if (ii.freq)
+	{
+		info->frequency = ii.freq;
+		info->channel   = nl80211_freq2channel(ii.freq);
+		info->valid    |= IWINFO_INFO_FREQUENCY | IWINFO_INFO_CHANNEL;
+	}
+
+	/* signal, bitrate and quality from one station dump */
+	nl80211_fill_signal(ifname, &rr);
+
+	if (rr.rssi)
+	{
+		info->signal  = rr.rssi;
+		info->quality = nl80211_signal2quality(rr.rssi);
+		info->valid  |= IWINFO_INFO_SIGNAL | IWINFO_INFO_QUALITY;
+	}
+
+	if (rr.rate)
+	{
+		info->bitrate = rr.rate * 100;
+		info->valid  |= IWINFO_INFO_BITRATE;
+	}
+
+	if (!nl80211_get_quality_max(ifname, &info->quality_max))
+		info->valid |= IWINFO_INFO_QUALITY_MAX;
+
+	if (!nl80211_get_noise(ifname, &info->noise))
+		info->valid |= IWINFO_INFO_NOISE;
+
+	if (ii.has_txpower)
+	{
+		info->txpower = ii.txpower;
+		info->valid  |= IWINFO_INFO_TXPOWER;
+	}
+	else if (!nl80211_get_txpower(ifname, &info->txpower))
+	{
+		info->valid |= IWINFO_INFO_TXPOWER;
+	}
+
+	if (!nl80211_get_country(ifname, info->country))
+		info->valid |= IWINFO_INFO_COUNTRY;
+
+	if (wi.hwmodes)
+	{
+		info->hwmodes = wi.hwmodes;
+		info->valid  |= IWINFO_INFO_HWMODES;
+	}
+
+	if (wi.phy[0])
+	{
+		info->mbssid_support = wi.mbssid;
+		info->valid |= IWINFO_INFO_MBSSID_SUPPORT;
+	}
+
+	/* hardware name and offsets all derive from the same ids */
+	if (!nl80211_get_hardware_id(ifname, (char *)&info->hardware_id))
+	{
+		info->valid |= IWINFO_INFO_HARDWARE_ID;
+		hw = iwinfo_hardware(&info->hardware_id);
+	}
+
+	if (hw)
+	{
+		snprintf(info->hardware_name, sizeof(info->hardware_name), "%s %s",
+		         hw->vendor_name, hw->device_name);
+
+		info->txpower_offset   = hw->txpower_offset;
+		info->frequency_offset = hw->frequency_offset;
+		info->valid |= IWINFO_INFO_TXPOWER_OFFSET |
+		               IWINFO_INFO_FREQUENCY_OFFSET;
+	}
+	else
+	{
+		snprintf(info->hardware_name, sizeof(info->hardware_name),
+		         "Generic MAC80211");
+	}
+
+	info->valid |= IWINFO_INFO_HARDWARE_NAME;
+
+	if (!nl80211_get_encryption(ifname, (char *)&info->crypto))
+		info->valid |= IWINFO_INFO_ENCRYPTION;
+
+	return info->valid ? 0 : -1;
+}
@@ -489,6 +489,7 @@ int ra_get_encryption(const char *ifname, char *buf)
         return -1;
     memset(filename, 0, sizeof(filename));
     sprintf(filename, "/tmp/wifi_encryption_%s.dat",ifname);
+    IWINFO_STATS_COUNT(FILES, 1);
     fp = fopen(filename, "r");
     if(fp == NULL)
     {
@@ -0,0 +1,425 @@
+/*
+ * iwinfo - Wireless Information Library - Shared Memory Snapshots
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * A collector periodically publishes interface snapshots into fixed
+ * layout regions below IWINFO_SHM_DIR, any number of readers map them
+ * once and copy data out lock-free following the seqlock protocol
+ * described in iwinfo/shm.h. The shm_ops backend serves the usual
+ * operations from these snapshots.
+ */
+
+#include "iwinfo.h"
+#include "iwinfo/shm.h"
+
+
+struct shm_map {
+	char ifname[IFNAMSIZ];
+	int fd;
+	struct iwinfo_shm_region *r;
+};
+
+static struct shm_map shm_readers[IWINFO_SHM_MAPS];
+static struct shm_map shm_writers[IWINFO_SHM_MAPS];
+static int shm_evict = 0;
+
+static void shm_path(char *path, int len, const char *ifname)
+{
+	snprintf(path, len, "%s/iwinfo.%s", IWINFO_SHM_DIR, ifname);
+}
+
+static void shm_unmap(struct shm_map *m)
+{
+	if (!m->r)
+		return;
+
+	munmap(m->r, sizeof(*m->r));
+
+	if (m->fd > -1)
+		close(m->fd);
+
+	memset(m, 0, sizeof(*m));
+}
+
+static struct shm_map * shm_find(struct shm_map *maps, const char *ifname)
+{
+	int i;
+
+	for (i = 0; i < IWINFO_SHM_MAPS; i++)
+		if (maps[i].r && !strncmp(maps[i].ifname, ifname, IFNAMSIZ))
+			return &maps[i];
+
+	return NULL;
+}
+
+static struct shm_map * shm_slot(struct shm_map *maps)
+{
+	int i;
+
+	for (i = 0; i < IWINFO_SHM_MAPS; i++)
+		if (!maps[i].r)
+			return &maps[i];
+
+	i = shm_evict++ % IWINFO_SHM_MAPS;
+	shm_unmap(&maps[i]);
+
+	return &maps[i];
+}
+
+/* Regions are only trusted from root or ourselves, anybody may create files
+ * in IWINFO_SHM_DIR and a planted snapshot must not be served */
+static int shm_trusted(int fd)
+{
+	struct stat s;
+
+	if (fstat(fd, &s) || !S_ISREG(s.st_mode))
+		return 0;
+
+	return (s.st_uid == 0 || s.st_uid == geteuid());
+}
+
+/* Map the region of ifname read-only, the descriptor is not needed after
+ * mmap() so later reads do not involve any system call */
+static struct iwinfo_shm_region * shm_reader(const char *ifname)
+{
+	int fd;
+	char path[PATH_MAX];
+	struct stat s;
+	struct shm_map *m;
+	struct iwinfo_shm_region *r;
+
+	if ((m = shm_find(shm_readers, ifname)) != NULL)
+		return m->r;
+
+	shm_path(path, sizeof(path), ifname);
+
+	if ((fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC)) < 0)
+		return NULL;
+
+	if (!shm_trusted(fd) || fstat(fd, &s) || s.st_size != sizeof(*r))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	r = mmap(NULL, sizeof(*r), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (r == MAP_FAILED)
+		return NULL;
+
+	if (r->magic != IWINFO_SHM_MAGIC || r->size != sizeof(*r))
+	{
+		munmap(r, sizeof(*r));
+		return NULL;
+	}
+
+	m = shm_slot(shm_readers);
+	strncpy(m->ifname, ifname, sizeof(m->ifname) - 1);
+	m->fd = -1;
+	m->r = r;
+
+	return r;
+}
+
+/* The writer keeps its descriptor open to hold an exclusive lock, a second
+ * collector for the same interface would break the sequence protocol */
+static struct iwinfo_shm_region * shm_writer(const char *ifname)
+{
+	int fd;
+	char path[PATH_MAX];
+	struct shm_map *m;
+	struct iwinfo_shm_region *r;
+
+	if ((m = shm_find(shm_writers, ifname)) != NULL)
+		return m->r;
+
+	shm_path(path, sizeof(path), ifname);
+
+	if ((fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644)) < 0)
+		return NULL;
+
+	if (!shm_trusted(fd) ||
+	    flock(fd, LOCK_EX | LOCK_NB) || ftruncate(fd, sizeof(*r)))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	r = mmap(NULL, sizeof(*r), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (r == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	/* a crashed writer may have left seq odd */
+	if (r->magic != IWINFO_SHM_MAGIC || r->size != sizeof(*r) || (r->seq & 1))
+	{
+		r->seq = 0;
+		r->valid = 0;
+		r->size = sizeof(*r);
+		r->magic = IWINFO_SHM_MAGIC;
+	}
+
+	m = shm_slot(shm_writers);
+	strncpy(m->ifname, ifname, sizeof(m->ifname) - 1);
+	m->fd = fd;
+	m->r = r;
+
+	return r;
+}
+
+static int shm_stale(uint64_t stamp, int interval, int max_age)
+{
+	uint64_t age = iwinfo_msecs() - stamp;
+
+	if (max_age > 0)
+		return (age > max_age);
+
+	return (age > 2 * interval + IWINFO_SHM_SLACK);
+}
+
+/* Copy one section of the snapshot of ifname into buf, max_age limits the
+ * acceptable age in ms, zero derives it from the publishing interval. buf
+ * must hold IWINFO_BUFSIZE bytes for lists or a struct iwinfo_info. */
+int iwinfo_shm_read(const char *ifname, int section, int max_age,
+                    char *buf, int *len)
+{
+	int i, n, interval;
+	uint32_t seq, valid;
+	uint64_t stamp;
+	const void *src;
+	struct shm_map *m;
+	struct iwinfo_shm_region *r = shm_reader(ifname);
+
+	if (!r)
+		return -1;
+
+	for (i = 0; i < IWINFO_SHM_RETRIES; i++)
+	{
+		/* only yield to the publisher while it is midway an update */
+		if ((seq = r->seq) & 1)
+		{
+			sched_yield();
+			continue;
+		}
+
+		__sync_synchronize();
+
+		stamp    = r->stamp;
+		interval = r->interval;
+		valid    = r->valid;
+
+		switch (section)
+		{
+		case IWINFO_SHM_INFO:
+			n = sizeof(r->info);
+			src = &r->info;
+			break;
+
+		case IWINFO_SHM_ASSOC:
+			n = r->assoc_len;
+			src = r->assoc;
+			break;
+
+		case IWINFO_SHM_SURVEY:
+			n = r->survey_len;
+			src = r->survey;
+			break;
+
+		default:
+			return -1;
+		}
+
+		/* lengths may be torn, the sequence check below catches that */
+		if (n < 0 || n > IWINFO_BUFSIZE)
+			n = 0;
+
+		memcpy(buf, src, n);
+
+		__sync_synchronize();
+
+		if (r->seq == seq)
+			break;
+	}
+
+	if (i == IWINFO_SHM_RETRIES || !(valid & section))
+		return -1;
+
+	/* drop the mapping, the publisher may have recreated the file */
+	if (shm_stale(stamp, interval, max_age))
+	{
+		if ((m = shm_find(shm_readers, ifname)) != NULL)
+			shm_unmap(m);
+
+		return -1;
+	}
+
+	*len = n;
+	return 0;
+}
+
+/* Gather info, assoclist and survey of ifname and publish them, interval
+ * tells readers how often to expect updates */
+int iwinfo_shm_publish(const struct iwinfo_ops *ops, const char *ifname,
+                       int interval)
+{
+	int alen = 0, slen = 0;
+	uint32_t valid = 0;
+	struct iwinfo_info info;
+	static char abuf[IWINFO_BUFSIZE], sbuf[IWINFO_BUFSIZE];
+	struct iwinfo_shm_region *r;
+
+	/* republishing snapshots makes no sense */
+	if (ops->info == shm_get_info || !(r = shm_writer(ifname)))
+		return -1;
+
+	if (!iwinfo_info(ops, ifname, &info))
+		valid |= IWINFO_SHM_INFO;
+
+	if (!iwinfo_assoclist_ext(ops, ifname, abuf, &alen))
+		valid |= IWINFO_SHM_ASSOC;
+
+	if (ops->survey && !ops->survey(ifname, sbuf, &slen))
+		valid |= IWINFO_SHM_SURVEY;
+
+	/* everything is gathered, keep the write side as short as possible */
+	r->seq++;
+	__sync_synchronize();
+
+	r->info       = info;
+	r->assoc_len  = (valid & IWINFO_SHM_ASSOC) ? alen : 0;
+	r->survey_len = (valid & IWINFO_SHM_SURVEY) ? slen : 0;
+
+	memcpy(r->assoc, abuf, r->assoc_len);
+	memcpy(r->survey, sbuf, r->survey_len);
+
+	r->valid    = valid;
+	r->interval = interval;
+	r->stamp    = iwinfo_msecs();
+
+	__sync_synchronize();
+	r->seq++;
+
+	return valid ? 0 : -1;
+}
+
+
+/*
+ * shm_ops backend
+ */
+
+static int shm_info(const char *ifname, struct iwinfo_info *info)
+{
+	int len;
+
+	return iwinfo_shm_read(ifname, IWINFO_SHM_INFO, 0, (char *)info, &len);
+}
+
+#define SHM_GET_INT(op, flag)								\
+	int shm_get_##op(const char *ifname, int *buf)			\
+	{														\
+		struct iwinfo_info i;								\
+		if (shm_info(ifname, &i) || !(i.valid & IWINFO_INFO_##flag))	\
+			return -1;										\
+		*buf = i.op;										\
+		return 0;											\
+	}
+
+#define SHM_GET_DATA(op, flag, field)						\
+	int shm_get_##op(const char *ifname, char *buf)			\
+	{														\
+		struct iwinfo_info i;								\
+		if (shm_info(ifname, &i) || !(i.valid & IWINFO_INFO_##flag))	\
+			return -1;										\
+		memcpy(buf, &i.field, sizeof(i.field));				\
+		return 0;											\
+	}
+
+SHM_GET_INT(mode,             MODE)
+SHM_GET_INT(channel,          CHANNEL)
+SHM_GET_INT(frequency,        FREQUENCY)
+SHM_GET_INT(frequency_offset, FREQUENCY_OFFSET)
+SHM_GET_INT(txpower,          TXPOWER)
+SHM_GET_INT(txpower_offset,   TXPOWER_OFFSET)
+SHM_GET_INT(bitrate,          BITRATE)
+SHM_GET_INT(signal,           SIGNAL)
+SHM_GET_INT(noise,            NOISE)
+SHM_GET_INT(quality,          QUALITY)
+SHM_GET_INT(quality_max,      QUALITY_MAX)
+SHM_GET_INT(mbssid_support,   MBSSID_SUPPORT)
+
+SHM_GET_DATA(ssid,            SSID,          ssid)
+SHM_GET_DATA(bssid,           BSSID,         bssid)
+SHM_GET_DATA(country,         COUNTRY,       country)
+SHM_GET_DATA(hardware_id,     HARDWARE_ID,   hardware_id)
+SHM_GET_DATA(hardware_name,   HARDWARE_NAME, hardware_name)
+SHM_GET_DATA(encryption,      ENCRYPTION,    crypto)
+
+int shm_get_hwmodelist(const char *ifname, int *buf)
+{
+	struct iwinfo_info i;
+
+	if (shm_info(ifname, &i) || !(i.valid & IWINFO_INFO_HWMODES))
+		return -1;
+
+	*buf = i.hwmodes;
+	return 0;
+}
+
+int shm_get_info(const char *ifname, struct iwinfo_info *info)
+{
+	return shm_info(ifname, info);
+}
+
+int shm_get_assoclist(const char *ifname, char *buf, int *len)
+{
+	if (iwinfo_shm_read(ifname, IWINFO_SHM_ASSOC, 0, buf, len))
+		return -1;
+
+	iwinfo_assoclist_narrow(buf, len);
+	return 0;
+}
+
+int shm_get_assoclist_ext(const char *ifname, char *buf, int *len)
+{
+	return iwinfo_shm_read(ifname, IWINFO_SHM_ASSOC, 0, buf, len);
+}
+
+int shm_get_survey(const char *ifname, char *buf, int *len)
+{
+	return iwinfo_shm_read(ifname, IWINFO_SHM_SURVEY, 0, buf, len);
+}
+
+/* Whether a fresh snapshot of ifname holds the given section */
+int shm_probe(const char *ifname, int section)
+{
+	int len;
+	static char buf[IWINFO_BUFSIZE];
+
+	return !iwinfo_shm_read(ifname, section, 0, buf, &len);
+}
+
+void shm_close(void)
+{
+	int i;
+
+	for (i = 0; i < IWINFO_SHM_MAPS; i++)
+	{
+		shm_unmap(&shm_readers[i]);
+		shm_unmap(&shm_writers[i]);
+	}
+}
@@ -40,6 +40,8 @@ static int iwinfo_ioctl_socket(void)
 int iwinfo_ioctl(int cmd, void *ifr)
 {
 	int s = iwinfo_ioctl_socket();
+
+	IWINFO_STATS_COUNT(IOCTLS, 1);
 	return ioctl(s, cmd, ifr);
 }
 
@@ -133,6 +135,8 @@ struct iwinfo_hardware_entry * iwinfo_hardware(struct iwinfo_hardware_id *id)
 	char buf[256] = { 0 };
 	static struct iwinfo_hardware_entry e, *rv = NULL;
 
+	IWINFO_STATS_COUNT(FILES, 1);
+
 	if (!(db = fopen(IWINFO_HARDWARE_FILE, "r")))
 		return NULL;
 
@@ -177,6 +181,8 @@ int iwinfo_hardware_id_from_mtd(struct iwinfo_hardware_id *id)
 	int fd, len, off;
 	char buf[128];
 
+	IWINFO_STATS_COUNT(FILES, 1);
+
 	if (!(mtd = fopen("/proc/mtd", "r")))
 		return -1;
 
@@ -200,6 +206,8 @@ int iwinfo_hardware_id_from_mtd(struct iwinfo_hardware_id *id)
 
 	snprintf(buf, sizeof(buf), "/dev/mtdblock%d", off);
 
+	IWINFO_STATS_COUNT(FILES, 1);
+
 	if ((fd = open(buf, O_RDONLY)) < 0)
 		return -1;
 
@@ -261,105 +269,1364 @@ int iwinfo_hardware_id_from_mtd(struct iwinfo_hardware_id *id)
 	return (id->vendor_id && id->device_id) ? 0 : -1;
 }
 
+#define IWINFO_OUI_MS		0x0050f2
+#define IWINFO_OUI_IEEE80211	0x000fac
+
+#define IWINFO_SUITE_TYPES	32
+
+/* Suite flags indexed by OUI row (WPA, RSN) and suite type, so a lookup is
+ * one selector compare and one load */
+static const uint16_t iwinfo_cipher_suites[2][IWINFO_SUITE_TYPES] = {
+	[0] = {
+		[1]  = IWINFO_CIPHER_WEP40,
+		[2]  = IWINFO_CIPHER_TKIP,
+		[4]  = IWINFO_CIPHER_CCMP,
+		[5]  = IWINFO_CIPHER_WEP104,
+	},
+	[1] = {
+		[1]  = IWINFO_CIPHER_WEP40,
+		[2]  = IWINFO_CIPHER_TKIP,
+		[4]  = IWINFO_CIPHER_CCMP,
+		[5]  = IWINFO_CIPHER_WEP104,
+		[8]  = IWINFO_CIPHER_GCMP,
+		[9]  = IWINFO_CIPHER_GCMP256,
+		[10] = IWINFO_CIPHER_CCMP256,
+	},
+};
+
+/* FT and SHA-256/384 variants are folded into their base AKM */
+static const uint16_t iwinfo_akm_suites[2][IWINFO_SUITE_TYPES] = {
+	[0] = {
+		[1]  = IWINFO_KMGMT_8021x,
+		[2]  = IWINFO_KMGMT_PSK,
+	},
+	[1] = {
+		[1]  = IWINFO_KMGMT_8021x,
+		[2]  = IWINFO_KMGMT_PSK,
+		[3]  = IWINFO_KMGMT_8021x,	/* FT/802.1X */
+		[4]  = IWINFO_KMGMT_PSK,	/* FT/PSK */
+		[5]  = IWINFO_KMGMT_8021x,	/* 802.1X/SHA-256 */
+		[6]  = IWINFO_KMGMT_PSK,	/* PSK/SHA-256 */
+		[8]  = IWINFO_KMGMT_SAE,
+		[9]  = IWINFO_KMGMT_SAE,	/* FT/SAE */
+		[11] = IWINFO_KMGMT_8021x,	/* Suite B */
+		[12] = IWINFO_KMGMT_8021x,	/* Suite B 192 */
+		[13] = IWINFO_KMGMT_8021x,	/* FT/802.1X/SHA-384 */
+		[18] = IWINFO_KMGMT_OWE,
+		[24] = IWINFO_KMGMT_SAE,	/* SAE-EXT-KEY */
+		[25] = IWINFO_KMGMT_SAE,	/* FT/SAE-EXT-KEY */
+	},
+};
+
+static inline uint32_t iwinfo_suite_selector(const uint8_t *data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+	       ((uint32_t)data[2] << 8)  |  (uint32_t)data[3];
+}
+
+static inline uint16_t iwinfo_suite_lookup(const uint16_t map[][IWINFO_SUITE_TYPES],
+                                           const uint8_t *data)
+{
+	uint32_t sel = iwinfo_suite_selector(data);
+	uint8_t type = sel & 0xff;
+
+	/* proprietary or management frame protection suites map to 0 */
+	if (type >= IWINFO_SUITE_TYPES)
+		return 0;
+
+	switch (sel >> 8)
+	{
+	case IWINFO_OUI_MS:
+		return map[0][type];
+
+	case IWINFO_OUI_IEEE80211:
+		return map[1][type];
+
+	default:
+		return 0;
+	}
+}
+
+/* Decode a counted suite list, returns -1 if it overruns the element */
+static int iwinfo_suite_list(const uint16_t map[][IWINFO_SUITE_TYPES],
+                             uint8_t **data, int *len, uint16_t *flags)
+{
+	int i, count;
+
+	if (*len < 2)
+		return -1;
+
+	count = (*data)[0] | ((*data)[1] << 8);
+
+	if (2 + (count * 4) > *len)
+		return -1;
+
+	for (i = 0; i < count; i++)
+		*flags |= iwinfo_suite_lookup(map, *data + 2 + (i * 4));
+
+	*data += 2 + (count * 4);
+	*len  -= 2 + (count * 4);
+
+	return 0;
+}
+
 void iwinfo_parse_rsn(struct iwinfo_crypto_entry *c, uint8_t *data, uint8_t len,
-					  uint8_t defcipher, uint8_t defauth)
+					  uint16_t defcipher, uint8_t defauth)
 {
-	uint16_t i, count;
+	int left = len;
+	uint16_t suites = 0, ciphers = 0;
 
-	static unsigned char ms_oui[3]        = { 0x00, 0x50, 0xf2 };
-	static unsigned char ieee80211_oui[3] = { 0x00, 0x0f, 0xac };
+	/* version */
+	if (left < 2)
+		return;
 
 	data += 2;
-	len -= 2;
-
-	if (!memcmp(data, ms_oui, 3))
-		c->wpa_version += 1;
-	else if (!memcmp(data, ieee80211_oui, 3))
-		c->wpa_version += 2;
+	left -= 2;
 
-	if (len < 4)
+	/* group cipher, the OUI tells WPA and RSN apart */
+	if (left < 4)
 	{
-		c->group_ciphers |= defcipher;
-		c->pair_ciphers  |= defcipher;
-		c->auth_suites   |= defauth;
+		IWINFO_CRYPTO_ADD_CIPHERS(c, group, defcipher);
+		IWINFO_CRYPTO_ADD_CIPHERS(c, pair, defcipher);
+		c->auth_suites |= defauth;
 		return;
 	}
 
-	if (!memcmp(data, ms_oui, 3) || !memcmp(data, ieee80211_oui, 3))
+	switch (iwinfo_suite_selector(data) >> 8)
 	{
-		switch (data[3])
-		{
-			case 1: c->group_ciphers |= IWINFO_CIPHER_WEP40;  break;
-			case 2: c->group_ciphers |= IWINFO_CIPHER_TKIP;   break;
-			case 4: c->group_ciphers |= IWINFO_CIPHER_CCMP;   break;
-			case 5: c->group_ciphers |= IWINFO_CIPHER_WEP104; break;
-			case 6:  /* AES-128-CMAC */ break;
-			default: /* proprietary */  break;
-		}
+	case IWINFO_OUI_MS:
+		c->wpa_version += 1;
+		break;
+
+	case IWINFO_OUI_IEEE80211:
+		c->wpa_version += 2;
+		break;
 	}
 
+	IWINFO_CRYPTO_ADD_CIPHERS(c, group,
+		iwinfo_suite_lookup(iwinfo_cipher_suites, data));
+
 	data += 4;
-	len -= 4;
+	left -= 4;
 
-	if (len < 2)
+	/* pairwise ciphers */
+	if (left < 2)
 	{
-		c->pair_ciphers |= defcipher;
-		c->auth_suites  |= defauth;
+		IWINFO_CRYPTO_ADD_CIPHERS(c, pair, defcipher);
+		c->auth_suites |= defauth;
 		return;
 	}
 
-	count = data[0] | (data[1] << 8);
-	if (2 + (count * 4) > len)
+	if (iwinfo_suite_list(iwinfo_cipher_suites, &data, &left, &ciphers))
 		return;
 
-	for (i = 0; i < count; i++)
+	IWINFO_CRYPTO_ADD_CIPHERS(c, pair, ciphers);
+
+	/* key management */
+	if (left < 2)
 	{
-		if (!memcmp(data + 2 + (i * 4), ms_oui, 3) ||
-			!memcmp(data + 2 + (i * 4), ieee80211_oui, 3))
-		{
-			switch (data[2 + (i * 4) + 3])
-			{
-				case 1: c->pair_ciphers |= IWINFO_CIPHER_WEP40;  break;
-				case 2: c->pair_ciphers |= IWINFO_CIPHER_TKIP;   break;
-				case 4: c->pair_ciphers |= IWINFO_CIPHER_CCMP;   break;
-				case 5: c->pair_ciphers |= IWINFO_CIPHER_WEP104; break;
-				case 6:  /* AES-128-CMAC */ break;
-				default: /* proprietary */  break;
-			}
-		}
+		c->auth_suites |= defauth;
+		return;
 	}
 
-	data += 2 + (count * 4);
-	len -= 2 + (count * 4);
+	if (!iwinfo_suite_list(iwinfo_akm_suites, &data, &left, &suites))
+		c->auth_suites |= suites;
+}
+
+void * iwinfo_arena_alloc(struct iwinfo_arena *a, size_t len)
+{
+	void *p;
+	size_t size;
+	struct iwinfo_arena_chunk *c = a->chunks;
+
+	len = (len + 7) & ~7;
 
-	if (len < 2)
+	if (!c || (c->used + len) > c->size)
 	{
-		c->auth_suites |= defauth;
+		size = (len > IWINFO_ARENA_CHUNK) ? len : IWINFO_ARENA_CHUNK;
+
+		if (!(c = malloc(sizeof(*c) + size)))
+			return NULL;
+
+		c->size = size;
+		c->used = 0;
+		c->next = a->chunks;
+		a->chunks = c;
+	}
+
+	p = c->data + c->used;
+	c->used += len;
+
+	return p;
+}
+
+void iwinfo_arena_reset(struct iwinfo_arena *a)
+{
+	struct iwinfo_arena_chunk *c, *next;
+
+	/* keep the most recent chunk around for the next round */
+	if (!(c = a->chunks))
 		return;
+
+	while ((next = c->next) != NULL)
+	{
+		c->next = next->next;
+		free(next);
+	}
+
+	c->used = 0;
+}
+
+void iwinfo_arena_free(struct iwinfo_arena *a)
+{
+	struct iwinfo_arena_chunk *c, *next;
+
+	for (c = a->chunks; c; c = next)
+	{
+		next = c->next;
+		free(c);
 	}
 
-	count = data[0] | (data[1] << 8);
-	if (2 + (count * 4) > len)
+	a->chunks = NULL;
+}
+
+struct iwinfo_ie_blob * iwinfo_ie_blob(struct iwinfo_arena *a,
+                                       const uint8_t *ies, int len)
+{
+	struct iwinfo_ie_blob *b;
+
+	if (len <= 0 || len > 0xffff)
+		return NULL;
+
+	if (!(b = iwinfo_arena_alloc(a, sizeof(*b) + len)))
+		return NULL;
+
+	memset(b, 0, sizeof(*b));
+	memcpy(b->data, ies, len);
+	b->len = len;
+
+	return b;
+}
+
+/* Blob holding the IEs of b followed by the given ones, b itself stays in
+ * the arena until the next reset. On failure b is returned unchanged. */
+struct iwinfo_ie_blob * iwinfo_ie_blob_append(struct iwinfo_arena *a,
+                                              struct iwinfo_ie_blob *b,
+                                              const uint8_t *ies, int len)
+{
+	struct iwinfo_ie_blob *n;
+
+	if (!b)
+		return iwinfo_ie_blob(a, ies, len);
+
+	if (len <= 0 || b->len + len > 0xffff)
+		return b;
+
+	if (!(n = iwinfo_arena_alloc(a, sizeof(*n) + b->len + len)))
+		return b;
+
+	memset(n, 0, sizeof(*n));
+	memcpy(n->data, b->data, b->len);
+	memcpy(n->data + b->len, ies, len);
+	n->len = b->len + len;
+
+	return n;
+}
+
+static struct iwinfo_ie_set *ie_sets = NULL;
+
+static struct iwinfo_ie_set * iwinfo_ie_set_find(const char *ifname)
+{
+	struct iwinfo_ie_set *s;
+
+	for (s = ie_sets; s; s = s->next)
+		if (!strncmp(s->ifname, ifname, sizeof(s->ifname)))
+			break;
+
+	return s;
+}
+
+/* IE set of a device, created empty on first use */
+struct iwinfo_ie_set * iwinfo_ie_set(const char *ifname)
+{
+	struct iwinfo_ie_set *s;
+
+	if ((s = iwinfo_ie_set_find(ifname)) != NULL)
+		return s;
+
+	if (!(s = calloc(1, sizeof(*s))))
+		return NULL;
+
+	snprintf(s->ifname, sizeof(s->ifname), "%s", ifname);
+	iwinfo_ie_set_reset(s);
+
+	s->next = ie_sets;
+	ie_sets = s;
+
+	return s;
+}
+
+/* Start over for a new scan, blobs handed out before become invalid */
+void iwinfo_ie_set_reset(struct iwinfo_ie_set *s)
+{
+	int i;
+
+	iwinfo_arena_reset(&s->arena);
+	s->count = 0;
+
+	for (i = 0; i < IWINFO_IE_SET_SLOTS; i++)
+		s->index[i] = -1;
+}
+
+static int iwinfo_ie_set_slot(const struct iwinfo_ie_set *s,
+                              const uint8_t *mac)
+{
+	int i;
+	uint32_t hash = 2166136261U;
+
+	/* FNV-1a */
+	for (i = 0; i < 6; i++)
+		hash = (hash ^ mac[i]) * 16777619U;
+
+	for (i = hash % IWINFO_IE_SET_SLOTS;
+	     s->index[i] > -1 && memcmp(s->refs[s->index[i]].mac, mac, 6);
+	     i = (i + 1) % IWINFO_IE_SET_SLOTS);
+
+	return i;
+}
+
+/* Attach blob b, allocated from the arena of s, to the given BSSID */
+void iwinfo_ie_set_put(struct iwinfo_ie_set *s, const uint8_t *mac,
+                       struct iwinfo_ie_blob *b)
+{
+	int slot;
+
+	if (!b)
 		return;
 
-	for (i = 0; i < count; i++)
+	slot = iwinfo_ie_set_slot(s, mac);
+
+	if (s->index[slot] < 0)
+	{
+		if (s->count >= IWINFO_IE_SET_MAX)
+			return;
+
+		s->index[slot] = s->count;
+		memcpy(s->refs[s->count++].mac, mac, 6);
+	}
+
+	s->refs[s->index[slot]].ies = b;
+}
+
+struct iwinfo_ie_blob * iwinfo_ie_set_get(const struct iwinfo_ie_set *s,
+                                          const uint8_t *mac)
+{
+	int slot = iwinfo_ie_set_slot(s, mac);
+
+	return (s->index[slot] > -1) ? s->refs[s->index[slot]].ies : NULL;
+}
+
+void iwinfo_ie_sets_free(void)
+{
+	struct iwinfo_ie_set *s;
+
+	while ((s = ie_sets) != NULL)
+	{
+		ie_sets = s->next;
+		iwinfo_arena_free(&s->arena);
+		free(s);
+	}
+}
+
+const uint8_t * iwinfo_ie_find(const struct iwinfo_scanlist_ext_entry *e,
+                               uint8_t id, const uint8_t *prev)
+{
+	const uint8_t *ie, *end;
+
+	if (!e->ies)
+		return NULL;
+
+	ie  = prev ? (prev + prev[1] + 2) : e->ies->data;
+	end = e->ies->data + e->ies->len;
+
+	while ((ie + 2) <= end && (ie + ie[1] + 2) <= end)
+	{
+		if (ie[0] == id)
+			return ie;
+
+		ie += ie[1] + 2;
+	}
+
+	return NULL;
+}
+
+const uint8_t * iwinfo_ie_vendor(const struct iwinfo_scanlist_ext_entry *e,
+                                 const uint8_t *oui, const uint8_t *prev)
+{
+	const uint8_t *ie = prev;
+
+	while ((ie = iwinfo_ie_find(e, 221, ie)) != NULL)
+		if (ie[1] >= 3 && !memcmp(ie + 2, oui, 3))
+			return ie;
+
+	return NULL;
+}
+
+/* Decode the given IE once per scan and memoize the result in the blob */
+static int iwinfo_ie_decode(struct iwinfo_scanlist_ext_entry *e, uint8_t what)
+{
+	const uint8_t *ie;
+	struct iwinfo_ie_blob *b = e->ies;
+
+	if (!b)
+		return 0;
+
+	if (b->decoded & what)
+		return (b->present & what);
+
+	b->decoded |= what;
+
+	switch (what)
 	{
-		if (!memcmp(data + 2 + (i * 4), ms_oui, 3) ||
-			!memcmp(data + 2 + (i * 4), ieee80211_oui, 3))
+	case IWINFO_IE_HT_OPERATION:
+		if ((ie = iwinfo_ie_find(e, 61, NULL)) != NULL && ie[1] >= 2)
 		{
-			switch (data[2 + (i * 4) + 3])
-			{
-				case 1: c->auth_suites |= IWINFO_KMGMT_8021x; break;
-				case 2: c->auth_suites |= IWINFO_KMGMT_PSK;   break;
-				case 3:  /* FT/IEEE 802.1X */                 break;
-				case 4:  /* FT/PSK */                         break;
-				case 5:  /* IEEE 802.1X/SHA-256 */            break;
-				case 6:  /* PSK/SHA-256 */                    break;
-				default: /* proprietary */                    break;
-			}
+			b->ht.primary_channel  = ie[2];
+			b->ht.secondary_offset = ie[3] & 0x03;
+			b->ht.chan_width       = (ie[3] & 0x04) ? 40 : 20;
+			b->present |= what;
+		}
+		break;
+
+	case IWINFO_IE_VHT_OPERATION:
+		if ((ie = iwinfo_ie_find(e, 192, NULL)) != NULL && ie[1] >= 3)
+		{
+			b->vht.chan_width    = ie[2];
+			b->vht.center_chan_1 = ie[3];
+			b->vht.center_chan_2 = ie[4];
+			b->present |= what;
+		}
+		break;
+
+	case IWINFO_IE_BSS_LOAD:
+		if ((ie = iwinfo_ie_find(e, 11, NULL)) != NULL && ie[1] >= 5)
+		{
+			b->load.station_count       = ie[2] | (ie[3] << 8);
+			b->load.channel_utilization = ie[4];
+			b->load.admission_capacity  = ie[5] | (ie[6] << 8);
+			b->present |= what;
+		}
+		break;
+
+	case IWINFO_IE_COUNTRY:
+		if ((ie = iwinfo_ie_find(e, 7, NULL)) != NULL && ie[1] >= 3)
+		{
+			b->country.ccode[0]    = ie[2];
+			b->country.ccode[1]    = ie[3];
+			b->country.ccode[2]    = 0;
+			b->country.environment = ie[4];
+			b->present |= what;
 		}
+		break;
+	}
+
+	return (b->present & what);
+}
+
+int iwinfo_ie_ht_operation(struct iwinfo_scanlist_ext_entry *e,
+                           struct iwinfo_ht_operation *ht)
+{
+	if (!iwinfo_ie_decode(e, IWINFO_IE_HT_OPERATION))
+		return -1;
+
+	*ht = e->ies->ht;
+	return 0;
+}
+
+int iwinfo_ie_vht_operation(struct iwinfo_scanlist_ext_entry *e,
+                            struct iwinfo_vht_operation *vht)
+{
+	if (!iwinfo_ie_decode(e, IWINFO_IE_VHT_OPERATION))
+		return -1;
+
+	*vht = e->ies->vht;
+	return 0;
+}
+
+int iwinfo_ie_bss_load(struct iwinfo_scanlist_ext_entry *e,
+                       struct iwinfo_bss_load *load)
+{
+	if (!iwinfo_ie_decode(e, IWINFO_IE_BSS_LOAD))
+		return -1;
+
+	*load = e->ies->load;
+	return 0;
+}
+
+int iwinfo_ie_country(struct iwinfo_scanlist_ext_entry *e,
+                      struct iwinfo_country_ie *country)
+{
+	if (!iwinfo_ie_decode(e, IWINFO_IE_COUNTRY))
+		return -1;
+
+	*country = e->ies->country;
+	return 0;
+}
+
+
+/*
+ * List filtering. Backends apply the cheap criteria while decoding, the
+ * generic pass below covers everything they leave out.
+ */
+
+void iwinfo_filter_channel(struct iwinfo_filter *f, int channel)
+{
+	if (channel > 0 && channel < 256)
+		f->channels[channel / 32] |= (1U << (channel % 32));
+}
+
+void iwinfo_filter_frequency(struct iwinfo_filter *f, int mhz)
+{
+	if (mhz == 2484)
+		iwinfo_filter_channel(f, 14);
+	else if (mhz < 2484)
+		iwinfo_filter_channel(f, (mhz - 2407) / 5);
+	else if (mhz >= 4910 && mhz <= 4980)
+		iwinfo_filter_channel(f, (mhz - 4000) / 5);
+	else
+		iwinfo_filter_channel(f, (mhz - 5000) / 5);
+}
+
+int iwinfo_filter_signal(const struct iwinfo_filter *f, int signal)
+{
+	return (!f->min_signal || signal >= f->min_signal) &&
+	       (!f->max_signal || signal <= f->max_signal);
+}
+
+int iwinfo_filter_has_channel(const struct iwinfo_filter *f, int channel)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		if (f->channels[i])
+			return (channel > 0 && channel < 256 &&
+			        (f->channels[channel / 32] & (1U << (channel % 32))));
+
+	return 1;
+}
+
+int iwinfo_filter_ssid(const struct iwinfo_filter *f,
+                       const uint8_t *ssid, int len)
+{
+	if (!f->ssid[0])
+		return 1;
+
+	return (len == strlen(f->ssid) && !memcmp(ssid, f->ssid, len));
+}
+
+int iwinfo_filter_assoc(const struct iwinfo_filter *f,
+                        const struct iwinfo_assoclist_entry *e)
+{
+	return iwinfo_filter_signal(f, e->signal) &&
+	       (!f->max_inactive || e->inactive <= f->max_inactive);
+}
+
+int iwinfo_filter_scan(const struct iwinfo_filter *f,
+                       const struct iwinfo_scanlist_entry *e)
+{
+	return iwinfo_filter_signal(f, iwinfo_scan_signal(e)) &&
+	       iwinfo_filter_has_channel(f, e->channel) &&
+	       iwinfo_filter_ssid(f, e->ssid, strlen((const char *)e->ssid));
+}
+
+int iwinfo_assoc_signal(const void *e)
+{
+	return ((const struct iwinfo_assoclist_entry *)e)->signal;
+}
+
+int iwinfo_scan_signal(const void *e)
+{
+	return (int)((const struct iwinfo_scanlist_entry *)e)->signal - 0x100;
+}
+
+
+/*
+ * Bounded top-N selection: a min-heap on signal holds the N strongest
+ * entries seen so far, its root is the one to evict next.
+ */
+
+static void iwinfo_heap_swap(char *base, size_t size, int a, int b)
+{
+	char tmp[size];
+
+	memcpy(tmp, base + a * size, size);
+	memcpy(base + a * size, base + b * size, size);
+	memcpy(base + b * size, tmp, size);
+}
+
+static void iwinfo_heap_down(char *base, int count, size_t size, int i,
+                             int (*signal)(const void *))
+{
+	int l, r, m;
+
+	while (1)
+	{
+		l = 2 * i + 1;
+		r = l + 1;
+		m = i;
+
+		if (l < count && signal(base + l * size) < signal(base + m * size))
+			m = l;
+
+		if (r < count && signal(base + r * size) < signal(base + m * size))
+			m = r;
+
+		if (m == i)
+			break;
+
+		iwinfo_heap_swap(base, size, i, m);
+		i = m;
 	}
+}
+
+int iwinfo_topn_push(void *base, int *count, int n, size_t size,
+                     const void *entry, int (*signal)(const void *))
+{
+	int i, p;
+	char *b = base;
+
+	if (*count < n)
+	{
+		memmove(b + *count * size, entry, size);
 
-	data += 2 + (count * 4);
-	len -= 2 + (count * 4);
+		for (i = (*count)++; i > 0; i = p)
+		{
+			p = (i - 1) / 2;
+
+			if (signal(b + p * size) <= signal(b + i * size))
+				break;
+
+			iwinfo_heap_swap(b, size, i, p);
+		}
+
+		return 1;
+	}
+
+	if (signal(entry) <= signal(b))
+		return 0;
+
+	memmove(b, entry, size);
+	iwinfo_heap_down(b, *count, size, 0, signal);
+
+	return 1;
+}
+
+/* Turn a heap built by iwinfo_topn_push() into a list ordered strongest
+ * first by repeatedly moving the weakest entry to the end */
+void iwinfo_topn_sort(void *base, int count, size_t size,
+                      int (*signal)(const void *))
+{
+	while (count > 1)
+	{
+		iwinfo_heap_swap(base, size, 0, --count);
+		iwinfo_heap_down(base, count, size, 0, signal);
+	}
+}
+
+static void iwinfo_filter_list(const struct iwinfo_filter *f, char *buf,
+                               int *len, size_t size,
+                               int (*match)(const struct iwinfo_filter *,
+                                            const void *),
+                               int (*signal)(const void *))
+{
+	int i, count = 0;
+
+	for (i = 0; i < *len / size; i++)
+	{
+		if (!match(f, buf + i * size))
+			continue;
+
+		if (f->top)
+			iwinfo_topn_push(buf, &count, f->top, size, buf + i * size, signal);
+		else if (count++ != i)
+			memmove(buf + (count - 1) * size, buf + i * size, size);
+	}
+
+	if (f->top)
+		iwinfo_topn_sort(buf, count, size, signal);
+
+	*len = count * size;
+}
+
+static int iwinfo_filter_assoc_match(const struct iwinfo_filter *f,
+                                     const void *e)
+{
+	return iwinfo_filter_assoc(f, e);
+}
+
+static int iwinfo_filter_scan_match(const struct iwinfo_filter *f,
+                                    const void *e)
+{
+	return iwinfo_filter_scan(f, e);
+}
+
+void iwinfo_filter_assoclist(const struct iwinfo_filter *f, char *buf, int *len)
+{
+	iwinfo_filter_list(f, buf, len, sizeof(struct iwinfo_assoclist_ext_entry),
+	                   iwinfo_filter_assoc_match, iwinfo_assoc_signal);
+}
+
+void iwinfo_filter_scanlist(const struct iwinfo_filter *f, char *buf, int *len)
+{
+	iwinfo_filter_list(f, buf, len, sizeof(struct iwinfo_scanlist_entry),
+	                   iwinfo_filter_scan_match, iwinfo_scan_signal);
+}
+
+/*
+ * Conversion between the original assoclist layout and extended entries,
+ * both done in place. Widening drops the entries which do not fit into
+ * max bytes, the wide packet counters only get the low 32 bit.
+ */
+void iwinfo_assoclist_widen(char *buf, int *len, int max)
+{
+	int i, count = *len / sizeof(struct iwinfo_assoclist_entry);
+	struct iwinfo_assoclist_entry e;
+	struct iwinfo_assoclist_ext_entry *x;
+
+	if (count > max / sizeof(*x))
+		count = max / sizeof(*x);
+
+	/* back to front, every entry moves to a higher offset */
+	for (i = count - 1; i >= 0; i--)
+	{
+		memcpy(&e, buf + i * sizeof(e), sizeof(e));
+
+		x = (struct iwinfo_assoclist_ext_entry *)buf + i;
+		memset(x, 0, sizeof(*x));
+
+		x->base = e;
+		x->rx_packets = e.rx_packets;
+		x->tx_packets = e.tx_packets;
+	}
+
+	*len = count * sizeof(*x);
+}
+
+void iwinfo_assoclist_narrow(char *buf, int *len)
+{
+	int i, count = *len / sizeof(struct iwinfo_assoclist_ext_entry);
+	struct iwinfo_assoclist_ext_entry *x;
+
+	/* front to back, every entry moves to a lower offset */
+	for (i = 0, x = (struct iwinfo_assoclist_ext_entry *)buf; i < count; i++, x++)
+	{
+		x->base.rx_packets = x->rx_packets;
+		x->base.tx_packets = x->tx_packets;
+
+		memmove(buf + i * sizeof(x->base), &x->base, sizeof(x->base));
+	}
+
+	*len = count * sizeof(struct iwinfo_assoclist_entry);
+}
+
+/* Turn plain scan entries into extended ones, IEs are attached from the
+ * set of the last scan of ifname if given */
+void iwinfo_scanlist_widen(const char *ifname, char *buf, int *len, int max)
+{
+	int i, count = *len / sizeof(struct iwinfo_scanlist_entry);
+	struct iwinfo_scanlist_entry e;
+	struct iwinfo_scanlist_ext_entry *x;
+	struct iwinfo_ie_set *s = ifname ? iwinfo_ie_set_find(ifname) : NULL;
+
+	if (count > max / sizeof(*x))
+		count = max / sizeof(*x);
+
+	/* back to front, every entry moves to a higher offset */
+	for (i = count - 1; i >= 0; i--)
+	{
+		memcpy(&e, buf + i * sizeof(e), sizeof(e));
+
+		x = (struct iwinfo_scanlist_ext_entry *)buf + i;
+		x->base = e;
+		x->ies = s ? iwinfo_ie_set_get(s, e.mac) : NULL;
+	}
+
+	*len = count * sizeof(*x);
+}
+
+/*
+ * Scan result merging: entries are deduplicated by BSSID through an open
+ * addressing index, the strongest sighting of each BSS is kept.
+ */
+static int iwinfo_scan_merge_slot(struct iwinfo_scan_merge *m,
+                                  const uint8_t *mac)
+{
+	int i;
+	uint32_t hash = 2166136261U;
+
+	/* FNV-1a */
+	for (i = 0; i < 6; i++)
+		hash = (hash ^ mac[i]) * 16777619U;
+
+	for (i = hash % IWINFO_SCAN_MERGE_SLOTS;
+	     m->index[i] > -1 && memcmp(m->e[m->index[i]].bss.mac, mac, 6);
+	     i = (i + 1) % IWINFO_SCAN_MERGE_SLOTS);
+
+	return i;
+}
+
+void iwinfo_scan_merge_init(struct iwinfo_scan_merge *m, char *buf, int len)
+{
+	int i;
+
+	m->e = (struct iwinfo_scan_multi_entry *)buf;
+	m->count = 0;
+	m->max = len / sizeof(struct iwinfo_scan_multi_entry);
+
+	for (i = 0; i < IWINFO_SCAN_MERGE_SLOTS; i++)
+		m->index[i] = -1;
+}
+
+void iwinfo_scan_merge_add(struct iwinfo_scan_merge *m, const char *buf,
+                           int len, uint32_t radios)
+{
+	int i, slot;
+	struct iwinfo_scan_multi_entry *me;
+	const struct iwinfo_scanlist_entry *e;
+
+	for (i = 0; i < len; i += sizeof(struct iwinfo_scanlist_entry))
+	{
+		e = (const struct iwinfo_scanlist_entry *)&buf[i];
+		slot = iwinfo_scan_merge_slot(m, e->mac);
+
+		if (m->index[slot] > -1)
+		{
+			me = &m->e[m->index[slot]];
+
+			if (iwinfo_scan_signal(e) > iwinfo_scan_signal(&me->bss))
+				me->bss = *e;
+		}
+		else if (m->count < m->max)
+		{
+			m->index[slot] = m->count;
+			me = &m->e[m->count++];
+			me->radios = 0;
+			me->bss = *e;
+		}
+		else
+		{
+			continue;
+		}
+
+		me->radios |= radios;
+	}
+}
+
+/* Monotonic clock in milliseconds */
+uint64_t iwinfo_msecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Name resolution already done by a long lived handle, backends consult
+ * it before asking the kernel again. An empty ifname clears it.
+ */
+static struct {
+	char ifname[IFNAMSIZ];
+	char phy[IFNAMSIZ];
+	int ifindex;
+} iwinfo_resolved_hint;
+
+void iwinfo_resolved(const char *ifname, int ifindex, const char *phy)
+{
+	memset(&iwinfo_resolved_hint, 0, sizeof(iwinfo_resolved_hint));
+
+	if (!ifname || strlen(ifname) >= IFNAMSIZ)
+		return;
+
+	strcpy(iwinfo_resolved_hint.ifname, ifname);
+	iwinfo_resolved_hint.ifindex = ifindex;
+
+	if (phy && strlen(phy) < IFNAMSIZ)
+		strcpy(iwinfo_resolved_hint.phy, phy);
+}
+
+int iwinfo_resolved_ifindex(const char *ifname)
+{
+	if (!iwinfo_resolved_hint.ifname[0] ||
+	    strcmp(ifname, iwinfo_resolved_hint.ifname))
+		return 0;
+
+	return iwinfo_resolved_hint.ifindex;
+}
+
+const char * iwinfo_resolved_phy(const char *ifname)
+{
+	if (!iwinfo_resolved_hint.phy[0] ||
+	    strcmp(ifname, iwinfo_resolved_hint.ifname))
+		return NULL;
+
+	return iwinfo_resolved_hint.phy;
+}
+
+/*
+ * Station rate tracking: every interface keeps a ring of the recent
+ * counter samples per station, stations missing from a sample are dropped.
+ */
+enum {
+	IWINFO_RATE_RX_BYTES,
+	IWINFO_RATE_TX_BYTES,
+	IWINFO_RATE_RX_PACKETS,
+	IWINFO_RATE_TX_PACKETS,
+	IWINFO_RATE_TX_RETRIES,
+	IWINFO_RATE_TX_FAILED,
+	IWINFO_RATE_COUNTERS
+};
+
+struct iwinfo_rate_sample {
+	uint64_t stamp;
+	uint64_t c[IWINFO_RATE_COUNTERS];
+};
+
+struct iwinfo_rate_station {
+	uint8_t mac[6];
+	uint8_t seen;
+	int head;
+	int count;
+	uint32_t connected_time;
+	uint64_t raw[IWINFO_RATE_COUNTERS];
+	struct iwinfo_rate_sample ring[IWINFO_RATE_SAMPLES];
+};
+
+struct iwinfo_rate_table {
+	struct iwinfo_rate_table *next;
+	char ifname[IFNAMSIZ];
+	int count;
+	int size;
+	struct iwinfo_rate_station *sta;
+};
+
+static struct iwinfo_rate_table *rate_tables = NULL;
+
+static void iwinfo_rates_raw(const struct iwinfo_assoclist_ext_entry *e,
+                             uint64_t *c)
+{
+	c[IWINFO_RATE_RX_BYTES]   = e->rx_bytes;
+	c[IWINFO_RATE_TX_BYTES]   = e->tx_bytes;
+	c[IWINFO_RATE_RX_PACKETS] = e->rx_packets;
+	c[IWINFO_RATE_TX_PACKETS] = e->tx_packets;
+	c[IWINFO_RATE_TX_RETRIES] = e->tx_retries;
+	c[IWINFO_RATE_TX_FAILED]  = e->tx_failed;
+}
+
+static uint64_t iwinfo_rates_delta(uint64_t cur, uint64_t prev)
+{
+	if (cur >= prev)
+		return cur - prev;
+
+	/* 32 bit driver counter wrapped */
+	if (prev <= 0xFFFFFFFFULL && (prev - cur) > 0x80000000ULL)
+		return cur + 0x100000000ULL - prev;
+
+	/* counter was reset */
+	return cur;
+}
+
+static uint16_t iwinfo_rates_ratio(uint64_t part, uint64_t rest)
+{
+	return (part + rest) ? (part * 10000) / (part + rest) : 0;
+}
+
+static struct iwinfo_rate_table * iwinfo_rates_table(const char *ifname)
+{
+	struct iwinfo_rate_table *t;
+
+	for (t = rate_tables; t; t = t->next)
+		if (!strncmp(t->ifname, ifname, sizeof(t->ifname)))
+			return t;
+
+	t = calloc(1, sizeof(*t));
+
+	if (!t)
+		return NULL;
+
+	strncpy(t->ifname, ifname, sizeof(t->ifname) - 1);
+	t->next = rate_tables;
+	rate_tables = t;
+
+	return t;
+}
+
+static struct iwinfo_rate_station *
+iwinfo_rates_station(struct iwinfo_rate_table *t, const uint8_t *mac)
+{
+	int i;
+	struct iwinfo_rate_station *st;
+
+	for (i = 0; i < t->count; i++)
+		if (!memcmp(t->sta[i].mac, mac, 6))
+			return &t->sta[i];
+
+	if (t->count == t->size)
+	{
+		st = realloc(t->sta, (t->size + 16) * sizeof(*st));
+
+		if (!st)
+			return NULL;
+
+		t->sta = st;
+		t->size += 16;
+	}
+
+	st = &t->sta[t->count++];
+	memset(st, 0, sizeof(*st));
+	memcpy(st->mac, mac, 6);
+
+	return st;
+}
+
+static void iwinfo_rates_sample(struct iwinfo_rate_station *st,
+                                const struct iwinfo_assoclist_ext_entry *e,
+                                uint64_t now)
+{
+	int k, reset;
+	uint64_t raw[IWINFO_RATE_COUNTERS];
+	struct iwinfo_rate_sample *prev, *cur;
+
+	iwinfo_rates_raw(e, raw);
+
+	/* a reassociated station starts over, do not mistake it for a wrap */
+	reset = (e->connected_time && e->connected_time < st->connected_time);
+
+	prev = &st->ring[st->head];
+	st->head = (st->head + 1) % IWINFO_RATE_SAMPLES;
+	cur = &st->ring[st->head];
+
+	for (k = 0; k < IWINFO_RATE_COUNTERS; k++)
+	{
+		if (!st->count)
+			cur->c[k] = raw[k];
+		else
+			cur->c[k] = prev->c[k] +
+				(reset ? raw[k] : iwinfo_rates_delta(raw[k], st->raw[k]));
+
+		st->raw[k] = raw[k];
+	}
+
+	cur->stamp = now;
+	st->connected_time = e->connected_time;
+
+	if (st->count < IWINFO_RATE_SAMPLES)
+		st->count++;
+}
+
+static void iwinfo_rates_calc(const struct iwinfo_rate_station *st,
+                              int window, struct iwinfo_assoclist_rates *r)
+{
+	uint64_t d[IWINFO_RATE_COUNTERS], dt;
+	const struct iwinfo_rate_sample *cur, *old;
+	int k;
+
+	if (window > st->count - 1)
+		window = st->count - 1;
+
+	cur = &st->ring[st->head];
+	old = &st->ring[(st->head + IWINFO_RATE_SAMPLES - window) %
+	                IWINFO_RATE_SAMPLES];
+
+	memset(r, 0, sizeof(*r));
+	memcpy(r->mac, st->mac, 6);
+
+	r->rx_bytes   = cur->c[IWINFO_RATE_RX_BYTES];
+	r->tx_bytes   = cur->c[IWINFO_RATE_TX_BYTES];
+	r->rx_packets = cur->c[IWINFO_RATE_RX_PACKETS];
+	r->tx_packets = cur->c[IWINFO_RATE_TX_PACKETS];
+
+	dt = cur->stamp - old->stamp;
+
+	if (!window || !dt)
+		return;
+
+	for (k = 0; k < IWINFO_RATE_COUNTERS; k++)
+		d[k] = cur->c[k] - old->c[k];
+
+	r->interval       = dt;
+	r->rx_byte_rate   = d[IWINFO_RATE_RX_BYTES] * 1000 / dt;
+	r->tx_byte_rate   = d[IWINFO_RATE_TX_BYTES] * 1000 / dt;
+	r->rx_packet_rate = d[IWINFO_RATE_RX_PACKETS] * 1000 / dt;
+	r->tx_packet_rate = d[IWINFO_RATE_TX_PACKETS] * 1000 / dt;
+	r->tx_retry_ratio = iwinfo_rates_ratio(d[IWINFO_RATE_TX_RETRIES],
+	                                       d[IWINFO_RATE_TX_PACKETS]);
+	r->tx_fail_ratio  = iwinfo_rates_ratio(d[IWINFO_RATE_TX_FAILED],
+	                                       d[IWINFO_RATE_TX_PACKETS]);
+}
+
+/* Feed one assoclist sample of ifname into the tracker and compute the
+ * rates of each station over the last window samples into r. */
+int iwinfo_rates_update(const char *ifname,
+                        const struct iwinfo_assoclist_ext_entry *e, int count,
+                        int window, struct iwinfo_assoclist_rates *r)
+{
+	int i, n;
+	uint64_t now = iwinfo_msecs();
+	struct iwinfo_rate_table *t;
+	struct iwinfo_rate_station *st;
+
+	if (!(t = iwinfo_rates_table(ifname)))
+		return -1;
+
+	if (window < 1)
+		window = 1;
+	else if (window > IWINFO_RATE_SAMPLES - 1)
+		window = IWINFO_RATE_SAMPLES - 1;
+
+	for (i = 0; i < t->count; i++)
+		t->sta[i].seen = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!(st = iwinfo_rates_station(t, e[i].base.mac)))
+			return -1;
+
+		iwinfo_rates_sample(st, &e[i], now);
+		iwinfo_rates_calc(st, window, &r[i]);
+		st->seen = 1;
+	}
+
+	for (i = 0, n = 0; i < t->count; i++)
+		if (t->sta[i].seen && n++ != i)
+			t->sta[n - 1] = t->sta[i];
+
+	t->count = n;
+
+	return 0;
+}
+
+void iwinfo_rates_free(void)
+{
+	struct iwinfo_rate_table *t;
+
+	while ((t = rate_tables) != NULL)
+	{
+		rate_tables = t->next;
+		free(t->sta);
+		free(t);
+	}
+}
+
+/*
+ * Cross-process scan coalescing: the results of the last scan of a phy
+ * are kept in a file stamped with their completion time, a lock file
+ * serializes scanners so late comers wait for and reuse a running scan.
+ */
+#define IWINFO_SCAN_CACHE_PATH	64
+
+struct iwinfo_scan_cache_hdr {
+	uint32_t magic;
+	uint32_t count;
+	uint64_t stamp;
+};
+
+static int scan_window = -1;
+
+/* Set the reuse window in ms, zero disables coalescing. Defaults to
+ * IWINFO_SCAN_WINDOW ms or the IWINFO_SCAN_WINDOW environment variable. */
+void iwinfo_scan_coalesce(int window)
+{
+	scan_window = window;
+}
+
+static int iwinfo_scan_window(void)
+{
+	char *env;
+
+	if (scan_window < 0)
+	{
+		env = getenv("IWINFO_SCAN_WINDOW");
+		scan_window = env ? atoi(env) : IWINFO_SCAN_WINDOW;
+	}
+
+	return scan_window;
+}
+
+static int iwinfo_scan_cache_load(const char *path, struct iwinfo_ie_set *ies,
+                                  int window, char *buf, int *len)
+{
+	int i, fd, size, rv = -1;
+	uint16_t ielen;
+	struct stat st;
+	struct iwinfo_scan_cache_hdr *h;
+	struct iwinfo_scanlist_entry *e;
+	uint8_t *map, *p, *end;
+
+	IWINFO_STATS_COUNT(FILES, 1);
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+
+	if (fstat(fd, &st) || st.st_size < sizeof(*h) ||
+	    !(map = malloc(st.st_size)))
+	{
+		close(fd);
+		return -1;
+	}
+
+	size = read(fd, map, st.st_size);
+	close(fd);
+
+	h = (struct iwinfo_scan_cache_hdr *)map;
+	p = map + sizeof(*h);
+	end = map + ((size > 0) ? size : 0);
+
+	if (size != st.st_size || h->magic != IWINFO_SCAN_CACHE_MAGIC ||
+	    iwinfo_msecs() - h->stamp > window ||
+	    h->count > IWINFO_BUFSIZE / sizeof(*e) ||
+	    p + h->count * sizeof(*e) > end)
+		goto out;
+
+	memcpy(buf, p, h->count * sizeof(*e));
+	p += h->count * sizeof(*e);
+
+	/* a length prefixed IE record follows for every entry, zero if none */
+	iwinfo_ie_set_reset(ies);
+
+	for (i = 0, e = (struct iwinfo_scanlist_entry *)buf; i < h->count; i++, e++)
+	{
+		if (p + sizeof(ielen) > end)
+			goto out;
+
+		memcpy(&ielen, p, sizeof(ielen));
+		p += sizeof(ielen);
+
+		if (p + ielen > end)
+			goto out;
+
+		iwinfo_ie_set_put(ies, e->mac, iwinfo_ie_blob(&ies->arena, p, ielen));
+		p += ielen;
+	}
+
+	*len = h->count * sizeof(*e);
+	rv = 0;
+
+out:
+	free(map);
+	return rv;
+}
+
+static void iwinfo_scan_cache_store(const char *path, struct iwinfo_ie_set *ies,
+                                    const char *buf, int len)
+{
+	int i, fd;
+	uint16_t ielen;
+	struct iwinfo_ie_blob *b;
+	char tmp[IWINFO_SCAN_CACHE_PATH + 12];
+	FILE *f;
+	const struct iwinfo_scanlist_entry *e;
+	struct iwinfo_scan_cache_hdr h = {
+		.magic = IWINFO_SCAN_CACHE_MAGIC,
+		.count = len / sizeof(*e),
+		.stamp = iwinfo_msecs()
+	};
+
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+
+	IWINFO_STATS_COUNT(FILES, 1);
+
+	/* the name is predictable, never write through whatever is there */
+	unlink(tmp);
+
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+	               0644)) < 0)
+		return;
+
+	if (!(f = fdopen(fd, "w")))
+	{
+		close(fd);
+		unlink(tmp);
+		return;
+	}
+
+	fwrite(&h, sizeof(h), 1, f);
+	fwrite(buf, sizeof(*e), h.count, f);
+
+	for (i = 0, e = (const struct iwinfo_scanlist_entry *)buf; i < h.count; i++, e++)
+	{
+		b = iwinfo_ie_set_get(ies, e->mac);
+		ielen = b ? b->len : 0;
+
+		fwrite(&ielen, sizeof(ielen), 1, f);
+
+		if (b)
+			fwrite(b->data, 1, b->len, f);
+	}
+
+	if (fclose(f) || rename(tmp, path))
+		unlink(tmp);
+}
+
+/* Run scan for ifname unless a scan of the same key completed within the
+ * reuse window, waiting for a scan in progress in another process first.
+ * Only complete result sets may be stored for others to reuse. */
+int iwinfo_scan_shared(const char *key, const char *ifname, char *buf,
+                       int *len, int store,
+                       int (*scan)(const char *, char *, int *))
+{
+	static int held = 0;
+	int fd, rv, waited, window = iwinfo_scan_window();
+	char path[IWINFO_SCAN_CACHE_PATH], lock[IWINFO_SCAN_CACHE_PATH + 8];
+	struct timespec ts = { 0, 10 * 1000 * 1000 };
+	struct iwinfo_ie_set *ies;
+
+	/* nested scans on pseudo or temporary interfaces hold the lock already */
+	if (held || window <= 0 || !(ies = iwinfo_ie_set(ifname)))
+		return scan(ifname, buf, len);
+
+	snprintf(path, sizeof(path), IWINFO_SCAN_CACHE_DIR "/iwinfo-scan.%s", key);
+	snprintf(lock, sizeof(lock), "%s.lock", path);
+
+	if (!iwinfo_scan_cache_load(path, ies, window, buf, len))
+		return 0;
+
+	IWINFO_STATS_COUNT(FILES, 1);
+
+	if ((fd = open(lock, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644)) < 0)
+		return scan(ifname, buf, len);
+
+	/* a stuck holder must not hang us, scan without the lock after a while */
+	for (waited = 0; flock(fd, LOCK_EX | LOCK_NB); waited += 10)
+	{
+		if ((errno != EWOULDBLOCK && errno != EINTR) ||
+		    waited >= IWINFO_SCAN_LOCK_WAIT)
+		{
+			close(fd);
+			return scan(ifname, buf, len);
+		}
+
+		nanosleep(&ts, NULL);
+	}
+
+	/* somebody else may have finished scanning while we waited */
+	if (!iwinfo_scan_cache_load(path, ies, window, buf, len))
+	{
+		rv = 0;
+	}
+	else
+	{
+		held = 1;
+		rv = scan(ifname, buf, len);
+		held = 0;
+
+		if (!rv && store)
+			iwinfo_scan_cache_store(path, ies, buf, *len);
+	}
+
+	flock(fd, LOCK_UN);
+	close(fd);
+
+	return rv;
 }
@@ -459,6 +459,7 @@ static char * wext_sysfs_ifname_file(const char *ifname, const char *path)
 	char *rv = NULL;
 
 	snprintf(buf, sizeof(buf), "/sys/class/net/%s/%s", ifname, path);
+	IWINFO_STATS_COUNT(FILES, 1);
 
 	if ((f = fopen(buf, "r")) != NULL)
 	{
@@ -217,7 +217,7 @@ static inline void wext_fill_wpa(unsigned char *iebuf, int ielen, struct iwinfo_
 {
 	static unsigned char ms_oui[3] = { 0x00, 0x50, 0xf2 };
 
-	while (ielen >= 2 && ielen >= iebuf[1])
+	while (ielen >= 2 && ielen >= iebuf[1] + 2)
 	{
 		switch (iebuf[0])
 		{
@@ -240,7 +240,8 @@ static inline void wext_fill_wpa(unsigned char *iebuf, int ielen, struct iwinfo_
 
 
 static inline void wext_fill_entry(struct stream_descr *stream, struct iw_event *event,
-	struct iw_range *iw_range, int has_range, struct iwinfo_scanlist_entry *e)
+	struct iw_range *iw_range, int has_range, struct iwinfo_scanlist_entry *e,
+	struct iwinfo_ie_set *ies, struct iwinfo_ie_blob **blob)
 {
 	int i;
 	double freq;
@@ -331,11 +332,18 @@ static inline void wext_fill_entry(struct stream_descr *stream, struct iw_event
 #endif
 		 case IWEVGENIE:
 			wext_fill_wpa(event->u.data.pointer, event->u.data.length, e);
+
+			/* drivers report WPA and RSN as separate events */
+			if (ies)
+				*blob = iwinfo_ie_blob_append(&ies->arena, *blob,
+				                              event->u.data.pointer,
+				                              event->u.data.length);
 			break;
 	}
 }
 
 
+/* IEs reported by the driver are kept in the IE set of ifname */
 int wext_get_scanlist(const char *ifname, char *buf, int *len)
 {
 	struct iwreq wrq;
@@ -349,6 +357,13 @@ int wext_get_scanlist(const char *ifname, char *buf, int *len)
 
 	int entrylen = 0;
 	struct iwinfo_scanlist_entry e;
+	struct iwinfo_ie_blob *blob = NULL;
+	struct iwinfo_ie_set *ies = iwinfo_ie_set(ifname);
+
+	memset(&e, 0, sizeof(e));
+
+	if (ies)
+		iwinfo_ie_set_reset(ies);
 
 	wrq.u.data.pointer = (caddr_t) &range;
 	wrq.u.data.length  = sizeof(struct iw_range);
@@ -497,6 +512,9 @@ int wext_get_scanlist(const char *ifname, char *buf, int *len)
 
 								memcpy(&buf[entrylen], &e, sizeof(struct iwinfo_scanlist_entry));
 								entrylen += sizeof(struct iwinfo_scanlist_entry);
+
+								if (ies)
+									iwinfo_ie_set_put(ies, e.mac, blob);
 							}
 							else
 							{
@@ -505,9 +523,11 @@ int wext_get_scanlist(const char *ifname, char *buf, int *len)
 							}
 
 							memset(&e, 0, sizeof(struct iwinfo_scanlist_entry));
+							blob = NULL;
 						}
 
-						wext_fill_entry(&stream, &iwe, &range, has_range, &e);
+						wext_fill_entry(&stream, &iwe, &range, has_range, &e,
+						                ies, &blob);
 					}
 
 				} while(ret > 0);
@@ -525,3 +545,12 @@ int wext_get_scanlist(const char *ifname, char *buf, int *len)
 
 	return -1;
 }
+
+int wext_get_scanlist_ext(const char *ifname, char *buf, int *len)
+{
+	if (wext_get_scanlist(ifname, buf, len))
+		return -1;
+
+	iwinfo_scanlist_widen(ifname, buf, len, IWINFO_BUFSIZE);
+	return 0;
+}
@@ -386,27 +386,36 @@ int wl_get_enctype(const char *ifname, char *buf)
 	return 0;
 }
 
-static void wl_get_assoclist_cb(const char *ifname,
-							    struct iwinfo_assoclist_entry *e)
+static int wl_get_assoclist_cb(const char *ifname,
+							   struct iwinfo_assoclist_ext_entry *e)
 {
 	wl_sta_info_t sta = { 0 };
 
-	if (!wl_iovar(ifname, "sta_info", e->mac, 6, &sta, sizeof(sta)) &&
-		(sta.ver >= 2))
+	if (wl_iovar(ifname, "sta_info", e->base.mac, 6, &sta, sizeof(sta)))
+		return -1;
+
+	if (sta.ver >= 2)
 	{
-		e->inactive     = sta.idle * 1000;
-		e->rx_packets   = sta.rx_ucast_pkts;
-		e->tx_packets   = sta.tx_pkts;
-		e->rx_rate.rate = sta.rx_rate;
-		e->tx_rate.rate = sta.tx_rate;
+		e->base.inactive     = sta.idle * 1000;
+		e->base.rx_packets   = sta.rx_ucast_pkts;
+		e->base.tx_packets   = sta.tx_pkts;
+		e->base.rx_rate.rate = sta.rx_rate;
+		e->base.tx_rate.rate = sta.tx_rate;
+
+		e->connected_time = sta.in;
+		e->rx_packets     = sta.rx_ucast_pkts;
+		e->tx_packets     = sta.tx_pkts;
+		e->tx_failed      = sta.tx_failures;
 
 		/* ToDo: 11n */
-		e->rx_rate.mcs = -1;
-		e->tx_rate.mcs = -1;
+		e->base.rx_rate.mcs = -1;
+		e->base.tx_rate.mcs = -1;
 	}
+
+	return 0;
 }
 
-int wl_get_assoclist(const char *ifname, char *buf, int *len)
+int wl_get_assoclist_ext(const char *ifname, char *buf, int *len)
 {
 	int i, j, noise;
 	int ap, infra, passive;
@@ -415,7 +424,7 @@ int wl_get_assoclist(const char *ifname, char *buf, int *len)
 	char devstr[IFNAMSIZ];
 	struct wl_maclist *macs;
 	struct wl_sta_rssi rssi;
-	struct iwinfo_assoclist_entry entry;
+	struct iwinfo_assoclist_ext_entry entry;
 	FILE *arp;
 
 	ap = infra = passive = 0;
@@ -429,18 +438,19 @@ int wl_get_assoclist(const char *ifname, char *buf, int *len)
 
 	if ((ap || infra || passive) && ((macs = wl_read_assoclist(ifname)) != NULL))
 	{
-		for (i = 0, j = 0; i < macs->count; i++, j += sizeof(struct iwinfo_assoclist_entry))
+		for (i = 0, j = 0; i < macs->count && j + sizeof(entry) <= IWINFO_BUFSIZE;
+		     i++, j += sizeof(entry))
 		{
 			memset(&entry, 0, sizeof(entry));
 			memcpy(rssi.mac, &macs->ea[i], 6);
 
 			if (!wl_ioctl(ifname, WLC_GET_RSSI, &rssi, sizeof(struct wl_sta_rssi)))
-				entry.signal = (rssi.rssi - 0x100);
+				entry.base.signal = (rssi.rssi - 0x100);
 			else
-				entry.signal = 0;
+				entry.base.signal = 0;
 
-			entry.noise = noise;
-			memcpy(entry.mac, &macs->ea[i], 6);
+			entry.base.noise = noise;
+			memcpy(entry.base.mac, &macs->ea[i], 6);
 			wl_get_assoclist_cb(ifname, &entry);
 
 			memcpy(&buf[j], &entry, sizeof(entry));
@@ -450,11 +460,16 @@ int wl_get_assoclist(const char *ifname, char *buf, int *len)
 		free(macs);
 		return 0;
 	}
-	else if ((arp = fopen("/proc/net/arp", "r")) != NULL)
+
+	IWINFO_STATS_COUNT(FILES, 1);
+
+	if ((arp = fopen("/proc/net/arp", "r")) != NULL)
 	{
 		j = 0;
+		memset(&entry, 0, sizeof(entry));
 
-		while (fgets(line, sizeof(line), arp) != NULL)
+		while (fgets(line, sizeof(line), arp) != NULL &&
+		       j + sizeof(entry) <= IWINFO_BUFSIZE)
 		{
 			if (sscanf(line, "%*s 0x%*d 0x%*d %17s %*s %s", macstr, devstr) && !strcmp(devstr, ifname))
 			{
@@ -466,12 +481,12 @@ int wl_get_assoclist(const char *ifname, char *buf, int *len)
 				rssi.mac[5] = strtol(&macstr[15], NULL, 16);
 
 				if (!wl_ioctl(ifname, WLC_GET_RSSI, &rssi, sizeof(struct wl_sta_rssi)))
-					entry.signal = (rssi.rssi - 0x100);
+					entry.base.signal = (rssi.rssi - 0x100);
 				else
-					entry.signal = 0;
+					entry.base.signal = 0;
 
-				entry.noise = noise;
-				memcpy(entry.mac, rssi.mac, 6);
+				entry.base.noise = noise;
+				memcpy(entry.base.mac, rssi.mac, 6);
 				memcpy(&buf[j], &entry, sizeof(entry));
 
 				j += sizeof(entry);
@@ -486,6 +501,39 @@ int wl_get_assoclist(const char *ifname, char *buf, int *len)
 	return -1;
 }
 
+int wl_get_assoclist(const char *ifname, char *buf, int *len)
+{
+	if (wl_get_assoclist_ext(ifname, buf, len))
+		return -1;
+
+	iwinfo_assoclist_narrow(buf, len);
+	return 0;
+}
+
+int wl_get_station(const char *ifname, const uint8_t *mac,
+                   struct iwinfo_assoclist_ext_entry *e)
+{
+	int noise;
+	struct wl_sta_rssi rssi;
+
+	memset(e, 0, sizeof(*e));
+	memcpy(e->base.mac, mac, 6);
+
+	/* sta_info fails for unknown peers, no need to walk the maclist */
+	if (wl_get_assoclist_cb(ifname, e))
+		return -1;
+
+	memcpy(rssi.mac, mac, 6);
+
+	if (!wl_ioctl(ifname, WLC_GET_RSSI, &rssi, sizeof(struct wl_sta_rssi)))
+		e->base.signal = (rssi.rssi - 0x100);
+
+	if (!wl_get_noise(ifname, &noise))
+		e->base.noise = noise;
+
+	return 0;
+}
+
 int wl_get_txpwrlist(const char *ifname, char *buf, int *len)
 {
 	struct iwinfo_txpwrlist_entry entry;
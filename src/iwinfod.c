@@ -0,0 +1,694 @@
+/*
+ * iwinfod - Wireless Information Library - Query Daemon
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ *
+ * The daemon owns the netlink and control socket connections of all
+ * backends and answers queries from the cache as long as the per
+ * operation TTL allows. Binary queries use the layout in iwinfo/daemon.h,
+ * a line like {"op":"channel","ifname":"wlan0"} is answered with
+ * {"rv":0,"value":36} for the scalar and string operations. Scans run
+ * asynchronously where the backend supports it, the client asking for the
+ * scan list is answered once the results arrive while everybody else is
+ * served meanwhile.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <poll.h>
+#include <signal.h>
+
+#include "iwinfo.h"
+#include "iwinfo/daemon.h"
+
+
+#define IWINFOD_CLIENTS		32
+#define IWINFOD_CACHE		256
+#define IWINFOD_LINE		512
+#define IWINFOD_SCANS		8
+#define IWINFOD_SCAN_TIMEOUT	10000	/* ms */
+#define IWINFOD_FAIL_TTL	1000	/* ms */
+
+enum iwinfod_kind {
+	IWINFOD_INT,
+	IWINFOD_STRING,
+	IWINFOD_DATA,
+	IWINFOD_INFO,
+	IWINFOD_LIST,
+};
+
+struct iwinfod_op {
+	const char *name;
+	enum iwinfod_kind kind;
+	int size;
+	int ttl;
+	size_t offset;
+};
+
+#define IWINFOD_OP(OP, op, kind, size, ttl) \
+	[IWINFO_DAEMON_##OP] = { #op, kind, size, ttl, offsetof(struct iwinfo_ops, op) }
+
+/* Link metrics expire quickly, configuration after a few seconds and
+ * hardware properties hardly ever */
+static const struct iwinfod_op iwinfod_ops[__IWINFO_DAEMON_OP_MAX] = {
+	[IWINFO_DAEMON_TYPE] = { "type", IWINFOD_STRING, 16, 60000, 0 },
+	[IWINFO_DAEMON_INFO] = { "info", IWINFOD_INFO, sizeof(struct iwinfo_info), 1000, 0 },
+
+	IWINFOD_OP(MODE,             mode,             IWINFOD_INT,    sizeof(int), 5000),
+	IWINFOD_OP(CHANNEL,          channel,          IWINFOD_INT,    sizeof(int), 5000),
+	IWINFOD_OP(FREQUENCY,        frequency,        IWINFOD_INT,    sizeof(int), 5000),
+	IWINFOD_OP(FREQUENCY_OFFSET, frequency_offset, IWINFOD_INT,    sizeof(int), 60000),
+	IWINFOD_OP(TXPOWER,          txpower,          IWINFOD_INT,    sizeof(int), 5000),
+	IWINFOD_OP(TXPOWER_OFFSET,   txpower_offset,   IWINFOD_INT,    sizeof(int), 60000),
+	IWINFOD_OP(BITRATE,          bitrate,          IWINFOD_INT,    sizeof(int), 1000),
+	IWINFOD_OP(SIGNAL,           signal,           IWINFOD_INT,    sizeof(int), 1000),
+	IWINFOD_OP(NOISE,            noise,            IWINFOD_INT,    sizeof(int), 1000),
+	IWINFOD_OP(QUALITY,          quality,          IWINFOD_INT,    sizeof(int), 1000),
+	IWINFOD_OP(QUALITY_MAX,      quality_max,      IWINFOD_INT,    sizeof(int), 60000),
+	IWINFOD_OP(MBSSID_SUPPORT,   mbssid_support,   IWINFOD_INT,    sizeof(int), 60000),
+	IWINFOD_OP(HWMODELIST,       hwmodelist,       IWINFOD_INT,    sizeof(int), 60000),
+	IWINFOD_OP(SSID,             ssid,             IWINFOD_STRING, IWINFO_ESSID_MAX_SIZE + 1, 5000),
+	IWINFOD_OP(BSSID,            bssid,            IWINFOD_STRING, 18, 5000),
+	IWINFOD_OP(COUNTRY,          country,          IWINFOD_STRING, 3, 5000),
+	IWINFOD_OP(HARDWARE_ID,      hardware_id,      IWINFOD_DATA,   sizeof(struct iwinfo_hardware_id), 60000),
+	IWINFOD_OP(HARDWARE_NAME,    hardware_name,    IWINFOD_STRING, 128, 60000),
+	IWINFOD_OP(PHYNAME,          phyname,          IWINFOD_STRING, IFNAMSIZ, 60000),
+	IWINFOD_OP(ENCRYPTION,       encryption,       IWINFOD_DATA,   sizeof(struct iwinfo_crypto_entry), 5000),
+	IWINFOD_OP(ASSOCLIST,        assoclist,        IWINFOD_LIST,   IWINFO_BUFSIZE, 1000),
+	IWINFOD_OP(TXPWRLIST,        txpwrlist,        IWINFOD_LIST,   IWINFO_BUFSIZE, 60000),
+	IWINFOD_OP(SCANLIST,         scanlist,         IWINFOD_LIST,   IWINFO_BUFSIZE, 10000),
+	IWINFOD_OP(FREQLIST,         freqlist,         IWINFOD_LIST,   IWINFO_BUFSIZE, 60000),
+	IWINFOD_OP(SURVEY,           survey,           IWINFOD_LIST,   IWINFO_BUFSIZE, 2000),
+	IWINFOD_OP(COUNTRYLIST,      countrylist,      IWINFOD_LIST,   IWINFO_BUFSIZE, 60000),
+	IWINFOD_OP(ASSOCLIST_EXT,    assoclist_ext,    IWINFOD_LIST,   IWINFO_BUFSIZE, 1000),
+};
+
+struct iwinfod_entry {
+	char ifname[IFNAMSIZ];
+	int op;
+	int rv;
+	int len;
+	uint64_t stamp;
+	char *data;
+};
+
+struct iwinfod_client {
+	int fd;
+	int len;
+	int pending;
+	char buf[IWINFOD_LINE];
+};
+
+/* A scan in flight, waiting has a bit set for every client slot that asked
+ * for its results */
+struct iwinfod_scan {
+	char ifname[IFNAMSIZ];
+	const struct iwinfo_ops *ops;
+	struct iwinfo_scan scan;
+	uint64_t deadline;
+	uint32_t waiting;
+};
+
+static struct iwinfod_entry cache[IWINFOD_CACHE];
+static struct iwinfod_client clients[IWINFOD_CLIENTS];
+static struct iwinfod_scan scans[IWINFOD_SCANS];
+static volatile sig_atomic_t running = 1;
+
+
+static void iwinfod_signal(int sig)
+{
+	running = 0;
+}
+
+static int iwinfod_run(int op, const char *ifname, char *buf, int *len)
+{
+	int rv;
+	void *fn;
+	const char *type;
+	const struct iwinfo_ops *ops;
+	const struct iwinfod_op *o = &iwinfod_ops[op];
+
+	if (op == IWINFO_DAEMON_TYPE)
+	{
+		if (!(type = iwinfo_type(ifname)))
+			return -1;
+
+		*len = strlen(type) + 1;
+		memcpy(buf, type, *len);
+		return 0;
+	}
+
+	if (!(ops = iwinfo_backend(ifname)))
+		return -1;
+
+	if (op == IWINFO_DAEMON_INFO)
+	{
+		*len = sizeof(struct iwinfo_info);
+		return iwinfo_info(ops, ifname, (struct iwinfo_info *)buf);
+	}
+
+	if (!(fn = *(void **)((char *)ops + o->offset)))
+		return -1;
+
+	switch (o->kind)
+	{
+	case IWINFOD_INT:
+		*len = sizeof(int);
+		return ((int (*)(const char *, int *))fn)(ifname, (int *)buf);
+
+	case IWINFOD_STRING:
+		memset(buf, 0, o->size);
+		rv = ((int (*)(const char *, char *))fn)(ifname, buf);
+		buf[o->size - 1] = 0;
+		*len = strlen(buf) + 1;
+		return rv;
+
+	case IWINFOD_DATA:
+		*len = o->size;
+		return ((int (*)(const char *, char *))fn)(ifname, buf);
+
+	case IWINFOD_LIST:
+		*len = 0;
+		rv = ((int (*)(const char *, char *, int *))fn)(ifname, buf, len);
+
+		if (*len < 0 || *len > IWINFO_BUFSIZE)
+			*len = 0;
+
+		return rv;
+
+	default:
+		return -1;
+	}
+}
+
+/* Find the cache entry of op on ifname, *slot is set to it or to the entry
+ * making room for it. Returns the entry if it is still fresh, failures
+ * expire sooner so a device showing up is noticed quickly. */
+static struct iwinfod_entry * iwinfod_lookup(int op, const char *ifname,
+                                             struct iwinfod_entry **slot)
+{
+	int i, ttl;
+	struct iwinfod_entry *e = NULL, *oldest = &cache[0];
+
+	for (i = 0; i < IWINFOD_CACHE; i++)
+	{
+		if (cache[i].data && cache[i].op == op &&
+		    !strncmp(cache[i].ifname, ifname, IFNAMSIZ))
+		{
+			e = &cache[i];
+			break;
+		}
+
+		if (!cache[i].data)
+			oldest = &cache[i];
+		else if (oldest->data && cache[i].stamp < oldest->stamp)
+			oldest = &cache[i];
+	}
+
+	*slot = e ? e : oldest;
+
+	if (!e)
+		return NULL;
+
+	ttl = iwinfod_ops[op].ttl;
+
+	if (e->rv && ttl > IWINFOD_FAIL_TTL)
+		ttl = IWINFOD_FAIL_TTL;
+
+	return (iwinfo_msecs() - e->stamp < ttl) ? e : NULL;
+}
+
+/* Remember the result of op in e, the least recently refreshed entry is
+ * reused if op was not cached yet */
+static struct iwinfod_entry * iwinfod_store(struct iwinfod_entry *e, int op,
+                                            const char *ifname, int rv,
+                                            char *buf, int len)
+{
+	char *data;
+
+	if (e->data && (e->op != op || strncmp(e->ifname, ifname, IFNAMSIZ)))
+	{
+		free(e->data);
+		memset(e, 0, sizeof(*e));
+	}
+
+	if (!(data = realloc(e->data, len ? len : 1)))
+	{
+		free(e->data);
+		memset(e, 0, sizeof(*e));
+		return NULL;
+	}
+
+	memcpy(data, buf, len);
+	strncpy(e->ifname, ifname, sizeof(e->ifname) - 1);
+
+	e->op    = op;
+	e->rv    = rv;
+	e->len   = (rv == 0) ? len : 0;
+	e->data  = data;
+	e->stamp = iwinfo_msecs();
+
+	return e;
+}
+
+/* Answer op from the cache or run it and remember the result */
+static struct iwinfod_entry * iwinfod_query(int op, const char *ifname)
+{
+	int rv, len = 0;
+	static char buf[IWINFO_BUFSIZE];
+	struct iwinfod_entry *e, *slot;
+
+	if ((e = iwinfod_lookup(op, ifname, &slot)) != NULL)
+		return e;
+
+	rv = iwinfod_run(op, ifname, buf, &len);
+
+	return iwinfod_store(slot, op, ifname, rv, buf, len);
+}
+
+static int iwinfod_send(int fd, const void *buf, int len)
+{
+	int n;
+	const char *p = buf;
+
+	while (len > 0)
+	{
+		if ((n = send(fd, p, len, MSG_NOSIGNAL)) < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0)
+			return -1;
+
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int iwinfod_reply(int fd, struct iwinfod_entry *e)
+{
+	struct iwinfo_daemon_res res = { .rv = -1 };
+
+	if (e)
+	{
+		res.rv = e->rv;
+		res.len = e->len;
+	}
+
+	if (iwinfod_send(fd, &res, sizeof(res)))
+		return -1;
+
+	return res.len ? iwinfod_send(fd, e->data, res.len) : 0;
+}
+
+/* Start scanning ifname on behalf of client slot c or join the scan already
+ * running there, returns -1 if the backend cannot scan asynchronously */
+static int iwinfod_scan_start(const char *ifname, int c)
+{
+	int i, slot = -1;
+	struct iwinfod_scan *s;
+	const struct iwinfo_ops *ops;
+
+	for (i = 0; i < IWINFOD_SCANS; i++)
+	{
+		if (!scans[i].ops)
+			slot = (slot < 0) ? i : slot;
+		else if (!strncmp(scans[i].ifname, ifname, IFNAMSIZ))
+			break;
+	}
+
+	if (i < IWINFOD_SCANS)
+	{
+		scans[i].waiting |= (1U << c);
+		return 0;
+	}
+
+	if (slot < 0 || !(ops = iwinfo_backend(ifname)) || !ops->scan_trigger)
+		return -1;
+
+	s = &scans[slot];
+	memset(s, 0, sizeof(*s));
+	s->scan.fd = -1;
+
+	if (ops->scan_trigger(ifname, &s->scan))
+		return -1;
+
+	snprintf(s->ifname, sizeof(s->ifname), "%s", ifname);
+	s->ops = ops;
+	s->deadline = iwinfo_msecs() + IWINFOD_SCAN_TIMEOUT;
+	s->waiting = (1U << c);
+
+	return 0;
+}
+
+static int iwinfod_binary(struct iwinfod_client *c, struct iwinfo_daemon_req *req)
+{
+	struct iwinfod_entry *e = NULL, *slot;
+
+	req->ifname[IFNAMSIZ - 1] = 0;
+
+	if (req->magic != IWINFO_DAEMON_MAGIC)
+		return -1;
+
+	if (req->op >= __IWINFO_DAEMON_OP_MAX)
+		return iwinfod_reply(c->fd, NULL);
+
+	/* a scan would block everybody else, answer once its results are in */
+	if (req->op == IWINFO_DAEMON_SCANLIST &&
+	    !iwinfod_lookup(req->op, req->ifname, &slot) &&
+	    !iwinfod_scan_start(req->ifname, c - clients))
+	{
+		c->pending = 1;
+		return 0;
+	}
+
+	e = iwinfod_query(req->op, req->ifname);
+
+	return iwinfod_reply(c->fd, e);
+}
+
+/* Extract the string value of "key" from a flat JSON object */
+static int iwinfod_json_get(const char *line, const char *key,
+                            char *out, int len)
+{
+	int i;
+	char pat[32];
+	const char *p;
+
+	snprintf(pat, sizeof(pat), "\"%s\"", key);
+
+	if (!(p = strstr(line, pat)))
+		return -1;
+
+	for (p += strlen(pat); *p == ' ' || *p == ':'; p++);
+
+	if (*p++ != '"')
+		return -1;
+
+	for (i = 0; *p && *p != '"' && i < len - 1; i++)
+		out[i] = *p++;
+
+	out[i] = 0;
+	return 0;
+}
+
+static int iwinfod_json(int fd, const char *line)
+{
+	int op, n;
+	char name[32], ifname[IFNAMSIZ];
+	char out[IWINFOD_LINE];
+	const char *p;
+	struct iwinfod_entry *e = NULL;
+
+	if (iwinfod_json_get(line, "op", name, sizeof(name)) ||
+	    iwinfod_json_get(line, "ifname", ifname, sizeof(ifname)))
+		return iwinfod_send(fd, "{\"rv\":-1}\n", 10);
+
+	for (op = 0; op < __IWINFO_DAEMON_OP_MAX; op++)
+		if (!strcmp(iwinfod_ops[op].name, name))
+			break;
+
+	if (op == __IWINFO_DAEMON_OP_MAX ||
+	    (iwinfod_ops[op].kind != IWINFOD_INT &&
+	     iwinfod_ops[op].kind != IWINFOD_STRING) ||
+	    !(e = iwinfod_query(op, ifname)) || e->rv)
+		return iwinfod_send(fd, "{\"rv\":-1}\n", 10);
+
+	if (iwinfod_ops[op].kind == IWINFOD_INT)
+		return iwinfod_send(fd, out, snprintf(out, sizeof(out),
+			"{\"rv\":0,\"value\":%d}\n", *(int *)e->data));
+
+	n = snprintf(out, sizeof(out), "{\"rv\":0,\"value\":\"");
+
+	for (p = e->data; *p && n < sizeof(out) - 16; p++)
+	{
+		if (*p == '"' || *p == '\\')
+			n += sprintf(out + n, "\\%c", *p);
+		else if ((unsigned char)*p < 0x20)
+			n += sprintf(out + n, "\\u%04x", (unsigned char)*p);
+		else
+			out[n++] = *p;
+	}
+
+	n += sprintf(out + n, "\"}\n");
+
+	return iwinfod_send(fd, out, n);
+}
+
+/* Handle all complete queries buffered for c, returns -1 to drop it */
+static int iwinfod_input(struct iwinfod_client *c)
+{
+	int n;
+	char *nl;
+	struct iwinfo_daemon_req req;
+
+	while (c->len > 0 && !c->pending)
+	{
+		if (c->buf[0] == '{')
+		{
+			if (!(nl = memchr(c->buf, '\n', c->len)))
+				return (c->len < sizeof(c->buf) - 1) ? 0 : -1;
+
+			*nl = 0;
+			n = nl - c->buf + 1;
+
+			if (iwinfod_json(c->fd, c->buf))
+				return -1;
+		}
+		else
+		{
+			if (c->len < sizeof(req))
+				return 0;
+
+			memcpy(&req, c->buf, sizeof(req));
+			n = sizeof(req);
+
+			if (iwinfod_binary(c, &req))
+				return -1;
+		}
+
+		memmove(c->buf, c->buf + n, c->len - n);
+		c->len -= n;
+	}
+
+	return 0;
+}
+
+static void iwinfod_drop(struct iwinfod_client *c)
+{
+	int i;
+
+	for (i = 0; i < IWINFOD_SCANS; i++)
+		scans[i].waiting &= ~(1U << (c - clients));
+
+	close(c->fd);
+	c->fd = -1;
+	c->pending = 0;
+}
+
+/* Collect the results of s once the scan ended or timed out and answer all
+ * clients waiting for them */
+static void iwinfod_scan_done(struct iwinfod_scan *s, uint64_t now)
+{
+	int i, rv, len = 0;
+	uint32_t waiting = s->waiting;
+	static char buf[IWINFO_BUFSIZE];
+	struct iwinfod_entry *e, *slot;
+	struct iwinfod_client *c;
+
+	rv = s->ops->scan_ready(&s->scan);
+
+	if (rv == IWINFO_SCAN_PENDING && now < s->deadline)
+		return;
+
+	if (rv == IWINFO_SCAN_READY)
+		rv = s->ops->scan_results(&s->scan, buf, &len);
+	else
+		rv = -1;
+
+	s->ops->scan_close(&s->scan);
+
+	iwinfod_lookup(IWINFO_DAEMON_SCANLIST, s->ifname, &slot);
+	e = iwinfod_store(slot, IWINFO_DAEMON_SCANLIST, s->ifname, rv, buf, len);
+
+	memset(s, 0, sizeof(*s));
+
+	for (i = 0; i < IWINFOD_CLIENTS; i++)
+	{
+		c = &clients[i];
+
+		if (!(waiting & (1U << i)) || c->fd < 0)
+			continue;
+
+		c->pending = 0;
+
+		if (iwinfod_reply(c->fd, e))
+		{
+			iwinfod_drop(c);
+			waiting &= ~(1U << i);
+		}
+	}
+
+	/* go on with whatever the clients sent while they were waiting */
+	for (i = 0; i < IWINFOD_CLIENTS; i++)
+		if ((waiting & (1U << i)) && clients[i].fd > -1 &&
+		    iwinfod_input(&clients[i]))
+			iwinfod_drop(&clients[i]);
+}
+
+static int iwinfod_listen(const char *path)
+{
+	int fd;
+	struct sockaddr_un sun = { .sun_family = AF_UNIX };
+
+	strncpy(sun.sun_path, path, sizeof(sun.sun_path) - 1);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+		return -1;
+
+	unlink(path);
+
+	if (bind(fd, (struct sockaddr *)&sun, sizeof(sun)) || listen(fd, 16))
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int main(int argc, char **argv)
+{
+	int i, n, lfd, fd, timeout;
+	uint64_t now;
+	const char *path = (argc > 1) ? argv[1] : IWINFO_DAEMON_SOCK;
+	struct timeval tv = { .tv_sec = 1 };
+	struct pollfd pfd[IWINFOD_CLIENTS + 1 + IWINFOD_SCANS];
+	struct iwinfod_client *c;
+
+	/* the daemon is the one answering, never route to ourselves */
+	iwinfo_client(0);
+
+	if ((lfd = iwinfod_listen(path)) < 0)
+	{
+		fprintf(stderr, "Unable to listen on %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, iwinfod_signal);
+	signal(SIGTERM, iwinfod_signal);
+
+	for (i = 0; i < IWINFOD_CLIENTS; i++)
+		clients[i].fd = -1;
+
+	while (running)
+	{
+		pfd[0].fd = lfd;
+		pfd[0].events = POLLIN;
+
+		/* clients waiting for a scan are only watched for hangups */
+		for (i = 0; i < IWINFOD_CLIENTS; i++)
+		{
+			pfd[i + 1].fd = clients[i].fd;
+			pfd[i + 1].events = clients[i].pending ? 0 : POLLIN;
+			pfd[i + 1].revents = 0;
+		}
+
+		now = iwinfo_msecs();
+		timeout = -1;
+
+		for (i = 0; i < IWINFOD_SCANS; i++)
+		{
+			pfd[IWINFOD_CLIENTS + 1 + i].fd = scans[i].ops ? scans[i].scan.fd : -1;
+			pfd[IWINFOD_CLIENTS + 1 + i].events = POLLIN;
+			pfd[IWINFOD_CLIENTS + 1 + i].revents = 0;
+
+			if (!scans[i].ops)
+				continue;
+
+			n = (scans[i].deadline > now) ? scans[i].deadline - now : 0;
+
+			if (timeout < 0 || n < timeout)
+				timeout = n;
+		}
+
+		if (poll(pfd, IWINFOD_CLIENTS + 1 + IWINFOD_SCANS, timeout) < 0)
+			continue;
+
+		now = iwinfo_msecs();
+
+		for (i = 0; i < IWINFOD_SCANS; i++)
+			if (scans[i].ops &&
+			    (pfd[IWINFOD_CLIENTS + 1 + i].revents || now >= scans[i].deadline))
+				iwinfod_scan_done(&scans[i], now);
+
+		if ((pfd[0].revents & POLLIN) &&
+		    (fd = accept(lfd, NULL, NULL)) > -1)
+		{
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+			for (i = 0; i < IWINFOD_CLIENTS && clients[i].fd > -1; i++);
+
+			if (i < IWINFOD_CLIENTS)
+			{
+				/* a stalled reader must not block everybody else */
+				setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+				clients[i].fd = fd;
+				clients[i].len = 0;
+				clients[i].pending = 0;
+			}
+			else
+			{
+				close(fd);
+			}
+		}
+
+		for (i = 0; i < IWINFOD_CLIENTS; i++)
+		{
+			c = &clients[i];
+
+			if (c->fd < 0 || !pfd[i + 1].revents)
+				continue;
+
+			if (c->pending)
+			{
+				iwinfod_drop(c);
+				continue;
+			}
+
+			n = recv(c->fd, c->buf + c->len,
+			         sizeof(c->buf) - 1 - c->len, MSG_DONTWAIT);
+
+			if (n < 0 && (errno == EAGAIN || errno == EINTR))
+				continue;
+
+			if (n > 0)
+			{
+				c->len += n;
+
+				if (!iwinfod_input(c))
+					continue;
+			}
+
+			iwinfod_drop(c);
+		}
+	}
+
+	unlink(path);
+	iwinfo_finish();
+
+	return 0;
+}
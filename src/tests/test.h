@@ -0,0 +1,63 @@
+/*
+ * iwinfo - Wireless Information Library - Test Helpers
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef __IWINFO_TEST_H_
+#define __IWINFO_TEST_H_
+
+#include <stdio.h>
+
+
+static int test_failures = 0;
+
+#define CHECK(cond)												\
+	do {														\
+		if (!(cond))											\
+		{														\
+			fprintf(stderr, "%s:%d: check failed: %s\n",		\
+			        __FILE__, __LINE__, #cond);					\
+			test_failures++;									\
+		}														\
+	} while (0)
+
+#define CHECK_INT(a, b)											\
+	do {														\
+		long long _a = (a), _b = (b);							\
+		if (_a != _b)											\
+		{														\
+			fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n",	\
+			        __FILE__, __LINE__, #a, _a, _b);			\
+			test_failures++;									\
+		}														\
+	} while (0)
+
+#define CHECK_STR(a, b)											\
+	do {														\
+		const char *_a = (const char *)(a), *_b = (b);			\
+		if (strcmp(_a, _b))										\
+		{														\
+			fprintf(stderr, "%s:%d: %s is \"%s\", expected \"%s\"\n",	\
+			        __FILE__, __LINE__, #a, _a, _b);			\
+			test_failures++;									\
+		}														\
+	} while (0)
+
+static inline int test_done(const char *name)
+{
+	printf("%-16s %s\n", name, test_failures ? "FAIL" : "ok");
+	return !!test_failures;
+}
+
+#endif
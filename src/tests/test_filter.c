@@ -0,0 +1,148 @@
+/*
+ * iwinfo - Wireless Information Library - List Filter Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdlib.h>
+
+#include "iwinfo.h"
+#include "iwinfo/utils.h"
+#include "test.h"
+
+
+#define STATIONS	64
+
+static int assoc_fill(struct iwinfo_assoclist_ext_entry *e, int count)
+{
+	int i;
+
+	memset(e, 0, count * sizeof(*e));
+
+	/* distinct signals in a scrambled order, -30 .. -93 dBm */
+	for (i = 0; i < count; i++)
+	{
+		e[i].base.mac[5] = i;
+		e[i].base.signal = -30 - ((i * 37) % count);
+		e[i].base.inactive = i * 100;
+	}
+
+	return count * sizeof(*e);
+}
+
+static void test_topn(void)
+{
+	int i, len;
+	struct iwinfo_filter f = { .top = 5 };
+	struct iwinfo_assoclist_ext_entry e[STATIONS];
+
+	len = assoc_fill(e, STATIONS);
+	iwinfo_filter_assoclist(&f, (char *)e, &len);
+
+	CHECK_INT(len, 5 * sizeof(e[0]));
+
+	for (i = 0; i < 5; i++)
+		CHECK_INT(e[i].base.signal, -30 - i);
+
+	/* more room than entries keeps everything, still ordered */
+	f.top = STATIONS * 2;
+	len = assoc_fill(e, STATIONS);
+	iwinfo_filter_assoclist(&f, (char *)e, &len);
+
+	CHECK_INT(len, STATIONS * sizeof(e[0]));
+
+	for (i = 1; i < STATIONS; i++)
+		CHECK(e[i - 1].base.signal > e[i].base.signal);
+}
+
+static void test_criteria(void)
+{
+	int i, len;
+	struct iwinfo_filter f = { .min_signal = -50, .max_signal = -40 };
+	struct iwinfo_assoclist_ext_entry e[STATIONS];
+
+	/* without top the matches keep their original order */
+	len = assoc_fill(e, STATIONS);
+	iwinfo_filter_assoclist(&f, (char *)e, &len);
+
+	CHECK_INT(len, 11 * sizeof(e[0]));
+
+	for (i = 0; i < len / sizeof(e[0]); i++)
+	{
+		CHECK(e[i].base.signal >= -50 && e[i].base.signal <= -40);
+		CHECK(i == 0 || e[i - 1].base.mac[5] < e[i].base.mac[5]);
+	}
+
+	/* criteria apply before the top-N selection */
+	f.max_signal = 0;
+	f.max_inactive = 1000;
+	f.top = 3;
+	len = assoc_fill(e, STATIONS);
+	iwinfo_filter_assoclist(&f, (char *)e, &len);
+
+	CHECK_INT(len, 3 * sizeof(e[0]));
+
+	for (i = 0; i < len / sizeof(e[0]); i++)
+		CHECK(e[i].base.inactive <= 1000 && e[i].base.signal >= -50);
+
+	CHECK(e[0].base.signal > e[1].base.signal && e[1].base.signal > e[2].base.signal);
+}
+
+static void test_scan(void)
+{
+	int len;
+	struct iwinfo_filter f = { 0 };
+	struct iwinfo_scanlist_entry e[4];
+
+	memset(e, 0, sizeof(e));
+
+	/* signal is stored as dBm + 0x100 */
+	e[0].channel = 1;   e[0].signal = 0x100 - 60; strcpy((char *)e[0].ssid, "home");
+	e[1].channel = 36;  e[1].signal = 0x100 - 50; strcpy((char *)e[1].ssid, "home");
+	e[2].channel = 6;   e[2].signal = 0x100 - 40; strcpy((char *)e[2].ssid, "guest");
+	e[3].channel = 149; e[3].signal = 0x100 - 70; strcpy((char *)e[3].ssid, "home");
+
+	iwinfo_filter_frequency(&f, 2412);
+	iwinfo_filter_frequency(&f, 5180);
+	iwinfo_filter_frequency(&f, 2437);
+
+	CHECK(iwinfo_filter_has_channel(&f, 1));
+	CHECK(iwinfo_filter_has_channel(&f, 36));
+	CHECK(iwinfo_filter_has_channel(&f, 6));
+	CHECK(!iwinfo_filter_has_channel(&f, 149));
+	CHECK(!iwinfo_filter_has_channel(&f, 0));
+
+	strcpy(f.ssid, "home");
+	f.top = 1;
+
+	len = sizeof(e);
+	iwinfo_filter_scanlist(&f, (char *)e, &len);
+
+	CHECK_INT(len, sizeof(e[0]));
+	CHECK_INT(e[0].channel, 36);
+
+	/* an empty filter matches anything */
+	memset(&f, 0, sizeof(f));
+	CHECK(iwinfo_filter_has_channel(&f, 200));
+	CHECK(iwinfo_filter_ssid(&f, (const uint8_t *)"x", 1));
+	CHECK(iwinfo_filter_signal(&f, -100));
+}
+
+int main(int argc, char **argv)
+{
+	test_topn();
+	test_criteria();
+	test_scan();
+
+	return test_done("filter");
+}
@@ -0,0 +1,214 @@
+/*
+ * iwinfo - Wireless Information Library - Scan IE Set Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "../iwinfo_utils.c"
+#include "test.h"
+
+
+/* HT operation on channel 6 with the secondary above, BSS load 3/128 */
+static const uint8_t ies_a[] = {
+	61, 2, 6, 0x05,
+	11, 5, 3, 0, 128, 0, 0
+};
+
+static const uint8_t ies_b[] = {
+	7, 3, 'D', 'E', ' '
+};
+
+static void entry(struct iwinfo_scanlist_entry *e, uint8_t id)
+{
+	memset(e, 0, sizeof(*e));
+	e->mac[5] = id;
+	e->channel = id;
+}
+
+static void put(struct iwinfo_ie_set *s, uint8_t id, const uint8_t *ies,
+                int len)
+{
+	uint8_t mac[6] = { 0, 0, 0, 0, 0, id };
+
+	iwinfo_ie_set_put(s, mac, iwinfo_ie_blob(&s->arena, ies, len));
+}
+
+static void test_widen(void)
+{
+	int len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_scanlist_entry *e = (struct iwinfo_scanlist_entry *)buf;
+	struct iwinfo_scanlist_ext_entry *x = (struct iwinfo_scanlist_ext_entry *)buf;
+	struct iwinfo_ie_set *s = iwinfo_ie_set("wlan0");
+	struct iwinfo_ht_operation ht;
+	struct iwinfo_bss_load load;
+	struct iwinfo_country_ie country;
+
+	CHECK(s != NULL);
+	CHECK(iwinfo_ie_set("wlan0") == s);
+
+	put(s, 1, ies_a, sizeof(ies_a));
+	put(s, 3, ies_b, sizeof(ies_b));
+
+	entry(&e[0], 1);
+	entry(&e[1], 2);
+	entry(&e[2], 3);
+	len = 3 * sizeof(*e);
+
+	/* attached by BSSID, entries without IEs get none */
+	iwinfo_scanlist_widen("wlan0", buf, &len, sizeof(buf));
+
+	CHECK_INT(len, 3 * sizeof(*x));
+	CHECK_INT(x[0].base.channel, 1);
+	CHECK_INT(x[1].base.channel, 2);
+	CHECK_INT(x[2].base.channel, 3);
+	CHECK(x[0].ies != NULL);
+	CHECK(x[1].ies == NULL);
+	CHECK(x[2].ies != NULL);
+
+	CHECK_INT(iwinfo_ie_ht_operation(&x[0], &ht), 0);
+	CHECK_INT(ht.primary_channel, 6);
+	CHECK_INT(ht.chan_width, 40);
+	CHECK_INT(iwinfo_ie_bss_load(&x[0], &load), 0);
+	CHECK_INT(load.station_count, 3);
+	CHECK_INT(load.channel_utilization, 128);
+	CHECK_INT(iwinfo_ie_country(&x[0], &country), -1);
+
+	CHECK_INT(iwinfo_ie_country(&x[2], &country), 0);
+	CHECK_STR(country.ccode, "DE");
+	CHECK_INT(iwinfo_ie_bss_load(&x[1], &load), -1);
+
+	/* unknown devices and plain fallbacks carry no IEs */
+	entry(&e[0], 1);
+	len = sizeof(*e);
+	iwinfo_scanlist_widen(NULL, buf, &len, sizeof(buf));
+
+	CHECK_INT(len, sizeof(*x));
+	CHECK(x[0].ies == NULL);
+
+	/* entries beyond max are dropped */
+	entry(&e[0], 1);
+	entry(&e[1], 3);
+	len = 2 * sizeof(*e);
+	iwinfo_scanlist_widen("wlan0", buf, &len, sizeof(*x) + 1);
+
+	CHECK_INT(len, sizeof(*x));
+	CHECK(x[0].ies != NULL);
+}
+
+static void test_devices(void)
+{
+	uint8_t mac[6] = { 0, 0, 0, 0, 0, 1 };
+	struct iwinfo_ie_blob *b;
+	struct iwinfo_ie_set *s0 = iwinfo_ie_set("wlan0");
+	struct iwinfo_ie_set *s1 = iwinfo_ie_set("wlan1");
+
+	CHECK(s0 && s1 && s0 != s1);
+
+	/* scanning another device keeps the blobs of the first one */
+	b = iwinfo_ie_set_get(s0, mac);
+	CHECK(b != NULL);
+
+	iwinfo_ie_set_reset(s1);
+	put(s1, 1, ies_b, sizeof(ies_b));
+
+	CHECK(iwinfo_ie_set_get(s0, mac) == b);
+	CHECK_INT(b->len, sizeof(ies_a));
+	CHECK(!memcmp(b->data, ies_a, sizeof(ies_a)));
+	CHECK_INT(iwinfo_ie_set_get(s1, mac)->len, sizeof(ies_b));
+
+	/* a new scan of the device drops its IEs */
+	iwinfo_ie_set_reset(s0);
+	CHECK(iwinfo_ie_set_get(s0, mac) == NULL);
+}
+
+static void test_cache(void)
+{
+	int len;
+	char buf[IWINFO_BUFSIZE], path[64];
+	struct iwinfo_scanlist_entry e[2];
+	struct iwinfo_scanlist_ext_entry *x = (struct iwinfo_scanlist_ext_entry *)buf;
+	struct iwinfo_ie_set *s = iwinfo_ie_set("wlan2");
+
+	snprintf(path, sizeof(path), "/tmp/iwinfo-test-ies.%d", getpid());
+
+	iwinfo_ie_set_reset(s);
+	put(s, 2, ies_a, sizeof(ies_a));
+
+	entry(&e[0], 1);
+	entry(&e[1], 2);
+
+	iwinfo_scan_cache_store(path, s, (char *)e, sizeof(e));
+
+	/* loading replaces the IE set with the stored records */
+	iwinfo_ie_set_reset(s);
+	put(s, 1, ies_b, sizeof(ies_b));
+
+	CHECK_INT(iwinfo_scan_cache_load(path, s, 60000, buf, &len), 0);
+	CHECK_INT(len, sizeof(e));
+
+	iwinfo_scanlist_widen("wlan2", buf, &len, sizeof(buf));
+
+	CHECK_INT(len, 2 * sizeof(*x));
+	CHECK(x[0].ies == NULL);
+	CHECK(x[1].ies != NULL);
+	CHECK_INT(x[1].ies->len, sizeof(ies_a));
+	CHECK(!memcmp(x[1].ies->data, ies_a, sizeof(ies_a)));
+
+	unlink(path);
+}
+
+static void test_cache_tmp(void)
+{
+	int fd, len;
+	char buf[IWINFO_BUFSIZE], path[64], tmp[80], victim[64];
+	struct iwinfo_scanlist_entry e;
+	struct stat st;
+
+	snprintf(path, sizeof(path), "/tmp/iwinfo-test-tmp.%d", getpid());
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+	snprintf(victim, sizeof(victim), "/tmp/iwinfo-test-victim.%d", getpid());
+
+	fd = open(victim, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	CHECK(fd > -1);
+	close(fd);
+
+	/* a link planted at the temporary name is replaced, not followed */
+	CHECK_INT(symlink(victim, tmp), 0);
+
+	entry(&e, 1);
+	iwinfo_scan_cache_store(path, iwinfo_ie_set("wlan3"), (char *)&e, sizeof(e));
+
+	CHECK_INT(stat(victim, &st), 0);
+	CHECK_INT(st.st_size, 0);
+	CHECK_INT(lstat(tmp, &st), -1);
+	CHECK_INT(iwinfo_scan_cache_load(path, iwinfo_ie_set("wlan3"), 60000,
+	                                 buf, &len), 0);
+	CHECK_INT(len, sizeof(e));
+
+	unlink(path);
+	unlink(tmp);
+	unlink(victim);
+}
+
+int main(int argc, char **argv)
+{
+	test_widen();
+	test_devices();
+	test_cache();
+	test_cache_tmp();
+
+	iwinfo_ie_sets_free();
+
+	return test_done("ies");
+}
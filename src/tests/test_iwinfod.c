@@ -0,0 +1,114 @@
+/*
+ * iwinfo - Wireless Information Library - Query Daemon Cache Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#define main iwinfod_main
+#include "../iwinfod.c"
+#undef main
+
+#include "test.h"
+
+
+static struct iwinfod_entry * store(int op, const char *ifname, int rv,
+                                    char *buf, int len)
+{
+	struct iwinfod_entry *slot;
+
+	iwinfod_lookup(op, ifname, &slot);
+
+	return iwinfod_store(slot, op, ifname, rv, buf, len);
+}
+
+static void test_scanlist(void)
+{
+	int i;
+	struct iwinfo_scanlist_entry e[3], *c;
+	struct iwinfod_entry *x;
+
+	memset(e, 0, sizeof(e));
+
+	for (i = 0; i < 3; i++)
+		e[i].channel = i + 1;
+
+	x = store(IWINFO_DAEMON_SCANLIST, "wlan0", 0, (char *)e, sizeof(e));
+
+	CHECK(x != NULL);
+	CHECK_INT(x->len, sizeof(e));
+
+	/* scan entries are plain data and cached as they are */
+	for (i = 0, c = (struct iwinfo_scanlist_entry *)x->data; i < 3; i++)
+		CHECK_INT(c[i].channel, i + 1);
+}
+
+static void test_fail_ttl(void)
+{
+	int v = 42;
+	struct iwinfod_entry *ok, *fail, *slot;
+
+	ok = store(IWINFO_DAEMON_HARDWARE_NAME, "wlan0", 0, (char *)&v, sizeof(v));
+	fail = store(IWINFO_DAEMON_HARDWARE_NAME, "wlan1", -1, NULL, 0);
+
+	CHECK(ok && fail && ok != fail);
+	CHECK_INT(fail->len, 0);
+
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_HARDWARE_NAME, "wlan0", &slot) == ok);
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_HARDWARE_NAME, "wlan1", &slot) == fail);
+
+	/* both are older than the failure TTL, well within the op TTL */
+	ok->stamp -= IWINFOD_FAIL_TTL + 500;
+	fail->stamp -= IWINFOD_FAIL_TTL + 500;
+
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_HARDWARE_NAME, "wlan0", &slot) == ok);
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_HARDWARE_NAME, "wlan1", &slot) == NULL);
+
+	/* the stale entry is refreshed in place */
+	CHECK(slot == fail);
+	CHECK(store(IWINFO_DAEMON_HARDWARE_NAME, "wlan1", 0,
+	            (char *)&v, sizeof(v)) == fail);
+	CHECK_INT(fail->rv, 0);
+}
+
+static void test_evict(void)
+{
+	int i;
+	char ifname[IFNAMSIZ];
+	struct iwinfod_entry *first, *slot;
+
+	for (i = 0; i < IWINFOD_CACHE; i++)
+		if (cache[i].data)
+			cache[i].stamp = 1;
+
+	first = store(IWINFO_DAEMON_CHANNEL, "first", 0, (char *)&i, sizeof(i));
+	first->stamp = 0;
+
+	/* a full cache reuses the least recently refreshed entry */
+	for (i = 0; i < IWINFOD_CACHE; i++)
+	{
+		snprintf(ifname, sizeof(ifname), "wlan%d", i);
+		store(IWINFO_DAEMON_CHANNEL, ifname, 0, (char *)&i, sizeof(i));
+	}
+
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_CHANNEL, "first", &slot) == NULL);
+	CHECK(iwinfod_lookup(IWINFO_DAEMON_CHANNEL, "wlan0", &slot) != NULL);
+}
+
+int main(int argc, char **argv)
+{
+	test_scanlist();
+	test_fail_ttl();
+	test_evict();
+
+	return test_done("iwinfod");
+}
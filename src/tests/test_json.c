@@ -0,0 +1,118 @@
+/*
+ * iwinfo - Wireless Information Library - CLI JSON Output Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#define main iwinfo_main
+#include "../iwinfo_cli.c"
+#undef main
+
+#include "test.h"
+
+
+/* Quote s like a JSON value and return what ended up in the buffer */
+static const char * quote(const char *s, int len)
+{
+	static char buf[OUT_BUFSIZE + 1];
+
+	out_len = 0;
+	out_json_string(s, len);
+
+	memcpy(buf, out_buf, out_len);
+	buf[out_len] = 0;
+	out_len = 0;
+
+	return buf;
+}
+
+static void test_escape(void)
+{
+	char ctl[] = { 'a', 0x01, 0x1f, '\n', '\t', 'b', 0 };
+	char ssid[IWINFO_ESSID_MAX_SIZE];
+
+	CHECK_STR(quote("plain", 5), "\"plain\"");
+	CHECK_STR(quote("", 0), "\"\"");
+
+	CHECK_STR(quote("say \"hi\"", 8), "\"say \\\"hi\\\"\"");
+	CHECK_STR(quote("C:\\tmp\\", 7), "\"C:\\\\tmp\\\\\"");
+
+	/* control characters become \u escapes, the rest passes as is */
+	CHECK_STR(quote(ctl, sizeof(ctl)), "\"a\\u0001\\u001f\\u000a\\u0009b\"");
+	CHECK_STR(quote("\x7f", 1), "\"\x7f\"");
+	CHECK_STR(quote("caf\xc3\xa9", 5), "\"caf\xc3\xa9\"");
+	CHECK_STR(quote("\xf0\x9f\x93\xb6", 4), "\"\xf0\x9f\x93\xb6\"");
+
+	/* bytes that are not valid UTF-8 are escaped one by one */
+	CHECK_STR(quote("\xff", 1), "\"\\u00ff\"");
+	CHECK_STR(quote("caf\xc3", 4), "\"caf\\u00c3\"");
+	CHECK_STR(quote("\xc3\xa9", 1), "\"\\u00c3\"");
+	CHECK_STR(quote("\xc0\xaf", 2), "\"\\u00c0\\u00af\"");
+	CHECK_STR(quote("\xed\xa0\x80", 3), "\"\\u00ed\\u00a0\\u0080\"");
+	CHECK_STR(quote("\xe2\x82x", 3), "\"\\u00e2\\u0082x\"");
+
+	/* escapes next to each other and at both ends */
+	CHECK_STR(quote("\"\\\"", 3), "\"\\\"\\\\\\\"\"");
+
+	/* the bound wins over a missing terminator, a NUL ends early */
+	memset(ssid, 'x', sizeof(ssid));
+	ssid[0] = '"';
+	CHECK_INT(strlen(quote(ssid, sizeof(ssid))), sizeof(ssid) + 3);
+	CHECK_STR(quote("ab\0cd", 5), "\"ab\"");
+}
+
+/* Run a record through the output path and read back what reached stdout */
+static void test_record(void)
+{
+	int fd, saved, n;
+	char buf[512];
+	FILE *f = tmpfile();
+
+	CHECK(f != NULL);
+
+	if (!f)
+		return;
+
+	fd = fileno(f);
+	saved = dup(1);
+	dup2(fd, 1);
+
+	out_format = OUT_JSON;
+
+	out_record_begin("scan\"list");
+	out_str("ssid", "a\"b\\c\nd");
+	out_open("modes", '[');
+	out_str(NULL, "\x02");
+	out_close();
+	out_int("signal", -60);
+	out_record_end();
+
+	dup2(saved, 1);
+	close(saved);
+
+	lseek(fd, 0, SEEK_SET);
+	n = read(fd, buf, sizeof(buf) - 1);
+	buf[(n > 0) ? n : 0] = 0;
+	fclose(f);
+
+	CHECK_STR(buf, "{\"scan\\\"list\":{\"ssid\":\"a\\\"b\\\\c\\u000ad\","
+	               "\"modes\":[\"\\u0002\"],\"signal\":-60}}\n");
+}
+
+int main(int argc, char **argv)
+{
+	test_escape();
+	test_record();
+
+	return test_done("json");
+}
@@ -0,0 +1,106 @@
+/*
+ * iwinfo - Wireless Information Library - OpenMetrics Exporter Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "../iwinfo_metrics.c"
+#include "test.h"
+
+
+static struct metrics_buf b;
+
+static const char * format(struct metrics_dev *d, int n)
+{
+	free(b.data);
+	memset(&b, 0, sizeof(b));
+
+	if (metrics_grow(&b, 1))
+		return "";
+
+	metrics_format(&b, d, n, 1234);
+	metrics_grow(&b, 1);
+	b.data[b.len] = 0;
+
+	return b.data;
+}
+
+static void test_survey(void)
+{
+	const char *out;
+	struct iwinfo_survey_entry s[2];
+	struct metrics_dev d;
+
+	memset(&d, 0, sizeof(d));
+	memset(s, 0, sizeof(s));
+
+	strcpy(d.ifname, "wlan0");
+	strcpy(d.phy, "phy0");
+
+	s[0].mhz = 2412;
+	s[0].noise = -95;
+	s[0].in_use = 1;
+	s[0].time = 1500;
+	s[0].time_busy = 250;
+
+	/* a channel never dwelled on still reports whether it is in use */
+	s[1].mhz = 2437;
+
+	d.survey = (char *)s;
+	d.survey_len = sizeof(s);
+
+	out = format(&d, 1);
+
+	CHECK(strstr(out, "# TYPE iwinfo_survey_in_use gauge\n") != NULL);
+	CHECK(strstr(out, "iwinfo_survey_in_use{phy=\"phy0\",frequency=\"2412\"} 1\n") != NULL);
+	CHECK(strstr(out, "iwinfo_survey_in_use{phy=\"phy0\",frequency=\"2437\"} 0\n") != NULL);
+
+	/* in_use is no longer a label of the other families */
+	CHECK(strstr(out, "in_use=") == NULL);
+	CHECK(strstr(out, "iwinfo_survey_noise_dbm{phy=\"phy0\",frequency=\"2412\"} -95\n") != NULL);
+	CHECK(strstr(out, "iwinfo_survey_busy_seconds_total{phy=\"phy0\",frequency=\"2412\"} 0.250\n") != NULL);
+	CHECK(strstr(out, "frequency=\"2437\"} 0.") == NULL);
+	CHECK(strstr(out, "iwinfo_survey_noise_dbm{phy=\"phy0\",frequency=\"2437\"}") == NULL);
+
+	CHECK(strstr(out, "iwinfo_scrape_duration_seconds 1.234\n# EOF\n") != NULL);
+}
+
+static void test_labels(void)
+{
+	const char *out;
+	struct metrics_dev d;
+
+	memset(&d, 0, sizeof(d));
+
+	strcpy(d.ifname, "wlan0");
+	strcpy(d.phy, "phy0");
+	d.info.valid = IWINFO_INFO_SSID | IWINFO_INFO_CHANNEL;
+	d.info.channel = 36;
+	strcpy(d.info.ssid, "a\"b\\c\nd");
+
+	out = format(&d, 1);
+
+	CHECK(strstr(out, ",ssid=\"a\\\"b\\\\c\\nd\",") != NULL);
+	CHECK(strstr(out, "iwinfo_channel{ifname=\"wlan0\",phy=\"phy0\"} 36\n") != NULL);
+	CHECK(strstr(out, "iwinfo_frequency_mhz{") == NULL);
+}
+
+int main(int argc, char **argv)
+{
+	test_survey();
+	test_labels();
+
+	free(b.data);
+
+	return test_done("metrics");
+}
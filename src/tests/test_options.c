@@ -0,0 +1,73 @@
+/*
+ * iwinfo - Wireless Information Library - CLI Option Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#define main iwinfo_main
+#include "../iwinfo_cli.c"
+#undef main
+
+#include "test.h"
+
+
+#define ARGC(a)	(int)(sizeof(a) / sizeof(a[0]) - 1)
+
+static void test_leading(void)
+{
+	char *argv[] = { "iwinfo", "-j", "--interval", "250", "-n", "3",
+	                 "wlan0", "monitor", NULL };
+	struct cli_options o = { .interval = 1000 };
+
+	/* parsing stops at the device */
+	CHECK_INT(parse_options(ARGC(argv), argv, &o), 6);
+	CHECK_INT(o.interval, 250);
+	CHECK_INT(out_format, OUT_JSON);
+	CHECK(o.f == &o.filter);
+	CHECK_INT(o.filter.top, 3);
+
+	out_format = OUT_TEXT;
+}
+
+static void test_trailing(void)
+{
+	char fields[] = "counters,rates";
+	char *argv[] = { "iwinfo", "wlan0", "monitor", "--interval", "100",
+	                 "--fields", fields, "-R", NULL };
+	char *extra[] = { "monitor", "-I", "50", "wlan1", NULL };
+	struct cli_options o = { .interval = 1000 };
+
+	CHECK_INT(parse_options(ARGC(argv), argv, &o), 1);
+	CHECK(o.f == NULL);
+
+	/* the words after the command, argv[0] being the command itself */
+	CHECK_INT(parse_options(ARGC(argv) - 2, argv + 2, &o), ARGC(argv) - 2);
+	CHECK_INT(o.interval, 100);
+	CHECK_INT(o.rates, 1);
+	CHECK_INT(o.filter.fields, IWINFO_FIELD_COUNTERS | IWINFO_FIELD_RATES);
+
+	/* leftover operands are reported by index */
+	CHECK_INT(parse_options(ARGC(extra), extra, &o), 3);
+	CHECK_INT(o.interval, 50);
+}
+
+int main(int argc, char **argv)
+{
+	/* getopt must not complain on stderr about what we feed it */
+	opterr = 0;
+
+	test_leading();
+	test_trailing();
+
+	return test_done("options");
+}
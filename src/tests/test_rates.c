@@ -0,0 +1,151 @@
+/*
+ * iwinfo - Wireless Information Library - Station Rate Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "../iwinfo_utils.c"
+#include "test.h"
+
+
+static void sample(struct iwinfo_rate_station *st,
+                   struct iwinfo_assoclist_ext_entry *e, uint64_t now,
+                   uint64_t rx_bytes, uint64_t tx_packets, uint32_t retries,
+                   uint32_t connected)
+{
+	e->rx_bytes = rx_bytes;
+	e->tx_packets = tx_packets;
+	e->tx_retries = retries;
+	e->connected_time = connected;
+
+	iwinfo_rates_sample(st, e, now);
+}
+
+static void test_wrap(void)
+{
+	struct iwinfo_rate_station st = { 0 };
+	struct iwinfo_assoclist_ext_entry e = { 0 };
+	struct iwinfo_assoclist_rates r;
+
+	/* 32 bit driver counter close to its limit */
+	sample(&st, &e, 1000, 0xFFFFF000ULL, 100, 0, 10);
+	iwinfo_rates_calc(&st, 1, &r);
+
+	CHECK_INT(r.interval, 0);
+	CHECK_INT(r.rx_bytes, 0xFFFFF000ULL);
+
+	/* wraps within the next second, 0x1800 bytes went by */
+	sample(&st, &e, 2000, 0x800, 1000, 100, 11);
+	iwinfo_rates_calc(&st, 1, &r);
+
+	CHECK_INT(r.interval, 1000);
+	CHECK_INT(r.rx_bytes, 0xFFFFF000ULL + 0x1800);
+	CHECK_INT(r.rx_byte_rate, 0x1800);
+	CHECK_INT(r.tx_packet_rate, 900);
+
+	/* 100 retries against 900 packets */
+	CHECK_INT(r.tx_retry_ratio, 1000);
+
+	/* the total keeps growing past 32 bit */
+	sample(&st, &e, 3000, 0x1000, 1000, 100, 12);
+	iwinfo_rates_calc(&st, 2, &r);
+
+	CHECK_INT(r.interval, 2000);
+	CHECK_INT(r.rx_bytes, 0x100001000ULL);
+	CHECK_INT(r.rx_byte_rate, 0x2000 / 2);
+}
+
+static void test_reset(void)
+{
+	struct iwinfo_rate_station st = { 0 };
+	struct iwinfo_assoclist_ext_entry e = { 0 };
+	struct iwinfo_assoclist_rates r;
+
+	sample(&st, &e, 1000, 5000, 0, 0, 100);
+
+	/* reassociated: fresh counters count in full, not as a wrap */
+	sample(&st, &e, 2000, 200, 0, 0, 5);
+	iwinfo_rates_calc(&st, 1, &r);
+
+	CHECK_INT(r.rx_bytes, 5200);
+	CHECK_INT(r.rx_byte_rate, 200);
+
+	/* a small drop without reassociation is a reset, not a wrap */
+	sample(&st, &e, 3000, 100, 0, 0, 6);
+	iwinfo_rates_calc(&st, 1, &r);
+
+	CHECK_INT(r.rx_bytes, 5300);
+	CHECK_INT(r.rx_byte_rate, 100);
+}
+
+static void test_widen(void)
+{
+	int i, len;
+	char buf[4 * sizeof(struct iwinfo_assoclist_ext_entry)];
+	struct iwinfo_assoclist_entry in[4], *n;
+	struct iwinfo_assoclist_ext_entry *x;
+
+	memset(in, 0, sizeof(in));
+
+	for (i = 0; i < 4; i++)
+	{
+		in[i].mac[5] = i + 1;
+		in[i].signal = -40 - i;
+		in[i].rx_packets = 0xFFFFFFF0 + i;
+		in[i].tx_packets = i * 10;
+		in[i].tx_rate.mcs = i;
+	}
+
+	memcpy(buf, in, sizeof(in));
+	len = sizeof(in);
+	iwinfo_assoclist_widen(buf, &len, sizeof(buf));
+
+	CHECK_INT(len, 4 * sizeof(*x));
+
+	for (i = 0, x = (struct iwinfo_assoclist_ext_entry *)buf; i < 4; i++, x++)
+	{
+		CHECK(!memcmp(&x->base, &in[i], sizeof(in[i])));
+		CHECK_INT(x->rx_packets, 0xFFFFFFF0 + i);
+		CHECK_INT(x->tx_packets, i * 10);
+		CHECK_INT(x->rx_bytes, 0);
+		CHECK_INT(x->connected_time, 0);
+	}
+
+	/* narrowing restores the original array */
+	iwinfo_assoclist_narrow(buf, &len);
+
+	CHECK_INT(len, sizeof(in));
+	CHECK(!memcmp(buf, in, sizeof(in)));
+
+	/* entries beyond max are dropped */
+	len = sizeof(in);
+	iwinfo_assoclist_widen(buf, &len, 2 * sizeof(*x) + 1);
+
+	CHECK_INT(len, 2 * sizeof(*x));
+
+	iwinfo_assoclist_narrow(buf, &len);
+	n = (struct iwinfo_assoclist_entry *)buf;
+
+	CHECK_INT(len, 2 * sizeof(*n));
+	CHECK_INT(n[1].mac[5], 2);
+	CHECK_INT(n[1].signal, -41);
+}
+
+int main(int argc, char **argv)
+{
+	test_wrap();
+	test_reset();
+	test_widen();
+
+	return test_done("rates");
+}
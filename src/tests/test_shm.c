@@ -0,0 +1,224 @@
+/*
+ * iwinfo - Wireless Information Library - Shared Memory Snapshot Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "../iwinfo_shm.c"
+#include "test.h"
+
+
+/* long enough for many preemptions even on a single CPU */
+#define READ_TIME	500		/* ms */
+
+static char ifname[IFNAMSIZ];
+
+/* Every publish gets a new round, info and stations all carry it so a
+ * reader can tell a torn copy from a consistent one */
+static int round_no = 0;
+
+/* large lists keep the copies long enough to be preempted midway */
+static int stations(int round)
+{
+	return IWINFO_BUFSIZE / sizeof(struct iwinfo_assoclist_ext_entry) -
+	       (round % 64);
+}
+
+static int stub_info(const char *ifname, struct iwinfo_info *info)
+{
+	memset(info, 0, sizeof(*info));
+
+	round_no++;
+
+	info->valid = IWINFO_INFO_CHANNEL | IWINFO_INFO_SSID;
+	info->channel = round_no;
+	memset(info->ssid, 'a' + (round_no % 26), sizeof(info->ssid) - 1);
+
+	return 0;
+}
+
+static int stub_assoclist(const char *ifname, char *buf, int *len)
+{
+	int i, count = stations(round_no);
+	struct iwinfo_assoclist_entry *e = (struct iwinfo_assoclist_entry *)buf;
+
+	memset(buf, 0, count * sizeof(*e));
+
+	for (i = 0; i < count; i++)
+	{
+		e[i].mac[5] = i;
+		e[i].inactive = round_no;
+		e[i].rx_packets = round_no;
+	}
+
+	*len = count * sizeof(*e);
+	return 0;
+}
+
+static const struct iwinfo_ops stub_ops = {
+	.info      = stub_info,
+	.assoclist = stub_assoclist,
+};
+
+static void test_sections(void)
+{
+	int len;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_info info;
+	struct iwinfo_assoclist_entry *e = (struct iwinfo_assoclist_entry *)buf;
+
+	CHECK_INT(iwinfo_shm_publish(&stub_ops, ifname, 1000), 0);
+
+	CHECK(shm_probe(ifname, IWINFO_SHM_INFO));
+	CHECK(shm_probe(ifname, IWINFO_SHM_ASSOC));
+
+	/* the stub has no survey, that section must not be served */
+	CHECK(!shm_probe(ifname, IWINFO_SHM_SURVEY));
+	CHECK(shm_get_survey(ifname, buf, &len));
+
+	CHECK_INT(shm_get_info(ifname, &info), 0);
+	CHECK_INT(info.channel, round_no);
+
+	CHECK_INT(shm_get_assoclist(ifname, buf, &len), 0);
+	CHECK_INT(len, stations(round_no) * sizeof(*e));
+	CHECK_INT(e[0].rx_packets, round_no);
+
+	/* republishing from the snapshot backend is refused */
+	CHECK(iwinfo_shm_publish(&shm_ops, ifname, 1000));
+}
+
+static void test_seqlock(void)
+{
+	int len;
+	struct iwinfo_info info;
+	struct iwinfo_shm_region *w = shm_writer(ifname);
+
+	CHECK(w != NULL);
+
+	if (!w)
+		return;
+
+	/* a publisher midway an update makes readers give up after retries */
+	w->seq++;
+	CHECK(shm_info(ifname, &info));
+
+	w->seq++;
+	CHECK_INT(shm_info(ifname, &info), 0);
+
+	/* stale snapshots are rejected */
+	w->stamp -= 10000;
+	CHECK(shm_info(ifname, &info));
+	CHECK_INT(iwinfo_shm_read(ifname, IWINFO_SHM_INFO, 20000,
+	                          (char *)&info, &len), 0);
+}
+
+static int consistent(const struct iwinfo_info *info,
+                      const char *buf, int len)
+{
+	int i;
+	const struct iwinfo_assoclist_ext_entry *x =
+		(const struct iwinfo_assoclist_ext_entry *)buf;
+
+	for (i = 0; i < sizeof(info->ssid) - 1; i++)
+		if (info->ssid[i] != 'a' + (info->channel % 26))
+			return 0;
+
+	if (len != stations(x[0].base.inactive) * sizeof(*x))
+		return 0;
+
+	for (i = 0; i < len / sizeof(*x); i++)
+		if (x[i].base.inactive != x[0].base.inactive ||
+		    x[i].rx_packets != x[0].base.inactive)
+			return 0;
+
+	return 1;
+}
+
+/* a child publishes as fast as it can while the parent keeps reading */
+static void test_concurrent(void)
+{
+	int len, ok = 0, torn = 0;
+	uint64_t start = iwinfo_msecs();
+	pid_t pid;
+	char buf[IWINFO_BUFSIZE];
+	struct iwinfo_info info;
+
+	if ((pid = fork()) == 0)
+	{
+		while (1)
+			iwinfo_shm_publish(&stub_ops, ifname, 1000);
+	}
+
+	CHECK(pid > 0);
+
+	if (pid < 0)
+		return;
+
+	while (iwinfo_msecs() - start < READ_TIME)
+	{
+		if (iwinfo_shm_read(ifname, IWINFO_SHM_ASSOC, 0, buf, &len) ||
+		    shm_info(ifname, &info))
+			continue;
+
+		if (!consistent(&info, buf, len))
+			torn++;
+		else
+			ok++;
+	}
+
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+
+	CHECK_INT(torn, 0);
+	CHECK(ok > 0);
+}
+
+static void test_untrusted(void)
+{
+	char path[PATH_MAX], link[PATH_MAX], other[IFNAMSIZ];
+
+	snprintf(other, sizeof(other), "lnk%d", getpid());
+	shm_path(path, sizeof(path), ifname);
+	shm_path(link, sizeof(link), other);
+
+	/* a link planted in the shared directory is neither read nor written */
+	CHECK_INT(symlink(path, link), 0);
+	CHECK(shm_reader(other) == NULL);
+	CHECK(shm_writer(other) == NULL);
+	CHECK(iwinfo_shm_publish(&stub_ops, other, 1000));
+
+	unlink(link);
+}
+
+int main(int argc, char **argv)
+{
+	char path[PATH_MAX];
+
+	snprintf(ifname, sizeof(ifname), "test%d", getpid());
+
+	test_sections();
+	test_seqlock();
+	test_untrusted();
+
+	shm_close();
+	test_concurrent();
+
+	shm_close();
+	shm_path(path, sizeof(path), ifname);
+	unlink(path);
+
+	return test_done("shm");
+}
@@ -0,0 +1,251 @@
+/*
+ * iwinfo - Wireless Information Library - wpa_supplicant Parser Tests
+ *
+ * The iwinfo library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License version 2
+ * as published by the Free Software Foundation.
+ *
+ * The iwinfo library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the iwinfo library. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include "../iwinfo_nl80211.c"
+#include "test.h"
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define TEST_IFNAME	"iwtest0"
+#define TEST_SUPDIR	"/var/run/wpa_supplicant-" TEST_IFNAME
+
+
+/* Reply to "BSS RANGE=" holding the complete table */
+static const char bss_range_last[] =
+	"id=3\n"
+	"bssid=00:11:22:33:44:55\n"
+	"freq=2437\n"
+	"level=-52\n"
+	"flags=[WPA2-PSK-CCMP][ESS]\n"
+	"ssid=home\n"
+	"====\n"
+	"id=7\n"
+	"bssid=66:77:88:99:aa:bb\n"
+	"freq=5180\n"
+	"level=-71\n"
+	"flags=[WPA2-SAE-CCMP+GCMP-256][ESS]\n"
+	"ssid=office\n"
+	"####\n";
+
+/* Reply cut short by the supplicant reply buffer, more records follow */
+static const char bss_range_page[] =
+	"id=4\n"
+	"bssid=00:11:22:33:44:66\n"
+	"freq=2412\n"
+	"level=-60\n"
+	"flags=[ESS]\n"
+	"ssid=open\n"
+	"====\n"
+	"id=5\n"
+	"bssid=00:11:22:33:44:77\n";
+
+static const char scan_results[] =
+	"bssid / frequency / signal level / flags / ssid\n"
+	"00:11:22:33:44:55\t2462\t-48\t[WPA-PSK-TKIP][WPA2-PSK-CCMP][ESS]\tmixed\n"
+	"garbage line\n"
+	"66:77:88:99:aa:bb\t5745\t-80\t[ESS]\t\n";
+
+/* Minimal supplicant control interface, "FIRE" reports a finished scan to
+ * the attached monitor */
+static pid_t fake_supplicant(void)
+{
+	int sock, n;
+	pid_t pid;
+	char buf[256];
+	const char *reply;
+	socklen_t flen, mlen = 0;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX }, from, mon;
+
+	mkdir(TEST_SUPDIR, 0700);
+	snprintf(addr.sun_path, sizeof(addr.sun_path),
+	         TEST_SUPDIR "/" TEST_IFNAME);
+	unlink(addr.sun_path);
+
+	if ((sock = socket(PF_UNIX, SOCK_DGRAM, 0)) < 0)
+		return -1;
+
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    (pid = fork()) != 0)
+	{
+		close(sock);
+		return (pid > 0) ? pid : -1;
+	}
+
+	while (flen = sizeof(from),
+	       (n = recvfrom(sock, buf, sizeof(buf) - 1, 0,
+	                     (struct sockaddr *)&from, &flen)) > 0)
+	{
+		buf[n] = 0;
+		reply = "OK\n";
+
+		if (!strcmp(buf, "ATTACH"))
+		{
+			mon = from;
+			mlen = flen;
+		}
+		else if (!strcmp(buf, "DETACH"))
+		{
+			mlen = 0;
+		}
+		else if (!strcmp(buf, "FIRE"))
+		{
+			if (mlen)
+				sendto(sock, "<2>CTRL-EVENT-SCAN-RESULTS ", 27, 0,
+				       (struct sockaddr *)&mon, mlen);
+		}
+		else if (!strcmp(buf, "STATUS"))
+		{
+			reply = "wpa_state=SCANNING\n";
+		}
+		else if (!strncmp(buf, "BSS RANGE=", 10))
+		{
+			reply = bss_range_last;
+		}
+		else if (strcmp(buf, "SCAN"))
+		{
+			reply = "UNKNOWN COMMAND\n";
+		}
+
+		sendto(sock, reply, strlen(reply), 0, (struct sockaddr *)&from, flen);
+	}
+
+	_exit(0);
+}
+
+static void test_bss_range(void)
+{
+	int n, next = 0;
+	static struct iwinfo_scanlist_entry e[4];
+	static const uint8_t mac[6] = { 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb };
+
+	n = nl80211_wpactl_parse_bss(bss_range_last, e, 4, 70, &next);
+
+	CHECK_INT(n, 2);
+	CHECK_INT(next, -1);
+	CHECK_STR(e[0].ssid, "home");
+	CHECK_INT(e[0].channel, 6);
+	CHECK_INT(e[0].crypto.wpa_version, 2);
+	CHECK(e[0].crypto.auth_suites & IWINFO_KMGMT_PSK);
+	CHECK_STR(e[1].ssid, "office");
+	CHECK_INT(e[1].channel, 36);
+	CHECK(!memcmp(e[1].mac, mac, 6));
+	CHECK(e[1].crypto.auth_suites & IWINFO_KMGMT_SAE);
+
+	/* ciphers past the original 8 bit fields land in the _ext ones */
+	CHECK_INT(e[1].crypto.pair_ciphers, IWINFO_CIPHER_CCMP);
+	CHECK_INT(IWINFO_CRYPTO_CIPHERS(&e[1].crypto, pair),
+	          IWINFO_CIPHER_CCMP | IWINFO_CIPHER_GCMP256);
+	CHECK_INT(IWINFO_CRYPTO_CIPHERS(&e[1].crypto, group),
+	          IWINFO_CIPHER_CCMP | IWINFO_CIPHER_GCMP256);
+	CHECK_INT(e[1].mode, IWINFO_OPMODE_MASTER);
+
+	/* the table has more entries than the caller has room for */
+	next = 0;
+	n = nl80211_wpactl_parse_bss(bss_range_last, e, 1, 70, &next);
+
+	CHECK_INT(n, 1);
+	CHECK_STR(e[0].ssid, "home");
+
+	/* an incomplete trailing record is dropped, paging continues */
+	next = 0;
+	n = nl80211_wpactl_parse_bss(bss_range_page, e, 4, 70, &next);
+
+	CHECK_INT(n, 1);
+	CHECK_INT(next, 6);
+	CHECK_STR(e[0].ssid, "open");
+	CHECK_INT(e[0].crypto.enabled, 0);
+}
+
+static void test_scan_results(void)
+{
+	int n;
+	static struct iwinfo_scanlist_entry e[4];
+
+	n = nl80211_wpactl_parse_results(scan_results, e, 4, 70);
+
+	CHECK_INT(n, 2);
+	CHECK_STR(e[0].ssid, "mixed");
+	CHECK_INT(e[0].channel, 11);
+	CHECK_INT(e[0].crypto.wpa_version, 3);
+	CHECK(e[0].crypto.pair_ciphers & IWINFO_CIPHER_TKIP);
+	CHECK(e[0].crypto.pair_ciphers & IWINFO_CIPHER_CCMP);
+	CHECK_STR(e[1].ssid, "");
+	CHECK_INT(e[1].channel, 149);
+}
+
+static void test_scan_async(void)
+{
+	int len = 0;
+	pid_t pid;
+	char *res;
+	static char buf[IWINFO_BUFSIZE];
+	struct iwinfo_scanlist_entry *e = (struct iwinfo_scanlist_entry *)buf;
+	struct nl80211_scan_handle *h;
+	struct iwinfo_scan s = { 0 };
+
+	if ((pid = fake_supplicant()) < 0)
+	{
+		fprintf(stderr, "wpactl: no access to " TEST_SUPDIR
+		                ", async scan not tested\n");
+		return;
+	}
+
+	/* what nl80211_scan_trigger() does once nl80211 is up */
+	h = calloc(1, sizeof(*h));
+	h->ctl.sock = -1;
+
+	snprintf(s.ifname, sizeof(s.ifname), TEST_IFNAME);
+	s.state = IWINFO_SCAN_PENDING;
+	s.priv  = h;
+
+	CHECK_INT(nl80211_scan_trigger_sup(&s), 0);
+	CHECK_INT(nl80211_scan_ready(&s), IWINFO_SCAN_PENDING);
+
+	/* other queries of the interface while the scan runs must not take
+	 * the path the supplicant reports to */
+	res = nl80211_wpactl_info(TEST_IFNAME, "STATUS", NULL);
+	CHECK(res && !strncmp(res, "wpa_state=", 10));
+
+	res = nl80211_wpactl_info(TEST_IFNAME, "FIRE", NULL);
+	CHECK(res && !strncmp(res, "OK", 2));
+
+	CHECK_INT(nl80211_scan_ready(&s), IWINFO_SCAN_READY);
+
+	/* collecting shares the control socket of the scan */
+	CHECK_INT(nl80211_scan_results(&s, buf, &len), 0);
+	CHECK_INT(len, 2 * sizeof(*e));
+	CHECK_STR(e[0].ssid, "home");
+	CHECK_STR(e[1].ssid, "office");
+
+	nl80211_scan_close(&s);
+
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+
+	unlink(TEST_SUPDIR "/" TEST_IFNAME);
+	rmdir(TEST_SUPDIR);
+}
+
+int main(void)
+{
+	test_bss_range();
+	test_scan_results();
+	test_scan_async();
+
+	return test_done("wpactl");
+}